@@ -5,6 +5,29 @@
 #include "Lib_Examples\CommandLayer.h"
 #include <conio.h>
 #include "Lib_Examples\KinovaTypes.h"
+#include "ArmDaemon.h"
+#include "ArmLease.h"
+#include "Calibration.h"
+#include "CommandQueue.h"
+#include "ErrorLog.h"
+#include "Interpolator.h"
+#include "Latency.h"
+#include "LoadTest.h"
+#include "LossyLink.h"
+#include "NatNetClient.h"
+#include "NatNetFrame.h"
+#include "Predictor.h"
+#include "Presets.h"
+#include "Retarget.h"
+#include "Roadmap.h"
+#include "StateCache.h"
+#include "TeleopClient.h"
+#include "TeleopServer.h"
+#include "Thermal.h"
+#include "Timing.h"
+#include "Trajectory.h"
+#include "TrajectoryStreamer.h"
+#include <algorithm>
 #include <iostream>
 
 
@@ -24,6 +47,16 @@ int(*MyInitFingers)();
 int(*MyEraseAllTrajectories)();
 int(*MyGetAngularCommand)(AngularPosition &);
 int(*MyGetCartesianCommand)(CartesianPosition &);
+int(*MyGetCartesianPosition)(CartesianPosition &);
+int(*MyGetAngularPosition)(AngularPosition &);
+int(*MyGetGlobalTrajectoryInfo)(TrajectoryFIFO &);
+int(*MyGetCartesianForce)(CartesianPosition &);
+int(*MyGetAngularForceGravityFree)(AngularPosition &);
+int(*MyGetAngularCurrent)(AngularPosition &);
+int(*MyGetSensorsInfo)(SensorsInfo &);
+int(*MyGetSystemErrorCount)(unsigned int &);
+int(*MyGetSystemError)(unsigned int, SystemError &);
+int(*MyClearErrorLog)();
 
 KinovaDevice list[MAX_KINOVA_DEVICE];
 char* leftArm = "PJ00650019161750001";
@@ -31,8 +64,25 @@ char* rightArm = "PJ00900006020921-0 ";
 int leftArmIndex = -1;
 int rightArmIndex = -1;
 
+// how often the worker reads back the state of each arm
+#define STATE_REFRESH_PERIOD_MICROS 10000
+// forces and currents are read faster, for the operator's force feedback
+#define EFFORT_REFRESH_PERIOD_MICROS 8000
+// temperatures change slowly, this is plenty for the thermal governor
+#define SENSOR_REFRESH_PERIOD_MICROS 100000
+
+MotionLimits trajectoryLimits = DefaultMotionLimits();
+JointMotionLimits jointTrajectoryLimits = DefaultJointMotionLimits();
+
 extern "C"
 {
+	static int ExecuteCommand(const ArmCommand &command);
+	static void RefreshArmStates();
+	static void RefreshArmEfforts();
+	static void RefreshArmSensors();
+	static void PollSystemErrors();
+	static void FeedTrajectories();
+
 	// test function just to figure out if we can access dll & it works
 	int TestFunction()
 	{
@@ -68,6 +118,16 @@ extern "C"
 		MyEraseAllTrajectories = (int(*)()) GetProcAddress(commandLayer_handle, "EraseAllTrajectories");
 		MyInitFingers = (int(*)()) GetProcAddress(commandLayer_handle, "InitFingers");
 		MyGetCartesianCommand = (int(*)(CartesianPosition &)) GetProcAddress(commandLayer_handle, "GetCartesianCommand");
+		MyGetCartesianPosition = (int(*)(CartesianPosition &)) GetProcAddress(commandLayer_handle, "GetCartesianPosition");
+		MyGetAngularPosition = (int(*)(AngularPosition &)) GetProcAddress(commandLayer_handle, "GetAngularPosition");
+		MyGetGlobalTrajectoryInfo = (int(*)(TrajectoryFIFO &)) GetProcAddress(commandLayer_handle, "GetGlobalTrajectoryInfo");
+		MyGetCartesianForce = (int(*)(CartesianPosition &)) GetProcAddress(commandLayer_handle, "GetCartesianForce");
+		MyGetAngularForceGravityFree = (int(*)(AngularPosition &)) GetProcAddress(commandLayer_handle, "GetAngularForceGravityFree");
+		MyGetAngularCurrent = (int(*)(AngularPosition &)) GetProcAddress(commandLayer_handle, "GetAngularCurrent");
+		MyGetSensorsInfo = (int(*)(SensorsInfo &)) GetProcAddress(commandLayer_handle, "GetSensorsInfo");
+		MyGetSystemErrorCount = (int(*)(unsigned int &)) GetProcAddress(commandLayer_handle, "GetSystemErrorCount");
+		MyGetSystemError = (int(*)(unsigned int, SystemError &)) GetProcAddress(commandLayer_handle, "GetSystemError");
+		MyClearErrorLog = (int(*)()) GetProcAddress(commandLayer_handle, "ClearErrorLog");
 		
 		//Verify that all functions has been loaded correctly
 		if (MyInitAPI == NULL)
@@ -102,6 +162,46 @@ extern "C"
 		{
 			return -17;
 		}
+		else if (MyGetCartesianPosition == NULL)
+		{
+			return -19;
+		}
+		else if (MyGetAngularPosition == NULL)
+		{
+			return -20;
+		}
+		else if (MyGetGlobalTrajectoryInfo == NULL)
+		{
+			return -21;
+		}
+		else if (MyGetCartesianForce == NULL)
+		{
+			return -22;
+		}
+		else if (MyGetAngularForceGravityFree == NULL)
+		{
+			return -23;
+		}
+		else if (MyGetAngularCurrent == NULL)
+		{
+			return -24;
+		}
+		else if (MyGetSensorsInfo == NULL)
+		{
+			return -25;
+		}
+		else if (MyGetSystemErrorCount == NULL)
+		{
+			return -26;
+		}
+		else if (MyGetSystemError == NULL)
+		{
+			return -27;
+		}
+		else if (MyClearErrorLog == NULL)
+		{
+			return -28;
+		}
 
 		int result = (*MyInitAPI)();
 
@@ -118,6 +218,14 @@ extern "C"
 
 		if (devicesCount >= 1)
 		{
+			StartCommandQueue(ExecuteCommand);
+			AddBackgroundTask(RefreshArmStates, STATE_REFRESH_PERIOD_MICROS);
+			AddBackgroundTask(RefreshArmEfforts, EFFORT_REFRESH_PERIOD_MICROS);
+			AddBackgroundTask(RefreshArmSensors, SENSOR_REFRESH_PERIOD_MICROS);
+			AddBackgroundTask(PollSystemErrors, SYSTEM_ERROR_POLL_PERIOD_MICROS);
+			AddBackgroundTask(FeedTrajectories, TRAJECTORY_FEED_PERIOD_MICROS);
+			StartRoadmap(ROADMAP_CACHE_FILE);
+			LoadCalibration(CALIBRATION_FILE);
 			return 0;
 		}
 
@@ -135,56 +243,49 @@ extern "C"
 		}
 	}
 
-	// send robot to new point
-	int MoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	static bool ArmConnected(bool rightArm)
+	{
+		return (rightArm ? rightArmIndex : leftArmIndex) >= 0;
+	}
+
+	// Kinova calls return NO_ERROR_KINOVA on success, we return 0 like the rest of the bridge
+	static int KinovaResult(int result)
+	{
+		return result == NO_ERROR_KINOVA ? 0 : result;
+	}
+
+	static int SendCartesianPoint(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
 	{
-		EnableDesiredArm(rightArm);
 		TrajectoryPoint pointToSend;
 		pointToSend.InitStruct();
+		float scale = ThermalScale(rightArm);
+		if (scale < 1.0f)
+		{
+			// the thermal governor is derating the arm
+			pointToSend.LimitationsActive = 1;
+			pointToSend.Limitations.speedParameter1 = THERMAL_NOMINAL_LINEAR_SPEED * scale;
+			pointToSend.Limitations.speedParameter2 = THERMAL_NOMINAL_ANGULAR_SPEED * scale;
+		}
 		pointToSend.Position.Type = CARTESIAN_POSITION;
 		pointToSend.Position.CartesianPosition.X = x;
 		pointToSend.Position.CartesianPosition.Y = y;
 		pointToSend.Position.CartesianPosition.Z = z;
 		pointToSend.Position.CartesianPosition.ThetaX = thetaX;
 		pointToSend.Position.CartesianPosition.ThetaY = thetaY;
-		pointToSend.Position.CartesianPosition.ThetaY = thetaZ;
-
-		MySendBasicTrajectory(pointToSend);
-
-		return 0;
-	}
+		pointToSend.Position.CartesianPosition.ThetaZ = thetaZ;
 
-	int MoveArmHome(bool rightArm)
-	{
-		EnableDesiredArm(rightArm);
-		MyMoveHome();
-		return 0;
+		return KinovaResult(MySendBasicTrajectory(pointToSend));
 	}
 
-	int MoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+	static int SendFingers(float fingerValue)
 	{
-		EnableDesiredArm(rightArm);
-		CartesianPosition currentCommand;
-		//get the actual angular command of the robot.
-		MyGetCartesianCommand(currentCommand);
-
-		MoveHand(rightArm, x, y, z, thetaX, currentCommand.Coordinates.ThetaY, thetaZ);
-
-		return 0;
-	}
-
-	/**
-	* @param pinky is extended if TRUE and close otherwise
-	* @param ring is extended if TRUE and close otherwise
-	* @param middle is extended if TRUE and close otherwise
-	* @param index is extended if TRUE and close otherwise
-	* @param thumb is extended if TRUE and close otherwise
-	*/
-	int MoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb) {
-		EnableDesiredArm(rightArm);
 		CartesianPosition currentCommand;
 		//get the actual angular command of the robot.
-		MyGetCartesianCommand(currentCommand);
+		int result = KinovaResult(MyGetCartesianCommand(currentCommand));
+		if (result != 0)
+		{
+			return result;
+		}
 
 		TrajectoryPoint pointToSend;
 		pointToSend.InitStruct(); // initializes all values to 0.0
@@ -195,38 +296,1553 @@ extern "C"
 		pointToSend.Position.CartesianPosition.ThetaY = currentCommand.Coordinates.ThetaY;
 		pointToSend.Position.CartesianPosition.ThetaZ = currentCommand.Coordinates.ThetaZ;
 
-		float fingerValue = 0.0f;
+		pointToSend.Position.Fingers.Finger1 = fingerValue;
+		pointToSend.Position.Fingers.Finger2 = fingerValue;
+		pointToSend.Position.Fingers.Finger3 = fingerValue;
+
+		return KinovaResult(MySendBasicTrajectory(pointToSend));
+	}
+
+	// Runs on the command queue's worker thread, which is the only thread talking to the arms
+	static int ExecuteCommand(const ArmCommand &command)
+	{
+		EnableDesiredArm(command.RightArm);
+
+		switch (command.Type)
+		{
+		case CMD_MOVE_HAND:
+			return SendCartesianPoint(command.RightArm, command.X, command.Y, command.Z, command.ThetaX, command.ThetaY, command.ThetaZ);
+
+		case CMD_MOVE_HAND_NO_THETA_Y:
+		{
+			CartesianPosition currentCommand;
+			//get the actual angular command of the robot.
+			int result = KinovaResult(MyGetCartesianCommand(currentCommand));
+			if (result != 0)
+			{
+				return result;
+			}
+			return SendCartesianPoint(command.RightArm, command.X, command.Y, command.Z, command.ThetaX, currentCommand.Coordinates.ThetaY, command.ThetaZ);
+		}
+
+		case CMD_MOVE_HOME:
+			return KinovaResult(MyMoveHome());
+
+		case CMD_MOVE_FINGERS:
+			return SendFingers(command.Fingers);
+
+		case CMD_STOP_ARM:
+			CancelWaypointStream(command.RightArm);
+			return KinovaResult(MyEraseAllTrajectories());
+
+		case CMD_CLEAR_ERROR_LOG:
+			// the poller notices the log got shorter and starts over
+			return KinovaResult(MyClearErrorLog());
+		}
+		return ERROR_INVALID_PARAM;
+	}
+
+	// Background task: read back where both arms actually are
+	static void RefreshArmStates()
+	{
+		for (int arm = 0; arm < 2; arm++)
+		{
+			bool right = arm == 1;
+			if (!ArmConnected(right))
+			{
+				continue;
+			}
+			EnableDesiredArm(right);
+
+			CartesianPosition cartesian;
+			AngularPosition angular;
+			if (MyGetCartesianPosition(cartesian) != NO_ERROR_KINOVA || MyGetAngularPosition(angular) != NO_ERROR_KINOVA)
+			{
+				continue;
+			}
+
+			ArmState state;
+			state.Timestamp = NowMicros();
+			state.X = cartesian.Coordinates.X;
+			state.Y = cartesian.Coordinates.Y;
+			state.Z = cartesian.Coordinates.Z;
+			state.ThetaX = cartesian.Coordinates.ThetaX;
+			state.ThetaY = cartesian.Coordinates.ThetaY;
+			state.ThetaZ = cartesian.Coordinates.ThetaZ;
+			state.Joints[0] = angular.Actuators.Actuator1;
+			state.Joints[1] = angular.Actuators.Actuator2;
+			state.Joints[2] = angular.Actuators.Actuator3;
+			state.Joints[3] = angular.Actuators.Actuator4;
+			state.Joints[4] = angular.Actuators.Actuator5;
+			state.Joints[5] = angular.Actuators.Actuator6;
+			state.Joints[6] = angular.Actuators.Actuator7;
+			state.Fingers[0] = cartesian.Fingers.Finger1;
+			state.Fingers[1] = cartesian.Fingers.Finger2;
+			state.Fingers[2] = cartesian.Fingers.Finger3;
+			PublishArmState(right, state);
+			ObserveArmPosition(right, state.Timestamp, MakeVec3(state.X, state.Y, state.Z));
+		}
+	}
+
+	static void RefreshArmEfforts()
+	{
+		for (int arm = 0; arm < 2; arm++)
+		{
+			bool right = arm == 1;
+			if (!ArmConnected(right))
+			{
+				continue;
+			}
+			EnableDesiredArm(right);
+
+			CartesianPosition force;
+			AngularPosition torques;
+			AngularPosition currents;
+			if (MyGetCartesianForce(force) != NO_ERROR_KINOVA ||
+				MyGetAngularForceGravityFree(torques) != NO_ERROR_KINOVA ||
+				MyGetAngularCurrent(currents) != NO_ERROR_KINOVA)
+			{
+				continue;
+			}
+
+			ArmEffort effort;
+			effort.Timestamp = NowMicros();
+			effort.Force[0] = force.Coordinates.X;
+			effort.Force[1] = force.Coordinates.Y;
+			effort.Force[2] = force.Coordinates.Z;
+			effort.Force[3] = force.Coordinates.ThetaX;
+			effort.Force[4] = force.Coordinates.ThetaY;
+			effort.Force[5] = force.Coordinates.ThetaZ;
+			effort.Torques[0] = torques.Actuators.Actuator1;
+			effort.Torques[1] = torques.Actuators.Actuator2;
+			effort.Torques[2] = torques.Actuators.Actuator3;
+			effort.Torques[3] = torques.Actuators.Actuator4;
+			effort.Torques[4] = torques.Actuators.Actuator5;
+			effort.Torques[5] = torques.Actuators.Actuator6;
+			effort.Torques[6] = torques.Actuators.Actuator7;
+			effort.Currents[0] = currents.Actuators.Actuator1;
+			effort.Currents[1] = currents.Actuators.Actuator2;
+			effort.Currents[2] = currents.Actuators.Actuator3;
+			effort.Currents[3] = currents.Actuators.Actuator4;
+			effort.Currents[4] = currents.Actuators.Actuator5;
+			effort.Currents[5] = currents.Actuators.Actuator6;
+			effort.Currents[6] = currents.Actuators.Actuator7;
+			effort.FingerCurrents[0] = currents.Fingers.Finger1;
+			effort.FingerCurrents[1] = currents.Fingers.Finger2;
+			effort.FingerCurrents[2] = currents.Fingers.Finger3;
+			PublishArmEffort(right, effort);
+		}
+	}
+
+	// Background task: pick up the entries added to each arm's error log since
+	// the last poll. One count query per arm when nothing happened.
+	static void PollSystemErrors()
+	{
+		static unsigned int errorsRead[2] = { 0, 0 };
+		for (int arm = 0; arm < 2; arm++)
+		{
+			bool right = arm == 1;
+			if (!ArmConnected(right))
+			{
+				continue;
+			}
+			EnableDesiredArm(right);
+
+			unsigned int count;
+			if (MyGetSystemErrorCount(count) != NO_ERROR_KINOVA)
+			{
+				continue;
+			}
+			if (count < errorsRead[arm])
+			{
+				// the log was cleared
+				errorsRead[arm] = 0;
+			}
+
+			unsigned int end = min(count, errorsRead[arm] + SYSTEM_ERROR_MAX_READS_PER_POLL);
+			for (; errorsRead[arm] < end; errorsRead[arm]++)
+			{
+				SystemError error;
+				if (MyGetSystemError(errorsRead[arm], error) != NO_ERROR_KINOVA)
+				{
+					break;
+				}
+
+				SystemErrorEntry entry;
+				memset(&entry, 0, sizeof(entry));
+				entry.Timestamp = NowMicros();
+				entry.LastCommandId = LatestCommandId();
+				entry.Arm = arm;
+				entry.LogIndex = errorsRead[arm];
+				entry.ErrorHeader = error.ErrorHeader;
+				entry.ErrorType = error.ErrorType;
+				entry.FirmwareVersion = error.FirmwareVersion;
+				entry.KeosVersion = error.KeosVersion;
+				entry.SystemTime = error.SystemTime;
+				entry.LifeTime = error.LifeTime;
+				for (int i = 0; i < ERROR_LAYER_COUNT; i++)
+				{
+					if (error.LayerErrorStatus[i])
+					{
+						entry.LayerErrors |= 1u << i;
+					}
+				}
+				entry.DataCount = max(0, min(error.DataCount, SYSTEM_ERROR_DATA_COUNT));
+				copy(error.Data, error.Data + entry.DataCount, entry.Data);
+				PushSystemError(entry);
+			}
+		}
+	}
+
+	static void RefreshArmSensors()
+	{
+		for (int arm = 0; arm < 2; arm++)
+		{
+			bool right = arm == 1;
+			if (!ArmConnected(right))
+			{
+				continue;
+			}
+			EnableDesiredArm(right);
+
+			SensorsInfo info;
+			if (MyGetSensorsInfo(info) != NO_ERROR_KINOVA)
+			{
+				continue;
+			}
+
+			ArmSensors sensors;
+			sensors.Timestamp = NowMicros();
+			sensors.Voltage = info.Voltage;
+			sensors.Current = info.Current;
+			sensors.Temperatures[0] = info.ActuatorTemp1;
+			sensors.Temperatures[1] = info.ActuatorTemp2;
+			sensors.Temperatures[2] = info.ActuatorTemp3;
+			sensors.Temperatures[3] = info.ActuatorTemp4;
+			sensors.Temperatures[4] = info.ActuatorTemp5;
+			sensors.Temperatures[5] = info.ActuatorTemp6;
+			sensors.Temperatures[6] = info.ActuatorTemp7;
+			PublishArmSensors(right, sensors);
+
+			ArmEffort effort;
+			if (ReadArmEffort(right, effort))
+			{
+				UpdateThermalModel(right, sensors, effort);
+			}
+		}
+	}
+
+	static int FifoSelectArm(bool rightArm)
+	{
+		if (!ArmConnected(rightArm))
+		{
+			return ERROR_NO_DEVICE_FOUND;
+		}
+		EnableDesiredArm(rightArm);
+		return 0;
+	}
+
+	static int FifoCount(unsigned int &count)
+	{
+		TrajectoryFIFO fifo;
+		int result = KinovaResult(MyGetGlobalTrajectoryInfo(fifo));
+		count = fifo.TrajectoryCount;
+		return result;
+	}
+
+	static int FifoErase()
+	{
+		return KinovaResult(MyEraseAllTrajectories());
+	}
+
+	// waypoint with its speed as the point's limitations, so the arm keeps to the planned timing
+	static int FifoSendWaypoint(const Waypoint &waypoint)
+	{
+		TrajectoryPoint pointToSend;
+		pointToSend.InitStruct();
+		if (waypoint.Angular)
+		{
+			pointToSend.Position.Type = ANGULAR_POSITION;
+			pointToSend.Position.Actuators.Actuator1 = waypoint.Pose[0];
+			pointToSend.Position.Actuators.Actuator2 = waypoint.Pose[1];
+			pointToSend.Position.Actuators.Actuator3 = waypoint.Pose[2];
+			pointToSend.Position.Actuators.Actuator4 = waypoint.Pose[3];
+			pointToSend.Position.Actuators.Actuator5 = waypoint.Pose[4];
+			pointToSend.Position.Actuators.Actuator6 = waypoint.Pose[5];
+		}
+		else
+		{
+			pointToSend.Position.Type = CARTESIAN_POSITION;
+			pointToSend.Position.CartesianPosition.X = waypoint.Pose[0];
+			pointToSend.Position.CartesianPosition.Y = waypoint.Pose[1];
+			pointToSend.Position.CartesianPosition.Z = waypoint.Pose[2];
+			pointToSend.Position.CartesianPosition.ThetaX = waypoint.Pose[3];
+			pointToSend.Position.CartesianPosition.ThetaY = waypoint.Pose[4];
+			pointToSend.Position.CartesianPosition.ThetaZ = waypoint.Pose[5];
+		}
+		pointToSend.LimitationsActive = 1;
+		pointToSend.Limitations.speedParameter1 = waypoint.LinearSpeed;
+		pointToSend.Limitations.speedParameter2 = waypoint.AngularSpeed;
+
+		return KinovaResult(MySendBasicTrajectory(pointToSend));
+	}
+
+	// Background task: keep streamed trajectories flowing into the FIFO
+	static void FeedTrajectories()
+	{
+		FifoOps ops = { FifoSelectArm, FifoCount, FifoErase, FifoSendWaypoint };
+		FeedWaypointStreams(ops);
+	}
+
+	static ArmCommand MakeCommand(int type, bool rightArm)
+	{
+		ArmCommand command;
+		memset(&command, 0, sizeof(command));
+		command.Type = type;
+		command.RightArm = rightArm;
+		return command;
+	}
+
+	// queue a command, returns its ID or -1 if the robot was not initialized
+	static int Submit(const ArmCommand &command)
+	{
+		unsigned int id = SubmitCommand(command);
+		return id == 0 ? -1 : (int)id;
+	}
+
+	// block until a queued command is done, returns 0 or the Kinova error code;
+	// ERROR_OPERATION_INCOMPLETED when its completion is no longer tracked
+	static int AwaitResult(int id)
+	{
+		if (id < 0)
+		{
+			return ERROR_API_NOT_INITIALIZED;
+		}
+		CommandCompletion completion;
+		switch (WaitForCompletion(id, -1, completion))
+		{
+		case 0:
+			return completion.Result;
+		case -1:
+			return ERROR_COMM_TIMEOUT;
+		default:
+			return ERROR_OPERATION_INCOMPLETED;
+		}
+	}
+
+	// queue a command and block until it is done, returns 0 or the Kinova error code
+	static int SubmitAndWait(const ArmCommand &command)
+	{
+		return AwaitResult(Submit(command));
+	}
+
+	int SubmitMoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaY = thetaY;
+		command.ThetaZ = thetaZ;
+		return Submit(command);
+	}
+
+	int SubmitMoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND_NO_THETA_Y, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaZ = thetaZ;
+		return Submit(command);
+	}
+
+	int SubmitMoveArmHome(bool rightArm)
+	{
+		return Submit(MakeCommand(CMD_MOVE_HOME, rightArm));
+	}
 
+	// see MoveFingers
+	int SubmitMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_FINGERS, rightArm);
 		if (pinky && ring && middle && index && thumb) {
 			//OPEN HAND CF_OpenHandOneFingers = 31, CF_OpenHandTwoFingers = 33,
 			//0.0 to 10.0 are the possible finger opening steps See KinovaTypes.h line 560 (struct FingersPosition)
-			fingerValue = 10.0f;
+			command.Fingers = 10.0f;
 		}
+		return Submit(command);
+	}
 
-		pointToSend.Position.Fingers.Finger1 = fingerValue;
-		pointToSend.Position.Fingers.Finger2 = fingerValue;
-		pointToSend.Position.Fingers.Finger3 = fingerValue;
+	int SubmitStopArm(bool rightArm)
+	{
+		return Submit(MakeCommand(CMD_STOP_ARM, rightArm));
+	}
 
-		MySendBasicTrajectory(pointToSend);
+	// empties the arm's error log on the robot
+	int SubmitClearErrorLog(bool rightArm)
+	{
+		return Submit(MakeCommand(CMD_CLEAR_ERROR_LOG, rightArm));
+	}
 
-		return fingerValue;
+	// Entries of the arms' error logs from *cursor on, oldest first. Start with
+	// *cursor 0 (everything still in the ring) or -1 (only new entries); it is
+	// moved past what was copied.
+	// returns the number of entries copied, or -1 for a NULL argument
+	int ReadSystemErrors(long long *cursor, SystemErrorEntry *entries, int maxCount)
+	{
+		if (cursor == NULL || entries == NULL)
+		{
+			return -1;
+		}
+		unsigned long long position = *cursor < 0 ? SystemErrorCursor() : (unsigned long long)*cursor;
+		int count = ReadSystemErrorEntries(position, entries, maxCount);
+		*cursor = (long long)position;
+		return count;
+	}
 
-	}//END MOVEFINGER FUNCTION
+	int PollCommandCompletions(CommandCompletion *completions, int maxCount)
+	{
+		return PollCompletions(completions, maxCount);
+	}
 
-	int StopArm(bool rightArm)
+	// returns:
+	// 0 - completion filled in
+	// -1 - timed out
+	// -2 - unknown or too old command ID
+	int WaitForCommand(int commandId, int timeoutMs, CommandCompletion *completion)
 	{
-		EnableDesiredArm(rightArm);
-		MyEraseAllTrajectories();
+		if (commandId <= 0 || completion == NULL)
+		{
+			return -2;
+		}
+		return WaitForCompletion((unsigned int)commandId, timeoutMs, *completion);
+	}
+
+	long long GetBridgeTime()
+	{
+		return NowMicros();
+	}
+
+	// start sending interpolated targets to both arms
+	// returns:
+	// 0 - success
+	// -1 - robot not initialized
+	// -2 - rate outside of 100 to 500 Hz
+	int StartTargetStream(int rateHz, int delayMs)
+	{
+		if (!CommandQueueRunning())
+		{
+			return -1;
+		}
+		return StartInterpolator(rateHz, delayMs * 1000LL);
+	}
+
+	int StopTargetStream()
+	{
+		StopInterpolator();
 		return 0;
 	}
 
-	// Close device & free the library
-	int CloseDevice(bool rightArm)
+	// orientation as a quaternion (x, y, z, w) in the Kinova base frame
+	int PushTargetSample(bool rightArm, long long timestamp, float x, float y, float z, float qx, float qy, float qz, float qw)
 	{
-		EnableDesiredArm(rightArm);
-		(*MyCloseAPI)();
-		FreeLibrary(commandLayer_handle);
+		Pose target;
+		target.Position = MakeVec3(x, y, z);
+		target.Orientation = MakeQuat(qx, qy, qz, qw);
+		PushTarget(rightArm, timestamp == 0 ? NowMicros() : timestamp, target);
+		return 0;
+	}
+
+	// orientation as Kinova ThetaX, ThetaY, ThetaZ like MoveHand
+	int PushTargetPose(bool rightArm, long long timestamp, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	{
+		Pose target;
+		target.Position = MakeVec3(x, y, z);
+		target.Orientation = FromKinovaEuler(thetaX, thetaY, thetaZ);
+		PushTarget(rightArm, timestamp == 0 ? NowMicros() : timestamp, target);
+		return 0;
+	}
+
+	// both arms at once, controllers[0] left and [1] right, for the arms in armMask
+	// (1 left, 2 right). Retargeted natively before they go into the stream.
+	int PushControllerTargets(long long timestamp, const ControllerPose *controllers, int armMask)
+	{
+		if (controllers == NULL)
+		{
+			return -1;
+		}
+		long long t = timestamp == 0 ? NowMicros() : timestamp;
+		for (int i = 0; i < 2; i++)
+		{
+			if (armMask & (i == 0 ? RETARGET_LEFT_ARM : RETARGET_RIGHT_ARM))
+			{
+				PushTarget(i == 1, t, RetargetPose(i == 1, controllers[i]));
+			}
+		}
+		return 0;
+	}
+
+	// Kinova poses for the controllers, without moving anything
+	int RetargetControllerPoses(const ControllerPose *controllers, int armMask, KinovaPose *poses)
+	{
+		if (controllers == NULL || poses == NULL)
+		{
+			return -1;
+		}
+		RetargetControllers(controllers, armMask, poses);
+		return 0;
+	}
+
+	// frame NULL resets the arm to its default (the right arm mirrors the left)
+	int SetControllerFrame(bool rightArm, const RetargetFrame *frame)
+	{
+		if (frame == NULL)
+		{
+			ClearRetargetFrame(rightArm);
+		}
+		else
+		{
+			SetRetargetFrame(rightArm, *frame);
+		}
+		ResetRetargetContinuity(rightArm);
+		return 0;
+	}
+
+	// returns:
+	// 0 - the arm's own frame
+	// 1 - the right arm mirrors the left one, frame is the left arm's
+	// -1 - frame is NULL
+	int GetControllerFrame(bool rightArm, RetargetFrame *frame)
+	{
+		if (frame == NULL)
+		{
+			return -1;
+		}
+		*frame = GetRetargetFrame(rightArm);
+		return HasRetargetFrame(rightArm) ? 0 : 1;
+	}
+
+	// model is one of PredictionModel (0 off), lead scales the horizon
+	// returns:
+	// 0 - prediction set
+	// -2 - unknown model or lead outside of 0 to 2
+	int SetTargetPrediction(int model, float lead)
+	{
+		return SetPrediction(model, lead) ? 0 : -2;
+	}
 
+	int GetPredictionStats(PredictorStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadPredictorStats(*stats);
 		return 0;
 	}
+
+	// histogram is LATENCY_COMMAND (0), LATENCY_MOTION (1) or LATENCY_CAPTURE (2)
+	int GetLatencyStats(int histogram, LatencyStats *stats)
+	{
+		if (stats == NULL || !ReadLatencyStats(histogram, *stats))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	int ResetLatencyStats(int histogram)
+	{
+		ResetLatency(histogram);
+		return 0;
+	}
+
+	// constraint is one of DualArmConstraint (0 free), distance in meters or
+	// 0 to keep the one the hands have when the next pair goes out
+	// returns:
+	// 0 - coordination set
+	// -2 - unknown constraint
+	// -3 - the constraint needs the right arm's base pose first
+	int CoordinateArms(bool enabled, int constraint, float distance)
+	{
+		if (constraint < DUAL_ARM_FREE || constraint > DUAL_ARM_RIGID)
+		{
+			return -2;
+		}
+		return SetDualArmCoordination(enabled, constraint, distance) ? 0 : -3;
+	}
+
+	// pose of the right arm's base in the left arm's base frame, meters and a
+	// quaternion (x, y, z, w)
+	int SetRightArmBase(float x, float y, float z, float qx, float qy, float qz, float qw)
+	{
+		Pose base;
+		base.Position = MakeVec3(x, y, z);
+		base.Orientation = MakeQuat(qx, qy, qz, qw);
+		SetDualArmBase(base);
+		return 0;
+	}
+
+	// returns:
+	// 0 - base pose set from the two arms' frames for source
+	// -1 - an arm is not calibrated against source
+	int DeriveRightArmBase(int source)
+	{
+		return DeriveDualArmBase(source) ? 0 : -1;
+	}
+
+	int GetDualArmStats(DualArmStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadDualArmStats(*stats);
+		return 0;
+	}
+
+	// pairs a tracked pose with where the arm is right now
+	// returns:
+	// 0 - sample recorded
+	// -1 - no recent arm state, bad source or too many samples
+	int AddCalibrationSample(bool rightArm, int source, const ControllerPose *pose)
+	{
+		if (pose == NULL || !RecordCalibrationSample(rightArm, source, *pose))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	int ClearCalibrationSamples(bool rightArm, int source)
+	{
+		ClearCalibration(rightArm, source);
+		return 0;
+	}
+
+	// fits the frame to the recorded samples, applies it and saves it
+	// returns:
+	// 0 - result filled in
+	// -1 - too few usable samples
+	// -2 - solved, but the calibration file could not be written
+	int CalibrateArm(bool rightArm, int source, bool withScale, CalibrationResult *result)
+	{
+		CalibrationResult solved;
+		if (!SolveCalibration(rightArm, source, withScale, solved))
+		{
+			return -1;
+		}
+		if (result != NULL)
+		{
+			*result = solved;
+		}
+		return SaveCalibration(CALIBRATION_FILE) ? 0 : -2;
+	}
+
+	int ClearTargetSamples(bool rightArm)
+	{
+		ClearTargets(rightArm);
+		return 0;
+	}
+
+	int GetTargetStreamStats(TargetStreamStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadTargetStreamStats(*stats);
+		return 0;
+	}
+
+	// latest pose read back from the arm
+	// returns:
+	// 0 - state filled in
+	// -1 - arm was never read
+	int GetArmState(bool rightArm, ArmState *state)
+	{
+		if (state == NULL || !ReadArmState(rightArm, *state))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	// latest forces and currents read back from the arm
+	// returns:
+	// 0 - effort filled in
+	// -1 - arm was never read
+	int GetArmEffort(bool rightArm, ArmEffort *effort)
+	{
+		if (effort == NULL || !ReadArmEffort(rightArm, *effort))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	// latest supply voltage, current and actuator temperatures
+	// returns:
+	// 0 - sensors filled in
+	// -1 - sensors were never read
+	int GetArmSensors(bool rightArm, ArmSensors *sensors)
+	{
+		if (sensors == NULL || !ReadArmSensors(rightArm, *sensors))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	// temperatures, current budget and derating of the arm
+	// returns:
+	// 0 - status filled in
+	// -1 - sensors were never read
+	int GetThermalStatus(bool rightArm, ThermalStatus *status)
+	{
+		if (status == NULL || !ReadThermalStatus(rightArm, *status))
+		{
+			return -1;
+		}
+		return 0;
+	}
+
+	int EnableThermalGovernor(bool enabled)
+	{
+		SetThermalGovernor(enabled);
+		return 0;
+	}
+
+	// maxVelocity and maxAcceleration hold 6 values each: X, Y, Z, ThetaX, ThetaY, ThetaZ
+	int SetTrajectoryLimits(const float *maxVelocity, const float *maxAcceleration)
+	{
+		if (maxVelocity == NULL || maxAcceleration == NULL)
+		{
+			return -1;
+		}
+		for (int i = 0; i < CARTESIAN_AXES; i++)
+		{
+			if (maxVelocity[i] <= 0.0f || maxAcceleration[i] <= 0.0f)
+			{
+				return -1;
+			}
+		}
+		for (int i = 0; i < CARTESIAN_AXES; i++)
+		{
+			trajectoryLimits.MaxVelocity[i] = maxVelocity[i];
+			trajectoryLimits.MaxAcceleration[i] = maxAcceleration[i];
+		}
+		return 0;
+	}
+
+	// maxVelocity (deg/s) and maxAcceleration (deg/s^2) hold 6 values each, one per
+	// actuator, for moves along the roadmap. Capped at what the actuators can do.
+	int SetJointTrajectoryLimits(const float *maxVelocity, const float *maxAcceleration)
+	{
+		if (maxVelocity == NULL || maxAcceleration == NULL)
+		{
+			return -1;
+		}
+		for (int i = 0; i < ARM_DOF; i++)
+		{
+			if (maxVelocity[i] <= 0.0f || maxAcceleration[i] <= 0.0f)
+			{
+				return -1;
+			}
+		}
+		for (int i = 0; i < ARM_DOF; i++)
+		{
+			jointTrajectoryLimits.MaxVelocity[i] = min(maxVelocity[i], JointMaxVelocity(i));
+			jointTrajectoryLimits.MaxAcceleration[i] = min(maxAcceleration[i], JointMaxAcceleration(i));
+		}
+		return 0;
+	}
+
+	// smooth minimum jerk move from where the arm is now to a named preset,
+	// interrupts any move the arm is streaming. Follows the collision free
+	// roadmap path when there is one, otherwise moves in a straight line.
+	// returns:
+	// > 0 - command ID, completes when the arm got there
+	// -1 - robot not initialized
+	// -2 - unknown preset
+	// -3 - arm position not known yet
+	int MoveArmToPreset(bool rightArm, const char *preset)
+	{
+		const PresetPose *found = FindPreset(preset);
+		if (found == NULL)
+		{
+			return -2;
+		}
+
+		ArmState state;
+		if (!ReadArmState(rightArm, state))
+		{
+			return -3;
+		}
+
+		unsigned int id = ReserveCommandId();
+		if (id == 0)
+		{
+			return -1;
+		}
+		long long submitTime = NowMicros();
+
+		JointConfig joints;
+		copy(state.Joints, state.Joints + ARM_DOF, joints.Angles);
+		vector<JointConfig> path;
+		vector<Waypoint> waypoints;
+		if (FindRoadmapPath(rightArm, joints, PresetIndex(preset), path))
+		{
+			GenerateJointPath(path, ThermalJointMotionLimits(rightArm, jointTrajectoryLimits), TRAJECTORY_WAYPOINT_SPACING, waypoints);
+		}
+		else
+		{
+			PresetPose goalPose = MirrorForArm(*found, rightArm);
+			float start[CARTESIAN_AXES] = { state.X, state.Y, state.Z, state.ThetaX, state.ThetaY, state.ThetaZ };
+			float goal[CARTESIAN_AXES] = { goalPose.X, goalPose.Y, goalPose.Z, goalPose.ThetaX, goalPose.ThetaY, goalPose.ThetaZ };
+			GenerateMinimumJerk(start, goal, ThermalMotionLimits(rightArm, trajectoryLimits), TRAJECTORY_WAYPOINT_SPACING, waypoints);
+		}
+		StartWaypointStream(rightArm, id, submitTime, waypoints);
+		return (int)id;
+	}
+
+	// capsule obstacle from (x1, y1, z1) to (x2, y2, z2) in the left arm's base
+	// frame, meters; the right arm sees it mirrored. Replans the roadmap.
+	// returns the number of obstacles
+	int AddObstacle(float x1, float y1, float z1, float x2, float y2, float z2, float radius)
+	{
+		Capsule obstacle = { MakeVec3(x1, y1, z1), MakeVec3(x2, y2, z2), radius };
+		vector<Capsule> obstacles = GetRoadmapObstacles();
+		obstacles.push_back(obstacle);
+		SetRoadmapObstacles(obstacles);
+		return (int)obstacles.size();
+	}
+
+	int ClearObstacles()
+	{
+		SetRoadmapObstacles(vector<Capsule>());
+		return 0;
+	}
+
+	// returns:
+	// 0 - not running
+	// 1 - planning, preset moves go in a straight line meanwhile
+	// 2 - ready
+	int GetRoadmapStatus()
+	{
+		return GetRoadmapState();
+	}
+
+	// send robot to new point
+	int MoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaY = thetaY;
+		command.ThetaZ = thetaZ;
+		return SubmitAndWait(command);
+	}
+
+	// controller pose straight from Unity, retargeted natively (see Retarget.h)
+	int MoveHandToController(bool rightArm, const ControllerPose *controller)
+	{
+		if (controller == NULL)
+		{
+			return -1;
+		}
+		ControllerPose controllers[2];
+		KinovaPose poses[2];
+		controllers[rightArm ? 1 : 0] = *controller;
+		RetargetControllers(controllers, rightArm ? RETARGET_RIGHT_ARM : RETARGET_LEFT_ARM, poses);
+
+		const KinovaPose &pose = poses[rightArm ? 1 : 0];
+		return MoveHand(rightArm, pose.X, pose.Y, pose.Z, pose.ThetaX, pose.ThetaY, pose.ThetaZ);
+	}
+
+	int MoveArmHome(bool rightArm)
+	{
+		return SubmitAndWait(MakeCommand(CMD_MOVE_HOME, rightArm));
+	}
+
+	int MoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND_NO_THETA_Y, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaZ = thetaZ;
+		return SubmitAndWait(command);
+	}
+
+	/**
+	* @param pinky is extended if TRUE and close otherwise
+	* @param ring is extended if TRUE and close otherwise
+	* @param middle is extended if TRUE and close otherwise
+	* @param index is extended if TRUE and close otherwise
+	* @param thumb is extended if TRUE and close otherwise
+	*/
+	int MoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb) {
+		return AwaitResult(SubmitMoveFingers(rightArm, pinky, ring, middle, index, thumb));
+
+	}//END MOVEFINGER FUNCTION
+
+	int StopArm(bool rightArm)
+	{
+		return SubmitAndWait(MakeCommand(CMD_STOP_ARM, rightArm));
+	}
+
+	// Close device & free the library
+	int CloseDevice(bool rightArm)
+	{
+		// the threads feeding commands go first, then queued commands finish
+		// before the API goes away
+		CloseNatNetClient();
+		CloseLossyLink();
+		CloseTeleopServer();
+		StopInterpolator();
+		StopCommandQueue();
+		StopRoadmap();
+
+		EnableDesiredArm(rightArm);
+		(*MyCloseAPI)();
+		FreeLibrary(commandLayer_handle);
+
+		return 0;
+	}
+
+	// Runs this process as the arm daemon (see ArmChannel.h) until a client
+	// shuts it down, then closes the API. From a command line:
+	// %windir%\SysWOW64\rundll32.exe ARM_base_32.dll,ArmDaemonMain
+	// returns:
+	// 0 - shut down by a client
+	// -1 - another daemon is running
+	// -2 - the shared memory could not be created
+	int RunArmDaemon()
+	{
+		int robotStatus;
+		int result = ServeArmChannel(InitRobot, robotStatus);
+		if (robotStatus == 0)
+		{
+			CloseDevice(false);
+		}
+		return result;
+	}
+
+	// entry point for rundll32, which wants the name undecorated
+#ifndef _WIN64
+#pragma comment(linker, "/EXPORT:ArmDaemonMain=_ArmDaemonMain@16")
+#endif
+	void __stdcall ArmDaemonMain(void *window, void *instance, char *commandLine, int show)
+	{
+		RunArmDaemon();
+	}
+
+	// Client side of the daemon, for Unity instead of InitRobot and the
+	// Submit* calls. Commands return a tag (> 0) that comes back as the Id of
+	// their completion, -1 when not connected or the daemon is gone, -2 when
+	// the channel is full.
+	// returns:
+	// 0 - connected
+	// -1 - no daemon running
+	// -2 - the daemon is another version of the bridge
+	// -3 - another client is connected
+	int ConnectArmDaemon()
+	{
+		return ConnectToArmDaemon();
+	}
+
+	// stops the arms, the daemon keeps running for the next client
+	int DisconnectArmDaemon()
+	{
+		DisconnectFromArmDaemon();
+		return 0;
+	}
+
+	// returns -1 when not connected
+	int ShutdownArmDaemon()
+	{
+		return RequestDaemonShutdown() ? 0 : -1;
+	}
+
+	int DaemonMoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaY = thetaY;
+		command.ThetaZ = thetaZ;
+		return SendDaemonCommand(command);
+	}
+
+	int DaemonMoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_HAND_NO_THETA_Y, rightArm);
+		command.X = x;
+		command.Y = y;
+		command.Z = z;
+		command.ThetaX = thetaX;
+		command.ThetaZ = thetaZ;
+		return SendDaemonCommand(command);
+	}
+
+	int DaemonMoveArmHome(bool rightArm)
+	{
+		return SendDaemonCommand(MakeCommand(CMD_MOVE_HOME, rightArm));
+	}
+
+	// see MoveFingers
+	int DaemonMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb)
+	{
+		ArmCommand command = MakeCommand(CMD_MOVE_FINGERS, rightArm);
+		if (pinky && ring && middle && index && thumb) {
+			command.Fingers = 10.0f;
+		}
+		return SendDaemonCommand(command);
+	}
+
+	int DaemonStopArm(bool rightArm)
+	{
+		return SendDaemonCommand(MakeCommand(CMD_STOP_ARM, rightArm));
+	}
+
+	int PollDaemonCompletions(CommandCompletion *completions, int maxCount)
+	{
+		return TakeDaemonCompletions(completions, maxCount);
+	}
+
+	// returns:
+	// 0 - state filled in
+	// -1 - not connected
+	// -2 - the daemon has not read the arm yet
+	int GetDaemonArmState(bool rightArm, ArmState *state)
+	{
+		if (state == NULL)
+		{
+			return -2;
+		}
+		return ReadDaemonArmState(rightArm, *state);
+	}
+
+	// round trip through the channel in microseconds, -1 when not connected,
+	// -2 on timeout
+	long long PingArmDaemon(int timeoutMs)
+	{
+		return MeasureDaemonRoundTrip(timeoutMs);
+	}
+
+	int GetArmChannelStats(ArmChannelStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadArmChannelStats(*stats);
+		return 0;
+	}
+
+	// Teleop server sink: a pose goes into the target stream when it runs,
+	// otherwise it waits until the arm is done with the previous one.
+	static unsigned int teleopMoves[2] = { 0, 0 };
+
+	static bool TeleopPose(bool rightArm, long long timestamp, int flags, const float *pose)
+	{
+		bool noThetaY = (flags & TELEOP_POSE_NO_THETA_Y) != 0;
+		if (InterpolatorRunning() && !noThetaY)
+		{
+			PushTargetPose(rightArm, timestamp, pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
+			return true;
+		}
+		int arm = rightArm ? 1 : 0;
+		CommandCompletion completion;
+		if (teleopMoves[arm] != 0 && WaitForCompletion(teleopMoves[arm], 0, completion) == -1)
+		{
+			return false;
+		}
+		ArmCommand command = MakeCommand(noThetaY ? CMD_MOVE_HAND_NO_THETA_Y : CMD_MOVE_HAND, rightArm);
+		command.X = pose[0];
+		command.Y = pose[1];
+		command.Z = pose[2];
+		command.ThetaX = pose[3];
+		command.ThetaY = pose[4];
+		command.ThetaZ = pose[5];
+		command.CaptureTime = timestamp;
+		int id = Submit(command);
+		teleopMoves[arm] = id < 0 ? 0 : (unsigned int)id;
+		return true;
+	}
+
+	// a lost sample filled in fills a gap in the stream, a move that late is no use
+	static void TeleopRecovered(bool rightArm, long long timestamp, int flags, const float *pose)
+	{
+		if (InterpolatorRunning() && (flags & TELEOP_POSE_NO_THETA_Y) == 0)
+		{
+			PushTargetPose(rightArm, timestamp, pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
+		}
+	}
+
+	static void TeleopStop(bool rightArm)
+	{
+		ClearTargets(rightArm);
+		Submit(MakeCommand(CMD_STOP_ARM, rightArm));
+	}
+
+	static void TeleopHome(bool rightArm)
+	{
+		ClearTargets(rightArm);
+		Submit(MakeCommand(CMD_MOVE_HOME, rightArm));
+	}
+
+	static void TeleopFingers(bool rightArm, int fingers)
+	{
+		SubmitMoveFingers(rightArm, (fingers & TELEOP_FINGER_PINKY) != 0, (fingers & TELEOP_FINGER_RING) != 0,
+			(fingers & TELEOP_FINGER_MIDDLE) != 0, (fingers & TELEOP_FINGER_INDEX) != 0, (fingers & TELEOP_FINGER_THUMB) != 0);
+	}
+
+	// a new holder starts the stream over from its own samples, so the arm never
+	// heads for where the one before it was going
+	static void ArmLeaseChanged(bool rightArm, int)
+	{
+		ClearTargets(rightArm);
+	}
+
+	// Robot side of the native operator link, see TeleopServer.h. port 0 takes
+	// any free port (see the stats).
+	// returns:
+	// 0 - listening
+	// -1 - already running
+	// -2 - the port could not be opened
+	static TeleopSink BridgeSink()
+	{
+		SetArmLeaseListener(ArmLeaseChanged);
+		TeleopSink sink = { TeleopPose, TeleopRecovered, TeleopStop, TeleopHome, TeleopFingers };
+		teleopMoves[0] = 0;
+		teleopMoves[1] = 0;
+		return sink;
+	}
+
+	int StartTeleopServer(int port)
+	{
+		return OpenTeleopServer(port, BridgeSink());
+	}
+
+	int StopTeleopServer()
+	{
+		CloseTeleopServer();
+		return 0;
+	}
+
+	// The robot side fed from a capture instead of the network, to go through
+	// a session again offline; its poses go to the arms as the server's would.
+	// originalTiming spaces the datagrams as they came in, otherwise they go
+	// in as fast as the server takes them. The stats tell when it is done,
+	// StopTeleopServer ends it.
+	// returns:
+	// 0 - replaying
+	// -1 - the server is running
+	// -2 - the file is no capture
+	int StartTeleopReplay(const char *file, bool originalTiming)
+	{
+		return OpenTeleopReplay(file, originalTiming, BridgeSink());
+	}
+
+	// Writes everything the teleop server receives to file, see
+	// TeleopCapture.h.
+	// returns:
+	// 0 - capturing
+	// -1 - already capturing
+	// -2 - the file could not be created
+	int StartTeleopCapture(const char *file)
+	{
+		return OpenTeleopCapture(file);
+	}
+
+	int StopTeleopCapture()
+	{
+		CloseTeleopCapture();
+		return 0;
+	}
+
+	int GetTeleopServerStats(TeleopServerStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadTeleopServerStats(*stats);
+		return 0;
+	}
+
+	// Operator side, see TeleopClient.h.
+	// returns:
+	// 0 - ready
+	// -1 - the host does not resolve
+	// -2 - no socket
+	int ConnectTeleop(const char *host, int port)
+	{
+		return OpenTeleopClient(host, port);
+	}
+
+	int DisconnectTeleop()
+	{
+		CloseTeleopClient();
+		return 0;
+	}
+
+	// unreliable, the newest pose wins; 0 or -1 when not connected
+	int TeleopMoveArm(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+	{
+		float pose[6] = { x, y, z, thetaX, thetaY, thetaZ };
+		return SendTeleopPose(rightArm, 0, pose);
+	}
+
+	int TeleopMoveArmNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+	{
+		float pose[6] = { x, y, z, thetaX, 0.0f, thetaZ };
+		return SendTeleopPose(rightArm, TELEOP_POSE_NO_THETA_Y, pose);
+	}
+
+	// Both hands and their fingers in one compact frame (PoseCodec.h), contents
+	// is POSE_FRAME_* bits. Poses are x, y, z, thetaX, thetaY, thetaZ as in
+	// TeleopMoveArm, flags TELEOP_POSE_* for both; a hand without a pose is
+	// left out. Unreliable like TeleopMoveArm; 0 or -1 when not connected.
+	int TeleopMoveHands(int contents, const float *leftPose, const float *rightPose, int flags,
+		int leftFingers, int rightFingers)
+	{
+		PoseFrame frame;
+		memset(&frame, 0, sizeof(frame));
+		const float *poses[2] = { leftPose, rightPose };
+		int fingers[2] = { leftFingers, rightFingers };
+		for (int arm = 0; arm < 2; arm++)
+		{
+			if ((contents & (POSE_FRAME_LEFT << arm)) && poses[arm] != NULL)
+			{
+				const float *pose = poses[arm];
+				frame.Contents |= POSE_FRAME_LEFT << arm;
+				frame.Flags[arm] = flags;
+				frame.Hands[arm].Position = MakeVec3(pose[0], pose[1], pose[2]);
+				frame.Hands[arm].Orientation = FromKinovaEuler(pose[3], pose[4], pose[5]);
+			}
+			if (contents & (POSE_FRAME_LEFT_FINGERS << arm))
+			{
+				frame.Contents |= POSE_FRAME_LEFT_FINGERS << arm;
+				frame.Fingers[arm] = fingers[arm];
+			}
+		}
+		return SendTeleopFrame(frame);
+	}
+
+	// reliable, return the message's ID, -1 when not connected, -2 when too
+	// many wait for acknowledgement
+	int TeleopStopArm(bool rightArm)
+	{
+		return SendTeleopReliable(TELEOP_STOP, rightArm, 0);
+	}
+
+	int TeleopMoveArmHome(bool rightArm)
+	{
+		return SendTeleopReliable(TELEOP_HOME, rightArm, 0);
+	}
+
+	int TeleopMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb)
+	{
+		int fingers = (pinky ? TELEOP_FINGER_PINKY : 0) | (ring ? TELEOP_FINGER_RING : 0) |
+			(middle ? TELEOP_FINGER_MIDDLE : 0) | (index ? TELEOP_FINGER_INDEX : 0) | (thumb ? TELEOP_FINGER_THUMB : 0);
+		return SendTeleopReliable(TELEOP_FINGERS, rightArm, fingers);
+	}
+
+	// Redundancy for lossy links, see SetTeleopRedundancy in TeleopClient.h.
+	// Returns 0, or -1 when out of range.
+	int SetTeleopRedundancyMode(int frames, int parityGroup)
+	{
+		return SetTeleopRedundancy(frames, parityGroup);
+	}
+
+	// takes acknowledgements and repeats lost messages, call once a frame;
+	// returns how many wait for acknowledgement, -1 when not connected
+	int PollTeleop()
+	{
+		return PollTeleopClient();
+	}
+
+	int GetTeleopClientStats(TeleopClientStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadTeleopClientStats(*stats);
+		return 0;
+	}
+
+	// GetBridgeTime() of the robot's machine, to stamp what the operator
+	// captures; 0 until the link has synchronized the clocks
+	long long GetTeleopRobotTime()
+	{
+		return TeleopRobotTime();
+	}
+
+	// Local relay that loses, delays and jitters the operator link, see
+	// LossyLink.h. loss is a share (0 to 1), meanBurst the mean datagrams lost
+	// in a row. Connect the client to the relay's port (see the stats).
+	// returns:
+	// 0 - relaying
+	// -1 - already running
+	// -2 - the server does not resolve
+	// -3 - no socket
+	// -4 - out of range
+	int StartLossyLink(int port, const char *host, int serverPort, float loss, float meanBurst, int delayMicros,
+		int jitterMicros)
+	{
+		LossyLinkConfig config = { loss, meanBurst, delayMicros, jitterMicros };
+		return OpenLossyLink(port, host, serverPort, config);
+	}
+
+	int StopLossyLink()
+	{
+		CloseLossyLink();
+		return 0;
+	}
+
+	int GetLossyLinkStats(LossyLinkStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadLossyLinkStats(*stats);
+		return 0;
+	}
+
+	static atomic<bool> loadTestStop(false);
+
+	static BOOL WINAPI StopLoadTest(DWORD type)
+	{
+		loadTestStop = true;
+		return TRUE;
+	}
+
+	// Soak test of the operator link against a simulated arm, see LoadTest.h.
+	// It takes the teleop server and the command queue, so it runs in a process
+	// of its own with a console, until its time is up or Ctrl+C:
+	// %windir%\SysWOW64\rundll32.exe ARM_base_32.dll,LoadTestMain --operators 2 --seconds 3600
+#ifndef _WIN64
+#pragma comment(linker, "/EXPORT:LoadTestMain=_LoadTestMain@16")
+#endif
+	void __stdcall LoadTestMain(void *window, void *instance, char *commandLine, int show)
+	{
+		AllocConsole();
+		freopen("CONOUT$", "w", stdout);
+		SetConsoleCtrlHandler(StopLoadTest, TRUE);
+
+		LoadTestConfig config;
+		DefaultLoadTestConfig(config);
+		int result = -2;
+		if (ParseLoadTestArguments(commandLine, config))
+		{
+			FILE *out = config.OutFile[0] != 0 ? fopen(config.OutFile, "w") : stdout;
+			LoadTestReport report;
+			result = RunLoadTest(config, &loadTestStop, out != NULL ? out : stdout, report);
+			if (out != NULL && out != stdout)
+			{
+				WriteLoadTestReport(report, stdout);
+				fclose(out);
+			}
+		}
+		if (result != 0)
+		{
+			printf("load test failed (%d), options: --operators n --rate hz --motion circle|sweep|replay\n"
+				"--replay file --amplitude m --period s --loss share --burst n --delay us --jitter us\n"
+				"--arm us --arm-jitter us --seconds n --report n --out file\n", result);
+		}
+		printf("press a key to close\n");
+		_getch();
+	}
+
+	// Arm ownership among operator stations, see ArmLease.h. Teleop peers hold
+	// leases as TELEOP_LEASE_HOLDER_BASE on, the other holder IDs are free for
+	// the application's own clients. With required set an arm nobody leased
+	// takes no commands.
+	int SetArmLeasePolicy(bool required)
+	{
+		SetArmLeaseRequired(required);
+		return 0;
+	}
+
+	// returns:
+	// 0 - granted or renewed
+	// -1 - held by someone else at the same or a higher priority
+	// -2 - out of range
+	int RequestArmLease(bool rightArm, int holder, int priority, int durationMs)
+	{
+		SetArmLeaseListener(ArmLeaseChanged);
+		return AcquireArmLease(rightArm, holder, priority, (long long)durationMs * 1000, NowMicros());
+	}
+
+	// straight from one holder to the next; same returns, -1 when from does not
+	// hold the arm
+	int PassArmLease(bool rightArm, int from, int to, int priority, int durationMs)
+	{
+		SetArmLeaseListener(ArmLeaseChanged);
+		return HandOffArmLease(rightArm, from, to, priority, (long long)durationMs * 1000, NowMicros());
+	}
+
+	int ReturnArmLease(bool rightArm, int holder)
+	{
+		ReleaseArmLease(rightArm, holder);
+		return 0;
+	}
+
+	// 1 when the holder may command the arm now, 0 otherwise
+	int CanCommandArm(bool rightArm, int holder)
+	{
+		return ArmLeaseAllows(rightArm, holder, NowMicros()) ? 1 : 0;
+	}
+
+	int GetArmLease(bool rightArm, ArmLeaseInfo *info)
+	{
+		if (info == NULL)
+		{
+			return -1;
+		}
+		ReadArmLease(rightArm, NowMicros(), *info);
+		return 0;
+	}
+
+	int GetArmLeaseStats(ArmLeaseStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadArmLeaseStats(*stats);
+		return 0;
+	}
+
+	// Operator side: arms is 1 left, 2 right, 3 both, 0 releases them.
+	// Returns 0, or -1 when out of range.
+	int LeaseTeleopArms(int arms, int priority, int durationMs)
+	{
+		if (durationMs < 0 || durationMs > ARM_LEASE_MAX_MICROS / 1000)
+		{
+			return -1;
+		}
+		return SetTeleopLease(arms, priority, durationMs * 1000);
+	}
+
+	// Mocap straight from Motive, see NatNetClient.h. server is Motive's
+	// address (NULL to skip asking its version), localIp the interface the
+	// stream comes in on (NULL for any), receiveCpu the core to pin the receive
+	// thread to (-1 for none).
+	// returns:
+	// 0 - receiving
+	// -1 - already running
+	// -2 - an address does not resolve
+	// -3 - the stream could not be joined
+	int StartNatNet(const char *server, const char *localIp, int receiveCpu)
+	{
+		return OpenNatNetClient(server, localIp, receiveCpu);
+	}
+
+	int StopNatNet()
+	{
+		CloseNatNetClient();
+		return 0;
+	}
+
+	int GetNatNetStats(NatNetClientStats *stats)
+	{
+		if (stats == NULL)
+		{
+			return -1;
+		}
+		ReadNatNetClientStats(*stats);
+		return 0;
+	}
+
+	static NatNetSubscription natNetSubscription;
+	// chosen again only when the server's version changes
+	static int natNetVersion[4] = { -1, -1, -1, -1 };
+	static NatNetIndexer natNetIndexer;
+	static NatNetSelector natNetSelector;
+
+	// The rigid bodies and skeletons PollNatNet reads out of each frame, by
+	// Motive's IDs; everything else is skipped.
+	// returns:
+	// 0 - subscribed
+	// -1 - more than NATNET_MAX_SUBSCRIBED rigid bodies or
+	// NATNET_MAX_SUBSCRIBED_SKELETONS skeletons
+	int SubscribeNatNet(const int *rigidBodies, int rigidBodyCount, const int *skeletons, int skeletonCount)
+	{
+		if (rigidBodyCount < 0 || rigidBodyCount > NATNET_MAX_SUBSCRIBED || (rigidBodyCount > 0 && rigidBodies == NULL) ||
+			skeletonCount < 0 || skeletonCount > NATNET_MAX_SUBSCRIBED_SKELETONS || (skeletonCount > 0 && skeletons == NULL))
+		{
+			return -1;
+		}
+		natNetSubscription.RigidBodyCount = rigidBodyCount;
+		natNetSubscription.SkeletonCount = skeletonCount;
+		for (int i = 0; i < rigidBodyCount; i++)
+		{
+			natNetSubscription.RigidBodyId[i] = rigidBodies[i];
+		}
+		for (int i = 0; i < skeletonCount; i++)
+		{
+			natNetSubscription.SkeletonId[i] = skeletons[i];
+		}
+		return 0;
+	}
+
+	// Takes every frame that came in since the last poll and reads the
+	// subscribed rigid bodies and skeletons out of the newest into selection;
+	// the older ones are dropped unread. Call from the thread that subscribes.
+	// returns:
+	// >= 0 - frames taken, selection is only filled in when > 0
+	// -1 - selection is NULL
+	// -2 - the server's NatNet version is not understood
+	// -3 - the newest frame is malformed or has too many bones subscribed
+	int PollNatNet(NatNetSelection *selection)
+	{
+		if (selection == NULL)
+		{
+			return -1;
+		}
+		NatNetClientStats stats;
+		ReadNatNetClientStats(stats);
+		if (memcmp(stats.Version, natNetVersion, sizeof(natNetVersion)) != 0)
+		{
+			memcpy(natNetVersion, stats.Version, sizeof(natNetVersion));
+			natNetIndexer = SelectNatNetIndexer(natNetVersion);
+			natNetSelector = SelectNatNetSelector(natNetVersion);
+		}
+		if (natNetIndexer == NULL)
+		{
+			return -2;
+		}
+		int taken = 0;
+		for (; NatNetPacketsWaiting() > 1; taken++)
+		{
+			PopNatNetPacket();
+		}
+		const NatNetPacket *packet = PeekNatNetPacket();
+		if (packet == NULL)
+		{
+			return taken;
+		}
+		NatNetFrameIndex index;
+		int result = natNetIndexer(packet->Data, packet->Size, natNetSubscription, index);
+		if (result == 0)
+		{
+			result = natNetSelector(packet->Data, index, natNetSubscription, *selection);
+		}
+		PopNatNetPacket();
+		return result == 0 ? taken + 1 : -3;
+	}
 }
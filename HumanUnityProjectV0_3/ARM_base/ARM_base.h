@@ -2,6 +2,24 @@
 #define DllExport __declspec(dllexport)
 // https://docs.microsoft.com/en-us/cpp/build/exporting-from-a-dll-using-declspec-dllexport
 
+#include "ArmDaemon.h"
+#include "ArmLease.h"
+#include "Calibration.h"
+#include "CommandQueue.h"
+#include "DualArm.h"
+#include "ErrorLog.h"
+#include "Interpolator.h"
+#include "Latency.h"
+#include "LossyLink.h"
+#include "NatNetClient.h"
+#include "NatNetFrame.h"
+#include "Predictor.h"
+#include "Retarget.h"
+#include "StateCache.h"
+#include "TeleopClient.h"
+#include "TeleopServer.h"
+#include "Thermal.h"
+
 extern "C"
 {
   DllExport int TestFunction();
@@ -12,4 +30,125 @@ extern "C"
   DllExport int MoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
   DllExport int StopArm(bool rightArm);
   DllExport int CloseDevice(bool rightArm);
+
+  // Non-blocking versions of the calls above. Each returns the ID of the queued
+  // command (> 0) or -1 when the robot is not initialized; the outcome is
+  // reported later through PollCommandCompletions / WaitForCommand.
+  DllExport int SubmitMoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+  DllExport int SubmitMoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ);
+  DllExport int SubmitMoveArmHome(bool rightArm);
+  DllExport int SubmitMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
+  DllExport int SubmitStopArm(bool rightArm);
+  DllExport int PollCommandCompletions(CommandCompletion *completions, int maxCount);
+  DllExport int WaitForCommand(int commandId, int timeoutMs, CommandCompletion *completion);
+
+  // The arms' system error logs, see ErrorLog.h.
+  DllExport int SubmitClearErrorLog(bool rightArm);
+  DllExport int ReadSystemErrors(long long *cursor, SystemErrorEntry *entries, int maxCount);
+
+  // Native fixed rate target stream, see Interpolator.h. Timestamps are
+  // microseconds on the GetBridgeTime() clock, 0 means "now".
+  DllExport long long GetBridgeTime();
+  DllExport int StartTargetStream(int rateHz, int delayMs);
+  DllExport int StopTargetStream();
+  DllExport int PushTargetSample(bool rightArm, long long timestamp, float x, float y, float z, float qx, float qy, float qz, float qw);
+  DllExport int PushTargetPose(bool rightArm, long long timestamp, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+  DllExport int ClearTargetSamples(bool rightArm);
+  DllExport int GetTargetStreamStats(TargetStreamStats *stats);
+
+  // Latency compensation of the target stream, see Predictor.h and Latency.h.
+  DllExport int SetTargetPrediction(int model, float lead);
+  DllExport int GetPredictionStats(PredictorStats *stats);
+  DllExport int GetLatencyStats(int histogram, LatencyStats *stats);
+  DllExport int ResetLatencyStats(int histogram);
+
+  // Both arms of the target stream in lockstep, see DualArm.h.
+  DllExport int CoordinateArms(bool enabled, int constraint, float distance);
+  DllExport int SetRightArmBase(float x, float y, float z, float qx, float qy, float qz, float qw);
+  DllExport int DeriveRightArmBase(int source);
+  DllExport int GetDualArmStats(DualArmStats *stats);
+
+  // Controller to arm retargeting, see Retarget.h.
+  DllExport int MoveHandToController(bool rightArm, const ControllerPose *controller);
+  DllExport int PushControllerTargets(long long timestamp, const ControllerPose *controllers, int armMask);
+  DllExport int RetargetControllerPoses(const ControllerPose *controllers, int armMask, KinovaPose *poses);
+  DllExport int SetControllerFrame(bool rightArm, const RetargetFrame *frame);
+  DllExport int GetControllerFrame(bool rightArm, RetargetFrame *frame);
+
+  // Fitting the controller (or mocap) frame to the arm, see Calibration.h.
+  DllExport int AddCalibrationSample(bool rightArm, int source, const ControllerPose *pose);
+  DllExport int ClearCalibrationSamples(bool rightArm, int source);
+  DllExport int CalibrateArm(bool rightArm, int source, bool withScale, CalibrationResult *result);
+
+  // Cached arm state and smooth preset moves, see StateCache.h and Trajectory.h.
+  DllExport int GetArmState(bool rightArm, ArmState *state);
+  DllExport int GetArmEffort(bool rightArm, ArmEffort *effort);
+  DllExport int GetArmSensors(bool rightArm, ArmSensors *sensors);
+  DllExport int GetThermalStatus(bool rightArm, ThermalStatus *status);
+  DllExport int EnableThermalGovernor(bool enabled);
+  DllExport int SetTrajectoryLimits(const float *maxVelocity, const float *maxAcceleration);
+  DllExport int SetJointTrajectoryLimits(const float *maxVelocity, const float *maxAcceleration);
+  DllExport int MoveArmToPreset(bool rightArm, const char *preset);
+
+  // Obstacles for the preset roadmap, see Roadmap.h.
+  DllExport int AddObstacle(float x1, float y1, float z1, float x2, float y2, float z2, float radius);
+  DllExport int ClearObstacles();
+  DllExport int GetRoadmapStatus();
+
+  // The arms in a daemon process of their own, see ArmChannel.h.
+  DllExport int RunArmDaemon();
+  DllExport void __stdcall ArmDaemonMain(void *window, void *instance, char *commandLine, int show);
+  DllExport int ConnectArmDaemon();
+  DllExport int DisconnectArmDaemon();
+  DllExport int ShutdownArmDaemon();
+  DllExport int DaemonMoveHand(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+  DllExport int DaemonMoveHandNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ);
+  DllExport int DaemonMoveArmHome(bool rightArm);
+  DllExport int DaemonMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
+  DllExport int DaemonStopArm(bool rightArm);
+  DllExport int PollDaemonCompletions(CommandCompletion *completions, int maxCount);
+  DllExport int GetDaemonArmState(bool rightArm, ArmState *state);
+  DllExport long long PingArmDaemon(int timeoutMs);
+  DllExport int GetArmChannelStats(ArmChannelStats *stats);
+
+  // Native UDP operator link, see TeleopProtocol.h.
+  DllExport int StartTeleopServer(int port);
+  DllExport int StopTeleopServer();
+  DllExport int GetTeleopServerStats(TeleopServerStats *stats);
+  DllExport int StartTeleopReplay(const char *file, bool originalTiming);
+  DllExport int StartTeleopCapture(const char *file);
+  DllExport int StopTeleopCapture();
+  DllExport int ConnectTeleop(const char *host, int port);
+  DllExport int DisconnectTeleop();
+  DllExport int TeleopMoveArm(bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+  DllExport int TeleopMoveArmNoThetaY(bool rightArm, float x, float y, float z, float thetaX, float thetaZ);
+  DllExport int TeleopMoveHands(int contents, const float *leftPose, const float *rightPose, int flags, int leftFingers, int rightFingers);
+  DllExport int TeleopStopArm(bool rightArm);
+  DllExport int TeleopMoveArmHome(bool rightArm);
+  DllExport int TeleopMoveFingers(bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
+  DllExport int SetTeleopRedundancyMode(int frames, int parityGroup);
+  DllExport int PollTeleop();
+  DllExport int GetTeleopClientStats(TeleopClientStats *stats);
+  DllExport long long GetTeleopRobotTime();
+  DllExport int StartLossyLink(int port, const char *host, int serverPort, float loss, float meanBurst, int delayMicros, int jitterMicros);
+  DllExport int StopLossyLink();
+  DllExport int GetLossyLinkStats(LossyLinkStats *stats);
+  DllExport void __stdcall LoadTestMain(void *window, void *instance, char *commandLine, int show);
+  DllExport int LeaseTeleopArms(int arms, int priority, int durationMs);
+
+  // Arm ownership, see ArmLease.h.
+  DllExport int SetArmLeasePolicy(bool required);
+  DllExport int RequestArmLease(bool rightArm, int holder, int priority, int durationMs);
+  DllExport int PassArmLease(bool rightArm, int from, int to, int priority, int durationMs);
+  DllExport int ReturnArmLease(bool rightArm, int holder);
+  DllExport int CanCommandArm(bool rightArm, int holder);
+  DllExport int GetArmLease(bool rightArm, ArmLeaseInfo *info);
+  DllExport int GetArmLeaseStats(ArmLeaseStats *stats);
+
+  // Mocap from Motive, see NatNetClient.h.
+  DllExport int StartNatNet(const char *server, const char *localIp, int receiveCpu);
+  DllExport int StopNatNet();
+  DllExport int GetNatNetStats(NatNetClientStats *stats);
+  DllExport int SubscribeNatNet(const int *rigidBodies, int rigidBodyCount, const int *skeletons, int skeletonCount);
+  DllExport int PollNatNet(NatNetSelection *selection);
 }
@@ -0,0 +1,219 @@
+#include "ActuatorStream.h"
+#include "Timing.h"
+#include <cstring>
+
+// Weight of the newest round trip in the moving average.
+#define ROUND_TRIP_SMOOTHING 0.05
+
+static long long StreamNow(const ActuatorStream &stream)
+{
+	return stream.Ops.Clock ? stream.Ops.Clock() : NowMicros();
+}
+
+static int JointOf(const ActuatorStream &stream, unsigned char address)
+{
+	for (int i = 0; i < stream.JointCount; i++)
+	{
+		if (stream.Addresses[i] == address)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static const ActuatorRequest &Oldest(const ActuatorStream &stream)
+{
+	return stream.InFlight[stream.InFlightFirst];
+}
+
+static void PopOldest(ActuatorStream &stream)
+{
+	stream.InFlightFirst = (stream.InFlightFirst + 1) % ACTUATOR_STREAM_MAX_IN_FLIGHT;
+	stream.InFlightCount--;
+}
+
+static void PushRequest(ActuatorStream &stream, int joint, long long now)
+{
+	if (stream.InFlightCount == ACTUATOR_STREAM_MAX_IN_FLIGHT)
+	{
+		PopOldest(stream);
+		stream.Stats.Lost++;
+	}
+	ActuatorRequest &request = stream.InFlight[(stream.InFlightFirst + stream.InFlightCount) % ACTUATOR_STREAM_MAX_IN_FLIGHT];
+	request.SentAt = now;
+	request.Joint = joint;
+	stream.InFlightCount++;
+}
+
+// SEND_ALL_VALUES_2 and 3 follow SEND_ALL_VALUES_1 for the same request.
+static bool AnswersRequest(short command)
+{
+	return command != RS485_CMD_SEND_ALL_VALUES_2 && command != RS485_CMD_SEND_ALL_VALUES_3;
+}
+
+// Writes frames in transactions of RS485_CODEC_MAX_BATCH.
+static int WriteBatched(ActuatorStream &stream, const RS485Frame *frames, int count)
+{
+	long long now = StreamNow(stream);
+	for (int first = 0; first < count; first += RS485_CODEC_MAX_BATCH)
+	{
+		int batch = count - first < RS485_CODEC_MAX_BATCH ? count - first : RS485_CODEC_MAX_BATCH;
+		int sent = 0;
+		int result = stream.Ops.Write(frames + first, batch, sent);
+		stream.Stats.Transactions++;
+		stream.Stats.Messages += sent;
+		for (int i = first; i < first + sent; i++)
+		{
+			int joint = JointOf(stream, frames[i].DestinationAddress);
+			if (joint >= 0)
+			{
+				PushRequest(stream, joint, now);
+			}
+		}
+		if (result != 0)
+		{
+			stream.Stats.WriteErrors++;
+			return result;
+		}
+	}
+	return 0;
+}
+
+static void TakeReply(ActuatorStream &stream, const RS485Frame &frame, long long now)
+{
+	int joint = JointOf(stream, frame.SourceAddress);
+	if (joint < 0)
+	{
+		return;
+	}
+	stream.Stats.Replies++;
+	if (frame.Command == RS485_CMD_NACK)
+	{
+		stream.Stats.Nacks++;
+	}
+	else if (frame.Command == RS485_CMD_REPORT_ERROR)
+	{
+		stream.Stats.Faults++;
+	}
+	ReadRS485Feedback(frame, now, stream.Feedback[joint]);
+
+	if (!AnswersRequest(frame.Command))
+	{
+		return;
+	}
+	bool waiting = false;
+	for (int i = 0; i < stream.InFlightCount && !waiting; i++)
+	{
+		waiting = stream.InFlight[(stream.InFlightFirst + i) % ACTUATOR_STREAM_MAX_IN_FLIGHT].Joint == joint;
+	}
+	if (waiting)
+	{
+		while (Oldest(stream).Joint != joint)
+		{
+			PopOldest(stream);
+			stream.Stats.Lost++;
+		}
+		long long roundTrip = now - Oldest(stream).SentAt;
+		PopOldest(stream);
+		stream.Stats.LastRoundTrip = roundTrip;
+		if (roundTrip > stream.Stats.MaxRoundTrip)
+		{
+			stream.Stats.MaxRoundTrip = roundTrip;
+		}
+		stream.Stats.MeanRoundTrip = stream.Stats.MeanRoundTrip == 0.0 ? (double)roundTrip :
+			stream.Stats.MeanRoundTrip + ROUND_TRIP_SMOOTHING * (roundTrip - stream.Stats.MeanRoundTrip);
+	}
+}
+
+int PollActuatorStream(ActuatorStream &stream)
+{
+	RS485Frame frames[RS485_CODEC_MAX_BATCH * ACTUATOR_STREAM_MAX_JOINTS];
+	int wanted = sizeof(frames) / sizeof(frames[0]);
+	int received = wanted;
+	while (received == wanted)
+	{
+		int result = stream.Ops.Read(frames, wanted, received);
+		if (result != 0)
+		{
+			return result;
+		}
+		long long now = StreamNow(stream);
+		for (int i = 0; i < received; i++)
+		{
+			TakeReply(stream, frames[i], now);
+		}
+	}
+
+	long long now = StreamNow(stream);
+	while (stream.InFlightCount > 0 && now - Oldest(stream).SentAt > ACTUATOR_STREAM_TIMEOUT_MICROS)
+	{
+		PopOldest(stream);
+		stream.Stats.Lost++;
+	}
+	stream.Stats.Outstanding = stream.InFlightCount;
+	return 0;
+}
+
+static int SendToAll(ActuatorStream &stream, short command)
+{
+	RS485Frame frames[ACTUATOR_STREAM_MAX_JOINTS];
+	for (int i = 0; i < stream.JointCount; i++)
+	{
+		MakeRS485Message(frames[i], command, stream.Addresses[i]);
+	}
+	return WriteBatched(stream, frames, stream.JointCount);
+}
+
+int StartActuatorStream(ActuatorStream &stream, const RS485Ops &ops, const unsigned char *addresses, int count, bool allValues)
+{
+	if (count < 0 || count > ACTUATOR_STREAM_MAX_JOINTS)
+	{
+		return -1;
+	}
+	memset(&stream, 0, sizeof(stream));
+	stream.Ops = ops;
+	stream.JointCount = count;
+	stream.AllValues = allValues;
+	memcpy(stream.Addresses, addresses, count);
+
+	int result = SendToAll(stream, RS485_CMD_CLEAR_FAULT_FLAG);
+	if (result == 0)
+	{
+		result = SendToAll(stream, RS485_CMD_START_ASSERV);
+	}
+	return result;
+}
+
+int StreamJointPositions(ActuatorStream &stream, const float *degrees)
+{
+	RS485Frame frames[ACTUATOR_STREAM_MAX_JOINTS];
+	for (int i = 0; i < stream.JointCount; i++)
+	{
+		MakeRS485PositionCommand(frames[i], stream.Addresses[i], degrees[i], stream.AllValues);
+	}
+	stream.Stats.Cycles++;
+	int result = WriteBatched(stream, frames, stream.JointCount);
+	int polled = PollActuatorStream(stream);
+	return result != 0 ? result : polled;
+}
+
+int StreamJointFeedthrough(ActuatorStream &stream, const float *values)
+{
+	RS485Frame frames[ACTUATOR_STREAM_MAX_JOINTS];
+	for (int i = 0; i < stream.JointCount; i++)
+	{
+		MakeRS485Feedthrough(frames[i], stream.Addresses[i], values[i]);
+	}
+	stream.Stats.Cycles++;
+	int result = WriteBatched(stream, frames, stream.JointCount);
+	int polled = PollActuatorStream(stream);
+	return result != 0 ? result : polled;
+}
+
+int StopActuatorStream(ActuatorStream &stream)
+{
+	int result = SendToAll(stream, RS485_CMD_STOP_ASSERV);
+	int polled = PollActuatorStream(stream);
+	return result != 0 ? result : polled;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "RS485Codec.h"
+
+// Low level joint streaming straight to the actuators over RS-485, bypassing
+// the arm's own controller. Every cycle sends one position (or feedthrough)
+// message per joint, RS485_CODEC_MAX_BATCH messages per bus transaction, and
+// takes in whatever replies have arrived without waiting for the rest, so a
+// cycle costs about one transaction per three joints however slow the bus is.
+
+#define ACTUATOR_STREAM_MAX_JOINTS 8
+
+// Requests that can be waiting for their reply. The bus answers requests in
+// the order they went out, so a reply answers the oldest waiting request to its
+// joint and any request sent before that one has been lost. Requests waiting
+// longer than the timeout, or pushed out by newer ones, are lost too.
+#define ACTUATOR_STREAM_MAX_IN_FLIGHT 32
+#define ACTUATOR_STREAM_TIMEOUT_MICROS 100000
+
+// Bus side of the stream, OpenRS485_Write/OpenRS485_Read or the simulator
+// (SimulatedBus.h). Write and Read return 0 or an error code.
+struct RS485Ops
+{
+	int(*Write)(const RS485Frame *frames, int count, int &sent);
+	int(*Read)(RS485Frame *frames, int wanted, int &received);
+	// time source, NowMicros when null
+	long long(*Clock)();
+};
+
+struct ActuatorStreamStats
+{
+	unsigned long long Cycles;
+	unsigned long long Transactions;
+	unsigned long long Messages;
+	unsigned long long Replies;
+	unsigned long long Nacks;
+	unsigned long long Faults;
+	unsigned long long WriteErrors;
+	unsigned long long Lost;
+	// requests waiting for their reply
+	int Outstanding;
+	// microseconds from request to reply: last, moving average and worst
+	long long LastRoundTrip;
+	double MeanRoundTrip;
+	long long MaxRoundTrip;
+};
+
+struct ActuatorRequest
+{
+	long long SentAt;
+	int Joint;
+};
+
+struct ActuatorStream
+{
+	RS485Ops Ops;
+	int JointCount;
+	unsigned char Addresses[ACTUATOR_STREAM_MAX_JOINTS];
+	// position messages ask for SEND_ALL_VALUES_1..3 instead of SEND_POSITION_CURRENT
+	bool AllValues;
+	// requests waiting for their reply, oldest first, as a ring
+	ActuatorRequest InFlight[ACTUATOR_STREAM_MAX_IN_FLIGHT];
+	int InFlightFirst;
+	int InFlightCount;
+	ActuatorFeedback Feedback[ACTUATOR_STREAM_MAX_JOINTS];
+	ActuatorStreamStats Stats;
+};
+
+// Sets the stream up for count actuators (at most ACTUATOR_STREAM_MAX_JOINTS)
+// and starts their control, clearing faults first. Returns 0, -1 for a bad
+// count, or the bus error.
+int StartActuatorStream(ActuatorStream &stream, const RS485Ops &ops, const unsigned char *addresses, int count, bool allValues);
+
+// One cycle: a position in degrees, or a feedthrough value from -1 to 1, for
+// every joint, then PollActuatorStream. Returns 0 or the first bus error.
+int StreamJointPositions(ActuatorStream &stream, const float *degrees);
+int StreamJointFeedthrough(ActuatorStream &stream, const float *values);
+
+// Takes in the replies that have arrived. Returns 0 or the bus error.
+int PollActuatorStream(ActuatorStream &stream);
+
+// Stops the actuators' control. Returns 0 or the bus error.
+int StopActuatorStream(ActuatorStream &stream);
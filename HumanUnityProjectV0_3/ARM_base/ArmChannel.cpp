@@ -0,0 +1,232 @@
+#include "ArmChannel.h"
+#include "Timing.h"
+#include <cstring>
+#include <new>
+
+#include <Windows.h>
+
+using namespace std;
+
+static bool OpenEvents(ArmChannelHandle &handle)
+{
+	// auto-reset, so one signal wakes up one wait
+	handle.CommandEvent = CreateEventA(NULL, FALSE, FALSE, ARM_CHANNEL_COMMAND_EVENT);
+	handle.CompletionEvent = CreateEventA(NULL, FALSE, FALSE, ARM_CHANNEL_COMPLETION_EVENT);
+	return handle.CommandEvent != NULL && handle.CompletionEvent != NULL;
+}
+
+int CreateArmChannel(ArmChannelHandle &handle)
+{
+	memset(&handle, 0, sizeof(handle));
+	handle.Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(ArmChannel), ARM_CHANNEL_NAME);
+	if (handle.Mapping == NULL)
+	{
+		return -2;
+	}
+	// a client may still hold the mapping of an earlier daemon
+	bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+	handle.Channel = (ArmChannel *)MapViewOfFile(handle.Mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(ArmChannel));
+	if (handle.Channel == NULL || !OpenEvents(handle))
+	{
+		CloseArmChannel(handle);
+		return -2;
+	}
+
+	ArmChannel &channel = *handle.Channel;
+	bool compatible = existed && channel.Magic == ARM_CHANNEL_MAGIC && channel.Version == ARM_CHANNEL_VERSION;
+	if (compatible && DaemonAlive(channel, NowMicros()))
+	{
+		CloseArmChannel(handle);
+		return -1;
+	}
+	if (compatible)
+	{
+		// whatever the client sent to the dead daemon is stale by now
+		channel.CommandsRead = channel.CommandsWritten.load();
+		channel.PingReply = channel.PingRequest.load();
+		for (int i = 0; i < 2; i++)
+		{
+			// in case it died halfway through a state
+			new (&channel.Arms[i]) Snapshot<ArmState>();
+		}
+	}
+	else
+	{
+		// new mappings are zero filled, which is a valid empty channel
+		memset(handle.Channel, 0, sizeof(ArmChannel));
+		channel.Magic = ARM_CHANNEL_MAGIC;
+		channel.Version = ARM_CHANNEL_VERSION;
+	}
+	channel.ShutdownRequested = false;
+	channel.RobotStatus = ARM_CHANNEL_ROBOT_STARTING;
+	channel.DaemonProcess = GetCurrentProcessId();
+	channel.DaemonHeartbeat = NowMicros();
+	return 0;
+}
+
+int OpenArmChannel(ArmChannelHandle &handle)
+{
+	memset(&handle, 0, sizeof(handle));
+	handle.Mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, ARM_CHANNEL_NAME);
+	if (handle.Mapping == NULL)
+	{
+		return -1;
+	}
+	handle.Channel = (ArmChannel *)MapViewOfFile(handle.Mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(ArmChannel));
+	if (handle.Channel == NULL || !OpenEvents(handle))
+	{
+		CloseArmChannel(handle);
+		return -1;
+	}
+
+	ArmChannel &channel = *handle.Channel;
+	long long now = NowMicros();
+	int result = 0;
+	if (channel.Magic != ARM_CHANNEL_MAGIC || channel.Version != ARM_CHANNEL_VERSION)
+	{
+		result = -2;
+	}
+	else if (!DaemonAlive(channel, now))
+	{
+		result = -1;
+	}
+	else if (ClientAlive(channel, now) && channel.ClientProcess != GetCurrentProcessId())
+	{
+		result = -3;
+	}
+	if (result != 0)
+	{
+		CloseArmChannel(handle);
+		return result;
+	}
+
+	channel.ClientProcess = GetCurrentProcessId();
+	channel.ClientHeartbeat = now;
+	// completions of the previous client are of no use to this one
+	channel.CompletionsRead = channel.CompletionsWritten.load();
+	channel.ClientGeneration++;
+	return 0;
+}
+
+void CloseArmChannel(ArmChannelHandle &handle)
+{
+	if (handle.Channel != NULL)
+	{
+		UnmapViewOfFile(handle.Channel);
+	}
+	if (handle.Mapping != NULL)
+	{
+		CloseHandle(handle.Mapping);
+	}
+	if (handle.CommandEvent != NULL)
+	{
+		CloseHandle(handle.CommandEvent);
+	}
+	if (handle.CompletionEvent != NULL)
+	{
+		CloseHandle(handle.CompletionEvent);
+	}
+	memset(&handle, 0, sizeof(handle));
+}
+
+bool DaemonAlive(const ArmChannel &channel, long long now)
+{
+	return channel.DaemonProcess != 0 && now - channel.DaemonHeartbeat < ARM_CHANNEL_DAEMON_TIMEOUT_MICROS;
+}
+
+bool ClientAlive(const ArmChannel &channel, long long now)
+{
+	return channel.ClientProcess != 0 && now - channel.ClientHeartbeat < ARM_CHANNEL_CLIENT_TIMEOUT_MICROS;
+}
+
+ChannelCommand *ReserveChannelCommand(ArmChannel &channel)
+{
+	unsigned int written = channel.CommandsWritten.load(memory_order_relaxed);
+	if (written - channel.CommandsRead.load(memory_order_acquire) >= ARM_CHANNEL_COMMANDS)
+	{
+		return NULL;
+	}
+	return &channel.Commands[written % ARM_CHANNEL_COMMANDS];
+}
+
+void CommitChannelCommand(ArmChannel &channel)
+{
+	channel.CommandsWritten.fetch_add(1, memory_order_release);
+}
+
+void SignalChannelCommands(ArmChannelHandle &handle)
+{
+	SetEvent(handle.CommandEvent);
+}
+
+const ChannelCommand *PeekChannelCommand(ArmChannel &channel)
+{
+	unsigned int read = channel.CommandsRead.load(memory_order_relaxed);
+	if (read == channel.CommandsWritten.load(memory_order_acquire))
+	{
+		return NULL;
+	}
+	return &channel.Commands[read % ARM_CHANNEL_COMMANDS];
+}
+
+void ReleaseChannelCommand(ArmChannel &channel)
+{
+	channel.CommandsRead.fetch_add(1, memory_order_release);
+}
+
+bool PostChannelCompletion(ArmChannel &channel, const ChannelCompletion &completion)
+{
+	unsigned int written = channel.CompletionsWritten.load(memory_order_relaxed);
+	if (written - channel.CompletionsRead.load(memory_order_acquire) >= ARM_CHANNEL_COMPLETIONS)
+	{
+		channel.CompletionsDropped++;
+		return false;
+	}
+	channel.Completions[written % ARM_CHANNEL_COMPLETIONS] = completion;
+	channel.CompletionsWritten.store(written + 1, memory_order_release);
+	return true;
+}
+
+void SignalChannelCompletions(ArmChannelHandle &handle)
+{
+	SetEvent(handle.CompletionEvent);
+}
+
+int TakeChannelCompletions(ArmChannel &channel, ChannelCompletion *completions, int maxCount)
+{
+	unsigned int read = channel.CompletionsRead.load(memory_order_relaxed);
+	unsigned int available = channel.CompletionsWritten.load(memory_order_acquire) - read;
+	int count = 0;
+	while (count < maxCount && (unsigned int)count < available)
+	{
+		completions[count] = channel.Completions[(read + count) % ARM_CHANNEL_COMPLETIONS];
+		count++;
+	}
+	channel.CompletionsRead.store(read + count, memory_order_release);
+	return count;
+}
+
+void PublishChannelArmState(ArmChannel &channel, bool rightArm, const ArmState &state)
+{
+	channel.Arms[rightArm ? 1 : 0].Publish(state);
+}
+
+bool ReadChannelArmState(ArmChannel &channel, bool rightArm, ArmState &state)
+{
+	return channel.Arms[rightArm ? 1 : 0].Read(state);
+}
+
+static bool WaitForEvent(void *event, int timeoutMs)
+{
+	return WaitForSingleObject(event, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs) == WAIT_OBJECT_0;
+}
+
+bool WaitForChannelCommands(ArmChannelHandle &handle, int timeoutMs)
+{
+	return WaitForEvent(handle.CommandEvent, timeoutMs);
+}
+
+bool WaitForChannelCompletions(ArmChannelHandle &handle, int timeoutMs)
+{
+	return WaitForEvent(handle.CompletionEvent, timeoutMs);
+}
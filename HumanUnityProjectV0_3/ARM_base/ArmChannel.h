@@ -0,0 +1,159 @@
+#pragma once
+
+#include "CommandQueue.h"
+#include "Snapshot.h"
+#include "StateCache.h"
+#include <atomic>
+
+// Shared memory channel between an arm daemon and its client. The daemon is a
+// process of its own (see RunArmDaemon in ARM_base.cpp) that owns the Kinova
+// API, so a crash or reload of the client (Unity) leaves the arms and the API
+// untouched, and the daemon takes the next client that connects.
+//
+// The channel is one named file mapping holding fixed size records: a ring of
+// commands from the client, a ring of completions back, and the latest state of
+// each arm. Commands are written straight into their ring slot, nothing is
+// copied on the way. Both rings have a single producer and a single consumer
+// and only use atomic counters; a named auto-reset event per direction wakes up
+// the other side, so a command reaches the daemon within a few microseconds.
+// Times in the channel are NowMicros(), which is the same clock in every
+// process on the machine.
+//
+// Only one client at a time: a client whose heartbeat has stopped for
+// ARM_CHANNEL_CLIENT_TIMEOUT_MICROS is considered gone, the daemon stops both
+// arms and lets the next client in. A client in turn refuses to send commands
+// to a daemon whose heartbeat has stopped, so queued moves never run late.
+
+#define ARM_CHANNEL_NAME "Local\\ARM_base_channel"
+#define ARM_CHANNEL_COMMAND_EVENT "Local\\ARM_base_channel_commands"
+#define ARM_CHANNEL_COMPLETION_EVENT "Local\\ARM_base_channel_completions"
+
+#define ARM_CHANNEL_MAGIC 0x4d524141
+#define ARM_CHANNEL_VERSION 2
+
+// Ring sizes, powers of two so the counters may wrap.
+#define ARM_CHANNEL_COMMANDS 256
+#define ARM_CHANNEL_COMPLETIONS 256
+
+// Both sides beat every ARM_CHANNEL_HEARTBEAT_MICROS while they are up.
+#define ARM_CHANNEL_HEARTBEAT_MICROS 50000
+#define ARM_CHANNEL_CLIENT_TIMEOUT_MICROS 500000
+#define ARM_CHANNEL_DAEMON_TIMEOUT_MICROS 500000
+
+// RobotStatus while the daemon is still initializing the robot
+#define ARM_CHANNEL_ROBOT_STARTING 1
+
+// A command as the client wrote it. Tag is the client's ID for it, the daemon
+// hands it back in the completion in place of its own command ID.
+struct ChannelCommand
+{
+	unsigned int Tag;
+	long long ClientTime;
+	ArmCommand Command;
+};
+
+struct ChannelCompletion
+{
+	// when the client wrote the command and when the daemon took it
+	long long ClientTime;
+	long long ReceiveTime;
+	CommandCompletion Completion;
+};
+
+// The ring counters count records ever written and read. Each sits on a cache
+// line of its own so producer and consumer do not slow each other down.
+struct ArmChannel
+{
+	unsigned int Magic;
+	unsigned int Version;
+
+	// daemon side
+	std::atomic<unsigned int> DaemonProcess;
+	std::atomic<long long> DaemonHeartbeat;
+	// what InitRobot returned in the daemon, ARM_CHANNEL_ROBOT_STARTING before
+	std::atomic<int> RobotStatus;
+	std::atomic<bool> ShutdownRequested;
+
+	// client side, Generation counts the clients that ever connected
+	std::atomic<unsigned int> ClientProcess;
+	std::atomic<unsigned int> ClientGeneration;
+	std::atomic<long long> ClientHeartbeat;
+
+	// round trip probe: the client raises PingRequest, the daemon answers by
+	// copying it to PingReply
+	std::atomic<unsigned int> PingRequest;
+	std::atomic<unsigned int> PingReply;
+
+	// completions the daemon had to drop because the ring was full
+	std::atomic<unsigned int> CompletionsDropped;
+
+	alignas(64) std::atomic<unsigned int> CommandsWritten;
+	alignas(64) std::atomic<unsigned int> CommandsRead;
+	alignas(64) ChannelCommand Commands[ARM_CHANNEL_COMMANDS];
+
+	alignas(64) std::atomic<unsigned int> CompletionsWritten;
+	alignas(64) std::atomic<unsigned int> CompletionsRead;
+	alignas(64) ChannelCompletion Completions[ARM_CHANNEL_COMPLETIONS];
+
+	// zero filled is an empty snapshot
+	alignas(64) Snapshot<ArmState> Arms[2];
+};
+
+// Mapping and events of one end of the channel.
+struct ArmChannelHandle
+{
+	void *Mapping;
+	void *CommandEvent;
+	void *CompletionEvent;
+	ArmChannel *Channel;
+};
+
+// Daemon side. Creates the channel, or takes over the one a crashed daemon
+// left behind; commands still in it are discarded.
+// returns:
+// 0 - created
+// -1 - another daemon is alive
+// -2 - the shared memory or the events could not be created
+int CreateArmChannel(ArmChannelHandle &handle);
+
+// Client side.
+// returns:
+// 0 - connected
+// -1 - no daemon, or its heartbeat stopped
+// -2 - the channel belongs to another version of the bridge
+// -3 - another client is connected
+int OpenArmChannel(ArmChannelHandle &handle);
+
+void CloseArmChannel(ArmChannelHandle &handle);
+
+bool DaemonAlive(const ArmChannel &channel, long long now);
+bool ClientAlive(const ArmChannel &channel, long long now);
+
+// Client: the slot of the next command to fill in, NULL while the ring is
+// full. Nothing is sent before CommitChannelCommand, and the daemon is woken up
+// by SignalChannelCommands, once per batch.
+ChannelCommand *ReserveChannelCommand(ArmChannel &channel);
+void CommitChannelCommand(ArmChannel &channel);
+void SignalChannelCommands(ArmChannelHandle &handle);
+
+// Daemon: the oldest command not taken yet, NULL when there is none. It stays
+// valid until ReleaseChannelCommand.
+const ChannelCommand *PeekChannelCommand(ArmChannel &channel);
+void ReleaseChannelCommand(ArmChannel &channel);
+
+// Daemon: queues a completion, false (and counted) when the ring is full.
+// The client is woken up by SignalChannelCompletions, once per batch.
+bool PostChannelCompletion(ArmChannel &channel, const ChannelCompletion &completion);
+void SignalChannelCompletions(ArmChannelHandle &handle);
+
+// Client: takes up to maxCount completions, returns how many.
+int TakeChannelCompletions(ArmChannel &channel, ChannelCompletion *completions, int maxCount);
+
+void PublishChannelArmState(ArmChannel &channel, bool rightArm, const ArmState &state);
+// False when the daemon never published one.
+bool ReadChannelArmState(ArmChannel &channel, bool rightArm, ArmState &state);
+
+// Waits for the other side to signal, up to timeoutMs (-1 forever). Returns
+// false on timeout.
+bool WaitForChannelCommands(ArmChannelHandle &handle, int timeoutMs);
+bool WaitForChannelCompletions(ArmChannelHandle &handle, int timeoutMs);
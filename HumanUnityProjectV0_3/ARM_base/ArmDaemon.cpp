@@ -0,0 +1,362 @@
+#include "ArmDaemon.h"
+#include "Timing.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <Windows.h>
+#include "Lib_Examples\CommandLayer.h"
+
+using namespace std;
+
+// Weight of the newest sample in the moving averages.
+#define CHANNEL_SMOOTHING 0.05
+
+// Completions taken from the command queue at once.
+#define DAEMON_COMPLETION_BATCH 32
+
+// A command the daemon queued for the client, to find its tag again.
+struct ForwardedCommand
+{
+	unsigned int Id;
+	unsigned int Tag;
+	long long ClientTime;
+	long long ReceiveTime;
+};
+
+// daemon side
+static ForwardedCommand forwarded[COMPLETION_HISTORY_SIZE];
+
+// client side
+static mutex clientLock;
+static ArmChannelHandle client;
+static bool connected = false;
+static thread heartbeat;
+static atomic<bool> beating(false);
+static ArmChannelStats stats;
+
+static void Smooth(double &mean, long long sample)
+{
+	mean = mean == 0.0 ? (double)sample : mean + CHANNEL_SMOOTHING * (sample - mean);
+}
+
+static void PostForClient(ArmChannel &channel, const ForwardedCommand &command, const CommandCompletion &completion)
+{
+	ChannelCompletion result;
+	result.ClientTime = command.ClientTime;
+	result.ReceiveTime = command.ReceiveTime;
+	result.Completion = completion;
+	result.Completion.Id = command.Tag;
+	PostChannelCompletion(channel, result);
+}
+
+static void Forward(ArmChannel &channel, const ChannelCommand &command, long long now)
+{
+	ForwardedCommand entry;
+	entry.Tag = command.Tag;
+	entry.ClientTime = command.ClientTime;
+	entry.ReceiveTime = now;
+	entry.Id = SubmitCommand(command.Command);
+	if (entry.Id == 0)
+	{
+		CommandCompletion completion;
+		memset(&completion, 0, sizeof(completion));
+		completion.Result = ERROR_API_NOT_INITIALIZED;
+		completion.SubmitTime = now;
+		completion.StartTime = now;
+		completion.EndTime = now;
+		PostForClient(channel, entry, completion);
+		return;
+	}
+	forwarded[entry.Id % COMPLETION_HISTORY_SIZE] = entry;
+}
+
+// Returns true when something was posted.
+static bool ForwardCompletions(ArmChannel &channel)
+{
+	bool posted = false;
+	CommandCompletion completions[DAEMON_COMPLETION_BATCH];
+	int count;
+	while ((count = PollCompletions(completions, DAEMON_COMPLETION_BATCH)) > 0)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			// the daemon's own stops have no client to go to
+			const ForwardedCommand &command = forwarded[completions[i].Id % COMPLETION_HISTORY_SIZE];
+			if (command.Id == completions[i].Id)
+			{
+				PostForClient(channel, command, completions[i]);
+				posted = true;
+			}
+		}
+	}
+	return posted;
+}
+
+static void StopBothArms()
+{
+	ArmCommand command;
+	memset(&command, 0, sizeof(command));
+	command.Type = CMD_STOP_ARM;
+	command.RightArm = false;
+	SubmitCommand(command);
+	command.RightArm = true;
+	SubmitCommand(command);
+}
+
+int ServeArmChannel(int(*initRobot)(), int &robotStatus)
+{
+	robotStatus = ARM_CHANNEL_ROBOT_STARTING;
+	ArmChannelHandle handle;
+	int result = CreateArmChannel(handle);
+	if (result != 0)
+	{
+		return result;
+	}
+	ArmChannel &channel = *handle.Channel;
+	// the heartbeat must go on while the robot takes its time
+	thread starter([&] { channel.RobotStatus = initRobot(); });
+	memset(forwarded, 0, sizeof(forwarded));
+	long long stateTimes[2] = { 0, 0 };
+	// nobody to lose until a client shows up
+	bool clientLost = true;
+
+	// 1 ms waits instead of the default 15.6 ms
+	timeBeginPeriod(1);
+	while (!channel.ShutdownRequested)
+	{
+		WaitForChannelCommands(handle, ARM_DAEMON_POLL_MS);
+		long long now = NowMicros();
+		channel.DaemonHeartbeat = now;
+
+		bool signal = false;
+		unsigned int ping = channel.PingRequest;
+		if (ping != channel.PingReply)
+		{
+			channel.PingReply = ping;
+			signal = true;
+		}
+
+		const ChannelCommand *command;
+		while ((command = PeekChannelCommand(channel)) != NULL)
+		{
+			Forward(channel, *command, now);
+			ReleaseChannelCommand(channel);
+		}
+		signal = ForwardCompletions(channel) || signal;
+		if (signal)
+		{
+			SignalChannelCompletions(handle);
+		}
+
+		for (int arm = 0; arm < 2; arm++)
+		{
+			ArmState state;
+			if (ReadArmState(arm == 1, state) && state.Timestamp != stateTimes[arm])
+			{
+				PublishChannelArmState(channel, arm == 1, state);
+				stateTimes[arm] = state.Timestamp;
+			}
+		}
+
+		// dead man: the arms must not keep moving for a client that is gone
+		if (ClientAlive(channel, now))
+		{
+			clientLost = false;
+		}
+		else if (!clientLost)
+		{
+			clientLost = true;
+			StopBothArms();
+		}
+	}
+	timeEndPeriod(1);
+	starter.join();
+	robotStatus = channel.RobotStatus;
+
+	channel.DaemonProcess = 0;
+	CloseArmChannel(handle);
+	return 0;
+}
+
+static void Heartbeat(ArmChannel *channel)
+{
+	while (beating)
+	{
+		channel->ClientHeartbeat = NowMicros();
+		this_thread::sleep_for(chrono::microseconds(ARM_CHANNEL_HEARTBEAT_MICROS));
+	}
+}
+
+// Lock must be held.
+static void Disconnect()
+{
+	if (!connected)
+	{
+		return;
+	}
+	beating = false;
+	heartbeat.join();
+	// lets the next client in right away
+	client.Channel->ClientProcess = 0;
+	CloseArmChannel(client);
+	connected = false;
+}
+
+int ConnectToArmDaemon()
+{
+	lock_guard<mutex> lock(clientLock);
+	Disconnect();
+	int result = OpenArmChannel(client);
+	if (result != 0)
+	{
+		return result;
+	}
+	connected = true;
+	stats = ArmChannelStats();
+	beating = true;
+	heartbeat = thread(Heartbeat, client.Channel);
+	return 0;
+}
+
+void DisconnectFromArmDaemon()
+{
+	lock_guard<mutex> lock(clientLock);
+	Disconnect();
+}
+
+bool RequestDaemonShutdown()
+{
+	lock_guard<mutex> lock(clientLock);
+	if (!connected)
+	{
+		return false;
+	}
+	client.Channel->ShutdownRequested = true;
+	SignalChannelCommands(client);
+	Disconnect();
+	return true;
+}
+
+int SendDaemonCommand(const ArmCommand &command)
+{
+	lock_guard<mutex> lock(clientLock);
+	long long now = NowMicros();
+	if (!connected || !DaemonAlive(*client.Channel, now))
+	{
+		return -1;
+	}
+	ArmChannel &channel = *client.Channel;
+	ChannelCommand *slot = ReserveChannelCommand(channel);
+	if (slot == NULL)
+	{
+		stats.Refused++;
+		return -2;
+	}
+	// tags go on across clients, so a completion never matches a command it is not for
+	unsigned int tag = (channel.CommandsWritten.load() & 0x7fffffff) + 1;
+	slot->Tag = tag;
+	slot->ClientTime = now;
+	slot->Command = command;
+	slot->Command.SubmitTime = now;
+	CommitChannelCommand(channel);
+	SignalChannelCommands(client);
+	stats.Sent++;
+	return (int)tag;
+}
+
+int TakeDaemonCompletions(CommandCompletion *completions, int maxCount)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (!connected || completions == NULL)
+	{
+		return 0;
+	}
+	ChannelCompletion taken[DAEMON_COMPLETION_BATCH];
+	int total = 0;
+	while (total < maxCount)
+	{
+		int wanted = maxCount - total < DAEMON_COMPLETION_BATCH ? maxCount - total : DAEMON_COMPLETION_BATCH;
+		int count = TakeChannelCompletions(*client.Channel, taken, wanted);
+		for (int i = 0; i < count; i++)
+		{
+			long long latency = taken[i].ReceiveTime - taken[i].ClientTime;
+			Smooth(stats.MeanCommandLatency, latency);
+			if (latency > stats.MaxCommandLatency)
+			{
+				stats.MaxCommandLatency = latency;
+			}
+			completions[total++] = taken[i].Completion;
+		}
+		stats.Completed += count;
+		if (count < wanted)
+		{
+			break;
+		}
+	}
+	return total;
+}
+
+int ReadDaemonArmState(bool rightArm, ArmState &state)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (!connected)
+	{
+		return -1;
+	}
+	return ReadChannelArmState(*client.Channel, rightArm, state) ? 0 : -2;
+}
+
+long long MeasureDaemonRoundTrip(int timeoutMs)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (!connected)
+	{
+		return -1;
+	}
+	ArmChannel &channel = *client.Channel;
+	long long start = NowMicros();
+	long long deadline = start + (long long)timeoutMs * 1000;
+	unsigned int request = channel.PingRequest + 1;
+	channel.PingRequest = request;
+	SignalChannelCommands(client);
+	while (channel.PingReply != request)
+	{
+		long long left = deadline - NowMicros();
+		if (left <= 0)
+		{
+			return -2;
+		}
+		// completions wake this up too, so check again either way
+		WaitForChannelCompletions(client, (int)((left + 999) / 1000));
+	}
+	long long roundTrip = NowMicros() - start;
+	stats.LastRoundTrip = roundTrip;
+	Smooth(stats.MeanRoundTrip, roundTrip);
+	if (stats.MinRoundTrip == 0 || roundTrip < stats.MinRoundTrip)
+	{
+		stats.MinRoundTrip = roundTrip;
+	}
+	if (roundTrip > stats.MaxRoundTrip)
+	{
+		stats.MaxRoundTrip = roundTrip;
+	}
+	return roundTrip;
+}
+
+void ReadArmChannelStats(ArmChannelStats &result)
+{
+	lock_guard<mutex> lock(clientLock);
+	result = stats;
+	result.Connected = connected ? 1 : 0;
+	if (connected)
+	{
+		const ArmChannel &channel = *client.Channel;
+		result.RobotStatus = channel.RobotStatus;
+		result.ClientGeneration = channel.ClientGeneration;
+		result.DaemonAge = NowMicros() - channel.DaemonHeartbeat;
+		result.CompletionsDropped = channel.CompletionsDropped;
+	}
+}
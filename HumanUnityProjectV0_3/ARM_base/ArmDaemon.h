@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ArmChannel.h"
+
+// Both ends of the arm daemon (see ArmChannel.h). The daemon forwards the
+// client's commands to its command queue and sends back their completions,
+// tagged with the client's ID, and the arm states its worker reads. The client
+// side replaces the Submit* calls and GetArmState for a process that does not
+// load the Kinova API itself.
+
+// How long the daemon waits for a command before it looks at completions and
+// states again.
+#define ARM_DAEMON_POLL_MS 1
+
+// Mirrored by KinovaAPI.ArmChannelStats, keep them in sync.
+struct ArmChannelStats
+{
+	int Connected;
+	// InitRobot's result in the daemon, ARM_CHANNEL_ROBOT_STARTING before
+	int RobotStatus;
+	unsigned int ClientGeneration;
+	// since the daemon's last heartbeat, microseconds
+	long long DaemonAge;
+	unsigned int Sent;
+	unsigned int Completed;
+	// commands refused because the ring was full, and completions the daemon
+	// dropped because this client did not take them
+	unsigned int Refused;
+	unsigned int CompletionsDropped;
+	// client write to daemon take of a command: moving average and worst, microseconds
+	double MeanCommandLatency;
+	long long MaxCommandLatency;
+	// PingArmDaemon round trips, microseconds
+	long long LastRoundTrip;
+	double MeanRoundTrip;
+	long long MinRoundTrip;
+	long long MaxRoundTrip;
+};
+
+// Daemon: serves the channel until a client asks for a shutdown. The robot is
+// initialized with initRobot (InitRobot) on a thread of its own once the
+// channel is taken, so a second daemon never touches the arms, and clients get
+// ERROR_API_NOT_INITIALIZED for their commands until it is done. robotStatus is
+// what initRobot returned. Returns 0 or CreateArmChannel's error.
+int ServeArmChannel(int(*initRobot)(), int &robotStatus);
+
+// Client: see OpenArmChannel for the result. Connecting again from the same
+// process (a Unity domain reload) is fine. Until DisconnectFromArmDaemon a
+// thread keeps the client's heartbeat going, so the daemon stops the arms when
+// the client process dies or disconnects, not when it merely stalls.
+int ConnectToArmDaemon();
+void DisconnectFromArmDaemon();
+bool RequestDaemonShutdown();
+
+// Client: sends a command, returns its tag (> 0), -1 when not connected or the
+// daemon is gone, -2 when the ring is full.
+int SendDaemonCommand(const ArmCommand &command);
+
+// Client: completions of the commands sent, their Id is the tag.
+int TakeDaemonCompletions(CommandCompletion *completions, int maxCount);
+
+// Client: -1 when not connected, -2 when the daemon has no state of the arm.
+int ReadDaemonArmState(bool rightArm, ArmState &state);
+
+// Client: round trip of an empty request through the channel, microseconds,
+// -1 when not connected, -2 on timeout.
+long long MeasureDaemonRoundTrip(int timeoutMs);
+
+void ReadArmChannelStats(ArmChannelStats &stats);
@@ -0,0 +1,206 @@
+#include "ArmLease.h"
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+// A lease word: expiry in the low 48 bits, then 12 bits holder, 4 bits
+// priority. 0 is no lease.
+#define EXPIRY_BITS 48
+#define EXPIRY_MASK ((1ULL << EXPIRY_BITS) - 1)
+
+typedef unsigned long long LeaseWord;
+
+static atomic<LeaseWord> leases[2];
+static atomic<bool> required(false);
+static ArmLeaseListener leaseListener = NULL;
+
+// Counted without a lock, as the hot path counts too.
+static atomic<unsigned int> granted(0);
+static atomic<unsigned int> preempted(0);
+static atomic<unsigned int> handedOff(0);
+static atomic<unsigned int> renewed(0);
+static atomic<unsigned int> released(0);
+static atomic<unsigned int> refused(0);
+static atomic<unsigned int> commandsRefused(0);
+
+static LeaseWord MakeLease(int holder, int priority, long long expiry)
+{
+	return ((LeaseWord)priority << (EXPIRY_BITS + 12)) | ((LeaseWord)holder << EXPIRY_BITS) |
+		((LeaseWord)expiry & EXPIRY_MASK);
+}
+
+static int LeaseHolder(LeaseWord lease)
+{
+	return (int)((lease >> EXPIRY_BITS) & ARM_LEASE_MAX_HOLDER);
+}
+
+static int LeasePriority(LeaseWord lease)
+{
+	return (int)(lease >> (EXPIRY_BITS + 12));
+}
+
+static long long LeaseExpiry(LeaseWord lease)
+{
+	return (long long)(lease & EXPIRY_MASK);
+}
+
+// The holder of a lease that has not run out, 0 for none.
+static int LiveHolder(LeaseWord lease, long long now)
+{
+	return LeaseExpiry(lease) > now ? LeaseHolder(lease) : 0;
+}
+
+static bool ValidRequest(int holder, int priority, long long durationMicros)
+{
+	return holder > 0 && holder <= ARM_LEASE_MAX_HOLDER && priority >= 0 && priority <= ARM_LEASE_MAX_PRIORITY &&
+		durationMicros > 0 && durationMicros <= ARM_LEASE_MAX_MICROS;
+}
+
+static void Notify(bool rightArm, int holder)
+{
+	ArmLeaseListener listener = leaseListener;
+	if (listener != NULL)
+	{
+		listener(rightArm, holder);
+	}
+}
+
+void SetArmLeaseListener(ArmLeaseListener listener)
+{
+	leaseListener = listener;
+}
+
+void SetArmLeaseRequired(bool value)
+{
+	required = value;
+}
+
+void ResetArmLeases()
+{
+	leases[0] = 0;
+	leases[1] = 0;
+	granted = 0;
+	preempted = 0;
+	handedOff = 0;
+	renewed = 0;
+	released = 0;
+	refused = 0;
+	commandsRefused = 0;
+}
+
+int AcquireArmLease(bool rightArm, int holder, int priority, long long durationMicros, long long now)
+{
+	if (!ValidRequest(holder, priority, durationMicros))
+	{
+		return -2;
+	}
+	atomic<LeaseWord> &lease = leases[rightArm ? 1 : 0];
+	LeaseWord current = lease.load();
+	LeaseWord next = MakeLease(holder, priority, now + durationMicros);
+	int previous;
+	do
+	{
+		previous = LiveHolder(current, now);
+		if (previous != 0 && previous != holder && LeasePriority(current) >= priority)
+		{
+			refused++;
+			return -1;
+		}
+	} while (!lease.compare_exchange_weak(current, next));
+
+	if (previous == holder)
+	{
+		renewed++;
+		return 0;
+	}
+	if (previous == 0)
+	{
+		granted++;
+	}
+	else
+	{
+		preempted++;
+	}
+	Notify(rightArm, holder);
+	return 0;
+}
+
+int HandOffArmLease(bool rightArm, int from, int to, int priority, long long durationMicros, long long now)
+{
+	if (!ValidRequest(to, priority, durationMicros))
+	{
+		return -2;
+	}
+	atomic<LeaseWord> &lease = leases[rightArm ? 1 : 0];
+	LeaseWord current = lease.load();
+	LeaseWord next = MakeLease(to, priority, now + durationMicros);
+	do
+	{
+		if (from == 0 || LiveHolder(current, now) != from)
+		{
+			refused++;
+			return -1;
+		}
+	} while (!lease.compare_exchange_weak(current, next));
+
+	handedOff++;
+	if (to != from)
+	{
+		Notify(rightArm, to);
+	}
+	return 0;
+}
+
+void ReleaseArmLease(bool rightArm, int holder)
+{
+	atomic<LeaseWord> &lease = leases[rightArm ? 1 : 0];
+	LeaseWord current = lease.load();
+	do
+	{
+		if (holder == 0 || LeaseHolder(current) != holder)
+		{
+			return;
+		}
+	} while (!lease.compare_exchange_weak(current, 0));
+
+	released++;
+	Notify(rightArm, 0);
+}
+
+void ReleaseArmLeases(int holder)
+{
+	ReleaseArmLease(false, holder);
+	ReleaseArmLease(true, holder);
+}
+
+bool ArmLeaseAllows(bool rightArm, int holder, long long now)
+{
+	int current = LiveHolder(leases[rightArm ? 1 : 0].load(memory_order_acquire), now);
+	if (current == 0 ? !required.load(memory_order_relaxed) : current == holder)
+	{
+		return true;
+	}
+	commandsRefused.fetch_add(1, memory_order_relaxed);
+	return false;
+}
+
+void ReadArmLease(bool rightArm, long long now, ArmLeaseInfo &info)
+{
+	LeaseWord lease = leases[rightArm ? 1 : 0].load();
+	info.Holder = LiveHolder(lease, now);
+	info.Priority = info.Holder != 0 ? LeasePriority(lease) : 0;
+	info.Expiry = info.Holder != 0 ? LeaseExpiry(lease) : 0;
+}
+
+void ReadArmLeaseStats(ArmLeaseStats &stats)
+{
+	stats.Required = required ? 1 : 0;
+	stats.Granted = granted;
+	stats.Preempted = preempted;
+	stats.HandedOff = handedOff;
+	stats.Renewed = renewed;
+	stats.Released = released;
+	stats.Refused = refused;
+	stats.CommandsRefused = commandsRefused;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Ownership of the arms among several operator stations. An operator (a
+// holder, an ID from 1 to ARM_LEASE_MAX_HOLDER its transport assigns) leases
+// an arm for a while and renews the lease before it runs out; while it lasts
+// only the holder's commands reach the arm. A request of higher priority
+// takes the arm over at once, one of the same or a lower priority is refused
+// until the holder releases the arm or lets the lease run out.
+//
+// With leases required nobody commands an arm without a lease, so an
+// operator that never asks for one is an observer: it still gets the state
+// feedback but moves nothing. Otherwise an arm nobody leased is open to all,
+// as it was before leases.
+//
+// Each arm's lease is a single atomic word (holder, priority, expiry): a
+// command is checked with one load and leases change by compare and swap, no
+// locks anywhere. A handoff or preemption holds for the very next command.
+
+#define ARM_LEASE_MAX_HOLDER 4095
+#define ARM_LEASE_MAX_PRIORITY 15
+
+// Longest lease granted at once, microseconds.
+#define ARM_LEASE_MAX_MICROS 60000000
+
+// Mirrored by KinovaAPI.ArmLeaseInfo, keep them in sync.
+struct ArmLeaseInfo
+{
+	// 0 when nobody holds the arm
+	int Holder;
+	int Priority;
+	// NowMicros() when the lease runs out
+	long long Expiry;
+};
+
+// Mirrored by KinovaAPI.ArmLeaseStats, keep them in sync.
+struct ArmLeaseStats
+{
+	int Required;
+	// leases of an arm nobody held, taken over from a lower priority, handed
+	// on by the holder, and renewed by it
+	unsigned int Granted;
+	unsigned int Preempted;
+	unsigned int HandedOff;
+	unsigned int Renewed;
+	unsigned int Released;
+	// requests refused because someone else holds the arm
+	unsigned int Refused;
+	// commands kept from the arms
+	unsigned int CommandsRefused;
+};
+
+// Called from the thread that changed who holds an arm, with the new holder or
+// 0. A lease running out is nobody's doing and calls nothing.
+typedef void(*ArmLeaseListener)(bool rightArm, int holder);
+
+void SetArmLeaseListener(ArmLeaseListener listener);
+void SetArmLeaseRequired(bool required);
+
+// Forgets every lease and the stats.
+void ResetArmLeases();
+
+// returns:
+// 0 - the holder has the arm until now + durationMicros
+// -1 - another holder has it at the same or a higher priority
+// -2 - holder, priority or duration out of range
+int AcquireArmLease(bool rightArm, int holder, int priority, long long durationMicros, long long now);
+
+// The arm goes from one holder straight to the next, with no moment for a
+// third to take it in between. Same returns, -1 when from does not hold it.
+int HandOffArmLease(bool rightArm, int from, int to, int priority, long long durationMicros, long long now);
+
+// Nothing happens unless holder holds the arm.
+void ReleaseArmLease(bool rightArm, int holder);
+void ReleaseArmLeases(int holder);
+
+// Whether holder may command the arm now. Counts the commands it refuses.
+bool ArmLeaseAllows(bool rightArm, int holder, long long now);
+
+// Holder 0 when the arm is free, also when its lease ran out.
+void ReadArmLease(bool rightArm, long long now, ArmLeaseInfo &info);
+void ReadArmLeaseStats(ArmLeaseStats &stats);
@@ -0,0 +1,509 @@
+#include "Calibration.h"
+#include "StateCache.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define CALIBRATION_MAX_ITERATIONS 5
+// residuals over this many robust standard deviations are outliers
+#define CALIBRATION_OUTLIER_SIGMAS 3.0f
+
+struct CalibrationSample
+{
+	Pose Tracked;
+	Pose Robot;
+};
+
+struct CalibrationSet
+{
+	vector<CalibrationSample> Samples;
+	bool Solved;
+	RetargetFrame Frame;
+};
+
+static mutex calibrationLock;
+static CalibrationSet sets[2][CALIBRATION_SOURCE_COUNT];
+
+static const char *sourceNames[CALIBRATION_SOURCE_COUNT] = { "controller", "rigidbody" };
+
+static bool ValidSource(int source)
+{
+	return source >= 0 && source < CALIBRATION_SOURCE_COUNT;
+}
+
+// Into the right handed frame the retargeting stage works in.
+static Pose TrackedPose(int source, const ControllerPose &pose)
+{
+	Pose tracked;
+	tracked.Position = pose.Position;
+	tracked.Orientation = Normalize(pose.Orientation);
+	if (source == CALIBRATION_CONTROLLER)
+	{
+		tracked.Position.Z = -pose.Position.Z;
+		tracked.Orientation = MirrorZ(tracked.Orientation);
+	}
+	return tracked;
+}
+
+bool RecordCalibrationSample(bool rightArm, int source, const ControllerPose &pose)
+{
+	ArmState state;
+	if (!ValidSource(source) || !ReadArmState(rightArm, state) || NowMicros() - state.Timestamp > CALIBRATION_MAX_STATE_AGE_MICROS)
+	{
+		return false;
+	}
+
+	CalibrationSample sample;
+	sample.Tracked = TrackedPose(source, pose);
+	sample.Robot.Position = MakeVec3(state.X, state.Y, state.Z);
+	sample.Robot.Orientation = FromKinovaEuler(state.ThetaX, state.ThetaY, state.ThetaZ);
+
+	lock_guard<mutex> lock(calibrationLock);
+	CalibrationSet &set = sets[rightArm ? 1 : 0][source];
+	if (set.Samples.size() >= CALIBRATION_MAX_SAMPLES)
+	{
+		return false;
+	}
+	set.Samples.push_back(sample);
+	return true;
+}
+
+void ClearCalibration(bool rightArm, int source)
+{
+	if (!ValidSource(source))
+	{
+		return;
+	}
+	lock_guard<mutex> lock(calibrationLock);
+	sets[rightArm ? 1 : 0][source].Samples.clear();
+}
+
+int CalibrationSampleCount(bool rightArm, int source)
+{
+	if (!ValidSource(source))
+	{
+		return 0;
+	}
+	lock_guard<mutex> lock(calibrationLock);
+	return (int)sets[rightArm ? 1 : 0][source].Samples.size();
+}
+
+// Eigenvector of the largest eigenvalue of a symmetric 4x4 matrix, cyclic Jacobi.
+static void LargestEigenvector(double m[4][4], double vector[4])
+{
+	double v[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+	for (int sweep = 0; sweep < 50; sweep++)
+	{
+		double off = 0.0;
+		for (int p = 0; p < 4; p++)
+		{
+			for (int q = p + 1; q < 4; q++)
+			{
+				off += m[p][q] * m[p][q];
+			}
+		}
+		if (off < 1e-20)
+		{
+			break;
+		}
+
+		for (int p = 0; p < 4; p++)
+		{
+			for (int q = p + 1; q < 4; q++)
+			{
+				if (fabs(m[p][q]) < 1e-30)
+				{
+					continue;
+				}
+				double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0);
+				double s = t * c;
+				for (int k = 0; k < 4; k++)
+				{
+					double mkp = m[k][p];
+					double mkq = m[k][q];
+					m[k][p] = c * mkp - s * mkq;
+					m[k][q] = s * mkp + c * mkq;
+				}
+				for (int k = 0; k < 4; k++)
+				{
+					double mpk = m[p][k];
+					double mqk = m[q][k];
+					m[p][k] = c * mpk - s * mqk;
+					m[q][k] = s * mpk + c * mqk;
+				}
+				for (int k = 0; k < 4; k++)
+				{
+					double vkp = v[k][p];
+					double vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	int best = 0;
+	for (int i = 1; i < 4; i++)
+	{
+		if (m[i][i] > m[best][best])
+		{
+			best = i;
+		}
+	}
+	for (int k = 0; k < 4; k++)
+	{
+		vector[k] = v[k][best];
+	}
+}
+
+// The rotation about the line through collinear samples is free.
+static bool SpansPlane(const vector<CalibrationSample> &samples, const vector<char> &used)
+{
+	const Vec3 *first = 0;
+	Vec3 direction = MakeVec3(0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (!used[i])
+		{
+			continue;
+		}
+		if (first == 0)
+		{
+			first = &samples[i].Tracked.Position;
+			continue;
+		}
+		Vec3 d = Sub(samples[i].Tracked.Position, *first);
+		if (Length(d) > Length(direction))
+		{
+			direction = d;
+		}
+	}
+	float length = Length(direction);
+	if (length < CALIBRATION_MIN_OUTLIER_ERROR)
+	{
+		return false;
+	}
+	direction = Scale(direction, 1.0f / length);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (used[i] && Length(Cross(direction, Sub(samples[i].Tracked.Position, *first))) >= CALIBRATION_MIN_OUTLIER_ERROR)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Horn (1987): rotation, translation and scale taking the tracked positions of
+// the used samples onto the robot positions. False for degenerate sets.
+static bool FitTransform(const vector<CalibrationSample> &samples, const vector<char> &used, bool withScale,
+	RetargetFrame &frame)
+{
+	double trackedMean[3] = { 0, 0, 0 };
+	double robotMean[3] = { 0, 0, 0 };
+	int count = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (!used[i])
+		{
+			continue;
+		}
+		const Vec3 &a = samples[i].Tracked.Position;
+		const Vec3 &b = samples[i].Robot.Position;
+		trackedMean[0] += a.X; trackedMean[1] += a.Y; trackedMean[2] += a.Z;
+		robotMean[0] += b.X; robotMean[1] += b.Y; robotMean[2] += b.Z;
+		count++;
+	}
+	if (count < 3)
+	{
+		return false;
+	}
+	for (int k = 0; k < 3; k++)
+	{
+		trackedMean[k] /= count;
+		robotMean[k] /= count;
+	}
+
+	// cross covariance of the centered point sets
+	double s[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+	double trackedSpread = 0.0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (!used[i])
+		{
+			continue;
+		}
+		double a[3] = { samples[i].Tracked.Position.X - trackedMean[0], samples[i].Tracked.Position.Y - trackedMean[1], samples[i].Tracked.Position.Z - trackedMean[2] };
+		double b[3] = { samples[i].Robot.Position.X - robotMean[0], samples[i].Robot.Position.Y - robotMean[1], samples[i].Robot.Position.Z - robotMean[2] };
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				s[r][c] += a[r] * b[c];
+			}
+			trackedSpread += a[r] * a[r];
+		}
+	}
+	if (trackedSpread < 1e-8 || !SpansPlane(samples, used))
+	{
+		return false;
+	}
+
+	double n[4][4] =
+	{
+		{ s[0][0] + s[1][1] + s[2][2], s[1][2] - s[2][1], s[2][0] - s[0][2], s[0][1] - s[1][0] },
+		{ s[1][2] - s[2][1], s[0][0] - s[1][1] - s[2][2], s[0][1] + s[1][0], s[2][0] + s[0][2] },
+		{ s[2][0] - s[0][2], s[0][1] + s[1][0], -s[0][0] + s[1][1] - s[2][2], s[1][2] + s[2][1] },
+		{ s[0][1] - s[1][0], s[2][0] + s[0][2], s[1][2] + s[2][1], -s[0][0] - s[1][1] + s[2][2] },
+	};
+	double q[4];
+	LargestEigenvector(n, q);
+	// Horn's eigenvector is (w, x, y, z)
+	frame.Rotation = Normalize(MakeQuat((float)q[1], (float)q[2], (float)q[3], (float)q[0]));
+
+	frame.Scale = 1.0f;
+	if (withScale)
+	{
+		double projected = 0.0;
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			if (!used[i])
+			{
+				continue;
+			}
+			Vec3 a = Sub(samples[i].Tracked.Position, MakeVec3((float)trackedMean[0], (float)trackedMean[1], (float)trackedMean[2]));
+			Vec3 b = Sub(samples[i].Robot.Position, MakeVec3((float)robotMean[0], (float)robotMean[1], (float)robotMean[2]));
+			projected += Dot(b, Rotate(frame.Rotation, a));
+		}
+		frame.Scale = (float)(projected / trackedSpread);
+		if (frame.Scale <= 0.0f)
+		{
+			return false;
+		}
+	}
+
+	Vec3 rotatedMean = Rotate(frame.Rotation, MakeVec3((float)trackedMean[0], (float)trackedMean[1], (float)trackedMean[2]));
+	frame.Translation = Sub(MakeVec3((float)robotMean[0], (float)robotMean[1], (float)robotMean[2]), Scale(rotatedMean, frame.Scale));
+
+	// hand offset: average of conj(R q_tracked) q_robot (Markley's quaternion mean)
+	double m[4][4] = { { 0 } };
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (!used[i])
+		{
+			continue;
+		}
+		Quat offset = Multiply(Conjugate(Multiply(frame.Rotation, samples[i].Tracked.Orientation)), samples[i].Robot.Orientation);
+		double o[4] = { offset.X, offset.Y, offset.Z, offset.W };
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				m[r][c] += o[r] * o[c];
+			}
+		}
+	}
+	double mean[4];
+	LargestEigenvector(m, mean);
+	frame.HandOffset = Normalize(MakeQuat((float)mean[0], (float)mean[1], (float)mean[2], (float)mean[3]));
+	return true;
+}
+
+static float PositionError(const RetargetFrame &frame, const CalibrationSample &sample)
+{
+	Vec3 predicted = Add(Scale(Rotate(frame.Rotation, sample.Tracked.Position), frame.Scale), frame.Translation);
+	return Length(Sub(predicted, sample.Robot.Position));
+}
+
+static float AngleError(const RetargetFrame &frame, const CalibrationSample &sample)
+{
+	Quat predicted = Multiply(Multiply(frame.Rotation, sample.Tracked.Orientation), frame.HandOffset);
+	return Length(RotationBetween(predicted, sample.Robot.Orientation));
+}
+
+bool SolveCalibration(bool rightArm, int source, bool withScale, CalibrationResult &result)
+{
+	if (!ValidSource(source))
+	{
+		return false;
+	}
+	vector<CalibrationSample> samples;
+	{
+		lock_guard<mutex> lock(calibrationLock);
+		samples = sets[rightArm ? 1 : 0][source].Samples;
+	}
+
+	vector<char> used(samples.size(), 1);
+	RetargetFrame frame;
+	if (!FitTransform(samples, used, withScale, frame))
+	{
+		return false;
+	}
+
+	// refit without the outliers until the inlier set settles
+	for (int iteration = 0; iteration < CALIBRATION_MAX_ITERATIONS; iteration++)
+	{
+		vector<float> errors(samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			errors[i] = PositionError(frame, samples[i]);
+		}
+		vector<float> sorted = errors;
+		nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+		float median = sorted[sorted.size() / 2];
+		float threshold = max(CALIBRATION_MIN_OUTLIER_ERROR, CALIBRATION_OUTLIER_SIGMAS * 1.4826f * median);
+
+		vector<char> inliers(samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			inliers[i] = errors[i] <= threshold;
+		}
+		if (inliers == used)
+		{
+			break;
+		}
+		RetargetFrame refit;
+		if (!FitTransform(samples, inliers, withScale, refit))
+		{
+			break;
+		}
+		used = inliers;
+		frame = refit;
+	}
+
+	result.Frame = frame;
+	result.Samples = (int)samples.size();
+	result.Inliers = 0;
+	double positionSquares = 0.0;
+	double angleSquares = 0.0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		if (used[i])
+		{
+			float position = PositionError(frame, samples[i]);
+			float angle = AngleError(frame, samples[i]);
+			positionSquares += position * position;
+			angleSquares += angle * angle;
+			result.Inliers++;
+		}
+	}
+	result.RmsPositionError = (float)sqrt(positionSquares / result.Inliers);
+	result.RmsAngleError = (float)sqrt(angleSquares / result.Inliers);
+
+	{
+		lock_guard<mutex> lock(calibrationLock);
+		CalibrationSet &set = sets[rightArm ? 1 : 0][source];
+		set.Solved = true;
+		set.Frame = frame;
+	}
+	if (source == CALIBRATION_CONTROLLER)
+	{
+		SetRetargetFrame(rightArm, frame);
+		ResetRetargetContinuity(rightArm);
+	}
+	return true;
+}
+
+bool GetCalibratedFrame(bool rightArm, int source, RetargetFrame &frame)
+{
+	if (!ValidSource(source))
+	{
+		return false;
+	}
+	lock_guard<mutex> lock(calibrationLock);
+	const CalibrationSet &set = sets[rightArm ? 1 : 0][source];
+	frame = set.Frame;
+	return set.Solved;
+}
+
+// line: <left|right> <source> qx qy qz qw tx ty tz scale hx hy hz hw
+bool SaveCalibration(const char *file)
+{
+	ofstream out(file, ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	out.precision(9);
+	out << "# arm source rotation(x y z w) translation(x y z) scale hand_offset(x y z w)\n";
+
+	lock_guard<mutex> lock(calibrationLock);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		for (int source = 0; source < CALIBRATION_SOURCE_COUNT; source++)
+		{
+			const CalibrationSet &set = sets[arm][source];
+			if (!set.Solved)
+			{
+				continue;
+			}
+			const RetargetFrame &f = set.Frame;
+			out << (arm == 1 ? "right" : "left") << ' ' << sourceNames[source]
+				<< ' ' << f.Rotation.X << ' ' << f.Rotation.Y << ' ' << f.Rotation.Z << ' ' << f.Rotation.W
+				<< ' ' << f.Translation.X << ' ' << f.Translation.Y << ' ' << f.Translation.Z
+				<< ' ' << f.Scale
+				<< ' ' << f.HandOffset.X << ' ' << f.HandOffset.Y << ' ' << f.HandOffset.Z << ' ' << f.HandOffset.W << '\n';
+		}
+	}
+	return out.good();
+}
+
+int LoadCalibration(const char *file)
+{
+	ifstream in(file);
+	int loaded = 0;
+	string line;
+	while (getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		char armName[16];
+		char sourceName[16];
+		RetargetFrame f;
+		if (sscanf(line.c_str(), "%15s %15s %f %f %f %f %f %f %f %f %f %f %f %f", armName, sourceName,
+			&f.Rotation.X, &f.Rotation.Y, &f.Rotation.Z, &f.Rotation.W,
+			&f.Translation.X, &f.Translation.Y, &f.Translation.Z, &f.Scale,
+			&f.HandOffset.X, &f.HandOffset.Y, &f.HandOffset.Z, &f.HandOffset.W) != 14)
+		{
+			continue;
+		}
+
+		bool rightArm = string(armName) == "right";
+		int source = -1;
+		for (int s = 0; s < CALIBRATION_SOURCE_COUNT; s++)
+		{
+			if (string(sourceName) == sourceNames[s])
+			{
+				source = s;
+			}
+		}
+		if (source < 0 || (!rightArm && string(armName) != "left"))
+		{
+			continue;
+		}
+
+		{
+			lock_guard<mutex> lock(calibrationLock);
+			CalibrationSet &set = sets[rightArm ? 1 : 0][source];
+			set.Solved = true;
+			set.Frame = f;
+		}
+		if (source == CALIBRATION_CONTROLLER)
+		{
+			SetRetargetFrame(rightArm, f);
+		}
+		loaded++;
+	}
+	return loaded;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Retarget.h"
+
+// Operator / mocap to robot calibration. Each sample pairs a tracked pose
+// (controller or mocap rigid body held at the gripper) with where the arm says
+// its end effector is (see StateCache.h). Solving fits the rigid transform,
+// optionally with scale, with Horn's closed form quaternion method, dropping
+// outliers, and fits the hand offset from the orientations.
+
+#define CALIBRATION_FILE "ARM_base_calibration.txt"
+
+#define CALIBRATION_MAX_SAMPLES 512
+// A sample is only taken when the arm state is at most this old.
+#define CALIBRATION_MAX_STATE_AGE_MICROS 50000
+// Residuals under this never count as outliers, meters.
+#define CALIBRATION_MIN_OUTLIER_ERROR 0.01f
+
+enum CalibrationSource
+{
+	// Vive controller as Unity reports it (left handed), see Retarget.h
+	CALIBRATION_CONTROLLER = 0,
+	// NatNet rigid body (right handed, meters)
+	CALIBRATION_RIGID_BODY = 1,
+	CALIBRATION_SOURCE_COUNT
+};
+
+// Mirrored by KinovaAPI.CalibrationResult.
+struct CalibrationResult
+{
+	RetargetFrame Frame;
+	int Samples;
+	int Inliers;
+	// over the inliers, meters and radians
+	float RmsPositionError;
+	float RmsAngleError;
+};
+
+// Pairs pose with the arm's cached state. False when the arm state is stale or
+// the sample set is full.
+bool RecordCalibrationSample(bool rightArm, int source, const ControllerPose &pose);
+void ClearCalibration(bool rightArm, int source);
+int CalibrationSampleCount(bool rightArm, int source);
+
+// Needs 3 inliers that are not on a line. On success the frame is kept for
+// SaveCalibration and, for controllers, handed to the retargeting stage.
+bool SolveCalibration(bool rightArm, int source, bool withScale, CalibrationResult &result);
+
+// Frame last solved or loaded for an arm and source.
+bool GetCalibratedFrame(bool rightArm, int source, RetargetFrame &frame);
+
+// Plain text, one line per solved arm and source. Loading hands the controller
+// frames to the retargeting stage. Returns the number of frames loaded.
+bool SaveCalibration(const char *file);
+int LoadCalibration(const char *file);
@@ -0,0 +1,91 @@
+#include "ClockSync.h"
+#include <cstring>
+
+void ResetClockSync(ClockSync &sync)
+{
+	memset(&sync, 0, sizeof(sync));
+}
+
+static void Estimate(ClockSync &sync)
+{
+	int best = 0;
+	for (int i = 1; i < sync.Count; i++)
+	{
+		best = sync.Delays[i] < sync.Delays[best] ? i : best;
+	}
+	long long bestDelay = sync.Delays[best];
+	long long margin = bestDelay / 2 > CLOCK_SYNC_DELAY_MARGIN ? bestDelay / 2 : CLOCK_SYNC_DELAY_MARGIN;
+	long long reference = sync.LocalTimes[(sync.Head + CLOCK_SYNC_WINDOW - 1) % CLOCK_SYNC_WINDOW];
+	long long base = sync.Offsets[best];
+
+	// least squares through the good samples, relative to reference and base
+	// so the doubles keep their precision
+	double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	long long first = reference;
+	for (int i = 0; i < sync.Count; i++)
+	{
+		if (sync.Delays[i] > bestDelay + margin)
+		{
+			continue;
+		}
+		double x = (double)(sync.LocalTimes[i] - reference);
+		double y = (double)(sync.Offsets[i] - base);
+		n += 1.0;
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+		first = sync.LocalTimes[i] < first ? sync.LocalTimes[i] : first;
+	}
+
+	double drift = 0.0;
+	double variance = n * sxx - sx * sx;
+	if (reference - first >= CLOCK_SYNC_MIN_DRIFT_SPAN && variance > 0.0)
+	{
+		double limit = CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6;
+		drift = (n * sxy - sx * sy) / variance;
+		drift = drift > limit ? limit : drift < -limit ? -limit : drift;
+	}
+	// the line's value at reference (x = 0)
+	double intercept = (sy - drift * sx) / n;
+
+	sync.Valid = true;
+	sync.Reference = reference;
+	sync.Offset = base + (long long)(intercept < 0.0 ? intercept - 0.5 : intercept + 0.5);
+	sync.Drift = drift;
+	sync.Delay = bestDelay;
+}
+
+void AddClockSample(ClockSync &sync, long long localTime, long long offset, long long delay)
+{
+	if (delay < 0)
+	{
+		return;
+	}
+	sync.LocalTimes[sync.Head] = localTime;
+	sync.Offsets[sync.Head] = offset;
+	sync.Delays[sync.Head] = delay;
+	sync.Head = (sync.Head + 1) % CLOCK_SYNC_WINDOW;
+	sync.Count += sync.Count < CLOCK_SYNC_WINDOW ? 1 : 0;
+	Estimate(sync);
+}
+
+long long ToPeerTime(const ClockSync &sync, long long localTime)
+{
+	if (!sync.Valid)
+	{
+		return localTime;
+	}
+	return localTime + sync.Offset + (long long)(sync.Drift * (double)(localTime - sync.Reference));
+}
+
+long long FromPeerTime(const ClockSync &sync, long long peerTime)
+{
+	if (!sync.Valid)
+	{
+		return peerTime;
+	}
+	// drift is tiny, one step of the inverse is exact to well below a microsecond
+	long long localTime = peerTime - sync.Offset;
+	return peerTime - sync.Offset - (long long)(sync.Drift * (double)(localTime - sync.Reference));
+}
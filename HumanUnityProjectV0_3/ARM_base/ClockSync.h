@@ -0,0 +1,61 @@
+#pragma once
+
+// Estimate of another machine's NowMicros() clock from NTP style exchanges:
+// one side sends at t1, the other receives at t2 and answers at t3, the answer
+// comes back at t4. Offset (peer minus local) is ((t2 - t1) + (t3 - t4)) / 2,
+// right when the two ways take equally long, and the round trip less the time
+// the peer held the message, (t4 - t1) - (t3 - t2), bounds its error.
+//
+// Samples whose round trip is well above the best in the window were queued
+// somewhere on the way and are left out; a straight line through the rest
+// gives the offset now and how fast it drifts.
+
+// Exchanges remembered.
+#define CLOCK_SYNC_WINDOW 32
+
+// A sample counts when its round trip is within the larger of this and half
+// the best round trip above the best one, microseconds.
+#define CLOCK_SYNC_DELAY_MARGIN 100
+
+// Drift is only fitted over samples this far apart, and no faster than this.
+#define CLOCK_SYNC_MIN_DRIFT_SPAN 2000000
+#define CLOCK_SYNC_MAX_DRIFT_PPM 500.0
+
+struct ClockSync
+{
+	int Count;
+	int Head;
+	long long LocalTimes[CLOCK_SYNC_WINDOW];
+	long long Offsets[CLOCK_SYNC_WINDOW];
+	long long Delays[CLOCK_SYNC_WINDOW];
+
+	// the estimate, offset at the local time Reference
+	bool Valid;
+	long long Reference;
+	long long Offset;
+	double Drift;
+	// best round trip in the window, twice the worst error of the offset
+	long long Delay;
+};
+
+void ResetClockSync(ClockSync &sync);
+
+// From an exchange started at t1 on the local clock, see above.
+inline long long ExchangeOffset(long long t1, long long t2, long long t3, long long t4)
+{
+	return ((t2 - t1) + (t3 - t4)) / 2;
+}
+
+inline long long ExchangeDelay(long long t1, long long t2, long long t3, long long t4)
+{
+	return (t4 - t1) - (t3 - t2);
+}
+
+// localTime is when the sample was taken. Negative delays (a clock stepped)
+// are ignored.
+void AddClockSample(ClockSync &sync, long long localTime, long long offset, long long delay);
+
+// The peer's clock at a local time and back; the time itself while there is no
+// estimate yet.
+long long ToPeerTime(const ClockSync &sync, long long localTime);
+long long FromPeerTime(const ClockSync &sync, long long peerTime);
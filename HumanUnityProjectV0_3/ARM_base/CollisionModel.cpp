@@ -0,0 +1,152 @@
+#include "CollisionModel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+enum ArmLink
+{
+	LINK_BASE = 0,
+	LINK_UPPER_ARM,
+	LINK_FOREARM,
+	LINK_WRIST,
+	LINK_HAND,
+	LINK_COUNT
+};
+
+// pairs far enough apart along the chain to be worth checking
+static const int selfPairs[][2] =
+{
+	{ LINK_BASE, LINK_FOREARM },
+	{ LINK_BASE, LINK_WRIST },
+	{ LINK_BASE, LINK_HAND },
+	{ LINK_UPPER_ARM, LINK_WRIST },
+	{ LINK_UPPER_ARM, LINK_HAND },
+};
+
+Capsule MirrorCapsule(const Capsule &capsule, bool rightArm)
+{
+	Capsule mirrored = capsule;
+	if (rightArm)
+	{
+		mirrored.A.X = -capsule.A.X;
+		mirrored.B.X = -capsule.B.X;
+	}
+	return mirrored;
+}
+
+static Capsule MakeCapsule(const Vec3 &a, const Vec3 &b, float radius)
+{
+	Capsule capsule = { a, b, radius };
+	return capsule;
+}
+
+static void ArmCapsules(const JointConfig &joints, Capsule links[LINK_COUNT])
+{
+	ArmFrames frames;
+	ForwardKinematics(joints, frames);
+
+	links[LINK_BASE] = MakeCapsule(frames.Frames[0], frames.Frames[1], 0.05f);
+	links[LINK_UPPER_ARM] = MakeCapsule(frames.Frames[1], frames.Frames[2], 0.045f);
+	links[LINK_FOREARM] = MakeCapsule(frames.Frames[3], frames.Frames[4], 0.04f);
+	links[LINK_WRIST] = MakeCapsule(frames.Frames[4], frames.Frames[5], 0.035f);
+	// hand and fingers
+	links[LINK_HAND] = MakeCapsule(frames.Frames[5], frames.Frames[6], 0.06f);
+}
+
+static float Clamp01(float value)
+{
+	return max(0.0f, min(1.0f, value));
+}
+
+// Closest distance between segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9).
+static float SegmentDistance(const Vec3 &p1, const Vec3 &q1, const Vec3 &p2, const Vec3 &q2)
+{
+	Vec3 d1 = Sub(q1, p1);
+	Vec3 d2 = Sub(q2, p2);
+	Vec3 r = Sub(p1, p2);
+	float a = Dot(d1, d1);
+	float e = Dot(d2, d2);
+	float f = Dot(d2, r);
+	float s = 0.0f;
+	float t = 0.0f;
+
+	if (a <= 1e-9f && e <= 1e-9f)
+	{
+		return Length(r);
+	}
+	if (a <= 1e-9f)
+	{
+		t = Clamp01(f / e);
+	}
+	else
+	{
+		float c = Dot(d1, r);
+		if (e <= 1e-9f)
+		{
+			s = Clamp01(-c / a);
+		}
+		else
+		{
+			float b = Dot(d1, d2);
+			float denominator = a * e - b * b;
+			s = denominator > 1e-9f ? Clamp01((b * f - c * e) / denominator) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = Clamp01(-c / a);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = Clamp01((b - c) / a);
+			}
+		}
+	}
+	return Length(Sub(Add(p1, Scale(d1, s)), Add(p2, Scale(d2, t))));
+}
+
+static bool Overlap(const Capsule &a, const Capsule &b)
+{
+	return SegmentDistance(a.A, a.B, b.A, b.B) < a.Radius + b.Radius;
+}
+
+bool InCollision(const JointConfig &joints, const vector<Capsule> &obstacles)
+{
+	Capsule links[LINK_COUNT];
+	ArmCapsules(joints, links);
+
+	for (size_t i = 0; i < sizeof(selfPairs) / sizeof(selfPairs[0]); i++)
+	{
+		if (Overlap(links[selfPairs[i][0]], links[selfPairs[i][1]]))
+		{
+			return true;
+		}
+	}
+	// the base is bolted to whatever it sits on, only the moving links count
+	for (size_t o = 0; o < obstacles.size(); o++)
+	{
+		for (int link = LINK_UPPER_ARM; link < LINK_COUNT; link++)
+		{
+			if (Overlap(links[link], obstacles[o]))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool MotionInCollision(const JointConfig &a, const JointConfig &b, const vector<Capsule> &obstacles, float resolution)
+{
+	int steps = max(1, (int)ceilf(JointDistance(a, b) / resolution));
+	for (int k = 1; k <= steps; k++)
+	{
+		if (InCollision(LerpJoints(a, b, (float)k / steps), obstacles))
+		{
+			return true;
+		}
+	}
+	return false;
+}
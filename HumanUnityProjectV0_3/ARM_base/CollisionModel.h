@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Kinematics.h"
+#include <vector>
+
+// Coarse collision model: the arm and its surroundings are capsules (a sphere
+// swept along a segment; A == B gives a sphere). Obstacles are in the arm's
+// base frame, meters.
+
+struct Capsule
+{
+	Vec3 A;
+	Vec3 B;
+	float Radius;
+};
+
+// Right arm obstacles negate x, like the presets.
+Capsule MirrorCapsule(const Capsule &capsule, bool rightArm);
+
+// True if the arm at joints hits itself or any obstacle.
+bool InCollision(const JointConfig &joints, const std::vector<Capsule> &obstacles);
+
+// Checks the straight joint space motion from a to b, every resolution degrees.
+bool MotionInCollision(const JointConfig &a, const JointConfig &b, const std::vector<Capsule> &obstacles, float resolution);
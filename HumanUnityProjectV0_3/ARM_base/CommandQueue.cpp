@@ -0,0 +1,318 @@
+#include "CommandQueue.h"
+#include "Latency.h"
+#include "Timing.h"
+#include "Lib_Examples\CommunicationLayerWindows.h"
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+static mutex queueLock;
+static condition_variable commandReady;
+static condition_variable commandDone;
+static deque<ArmCommand> pending;
+static thread worker;
+static bool running = false;
+static CommandExecutor execute = NULL;
+static unsigned int nextId = 1;
+
+// Completions waiting to be polled, as a ring.
+static CommandCompletion completionQueue[COMPLETION_QUEUE_SIZE];
+static int completionHead = 0;
+static int completionCount = 0;
+static unsigned int droppedCompletions = 0;
+
+// Last completions indexed by id, for WaitForCompletion.
+static CommandCompletion history[COMPLETION_HISTORY_SIZE];
+
+struct BackgroundSlot
+{
+	BackgroundTask Task;
+	long long Period;
+	long long Next;
+};
+
+static BackgroundSlot backgroundTasks[MAX_BACKGROUND_TASKS];
+static int backgroundCount = 0;
+// Set by AddBackgroundTask so an idle worker wakes up and looks at the new task.
+static bool tasksChanged = false;
+
+// Adds a finished command to the poll ring and the wait history. Lock must be held.
+static void RecordCompletion(const CommandCompletion &completion)
+{
+	if (completionCount == COMPLETION_QUEUE_SIZE)
+	{
+		completionHead = (completionHead + 1) % COMPLETION_QUEUE_SIZE;
+		completionCount--;
+		droppedCompletions++;
+	}
+	completionQueue[(completionHead + completionCount) % COMPLETION_QUEUE_SIZE] = completion;
+	completionCount++;
+
+	history[completion.Id % COMPLETION_HISTORY_SIZE] = completion;
+	commandDone.notify_all();
+}
+
+static bool IsMove(int type)
+{
+	return type == CMD_MOVE_HAND || type == CMD_MOVE_HAND_NO_THETA_Y || type == CMD_MOVE_HOME ||
+		type == CMD_MOVE_FINGERS;
+}
+
+// Drops the arm's queued moves, completing each with
+// ERROR_OPERATION_INCOMPLETED. Lock must be held.
+static void CancelPendingMoves(bool rightArm)
+{
+	long long now = NowMicros();
+	for (deque<ArmCommand>::iterator it = pending.begin(); it != pending.end();)
+	{
+		if (it->RightArm != rightArm || !IsMove(it->Type))
+		{
+			++it;
+			continue;
+		}
+		CommandCompletion completion;
+		completion.Id = it->Id;
+		completion.Result = ERROR_OPERATION_INCOMPLETED;
+		completion.SubmitTime = it->SubmitTime;
+		completion.StartTime = now;
+		completion.EndTime = now;
+		RecordCompletion(completion);
+		it = pending.erase(it);
+	}
+}
+
+static long long NextBackgroundDue()
+{
+	long long due = LLONG_MAX;
+	for (int i = 0; i < backgroundCount; i++)
+	{
+		if (backgroundTasks[i].Next < due)
+		{
+			due = backgroundTasks[i].Next;
+		}
+	}
+	return due;
+}
+
+static void WorkerLoop()
+{
+	unique_lock<mutex> lock(queueLock);
+	auto ready = [] { return !running || !pending.empty() || tasksChanged; };
+	while (true)
+	{
+		long long due = NextBackgroundDue();
+		if (due == LLONG_MAX)
+		{
+			commandReady.wait(lock, ready);
+		}
+		else if (due > NowMicros())
+		{
+			commandReady.wait_for(lock, chrono::microseconds(due - NowMicros()), ready);
+		}
+		tasksChanged = false;
+
+		if (!pending.empty())
+		{
+			ArmCommand command = pending.front();
+			pending.pop_front();
+
+			CommandCompletion completion;
+			completion.Id = command.Id;
+			completion.SubmitTime = command.SubmitTime;
+
+			lock.unlock();
+			completion.StartTime = NowMicros();
+			completion.Result = execute(command);
+			completion.EndTime = NowMicros();
+			RecordLatency(LATENCY_COMMAND, completion.EndTime - completion.SubmitTime);
+			if (command.CaptureTime != 0 && completion.Result == 0)
+			{
+				RecordLatency(LATENCY_CAPTURE, completion.EndTime - command.CaptureTime);
+			}
+			lock.lock();
+
+			RecordCompletion(completion);
+			continue;
+		}
+
+		if (!running)
+		{
+			// only get here once stopped and drained
+			return;
+		}
+
+		// nothing queued, run whatever background work is due
+		long long now = NowMicros();
+		for (int i = 0; i < backgroundCount && pending.empty(); i++)
+		{
+			if (backgroundTasks[i].Next <= now)
+			{
+				BackgroundTask task = backgroundTasks[i].Task;
+				backgroundTasks[i].Next = now + backgroundTasks[i].Period;
+				lock.unlock();
+				task();
+				lock.lock();
+			}
+		}
+	}
+}
+
+void StartCommandQueue(CommandExecutor executor)
+{
+	lock_guard<mutex> lock(queueLock);
+	if (running)
+	{
+		return;
+	}
+	execute = executor;
+	running = true;
+	worker = thread(WorkerLoop);
+}
+
+void StopCommandQueue()
+{
+	{
+		lock_guard<mutex> lock(queueLock);
+		if (!running)
+		{
+			return;
+		}
+		running = false;
+	}
+	commandReady.notify_all();
+	worker.join();
+}
+
+bool CommandQueueRunning()
+{
+	lock_guard<mutex> lock(queueLock);
+	return running;
+}
+
+unsigned int SubmitCommand(ArmCommand command)
+{
+	{
+		lock_guard<mutex> lock(queueLock);
+		if (!running)
+		{
+			return 0;
+		}
+		command.Id = nextId++;
+		command.SubmitTime = NowMicros();
+
+		// make the slot look unfinished until the worker overwrites it
+		history[command.Id % COMPLETION_HISTORY_SIZE].Id = 0;
+
+		if (command.Type == CMD_STOP_ARM)
+		{
+			// the moves it stops must not start again once it is done
+			CancelPendingMoves(command.RightArm);
+			pending.push_front(command);
+		}
+		else
+		{
+			pending.push_back(command);
+		}
+	}
+	commandReady.notify_one();
+	return command.Id;
+}
+
+unsigned int ReserveCommandId()
+{
+	lock_guard<mutex> lock(queueLock);
+	if (!running)
+	{
+		return 0;
+	}
+	unsigned int id = nextId++;
+	history[id % COMPLETION_HISTORY_SIZE].Id = 0;
+	return id;
+}
+
+unsigned int LatestCommandId()
+{
+	lock_guard<mutex> lock(queueLock);
+	return nextId - 1;
+}
+
+void PostCompletion(const CommandCompletion &completion)
+{
+	lock_guard<mutex> lock(queueLock);
+	RecordCompletion(completion);
+}
+
+bool AddBackgroundTask(BackgroundTask task, long long periodMicros)
+{
+	lock_guard<mutex> lock(queueLock);
+	for (int i = 0; i < backgroundCount; i++)
+	{
+		if (backgroundTasks[i].Task == task)
+		{
+			backgroundTasks[i].Period = periodMicros;
+			return true;
+		}
+	}
+	if (backgroundCount == MAX_BACKGROUND_TASKS)
+	{
+		return false;
+	}
+	BackgroundSlot &slot = backgroundTasks[backgroundCount++];
+	slot.Task = task;
+	slot.Period = periodMicros;
+	slot.Next = NowMicros();
+	tasksChanged = true;
+	commandReady.notify_one();
+	return true;
+}
+
+int PollCompletions(CommandCompletion *completions, int maxCount)
+{
+	lock_guard<mutex> lock(queueLock);
+	int count = 0;
+	while (count < maxCount && completionCount > 0)
+	{
+		completions[count++] = completionQueue[completionHead];
+		completionHead = (completionHead + 1) % COMPLETION_QUEUE_SIZE;
+		completionCount--;
+	}
+	return count;
+}
+
+int WaitForCompletion(unsigned int id, int timeoutMs, CommandCompletion &completion)
+{
+	unique_lock<mutex> lock(queueLock);
+	if (id == 0 || id >= nextId || nextId - id > COMPLETION_HISTORY_SIZE)
+	{
+		return -2;
+	}
+
+	CommandCompletion &slot = history[id % COMPLETION_HISTORY_SIZE];
+	// also wake up if newer commands recycled the slot while we were waiting
+	auto finished = [&] { return slot.Id == id || nextId - id > COMPLETION_HISTORY_SIZE; };
+	if (timeoutMs < 0)
+	{
+		commandDone.wait(lock, finished);
+	}
+	else if (!commandDone.wait_for(lock, chrono::milliseconds(timeoutMs), finished))
+	{
+		return -1;
+	}
+
+	if (slot.Id != id)
+	{
+		return -2;
+	}
+	completion = slot;
+	return 0;
+}
+
+unsigned int DroppedCompletionCount()
+{
+	lock_guard<mutex> lock(queueLock);
+	return droppedCompletions;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Commands understood by the bridge's command worker.
+enum ArmCommandType
+{
+	CMD_MOVE_HAND = 0,
+	CMD_MOVE_HAND_NO_THETA_Y = 1,
+	CMD_MOVE_HOME = 2,
+	CMD_MOVE_FINGERS = 3,
+	CMD_STOP_ARM = 4,
+	CMD_CLEAR_ERROR_LOG = 5,
+};
+
+// A command waiting to be sent to one of the arms.
+// x, y, z in meters, thetaX, thetaY, thetaZ in radians,
+// fingers from 0.0 (closed) to 10.0 (open).
+struct ArmCommand
+{
+	unsigned int Id;
+	int Type;
+	bool RightArm;
+	float X;
+	float Y;
+	float Z;
+	float ThetaX;
+	float ThetaY;
+	float ThetaZ;
+	float Fingers;
+	long long SubmitTime;
+	// when the pose was captured at the source, 0 when unknown
+	long long CaptureTime;
+};
+
+// Result of a command once the worker is done with it. Layout is mirrored by
+// KinovaAPI.CommandCompletion on the C# side, keep them in sync.
+// Result is 0 on success, otherwise the Kinova error code (ERROR_COMM_TIMEOUT,
+// ERROR_NACK_RECEIVED, ...). Times are microseconds from NowMicros().
+struct CommandCompletion
+{
+	unsigned int Id;
+	int Result;
+	long long SubmitTime;
+	long long StartTime;
+	long long EndTime;
+};
+
+// Sends one command to the robot and returns 0 or a Kinova error code.
+// Always called from the worker thread, so it owns the Kinova API while it runs.
+typedef int(*CommandExecutor)(const ArmCommand &command);
+
+// Periodic work (state polling, FIFO top-up, ...) the worker runs between
+// commands. Like the executor it runs on the worker thread, so it may use the
+// Kinova API, but it must select the arm it talks to itself.
+typedef void(*BackgroundTask)();
+
+#define MAX_BACKGROUND_TASKS 8
+
+// Size of the completion ring polled by PollCompletions. When Unity does not
+// drain it fast enough the oldest completions are dropped.
+#define COMPLETION_QUEUE_SIZE 256
+
+// WaitForCompletion can find any of the last COMPLETION_HISTORY_SIZE commands.
+#define COMPLETION_HISTORY_SIZE 1024
+
+void StartCommandQueue(CommandExecutor executor);
+void StopCommandQueue();
+bool CommandQueueRunning();
+
+// Queues a command and returns its ID (IDs start at 1 and only increase).
+// Returns 0 when the queue is not running. Stop commands skip ahead of any
+// queued commands and cancel the arm's queued moves, which complete with
+// ERROR_OPERATION_INCOMPLETED.
+unsigned int SubmitCommand(ArmCommand command);
+
+// For work that does not go through the worker as a single command (a
+// streamed trajectory, ...): take an ID now and post its completion when done.
+// ReserveCommandId returns 0 when the queue is not running.
+unsigned int ReserveCommandId();
+void PostCompletion(const CommandCompletion &completion);
+
+// Runs task about every periodMicros while no command is waiting. Adding the
+// same task again only changes its period. Returns false when all slots are used.
+bool AddBackgroundTask(BackgroundTask task, long long periodMicros);
+
+// Newest ID handed out by SubmitCommand or ReserveCommandId, 0 if none yet.
+unsigned int LatestCommandId();
+
+// Copies up to maxCount finished commands, oldest first, without blocking.
+// Returns how many were copied.
+int PollCompletions(CommandCompletion *completions, int maxCount);
+
+// Blocks until command id has completed or timeoutMs elapsed (negative waits
+// forever). Returns 0 when completion was filled in, -1 on timeout and -2 when
+// the ID is unknown or too old to still be tracked.
+int WaitForCompletion(unsigned int id, int timeoutMs, CommandCompletion &completion);
+
+// Number of completions dropped because the poll ring was full.
+unsigned int DroppedCompletionCount();
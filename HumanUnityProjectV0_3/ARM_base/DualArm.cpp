@@ -0,0 +1,262 @@
+#include "DualArm.h"
+#include "Calibration.h"
+#include "CommandQueue.h"
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+// Pairs whose dispatch skew is still to be measured.
+#define DUAL_ARM_PENDING_PAIRS 8
+
+struct PendingPair
+{
+	unsigned int Left;
+	unsigned int Right;
+};
+
+static mutex dualLock;
+static atomic<bool> coordinated(false);
+static int constraint = DUAL_ARM_FREE;
+static float wantedDistance = 0.0f;
+static bool hasBase = false;
+static Pose rightBase;
+// relation to keep: a distance, or the right hand in the left hand's frame
+static bool captured = false;
+static float keptDistance = 0.0f;
+static Pose relative;
+static PendingPair pending[DUAL_ARM_PENDING_PAIRS];
+static int pendingCount = 0;
+static unsigned int finishedPairs = 0;
+static long long skewSum = 0;
+static DualArmStats stats;
+
+static Pose ToLeftFrame(const Pose &right)
+{
+	Pose pose;
+	pose.Position = Add(Rotate(rightBase.Orientation, right.Position), rightBase.Position);
+	pose.Orientation = Normalize(Multiply(rightBase.Orientation, right.Orientation));
+	return pose;
+}
+
+static Pose FromLeftFrame(const Pose &pose)
+{
+	Quat inverse = Conjugate(rightBase.Orientation);
+	Pose right;
+	right.Position = Rotate(inverse, Sub(pose.Position, rightBase.Position));
+	right.Orientation = Normalize(Multiply(inverse, pose.Orientation));
+	return right;
+}
+
+// b seen from a
+static Pose Relative(const Pose &a, const Pose &b)
+{
+	Quat inverse = Conjugate(a.Orientation);
+	Pose pose;
+	pose.Position = Rotate(inverse, Sub(b.Position, a.Position));
+	pose.Orientation = Normalize(Multiply(inverse, b.Orientation));
+	return pose;
+}
+
+static Pose Compose(const Pose &a, const Pose &b)
+{
+	Pose pose;
+	pose.Position = Add(a.Position, Rotate(a.Orientation, b.Position));
+	pose.Orientation = Normalize(Multiply(a.Orientation, b.Orientation));
+	return pose;
+}
+
+static Pose Inverse(const Pose &a)
+{
+	Pose pose;
+	pose.Orientation = Conjugate(a.Orientation);
+	pose.Position = Scale(Rotate(pose.Orientation, a.Position), -1.0f);
+	return pose;
+}
+
+// Lock must be held.
+static void CollectFinishedPairs()
+{
+	int kept = 0;
+	for (int i = 0; i < pendingCount; i++)
+	{
+		CommandCompletion left, right;
+		int leftResult = WaitForCompletion(pending[i].Left, 0, left);
+		int rightResult = WaitForCompletion(pending[i].Right, 0, right);
+		if (leftResult == -1 || rightResult == -1)
+		{
+			pending[kept++] = pending[i];
+			continue;
+		}
+		if (leftResult != 0 || rightResult != 0 || left.Result != 0 || right.Result != 0)
+		{
+			// too old to find or failed, no meaningful skew
+			continue;
+		}
+		long long skew = right.StartTime - left.StartTime;
+		long long magnitude = skew < 0 ? -skew : skew;
+		stats.LastDispatchSkewMicros = skew;
+		if (magnitude > stats.MaxDispatchSkewMicros)
+		{
+			stats.MaxDispatchSkewMicros = magnitude;
+		}
+		finishedPairs++;
+		skewSum += skew;
+		stats.MeanDispatchSkewMicros = skewSum / finishedPairs;
+	}
+	pendingCount = kept;
+}
+
+bool SetDualArmCoordination(bool enabled, int newConstraint, float newDistance)
+{
+	lock_guard<mutex> lock(dualLock);
+	if (newConstraint < DUAL_ARM_FREE || newConstraint > DUAL_ARM_RIGID)
+	{
+		return false;
+	}
+	if (enabled && newConstraint != DUAL_ARM_FREE && !hasBase)
+	{
+		return false;
+	}
+	constraint = newConstraint;
+	wantedDistance = newDistance;
+	captured = false;
+	stats.Constraint = constraint;
+	coordinated = enabled;
+	return true;
+}
+
+bool DualArmCoordinated()
+{
+	return coordinated;
+}
+
+void SetDualArmBase(const Pose &base)
+{
+	lock_guard<mutex> lock(dualLock);
+	rightBase.Position = base.Position;
+	rightBase.Orientation = Normalize(base.Orientation);
+	hasBase = true;
+	captured = false;
+}
+
+bool DeriveDualArmBase(int source)
+{
+	RetargetFrame left, right;
+	if (!GetCalibratedFrame(false, source, left) || !GetCalibratedFrame(true, source, right))
+	{
+		return false;
+	}
+	// p = R x + t in both arms, for the same tracked x
+	Pose base;
+	base.Orientation = Normalize(Multiply(left.Rotation, Conjugate(right.Rotation)));
+	base.Position = Sub(left.Translation, Rotate(base.Orientation, right.Translation));
+	SetDualArmBase(base);
+	return true;
+}
+
+void ConstrainDualArm(Pose &left, Pose &right)
+{
+	lock_guard<mutex> lock(dualLock);
+	if (constraint == DUAL_ARM_FREE)
+	{
+		return;
+	}
+
+	Pose rightInLeft = ToLeftFrame(right);
+	if (!captured)
+	{
+		keptDistance = wantedDistance > 0.0f ? wantedDistance : Length(Sub(rightInLeft.Position, left.Position));
+		relative = Relative(left, rightInLeft);
+		stats.Distance = constraint == DUAL_ARM_FIXED_DISTANCE ? keptDistance : 0.0f;
+		captured = true;
+		if (constraint == DUAL_ARM_RIGID || wantedDistance <= 0.0f)
+		{
+			return;
+		}
+	}
+
+	Pose newLeft = left;
+	Pose newRight = rightInLeft;
+	if (constraint == DUAL_ARM_FIXED_DISTANCE)
+	{
+		Vec3 apart = Sub(rightInLeft.Position, left.Position);
+		float length = Length(apart);
+		if (length < 1e-6f)
+		{
+			return;
+		}
+		Vec3 half = Scale(apart, 0.5f * (length - keptDistance) / length);
+		newLeft.Position = Add(left.Position, half);
+		newRight.Position = Sub(rightInLeft.Position, half);
+	}
+	else
+	{
+		// meet halfway between where each hand says the other should be
+		Pose implied = Compose(left, relative);
+		newRight.Position = Lerp(rightInLeft.Position, implied.Position, 0.5f);
+		newRight.Orientation = Slerp(rightInLeft.Orientation, implied.Orientation, 0.5f);
+		newLeft = Compose(newRight, Inverse(relative));
+	}
+
+	float correction = Length(Sub(newLeft.Position, left.Position));
+	float rightCorrection = Length(Sub(newRight.Position, rightInLeft.Position));
+	correction = correction > rightCorrection ? correction : rightCorrection;
+	left = newLeft;
+	right = FromLeftFrame(newRight);
+
+	// under a tenth of a millimeter is just rounding
+	if (correction > 0.0001f)
+	{
+		stats.Corrections++;
+	}
+	stats.LastCorrection = correction;
+	if (correction > stats.MaxCorrection)
+	{
+		stats.MaxCorrection = correction;
+	}
+}
+
+void RecordDualArmPair(unsigned int leftCommand, unsigned int rightCommand, long long inputSkew)
+{
+	lock_guard<mutex> lock(dualLock);
+	stats.Pairs++;
+	stats.InputSkewMicros = inputSkew;
+	CollectFinishedPairs();
+	if (pendingCount == DUAL_ARM_PENDING_PAIRS)
+	{
+		// measuring the newest pairs matters more than the old ones
+		for (int i = 1; i < pendingCount; i++)
+		{
+			pending[i - 1] = pending[i];
+		}
+		pendingCount--;
+	}
+	pending[pendingCount].Left = leftCommand;
+	pending[pendingCount].Right = rightCommand;
+	pendingCount++;
+}
+
+void RecordDualArmHeld()
+{
+	lock_guard<mutex> lock(dualLock);
+	stats.PairsHeld++;
+}
+
+void ResetDualArm()
+{
+	lock_guard<mutex> lock(dualLock);
+	captured = false;
+	pendingCount = 0;
+	finishedPairs = 0;
+	skewSum = 0;
+	stats = DualArmStats();
+	stats.Constraint = constraint;
+}
+
+void ReadDualArmStats(DualArmStats &result)
+{
+	lock_guard<mutex> lock(dualLock);
+	CollectFinishedPairs();
+	result = stats;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Coordination of the two arms in the target stream. When it is on, the
+// interpolator samples both arms at the same render time and sends their
+// commands back to back in the same tick, or holds both back while either arm
+// is still busy or throttled, so a bimanual motion never drifts apart by whole
+// ticks. An arm with nothing to stream (no samples) does not hold the other.
+//
+// Optionally the pair is kept in a fixed relation, for carrying something with
+// both hands: the hands' distance, or the whole pose of the right hand relative
+// to the left one. The relation is the one the first coordinated pair had,
+// unless a distance is given. Each hand takes half of the correction.
+//
+// Relations are measured in the left arm's base frame, so they need the pose of
+// the right arm's base in it: set it directly, or have it derived from both
+// arms' calibration against the same tracker (see Calibration.h), which assumes
+// both frames have a scale of 1.
+
+enum DualArmConstraint
+{
+	DUAL_ARM_FREE = 0,
+	DUAL_ARM_FIXED_DISTANCE = 1,
+	DUAL_ARM_RIGID = 2,
+};
+
+// Mirrored by KinovaAPI.DualArmStats.
+struct DualArmStats
+{
+	int Constraint;
+	// meters, DUAL_ARM_FIXED_DISTANCE only
+	float Distance;
+	// ticks both arms were sent together, and ticks one arm was ready but
+	// waited for the other
+	unsigned int Pairs;
+	unsigned int PairsHeld;
+	// pairs moved by the constraint, and the largest move of one hand, meters
+	unsigned int Corrections;
+	float LastCorrection;
+	float MaxCorrection;
+	// newest right sample time minus newest left sample time when last sent
+	long long InputSkewMicros;
+	// right command start minus left command start, for finished pairs
+	long long LastDispatchSkewMicros;
+	long long MeanDispatchSkewMicros;
+	long long MaxDispatchSkewMicros;
+};
+
+// distance <= 0 keeps the distance of the first pair. Returns false for an
+// unknown constraint, or one that needs the base pose before it is known.
+bool SetDualArmCoordination(bool enabled, int constraint, float distance);
+bool DualArmCoordinated();
+
+// Pose of the right arm's base in the left arm's base frame.
+void SetDualArmBase(const Pose &rightBase);
+// From the calibrated frames of source for both arms. False if either is missing.
+bool DeriveDualArmBase(int source);
+
+// Called by the interpolator for each pair it is about to send: both targets
+// in their own arm's frame, moved by the constraint if there is one.
+void ConstrainDualArm(Pose &left, Pose &right);
+
+// Called after both commands of a pair were submitted, with their IDs and the
+// input skew. Dispatch skew is measured once both have completed.
+void RecordDualArmPair(unsigned int leftCommand, unsigned int rightCommand, long long inputSkew);
+void RecordDualArmHeld();
+
+// Forgets the captured relation and the statistics (stream restart).
+void ResetDualArm();
+
+void ReadDualArmStats(DualArmStats &stats);
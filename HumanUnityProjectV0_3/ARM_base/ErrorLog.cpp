@@ -0,0 +1,19 @@
+#include "ErrorLog.h"
+#include "EventRing.h"
+
+static EventRing<SystemErrorEntry, SYSTEM_ERROR_RING_SIZE> systemErrors;
+
+void PushSystemError(const SystemErrorEntry &entry)
+{
+	systemErrors.Push(entry);
+}
+
+int ReadSystemErrorEntries(unsigned long long &cursor, SystemErrorEntry *entries, int maxCount)
+{
+	return systemErrors.Read(cursor, entries, maxCount);
+}
+
+unsigned long long SystemErrorCursor()
+{
+	return systemErrors.Written();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// The arms' system error logs, as the bridge has read them. A background task
+// on the worker (PollSystemErrors in ARM_base.cpp) reads only the entries
+// added since its last poll and pushes them here, tagged with the bridge time
+// and the newest command ID. Readers pull them in bulk without locking.
+
+#define SYSTEM_ERROR_DATA_COUNT 50
+#define SYSTEM_ERROR_RING_SIZE 256
+
+// How often the logs are checked for new entries, and how many entries one
+// poll reads at most (the rest wait for the next poll).
+#define SYSTEM_ERROR_POLL_PERIOD_MICROS 200000
+#define SYSTEM_ERROR_MAX_READS_PER_POLL 16
+
+// A Kinova SystemError plus where it was seen. Mirrored by
+// KinovaAPI.SystemErrorEntry, keep them in sync.
+struct SystemErrorEntry
+{
+	// NowMicros() when the bridge read it
+	long long Timestamp;
+	// newest command ID handed out by then (see CommandQueue.h), 0 if none
+	unsigned int LastCommandId;
+	// 0 left, 1 right
+	int Arm;
+	// position in the arm's error log
+	unsigned int LogIndex;
+	unsigned int ErrorHeader;
+	// errorLoggerType
+	int ErrorType;
+	int FirmwareVersion;
+	int KeosVersion;
+	// the robot's own clock and lifetime counter
+	unsigned int SystemTime;
+	int LifeTime;
+	// bit i set when LayerErrorStatus[i] is
+	unsigned int LayerErrors;
+	int DataCount;
+	unsigned int Data[SYSTEM_ERROR_DATA_COUNT];
+};
+
+void PushSystemError(const SystemErrorEntry &entry);
+
+// Copies up to maxCount entries from cursor on, oldest first, and moves cursor
+// past them. Start with cursor 0; entries older than the ring are skipped.
+int ReadSystemErrorEntries(unsigned long long &cursor, SystemErrorEntry *entries, int maxCount);
+
+// Cursor just past the newest entry, to only see what comes next.
+unsigned long long SystemErrorCursor();
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+// Bounded event ring for one writer and any number of readers, without locks.
+// Like Snapshot, every slot carries a sequence that is odd while the writer
+// fills it in. Each reader keeps its own cursor (the number of the next event
+// it wants); events overwritten before a reader got to them are skipped.
+// T must be plain data (copied with memcpy).
+template <typename T, unsigned int N>
+class EventRing
+{
+public:
+	EventRing() : written(0)
+	{
+		for (unsigned int i = 0; i < N; i++)
+		{
+			slots[i].sequence.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void Push(const T &value)
+	{
+		unsigned long long n = written.load(std::memory_order_relaxed);
+		Slot &slot = slots[n % N];
+		slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy(&slot.value, &value, sizeof(T));
+		slot.sequence.store(2 * n + 2, std::memory_order_release);
+		written.store(n + 1, std::memory_order_release);
+	}
+
+	// Copies up to maxCount events from cursor on, oldest first, and moves
+	// cursor past them. Returns how many were copied.
+	int Read(unsigned long long &cursor, T *values, int maxCount) const
+	{
+		unsigned long long end = written.load(std::memory_order_acquire);
+		if (end > N && cursor < end - N)
+		{
+			cursor = end - N;
+		}
+		int count = 0;
+		for (; cursor < end && count < maxCount; cursor++)
+		{
+			const Slot &slot = slots[cursor % N];
+			unsigned long long expected = 2 * cursor + 2;
+			if (slot.sequence.load(std::memory_order_acquire) != expected)
+			{
+				// already being overwritten by a newer event
+				continue;
+			}
+			memcpy(&values[count], &slot.value, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) == expected)
+			{
+				count++;
+			}
+		}
+		return count;
+	}
+
+	// Number of events pushed so far, the cursor of the next one.
+	unsigned long long Written() const
+	{
+		return written.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<unsigned long long> sequence;
+		T value;
+	};
+
+	std::atomic<unsigned long long> written;
+	Slot slots[N];
+};
@@ -0,0 +1,395 @@
+#include "Interpolator.h"
+#include "CommandQueue.h"
+#include "DualArm.h"
+#include "Latency.h"
+#include "Predictor.h"
+#include "Thermal.h"
+#include "Timing.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+using namespace std;
+
+struct TargetSample
+{
+	long long Time;
+	Pose Target;
+};
+
+// Samples of one arm, as a ring ordered by time.
+struct TargetHistory
+{
+	TargetSample Samples[TARGET_HISTORY_SIZE];
+	int Head;
+	int Count;
+	// last command sent for this arm, 0 if none, and when
+	unsigned int LastCommand;
+	long long LastCommandTime;
+	// last Euler angles sent, to keep them unwrapped
+	float ThetaX;
+	float ThetaY;
+	float ThetaZ;
+	// the held pose was already sent since the last push
+	bool HoldSent;
+};
+
+static mutex targetLock;
+static TargetHistory histories[2];
+static TargetStreamStats stats;
+
+static thread scheduler;
+static atomic<bool> streaming(false);
+static long long periodMicros = 5000;
+static long long renderDelay = 20000;
+
+static TargetHistory &HistoryFor(bool rightArm)
+{
+	return histories[rightArm ? 1 : 0];
+}
+
+static const TargetSample &SampleAt(const TargetHistory &history, int i)
+{
+	return history.Samples[(history.Head + i) % TARGET_HISTORY_SIZE];
+}
+
+void PushTarget(bool rightArm, long long timestamp, const Pose &target)
+{
+	lock_guard<mutex> lock(targetLock);
+	TargetHistory &history = HistoryFor(rightArm);
+
+	// out of order or duplicate samples would break the bracketing search
+	if (history.Count > 0 && timestamp <= SampleAt(history, history.Count - 1).Time)
+	{
+		return;
+	}
+
+	if (history.Count == TARGET_HISTORY_SIZE)
+	{
+		history.Head = (history.Head + 1) % TARGET_HISTORY_SIZE;
+		history.Count--;
+	}
+	// streamed a little ahead to make up for the render delay and the arm's lag
+	Pose predicted = PredictTarget(rightArm, timestamp, target, renderDelay);
+	TargetSample &slot = history.Samples[(history.Head + history.Count) % TARGET_HISTORY_SIZE];
+	slot.Time = timestamp;
+	slot.Target.Position = predicted.Position;
+	slot.Target.Orientation = Normalize(predicted.Orientation);
+	history.Count++;
+	history.HoldSent = false;
+}
+
+void ClearTargets(bool rightArm)
+{
+	lock_guard<mutex> lock(targetLock);
+	HistoryFor(rightArm).Count = 0;
+	ResetPredictor(rightArm);
+}
+
+static bool Sample(const TargetHistory &history, long long t, Pose &pose, bool &extrapolated, bool &held)
+{
+	extrapolated = false;
+	held = false;
+	if (history.Count == 0)
+	{
+		return false;
+	}
+
+	const TargetSample &first = SampleAt(history, 0);
+	if (history.Count == 1 || t <= first.Time)
+	{
+		// a single sample has no velocity to extrapolate with
+		pose = first.Target;
+		held = t > first.Time;
+		return true;
+	}
+
+	const TargetSample &newest = SampleAt(history, history.Count - 1);
+	if (t <= newest.Time)
+	{
+		// find the pair of samples around t
+		int i = history.Count - 1;
+		while (SampleAt(history, i - 1).Time > t)
+		{
+			i--;
+		}
+		const TargetSample &a = SampleAt(history, i - 1);
+		const TargetSample &b = SampleAt(history, i);
+		float u = (float)(t - a.Time) / (float)(b.Time - a.Time);
+		pose.Position = Lerp(a.Target.Position, b.Target.Position, u);
+		pose.Orientation = Slerp(a.Target.Orientation, b.Target.Orientation, u);
+		return true;
+	}
+
+	// past the newest sample: keep going with the last velocity for a while
+	const TargetSample &previous = SampleAt(history, history.Count - 2);
+	long long ahead = t - newest.Time;
+	if (ahead > TARGET_MAX_EXTRAPOLATION_MICROS)
+	{
+		ahead = TARGET_MAX_EXTRAPOLATION_MICROS;
+		held = true;
+	}
+	extrapolated = true;
+	float u = (float)ahead / (float)(newest.Time - previous.Time);
+	pose.Position = Add(newest.Target.Position, Scale(Sub(newest.Target.Position, previous.Target.Position), u));
+	pose.Orientation = ApplyRotation(newest.Target.Orientation,
+		Scale(RotationBetween(previous.Target.Orientation, newest.Target.Orientation), u));
+	return true;
+}
+
+bool SampleTargets(bool rightArm, long long t, Pose &pose, bool &extrapolated, bool &held)
+{
+	lock_guard<mutex> lock(targetLock);
+	return Sample(HistoryFor(rightArm), t, pose, extrapolated, held);
+}
+
+// Samples the arm at renderTime. False when there is nothing to send: no
+// samples, or the held pose already went out and resendHold is false.
+static bool SampleArm(bool rightArm, long long renderTime, bool resendHold, Pose &pose, bool &held)
+{
+	TargetHistory &history = HistoryFor(rightArm);
+	bool extrapolated;
+	if (!Sample(history, renderTime, pose, extrapolated, held))
+	{
+		return false;
+	}
+	if (extrapolated)
+	{
+		stats.TicksExtrapolated++;
+	}
+	if (held)
+	{
+		stats.TicksHeld++;
+		if (history.HoldSent && !resendHold)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// True while the arm cannot take a command. scale is the thermal scale to
+// pace it by.
+static bool ArmBusy(bool rightArm, long long now, float scale)
+{
+	TargetHistory &history = HistoryFor(rightArm);
+
+	// a derated arm gets its commands further apart
+	if (scale < 1.0f && history.LastCommand != 0 && now - history.LastCommandTime < (long long)(periodMicros / scale))
+	{
+		stats.TicksThrottled++;
+		return true;
+	}
+
+	// latest wins: never stack a second command behind one the arm has not taken yet
+	CommandCompletion completion;
+	if (history.LastCommand != 0 && WaitForCompletion(history.LastCommand, 0, completion) == -1)
+	{
+		stats.TicksSkippedBusy++;
+		return true;
+	}
+	return false;
+}
+
+// Submits the pose sampled at renderTime to the arm. Returns the command ID, 0
+// if it was not taken.
+static unsigned int SendArm(bool rightArm, const Pose &pose, bool held, long long renderTime, long long now)
+{
+	TargetHistory &history = HistoryFor(rightArm);
+	float thetaX, thetaY, thetaZ;
+	ToKinovaEuler(pose.Orientation, thetaX, thetaY, thetaZ);
+	if (history.LastCommand != 0)
+	{
+		ToKinovaEulerNear(pose.Orientation, history.ThetaX, history.ThetaY, history.ThetaZ, thetaX, thetaY, thetaZ);
+	}
+
+	ArmCommand command = ArmCommand();
+	command.Type = CMD_MOVE_HAND;
+	command.RightArm = rightArm;
+	command.X = pose.Position.X;
+	command.Y = pose.Position.Y;
+	command.Z = pose.Position.Z;
+	command.ThetaX = thetaX;
+	command.ThetaY = thetaY;
+	command.ThetaZ = thetaZ;
+	// a held pose is as old as the last sample, not the render time
+	command.CaptureTime = held ? 0 : renderTime;
+
+	unsigned int id = SubmitCommand(command);
+	if (id != 0)
+	{
+		history.LastCommand = id;
+		history.LastCommandTime = now;
+		history.ThetaX = thetaX;
+		history.ThetaY = thetaY;
+		history.ThetaZ = thetaZ;
+		history.HoldSent = held;
+		stats.CommandsSent++;
+		RecordCommandedPosition(rightArm, now, pose.Position);
+	}
+	return id;
+}
+
+static void StreamArm(bool rightArm, long long renderTime)
+{
+	long long now = NowMicros();
+	Pose pose;
+	bool held;
+	if (SampleArm(rightArm, renderTime, false, pose, held) && !ArmBusy(rightArm, now, ThermalScale(rightArm)))
+	{
+		SendArm(rightArm, pose, held, renderTime, now);
+	}
+}
+
+// Both arms in lockstep (see DualArm.h).
+static void StreamArmPair(long long renderTime)
+{
+	TargetHistory &left = HistoryFor(false);
+	TargetHistory &right = HistoryFor(true);
+	if (left.Count == 0 || right.Count == 0)
+	{
+		StreamArm(false, renderTime);
+		StreamArm(true, renderTime);
+		return;
+	}
+
+	// a still hand goes again with its held pose while the other one moves, so
+	// the commands stay paired and the constraint sees both hands
+	Pose poses[2];
+	bool held[2];
+	SampleArm(false, renderTime, true, poses[0], held[0]);
+	SampleArm(true, renderTime, true, poses[1], held[1]);
+	if (held[0] && left.HoldSent && held[1] && right.HoldSent)
+	{
+		return;
+	}
+
+	// the pair goes at the pace of the more derated arm
+	long long now = NowMicros();
+	float scale = min(ThermalScale(false), ThermalScale(true));
+	bool leftBusy = ArmBusy(false, now, scale);
+	bool rightBusy = ArmBusy(true, now, scale);
+	if (leftBusy || rightBusy)
+	{
+		if (leftBusy != rightBusy)
+		{
+			RecordDualArmHeld();
+		}
+		return;
+	}
+
+	ConstrainDualArm(poses[0], poses[1]);
+	unsigned int leftId = SendArm(false, poses[0], held[0], renderTime, now);
+	unsigned int rightId = SendArm(true, poses[1], held[1], renderTime, now);
+	if (leftId != 0 && rightId != 0)
+	{
+		long long inputSkew = SampleAt(right, right.Count - 1).Time - SampleAt(left, left.Count - 1).Time;
+		RecordDualArmPair(leftId, rightId, inputSkew);
+	}
+}
+
+static void SchedulerLoop()
+{
+	long long nextTick = NowMicros();
+	while (streaming)
+	{
+		long long now = NowMicros();
+		if (now < nextTick)
+		{
+			// sleep most of the way, then yield so we wake up on time
+			if (nextTick - now > 2000)
+			{
+				this_thread::sleep_for(chrono::microseconds(nextTick - now - 1500));
+			}
+			else
+			{
+				this_thread::yield();
+			}
+			continue;
+		}
+
+		{
+			lock_guard<mutex> lock(targetLock);
+			long long lateness = now - nextTick;
+			if (lateness > stats.MaxLatenessMicros)
+			{
+				stats.MaxLatenessMicros = lateness;
+			}
+			stats.Ticks++;
+			if (DualArmCoordinated())
+			{
+				StreamArmPair(now - renderDelay);
+			}
+			else
+			{
+				StreamArm(false, now - renderDelay);
+				StreamArm(true, now - renderDelay);
+			}
+		}
+
+		nextTick += periodMicros;
+		if (nextTick < now)
+		{
+			// fell more than a tick behind (debugger, sleep, ...): don't try to catch up
+			nextTick = now + periodMicros;
+		}
+	}
+}
+
+int StartInterpolator(int rateHz, long long delayMicros)
+{
+	if (rateHz < TARGET_STREAM_MIN_RATE || rateHz > TARGET_STREAM_MAX_RATE)
+	{
+		return -2;
+	}
+	StopInterpolator();
+
+	{
+		lock_guard<mutex> lock(targetLock);
+		periodMicros = 1000000 / rateHz;
+		renderDelay = delayMicros < 0 ? 0 : delayMicros;
+		stats = TargetStreamStats();
+		histories[0] = TargetHistory();
+		histories[1] = TargetHistory();
+		ResetPredictor(false);
+		ResetPredictor(true);
+		ResetDualArm();
+	}
+
+#ifdef _WIN32
+	// default Windows timer resolution is 15.6 ms, far too coarse for this loop
+	timeBeginPeriod(1);
+#endif
+	streaming = true;
+	scheduler = thread(SchedulerLoop);
+	return 0;
+}
+
+void StopInterpolator()
+{
+	if (!streaming.exchange(false))
+	{
+		return;
+	}
+	scheduler.join();
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+bool InterpolatorRunning()
+{
+	return streaming;
+}
+
+void ReadTargetStreamStats(TargetStreamStats &result)
+{
+	lock_guard<mutex> lock(targetLock);
+	result = stats;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Fixed rate target stream. Unity pushes timestamped hand targets whenever it
+// has them; a native thread renders the stream a little in the past, blending
+// between samples (SLERP for orientation), and sends one MoveHand command per
+// arm per tick. Smoothness then depends on this thread, not on Unity's frame
+// rate, InvokeRepeating or GC pauses.
+//
+// Each arm is sent on its own unless the arms are coordinated (DualArm.h), in
+// which case both go out together or not at all.
+
+#define TARGET_STREAM_MIN_RATE 100
+#define TARGET_STREAM_MAX_RATE 500
+
+// Samples remembered per arm. At 90 Hz this is well over the render delay.
+#define TARGET_HISTORY_SIZE 32
+
+// How far past the newest sample we keep extrapolating before holding still.
+#define TARGET_MAX_EXTRAPOLATION_MICROS 50000
+
+// Counters since the stream was started. Mirrored by KinovaAPI.TargetStreamStats.
+struct TargetStreamStats
+{
+	unsigned int Ticks;
+	unsigned int CommandsSent;
+	// the arm was still busy with the previous tick's command
+	unsigned int TicksSkippedBusy;
+	// render time was past the newest sample
+	unsigned int TicksExtrapolated;
+	// render time was past the newest sample by more than the extrapolation limit
+	unsigned int TicksHeld;
+	// an arm was due but the thermal governor stretched its command period
+	unsigned int TicksThrottled;
+	// worst wake-up lateness of the scheduler thread
+	long long MaxLatenessMicros;
+};
+
+// rateHz must be in [TARGET_STREAM_MIN_RATE, TARGET_STREAM_MAX_RATE].
+// delayMicros is how far behind real time the stream is rendered; one or two
+// sample periods keeps it interpolating instead of extrapolating.
+// Returns 0, or -2 for a bad rate.
+int StartInterpolator(int rateHz, long long delayMicros);
+void StopInterpolator();
+bool InterpolatorRunning();
+
+// timestamp is on the NowMicros() clock. The target goes through the
+// predictor (see Predictor.h) before it is stored.
+void PushTarget(bool rightArm, long long timestamp, const Pose &target);
+
+// Forgets the samples of one arm, so it stops being streamed until the next push.
+void ClearTargets(bool rightArm);
+
+void ReadTargetStreamStats(TargetStreamStats &stats);
+
+// Pose of the stream for one arm at time t. Returns false when there are no samples.
+bool SampleTargets(bool rightArm, long long t, Pose &pose, bool &extrapolated, bool &held);
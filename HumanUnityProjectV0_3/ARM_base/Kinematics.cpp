@@ -0,0 +1,303 @@
+#include "Kinematics.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+#define PI_F 3.14159265359f
+#define DEG_TO_RAD (PI_F / 180.0f)
+
+// Jaco 2 6DOF lengths, meters
+#define D1 0.2755f
+#define D2 0.4100f
+#define D3 0.2073f
+#define D4 0.0741f
+#define D5 0.0741f
+#define D6 0.1600f
+#define E2 0.0098f
+
+#define IK_MAX_ITERATIONS 200
+#define IK_POSITION_TOLERANCE 0.001f
+#define IK_ORIENTATION_TOLERANCE 0.01f
+#define IK_DAMPING 0.05f
+// a meter of position error counts as much as this many radians
+#define IK_POSITION_WEIGHT 4.0f
+
+struct DhRow
+{
+	float Alpha;
+	float A;
+	float D;
+	// theta = Sign * q + Offset
+	float Sign;
+	float Offset;
+};
+
+static const DhRow *DhTable()
+{
+	// curved wrist, 30 degrees per bend
+	static const float aa = PI_F / 6.0f;
+	static const float ratio = sinf(aa) / sinf(2.0f * aa);
+	static const DhRow rows[ARM_DOF] =
+	{
+		{ PI_F / 2.0f, 0.0f, D1, -1.0f, 0.0f },
+		{ PI_F, D2, 0.0f, 1.0f, -PI_F / 2.0f },
+		{ PI_F / 2.0f, 0.0f, -E2, 1.0f, PI_F / 2.0f },
+		{ 2.0f * aa, 0.0f, -(D3 + ratio * D4), 1.0f, 0.0f },
+		{ 2.0f * aa, 0.0f, -(ratio * D4 + ratio * D5), 1.0f, -PI_F },
+		{ PI_F, 0.0f, -(ratio * D5 + D6), 1.0f, PI_F / 2.0f },
+	};
+	return rows;
+}
+
+// mechanical limits of actuators 2 and 3, degrees
+static const float jointMin[ARM_DOF] = { 0.0f, 47.0f, 19.0f, 0.0f, 0.0f, 0.0f };
+static const float jointMax[ARM_DOF] = { 0.0f, 313.0f, 341.0f, 0.0f, 0.0f, 0.0f };
+
+bool IsContinuousJoint(int joint)
+{
+	return joint != 1 && joint != 2;
+}
+
+bool WithinJointLimits(const JointConfig &joints)
+{
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		if (!IsContinuousJoint(i) && (joints.Angles[i] < jointMin[i] || joints.Angles[i] > jointMax[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+float JointMinimum(int joint)
+{
+	return jointMin[joint];
+}
+
+float JointMaximum(int joint)
+{
+	return jointMax[joint];
+}
+
+float JointMaxVelocity(int joint)
+{
+	return joint < 3 ? 36.0f : 48.0f;
+}
+
+float JointMaxAcceleration(int joint)
+{
+	return joint < 3 ? 80.0f : 100.0f;
+}
+
+JointConfig HomeJoints()
+{
+	JointConfig home = { { 275.0f, 167.5f, 57.5f, 240.0f, 82.5f, 75.0f } };
+	return home;
+}
+
+static Pose Compose(const Pose &a, const Pose &b)
+{
+	Pose result;
+	result.Position = Add(a.Position, Rotate(a.Orientation, b.Position));
+	result.Orientation = Normalize(Multiply(a.Orientation, b.Orientation));
+	return result;
+}
+
+// Rz(theta) Tz(d) Tx(a) Rx(alpha)
+static Pose DhTransform(const DhRow &row, float theta)
+{
+	Quat rz = MakeQuat(0.0f, 0.0f, sinf(theta * 0.5f), cosf(theta * 0.5f));
+	Quat rx = MakeQuat(sinf(row.Alpha * 0.5f), 0.0f, 0.0f, cosf(row.Alpha * 0.5f));
+	Pose transform;
+	transform.Position = MakeVec3(row.A * cosf(theta), row.A * sinf(theta), row.D);
+	transform.Orientation = Multiply(rz, rx);
+	return transform;
+}
+
+void ForwardKinematics(const JointConfig &joints, ArmFrames &frames)
+{
+	const DhRow *rows = DhTable();
+	Pose current;
+	current.Position = MakeVec3(0.0f, 0.0f, 0.0f);
+	current.Orientation = MakeQuat(0.0f, 0.0f, 0.0f, 1.0f);
+	frames.Frames[0] = current.Position;
+
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		float theta = rows[i].Sign * joints.Angles[i] * DEG_TO_RAD + rows[i].Offset;
+		current = Compose(current, DhTransform(rows[i], theta));
+		frames.Frames[i + 1] = current.Position;
+	}
+	frames.EndEffector = current;
+}
+
+Pose EndEffectorPose(const JointConfig &joints)
+{
+	ArmFrames frames;
+	ForwardKinematics(joints, frames);
+	return frames.EndEffector;
+}
+
+static void PoseError(const Pose &target, const Pose &current, float error[6])
+{
+	Vec3 position = Scale(Sub(target.Position, current.Position), IK_POSITION_WEIGHT);
+	Vec3 rotation = RotationBetween(current.Orientation, target.Orientation);
+	error[0] = position.X;
+	error[1] = position.Y;
+	error[2] = position.Z;
+	error[3] = rotation.X;
+	error[4] = rotation.Y;
+	error[5] = rotation.Z;
+}
+
+// Solves a x = b in place with partial pivoting. False if singular.
+static bool Solve6(float a[6][6], float b[6])
+{
+	for (int col = 0; col < 6; col++)
+	{
+		int pivot = col;
+		for (int row = col + 1; row < 6; row++)
+		{
+			if (fabsf(a[row][col]) > fabsf(a[pivot][col]))
+			{
+				pivot = row;
+			}
+		}
+		if (fabsf(a[pivot][col]) < 1e-12f)
+		{
+			return false;
+		}
+		if (pivot != col)
+		{
+			for (int k = 0; k < 6; k++)
+			{
+				swap(a[col][k], a[pivot][k]);
+			}
+			swap(b[col], b[pivot]);
+		}
+		for (int row = col + 1; row < 6; row++)
+		{
+			float f = a[row][col] / a[col][col];
+			for (int k = col; k < 6; k++)
+			{
+				a[row][k] -= f * a[col][k];
+			}
+			b[row] -= f * b[col];
+		}
+	}
+	for (int row = 5; row >= 0; row--)
+	{
+		for (int k = row + 1; k < 6; k++)
+		{
+			b[row] -= a[row][k] * b[k];
+		}
+		b[row] /= a[row][row];
+	}
+	return true;
+}
+
+bool InverseKinematics(const Pose &target, const JointConfig &seed, JointConfig &joints)
+{
+	const float step = 0.01f;
+	joints = seed;
+
+	for (int iteration = 0; iteration < IK_MAX_ITERATIONS; iteration++)
+	{
+		Pose current = EndEffectorPose(joints);
+		float error[6];
+		PoseError(target, current, error);
+
+		float positionError = Length(MakeVec3(error[0], error[1], error[2])) / IK_POSITION_WEIGHT;
+		float orientationError = Length(MakeVec3(error[3], error[4], error[5]));
+		if (positionError < IK_POSITION_TOLERANCE && orientationError < IK_ORIENTATION_TOLERANCE)
+		{
+			return WithinJointLimits(joints);
+		}
+
+		// numeric Jacobian, per radian of joint motion
+		float jacobian[6][ARM_DOF];
+		for (int j = 0; j < ARM_DOF; j++)
+		{
+			JointConfig moved = joints;
+			moved.Angles[j] += step / DEG_TO_RAD;
+			float movedError[6];
+			PoseError(target, EndEffectorPose(moved), movedError);
+			for (int i = 0; i < 6; i++)
+			{
+				jacobian[i][j] = (error[i] - movedError[i]) / step;
+			}
+		}
+
+		// (J^T J + lambda^2 I) dq = J^T e
+		float normal[6][6];
+		float rhs[6];
+		for (int r = 0; r < ARM_DOF; r++)
+		{
+			rhs[r] = 0.0f;
+			for (int i = 0; i < 6; i++)
+			{
+				rhs[r] += jacobian[i][r] * error[i];
+			}
+			for (int c = 0; c < ARM_DOF; c++)
+			{
+				normal[r][c] = r == c ? IK_DAMPING * IK_DAMPING : 0.0f;
+				for (int i = 0; i < 6; i++)
+				{
+					normal[r][c] += jacobian[i][r] * jacobian[i][c];
+				}
+			}
+		}
+		if (!Solve6(normal, rhs))
+		{
+			return false;
+		}
+
+		for (int j = 0; j < ARM_DOF; j++)
+		{
+			// at most 10 degrees per step keeps it from jumping branches
+			float delta = max(-10.0f, min(10.0f, rhs[j] / DEG_TO_RAD));
+			joints.Angles[j] += delta;
+			if (!IsContinuousJoint(j))
+			{
+				joints.Angles[j] = max(jointMin[j], min(jointMax[j], joints.Angles[j]));
+			}
+		}
+	}
+	return false;
+}
+
+float JointDistance(const JointConfig &a, const JointConfig &b)
+{
+	float distance = 0.0f;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		distance = max(distance, fabsf(a.Angles[i] - b.Angles[i]));
+	}
+	return distance;
+}
+
+JointConfig LerpJoints(const JointConfig &a, const JointConfig &b, float t)
+{
+	JointConfig result;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		result.Angles[i] = a.Angles[i] + (b.Angles[i] - a.Angles[i]) * t;
+	}
+	return result;
+}
+
+JointConfig UnwrapJoints(const JointConfig &joints, const JointConfig &reference)
+{
+	JointConfig result = joints;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		if (IsContinuousJoint(i))
+		{
+			while (result.Angles[i] - reference.Angles[i] > 180.0f) result.Angles[i] -= 360.0f;
+			while (result.Angles[i] - reference.Angles[i] < -180.0f) result.Angles[i] += 360.0f;
+		}
+	}
+	return result;
+}
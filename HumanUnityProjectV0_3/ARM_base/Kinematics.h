@@ -0,0 +1,51 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Kinematic model of the Jaco 2 6DOF curved wrist arm (j2n6s300), taken from
+// Kinova's DH parameters. Joint angles are the actuator angles the Kinova API
+// reports, in degrees.
+
+#define ARM_DOF 6
+
+struct JointConfig
+{
+	float Angles[ARM_DOF];
+};
+
+// Joints that can turn forever. The others stop at their mechanical limits.
+bool IsContinuousJoint(int joint);
+bool WithinJointLimits(const JointConfig &joints);
+// Mechanical range of a joint that is not continuous, degrees.
+float JointMinimum(int joint);
+float JointMaximum(int joint);
+// What the actuator can do, deg/s and deg/s^2. The big actuators 1-3 are
+// slower than the wrist.
+float JointMaxVelocity(int joint);
+float JointMaxAcceleration(int joint);
+
+// Kinova's own home position.
+JointConfig HomeJoints();
+
+// Origin of every DH frame: Frames[0] is the base, Frames[ARM_DOF] the end
+// effector. Used by the collision model.
+struct ArmFrames
+{
+	Vec3 Frames[ARM_DOF + 1];
+	Pose EndEffector;
+};
+
+void ForwardKinematics(const JointConfig &joints, ArmFrames &frames);
+Pose EndEffectorPose(const JointConfig &joints);
+
+// Damped least squares from seed. Returns false unless the result is within a
+// millimeter and about half a degree of target and inside the joint limits.
+bool InverseKinematics(const Pose &target, const JointConfig &seed, JointConfig &joints);
+
+// Largest single joint difference, degrees.
+float JointDistance(const JointConfig &a, const JointConfig &b);
+
+JointConfig LerpJoints(const JointConfig &a, const JointConfig &b, float t);
+
+// Shifts the continuous joints of joints by whole turns to be closest to reference.
+JointConfig UnwrapJoints(const JointConfig &joints, const JointConfig &reference);
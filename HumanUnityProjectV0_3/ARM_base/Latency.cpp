@@ -0,0 +1,201 @@
+#include "Latency.h"
+#include <algorithm>
+#include <mutex>
+
+using namespace std;
+
+// how far back a commanded position can still match the arm
+#define LATENCY_MAX_MATCH_MICROS ((long long)LATENCY_BUCKET_MICROS * LATENCY_BUCKET_COUNT)
+
+struct Histogram
+{
+	unsigned int Buckets[LATENCY_BUCKET_COUNT];
+	unsigned int Count;
+	double Sum;
+	long long Max;
+};
+
+struct CommandedPosition
+{
+	long long Time;
+	Vec3 Position;
+};
+
+struct MotionTracker
+{
+	CommandedPosition Commanded[LATENCY_COMMAND_HISTORY];
+	int Head;
+	int Count;
+	bool HasObserved;
+	long long ObservedTime;
+	Vec3 Observed;
+};
+
+static mutex latencyLock;
+static Histogram histograms[LATENCY_HISTOGRAM_COUNT];
+static MotionTracker trackers[2];
+
+static bool ValidHistogram(int histogram)
+{
+	return histogram >= 0 && histogram < LATENCY_HISTOGRAM_COUNT;
+}
+
+// Lock must be held.
+static void Record(Histogram &h, long long micros)
+{
+	if (h.Count >= LATENCY_DECAY_COUNT)
+	{
+		h.Count = 0;
+		for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+		{
+			h.Buckets[i] /= 2;
+			h.Count += h.Buckets[i];
+		}
+		h.Sum /= 2.0;
+	}
+	long long bucket = max(0LL, min((long long)LATENCY_BUCKET_COUNT - 1, micros / LATENCY_BUCKET_MICROS));
+	h.Buckets[bucket]++;
+	h.Count++;
+	h.Sum += (double)micros;
+	h.Max = max(h.Max, micros);
+}
+
+// Lock must be held.
+static long long Percentile(const Histogram &h, float fraction)
+{
+	if (h.Count == 0)
+	{
+		return -1;
+	}
+	unsigned int rank = (unsigned int)(fraction * (h.Count - 1));
+	unsigned int seen = 0;
+	for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+	{
+		seen += h.Buckets[i];
+		if (seen > rank)
+		{
+			return (long long)i * LATENCY_BUCKET_MICROS + LATENCY_BUCKET_MICROS / 2;
+		}
+	}
+	return (long long)(LATENCY_BUCKET_COUNT - 1) * LATENCY_BUCKET_MICROS + LATENCY_BUCKET_MICROS / 2;
+}
+
+void RecordLatency(int histogram, long long micros)
+{
+	if (!ValidHistogram(histogram))
+	{
+		return;
+	}
+	lock_guard<mutex> lock(latencyLock);
+	Record(histograms[histogram], micros);
+}
+
+void ResetLatency(int histogram)
+{
+	if (!ValidHistogram(histogram))
+	{
+		return;
+	}
+	lock_guard<mutex> lock(latencyLock);
+	histograms[histogram] = Histogram();
+}
+
+bool ReadLatencyStats(int histogram, LatencyStats &stats)
+{
+	if (!ValidHistogram(histogram))
+	{
+		return false;
+	}
+	lock_guard<mutex> lock(latencyLock);
+	const Histogram &h = histograms[histogram];
+	stats.Count = h.Count;
+	stats.MeanMicros = h.Count > 0 ? (long long)(h.Sum / h.Count) : 0;
+	stats.P50Micros = Percentile(h, 0.5f);
+	stats.P90Micros = Percentile(h, 0.9f);
+	stats.P99Micros = Percentile(h, 0.99f);
+	stats.MaxMicros = h.Max;
+	return true;
+}
+
+long long LatencyPercentile(int histogram, float fraction)
+{
+	if (!ValidHistogram(histogram))
+	{
+		return -1;
+	}
+	lock_guard<mutex> lock(latencyLock);
+	return Percentile(histograms[histogram], max(0.0f, min(1.0f, fraction)));
+}
+
+static const CommandedPosition &CommandedAt(const MotionTracker &tracker, int i)
+{
+	return tracker.Commanded[(tracker.Head + i) % LATENCY_COMMAND_HISTORY];
+}
+
+void RecordCommandedPosition(bool rightArm, long long time, const Vec3 &position)
+{
+	lock_guard<mutex> lock(latencyLock);
+	MotionTracker &tracker = trackers[rightArm ? 1 : 0];
+	if (tracker.Count > 0 && time <= CommandedAt(tracker, tracker.Count - 1).Time)
+	{
+		return;
+	}
+	if (tracker.Count == LATENCY_COMMAND_HISTORY)
+	{
+		tracker.Head = (tracker.Head + 1) % LATENCY_COMMAND_HISTORY;
+		tracker.Count--;
+	}
+	CommandedPosition &slot = tracker.Commanded[(tracker.Head + tracker.Count) % LATENCY_COMMAND_HISTORY];
+	slot.Time = time;
+	slot.Position = position;
+	tracker.Count++;
+}
+
+void ObserveArmPosition(bool rightArm, long long time, const Vec3 &position)
+{
+	lock_guard<mutex> lock(latencyLock);
+	MotionTracker &tracker = trackers[rightArm ? 1 : 0];
+	bool moving = false;
+	if (tracker.HasObserved && time > tracker.ObservedTime)
+	{
+		float seconds = (time - tracker.ObservedTime) * 1e-6f;
+		moving = Length(Sub(position, tracker.Observed)) / seconds >= LATENCY_MIN_SPEED;
+	}
+	tracker.HasObserved = true;
+	tracker.ObservedTime = time;
+	tracker.Observed = position;
+	if (!moving || tracker.Count < 2)
+	{
+		return;
+	}
+
+	// closest point of the commanded path over the window, newest segments first
+	float bestDistance = LATENCY_MATCH_DISTANCE;
+	long long bestTime = -1;
+	for (int i = tracker.Count - 1; i > 0; i--)
+	{
+		const CommandedPosition &a = CommandedAt(tracker, i - 1);
+		const CommandedPosition &b = CommandedAt(tracker, i);
+		if (b.Time > time)
+		{
+			continue;
+		}
+		if (time - b.Time > LATENCY_MAX_MATCH_MICROS)
+		{
+			break;
+		}
+		Vec3 segment = Sub(b.Position, a.Position);
+		float lengthSquared = Dot(segment, segment);
+		float u = lengthSquared > 1e-12f ? max(0.0f, min(1.0f, Dot(Sub(position, a.Position), segment) / lengthSquared)) : 1.0f;
+		float distance = Length(Sub(position, Add(a.Position, Scale(segment, u))));
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			bestTime = a.Time + (long long)(u * (b.Time - a.Time));
+		}
+	}
+	if (bestTime >= 0)
+	{
+		Record(histograms[LATENCY_MOTION], time - bestTime);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Latency histograms of the bridge, in microseconds.
+//
+// LATENCY_COMMAND is how long a queued command takes from SubmitCommand until
+// the worker is done sending it. LATENCY_MOTION is how far the arm trails the
+// streamed targets: every state refresh looks up when the target stream last
+// commanded the position the arm is at now. LATENCY_CAPTURE is how old the
+// sample a streamed move was taken from is once the move is sent: from when
+// the source captured it, on the operator's clock translated to this one (see
+// ClockSync.h), until the arm has it.
+
+enum LatencyHistogramId
+{
+	LATENCY_COMMAND = 0,
+	LATENCY_MOTION = 1,
+	LATENCY_CAPTURE = 2,
+	LATENCY_HISTOGRAM_COUNT
+};
+
+#define LATENCY_BUCKET_MICROS 2000
+#define LATENCY_BUCKET_COUNT 256
+
+// Once a histogram holds this many samples every bucket is halved, so it
+// follows changes instead of averaging over the whole session.
+#define LATENCY_DECAY_COUNT 4096
+
+// Motion latency is only measured while the arm moves at least this fast (m/s)
+// and sits within LATENCY_MATCH_DISTANCE (m) of a recent target.
+#define LATENCY_MIN_SPEED 0.02f
+#define LATENCY_MATCH_DISTANCE 0.005f
+
+// Commanded positions remembered per arm.
+#define LATENCY_COMMAND_HISTORY 256
+
+// Mirrored by KinovaAPI.LatencyStats. Percentiles are bucket centers.
+struct LatencyStats
+{
+	unsigned int Count;
+	long long MeanMicros;
+	long long P50Micros;
+	long long P90Micros;
+	long long P99Micros;
+	long long MaxMicros;
+};
+
+void RecordLatency(int histogram, long long micros);
+void ResetLatency(int histogram);
+
+// Returns false for an unknown histogram. Count is 0 when it is empty.
+bool ReadLatencyStats(int histogram, LatencyStats &stats);
+
+// fraction in [0, 1]. Returns -1 when the histogram is empty.
+long long LatencyPercentile(int histogram, float fraction);
+
+// Feed LATENCY_MOTION: the target stream reports what it commands, the state
+// refresh where the arm is.
+void RecordCommandedPosition(bool rightArm, long long time, const Vec3 &position);
+void ObserveArmPosition(bool rightArm, long long time, const Vec3 &position);
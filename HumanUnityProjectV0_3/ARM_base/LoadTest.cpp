@@ -0,0 +1,619 @@
+#include "LoadTest.h"
+#include "CommandQueue.h"
+#include "Presets.h"
+#include "Timing.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+using namespace std;
+
+// The hands move around this preset, and the orientation swings this far
+// about it, radians.
+#define LOAD_TEST_CENTER "HomePosition"
+#define LOAD_TEST_SWING 0.2f
+
+// Left in flight at the end before the stats are read, on top of the link's delay.
+#define LOAD_TEST_DRAIN_MICROS 50000
+
+struct ReplaySample
+{
+	double Time;
+	float Pose[6];
+};
+
+struct LoadOperator
+{
+	int Index;
+	UdpHandle Socket;
+	unsigned int Sequence;
+	PoseEncoder Encoder;
+	// as in TeleopClient: t1 of the probe waiting for an answer, the last
+	// answered exchange, and when to probe next
+	long long ProbeTime;
+	long long LastExchange[4];
+	long long NextProbe;
+	thread Worker;
+};
+
+// set up by RunLoadTest before any thread starts, read only while it runs
+static LoadTestConfig testConfig;
+static UdpAddress serverAddress;
+static long long startTime;
+static vector<ReplaySample> replay[2];
+static double replayLength;
+
+static atomic<bool> running(false);
+static LoadOperator operators[LOAD_TEST_MAX_OPERATORS];
+static atomic<unsigned int> framesSent(0);
+static atomic<unsigned int> sendFailures(0);
+static atomic<unsigned int> moves(0);
+// the server's thread submits a pose when the arm is done with the previous one
+static unsigned int armMoves[2];
+// owned by the command worker
+static mt19937 generator;
+
+void DefaultLoadTestConfig(LoadTestConfig &config)
+{
+	memset(&config, 0, sizeof(config));
+	config.Operators = 1;
+	config.RateHz = 90.0f;
+	config.Motion = LOAD_TEST_CIRCLE;
+	config.Amplitude = 0.05f;
+	config.PeriodSeconds = 2.0f;
+	config.Link.MeanBurst = 1.0f;
+	config.ArmMicros = 5000;
+	config.ArmJitterMicros = 1000;
+	config.Seconds = 60;
+	config.ReportSeconds = 10;
+}
+
+static bool ValidConfig(const LoadTestConfig &config)
+{
+	return config.Operators >= 1 && config.Operators <= LOAD_TEST_MAX_OPERATORS &&
+		config.RateHz >= 1.0f && config.RateHz <= 1000.0f &&
+		config.Motion >= LOAD_TEST_CIRCLE && config.Motion <= LOAD_TEST_REPLAY &&
+		config.Amplitude >= 0.0f && config.Amplitude <= 0.5f && config.PeriodSeconds > 0.0f &&
+		config.Link.Loss >= 0.0f && config.Link.Loss < 1.0f && config.Link.MeanBurst >= 1.0f &&
+		config.Link.DelayMicros >= 0 && config.Link.JitterMicros >= 0 &&
+		config.ArmMicros >= 0 && config.ArmJitterMicros >= 0 &&
+		config.ArmMicros + config.ArmJitterMicros <= LOAD_TEST_MAX_ARM_MICROS &&
+		config.Seconds >= 0 && config.ReportSeconds >= 0;
+}
+
+bool ParseLoadTestArguments(const char *arguments, LoadTestConfig &config)
+{
+	istringstream in(arguments != NULL ? arguments : "");
+	string option;
+	string value;
+	while (in >> option)
+	{
+		if (!(in >> value))
+		{
+			return false;
+		}
+		const char *text = value.c_str();
+		if (option == "--operators")
+		{
+			config.Operators = atoi(text);
+		}
+		else if (option == "--rate")
+		{
+			config.RateHz = (float)atof(text);
+		}
+		else if (option == "--motion")
+		{
+			config.Motion = value == "circle" ? LOAD_TEST_CIRCLE : value == "sweep" ? LOAD_TEST_SWEEP :
+				value == "replay" ? LOAD_TEST_REPLAY : -1;
+		}
+		else if (option == "--replay")
+		{
+			config.Motion = LOAD_TEST_REPLAY;
+			strncpy(config.ReplayFile, text, sizeof(config.ReplayFile) - 1);
+		}
+		else if (option == "--amplitude")
+		{
+			config.Amplitude = (float)atof(text);
+		}
+		else if (option == "--period")
+		{
+			config.PeriodSeconds = (float)atof(text);
+		}
+		else if (option == "--loss")
+		{
+			config.Link.Loss = (float)atof(text);
+		}
+		else if (option == "--burst")
+		{
+			config.Link.MeanBurst = (float)atof(text);
+		}
+		else if (option == "--delay")
+		{
+			config.Link.DelayMicros = atoi(text);
+		}
+		else if (option == "--jitter")
+		{
+			config.Link.JitterMicros = atoi(text);
+		}
+		else if (option == "--arm")
+		{
+			config.ArmMicros = atoi(text);
+		}
+		else if (option == "--arm-jitter")
+		{
+			config.ArmJitterMicros = atoi(text);
+		}
+		else if (option == "--seconds")
+		{
+			config.Seconds = atoi(text);
+		}
+		else if (option == "--report")
+		{
+			config.ReportSeconds = atoi(text);
+		}
+		else if (option == "--out")
+		{
+			strncpy(config.OutFile, text, sizeof(config.OutFile) - 1);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return ValidConfig(config);
+}
+
+// line: <seconds> <left|right> x y z thetaX thetaY thetaZ
+static bool LoadReplay(const char *file)
+{
+	replay[0].clear();
+	replay[1].clear();
+	replayLength = 0.0;
+	ifstream in(file);
+	string line;
+	while (getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		char armName[16];
+		ReplaySample sample;
+		float *p = sample.Pose;
+		if (sscanf(line.c_str(), "%lf %15s %f %f %f %f %f %f", &sample.Time, armName,
+			&p[0], &p[1], &p[2], &p[3], &p[4], &p[5]) != 8)
+		{
+			continue;
+		}
+		bool rightArm = string(armName) == "right";
+		if (!rightArm && string(armName) != "left")
+		{
+			continue;
+		}
+		vector<ReplaySample> &samples = replay[rightArm ? 1 : 0];
+		// out of order samples are a recording we do not understand
+		if (!samples.empty() && sample.Time < samples.back().Time)
+		{
+			continue;
+		}
+		samples.push_back(sample);
+		replayLength = sample.Time > replayLength ? sample.Time : replayLength;
+	}
+	return !replay[0].empty() || !replay[1].empty();
+}
+
+// The arm's sample at t into the loop, the last one before it. False when the
+// recording has none of the arm.
+static bool ReplayPose(bool rightArm, double t, Pose &hand)
+{
+	const vector<ReplaySample> &samples = replay[rightArm ? 1 : 0];
+	if (samples.empty())
+	{
+		return false;
+	}
+	double into = replayLength > 0.0 ? fmod(t, replayLength) : 0.0;
+	size_t low = 0;
+	size_t high = samples.size();
+	while (high - low > 1)
+	{
+		size_t middle = (low + high) / 2;
+		if (samples[middle].Time <= into)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	const float *p = samples[low].Pose;
+	hand.Position = MakeVec3(p[0], p[1], p[2]);
+	hand.Orientation = FromKinovaEuler(p[3], p[4], p[5]);
+	return true;
+}
+
+// Each operator a share of a period ahead of the one before, so they do not
+// all ask for the same pose.
+static void ParametricPose(bool rightArm, int index, double t, Pose &hand)
+{
+	PresetPose center = MirrorForArm(*FindPreset(LOAD_TEST_CENTER), rightArm);
+	double angle = 2.0 * 3.14159265358979 * (t / testConfig.PeriodSeconds + (double)index / testConfig.Operators);
+	float a = testConfig.Amplitude;
+	float s = (float)sin(angle);
+	float c = (float)cos(angle);
+	Vec3 offset = testConfig.Motion == LOAD_TEST_SWEEP ? MakeVec3(a * s, 0.0f, 0.0f) : MakeVec3(0.0f, a * c, a * s);
+	hand.Position = Add(MakeVec3(center.X, center.Y, center.Z), offset);
+	hand.Orientation = FromKinovaEuler(center.ThetaX, center.ThetaY, center.ThetaZ + LOAD_TEST_SWING * s);
+}
+
+static void MakeFrame(int index, long long now, PoseFrame &frame)
+{
+	memset(&frame, 0, sizeof(frame));
+	double t = (now - startTime) * 1e-6;
+	for (int arm = 0; arm < 2; arm++)
+	{
+		bool rightArm = arm == 1;
+		if (testConfig.Motion == LOAD_TEST_REPLAY)
+		{
+			if (!ReplayPose(rightArm, t, frame.Hands[arm]))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			ParametricPose(rightArm, index, t, frame.Hands[arm]);
+		}
+		frame.Contents |= rightArm ? POSE_FRAME_RIGHT : POSE_FRAME_LEFT;
+	}
+}
+
+static bool Send(LoadOperator &op, TeleopMessage &message, long long now)
+{
+	message.Sequence = ++op.Sequence;
+	message.Timestamp = now;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(message, buffer, sizeof(buffer));
+	return size > 0 && SendUdp(op.Socket, serverAddress, buffer, size) == size;
+}
+
+static void SendFrame(LoadOperator &op, long long now)
+{
+	PoseFrame frame;
+	MakeFrame(op.Index, now, frame);
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_FRAME;
+	bool keyframe;
+	message.FrameSize = EncodePoseFrame(op.Encoder, frame, message.Frame, sizeof(message.Frame), keyframe);
+	if (Send(op, message, now))
+	{
+		framesSent++;
+	}
+	else
+	{
+		sendFailures++;
+	}
+}
+
+static void SendProbe(LoadOperator &op, long long now)
+{
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_SYNC;
+	memcpy(message.SyncTimes, op.LastExchange, sizeof(op.LastExchange));
+	op.NextProbe = now + LOAD_TEST_SYNC_PERIOD_MICROS;
+	if (Send(op, message, now))
+	{
+		op.ProbeTime = now;
+		memset(op.LastExchange, 0, sizeof(op.LastExchange));
+	}
+}
+
+// Frame acknowledgements and clock probe answers, for up to timeoutMs.
+static void Receive(LoadOperator &op, int timeoutMs)
+{
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	UdpAddress from;
+	int size = ReceiveUdp(op.Socket, buffer, sizeof(buffer), from, timeoutMs);
+	while (size > 0)
+	{
+		long long arrival = NowMicros();
+		TeleopMessage message;
+		if (SameUdpAddress(from, serverAddress) && DecodeTeleopMessage(buffer, size, message) == 0)
+		{
+			if (message.Type == TELEOP_FRAME_ACK)
+			{
+				AcknowledgePoseFrame(op.Encoder, message.FrameId);
+			}
+			else if (message.Type == TELEOP_SYNC_REPLY && op.ProbeTime != 0 && message.SyncTimes[0] == op.ProbeTime)
+			{
+				long long exchange[4] = { op.ProbeTime, message.SyncTimes[1], message.Timestamp, arrival };
+				memcpy(op.LastExchange, exchange, sizeof(op.LastExchange));
+				op.ProbeTime = 0;
+			}
+		}
+		size = ReceiveUdp(op.Socket, buffer, sizeof(buffer), from, 0);
+	}
+}
+
+static void OperatorLoop(LoadOperator *op)
+{
+	long long period = (long long)(1e6 / testConfig.RateHz);
+	// spread over the period, so the operators do not send in lockstep
+	long long next = NowMicros() + period * op->Index / testConfig.Operators;
+	while (running)
+	{
+		long long now = NowMicros();
+		if (now >= op->NextProbe)
+		{
+			SendProbe(*op, now);
+		}
+		if (now >= next)
+		{
+			SendFrame(*op, now);
+			next += period;
+			// a thread that fell behind skips frames rather than bursting them
+			next = next < now ? now + period : next;
+		}
+		long long left = next - NowMicros();
+		Receive(*op, left > 0 ? (int)(left / 1000) : 0);
+	}
+}
+
+// Teleop server sink, the way ARM_base.cpp feeds a real arm without the
+// target stream: the newest pose goes to the arm once it is done with the last.
+static bool LoadTestPose(bool rightArm, long long timestamp, int flags, const float *pose)
+{
+	int arm = rightArm ? 1 : 0;
+	CommandCompletion completion;
+	if (armMoves[arm] != 0 && WaitForCompletion(armMoves[arm], 0, completion) == -1)
+	{
+		return false;
+	}
+	ArmCommand command;
+	memset(&command, 0, sizeof(command));
+	command.Type = (flags & TELEOP_POSE_NO_THETA_Y) != 0 ? CMD_MOVE_HAND_NO_THETA_Y : CMD_MOVE_HAND;
+	command.RightArm = rightArm;
+	command.X = pose[0];
+	command.Y = pose[1];
+	command.Z = pose[2];
+	command.ThetaX = pose[3];
+	command.ThetaY = pose[4];
+	command.ThetaZ = pose[5];
+	command.CaptureTime = timestamp;
+	armMoves[arm] = SubmitCommand(command);
+	return true;
+}
+
+// the operators send nothing but frames
+static void LoadTestStop(bool)
+{
+}
+
+static void LoadTestHome(bool)
+{
+}
+
+static void LoadTestFingers(bool, int)
+{
+}
+
+// Simulated arm: a move takes ArmMicros plus jitter and always succeeds.
+static int SimulatedMove(const ArmCommand &command)
+{
+	long long micros = testConfig.ArmMicros;
+	if (testConfig.ArmJitterMicros > 0)
+	{
+		micros += uniform_int_distribution<int>(0, testConfig.ArmJitterMicros)(generator);
+	}
+	this_thread::sleep_for(chrono::microseconds(micros));
+	if (command.Type == CMD_MOVE_HAND || command.Type == CMD_MOVE_HAND_NO_THETA_Y)
+	{
+		moves++;
+	}
+	return 0;
+}
+
+static void StopOperators(int count)
+{
+	running = false;
+	for (int i = 0; i < count; i++)
+	{
+		if (operators[i].Worker.joinable())
+		{
+			operators[i].Worker.join();
+		}
+		CloseUdpSocket(operators[i].Socket);
+		operators[i].Socket = UDP_NO_SOCKET;
+	}
+}
+
+static void Snapshot(long long now, LoadTestReport &report)
+{
+	report.Seconds = (now - startTime) * 1e-6;
+	report.Operators = testConfig.Operators;
+	report.FramesSent = framesSent;
+	report.SendFailures = sendFailures;
+	report.Moves = moves;
+	ReadTeleopServerStats(report.Server);
+	ReadLossyLinkStats(report.Link);
+	ReadLatencyStats(LATENCY_CAPTURE, report.EndToEnd);
+	ReadLatencyStats(LATENCY_COMMAND, report.Queue);
+
+	// a frame without a hand of the recording carries one pose
+	int hands = testConfig.Motion != LOAD_TEST_REPLAY ? 2 : (replay[0].empty() ? 0 : 1) + (replay[1].empty() ? 0 : 1);
+	report.PosesSent = report.FramesSent * hands;
+	report.PosesDropped = report.PosesSent > report.Moves ? report.PosesSent - report.Moves : 0;
+}
+
+static void WriteProgress(const LoadTestReport &report, const LoadTestReport &last, FILE *out)
+{
+	double seconds = report.Seconds - last.Seconds;
+	if (seconds <= 0.0)
+	{
+		return;
+	}
+	fprintf(out, "%8.1f s  frames %7.1f/s  moves %7.1f/s  dropped %5.1f%%  latency p50 %.1f p99 %.1f max %.1f ms\n",
+		report.Seconds, (report.FramesSent - last.FramesSent) / seconds, (report.Moves - last.Moves) / seconds,
+		report.PosesSent > last.PosesSent ?
+			100.0 * (report.PosesDropped - last.PosesDropped) / (report.PosesSent - last.PosesSent) : 0.0,
+		report.EndToEnd.P50Micros * 1e-3, report.EndToEnd.P99Micros * 1e-3, report.EndToEnd.MaxMicros * 1e-3);
+	fflush(out);
+}
+
+static void WriteLatency(const char *name, const LatencyStats &stats, FILE *out)
+{
+	if (stats.Count == 0)
+	{
+		fprintf(out, "%-22s none\n", name);
+		return;
+	}
+	fprintf(out, "%-22s mean %.2f  p50 %.1f  p90 %.1f  p99 %.1f  max %.2f ms\n", name, stats.MeanMicros * 1e-3,
+		stats.P50Micros * 1e-3, stats.P90Micros * 1e-3, stats.P99Micros * 1e-3, stats.MaxMicros * 1e-3);
+}
+
+void WriteLoadTestReport(const LoadTestReport &report, FILE *out)
+{
+	const TeleopServerStats &server = report.Server;
+	double seconds = report.Seconds > 0.0 ? report.Seconds : 1.0;
+	fprintf(out, "--- %d operators, %.1f s\n", report.Operators, report.Seconds);
+	fprintf(out, "%-22s %u (%.1f/s), %u failed to send\n", "frames sent", report.FramesSent,
+		report.FramesSent / seconds, report.SendFailures);
+	fprintf(out, "%-22s %u of %u poses (%.1f/s)\n", "moves", report.Moves, report.PosesSent, report.Moves / seconds);
+	fprintf(out, "%-22s %u (%.2f%%)\n", "poses dropped", report.PosesDropped,
+		report.PosesSent > 0 ? 100.0 * report.PosesDropped / report.PosesSent : 0.0);
+	fprintf(out, "%-22s %u stale, %u superseded, %u refused by leases\n", "  by the server", server.PosesStale,
+		server.PosesSuperseded, server.CommandsRefused);
+	fprintf(out, "%-22s %u datagrams lost, %u frames undecodable, %u from operators over the limit\n", "  on the way",
+		server.Lost, server.FramesUndecodable, server.PeersRefused);
+	if (report.Link.Datagrams > 0)
+	{
+		fprintf(out, "%-22s %u of %u datagrams dropped, %u overflowed\n", "  by the lossy link", report.Link.Dropped,
+			report.Link.Datagrams, report.Link.Overflowed);
+	}
+	WriteLatency("send to arm done", report.EndToEnd, out);
+	WriteLatency("submit to arm done", report.Queue, out);
+	fprintf(out, "%-22s %s, offset %lld us, round trip %lld us\n", "clock of last prober",
+		server.ClockSynced != 0 ? "synced" : "not synced", server.ClockOffset, server.ClockDelay);
+	fflush(out);
+}
+
+int RunLoadTest(const LoadTestConfig &config, const atomic<bool> *stop, FILE *out, LoadTestReport &report)
+{
+	memset(&report, 0, sizeof(report));
+	if (!ValidConfig(config) || (config.Motion == LOAD_TEST_REPLAY && !LoadReplay(config.ReplayFile)))
+	{
+		return -2;
+	}
+	if (TeleopServerRunning() || CommandQueueRunning())
+	{
+		return -1;
+	}
+	testConfig = config;
+	generator.seed((unsigned int)NowMicros());
+	armMoves[0] = 0;
+	armMoves[1] = 0;
+	framesSent = 0;
+	sendFailures = 0;
+	moves = 0;
+	ResetLatency(LATENCY_CAPTURE);
+	ResetLatency(LATENCY_COMMAND);
+
+	StartCommandQueue(SimulatedMove);
+	TeleopSink sink = { LoadTestPose, NULL, LoadTestStop, LoadTestHome, LoadTestFingers };
+	if (OpenTeleopServer(0, sink) != 0)
+	{
+		StopCommandQueue();
+		return -3;
+	}
+	TeleopServerStats serverStats;
+	ReadTeleopServerStats(serverStats);
+	int port = serverStats.Port;
+	bool lossy = config.Link.Loss > 0.0f || config.Link.DelayMicros > 0 || config.Link.JitterMicros > 0;
+	if (lossy)
+	{
+		LossyLinkStats linkStats;
+		if (OpenLossyLink(0, "127.0.0.1", port, config.Link) != 0)
+		{
+			CloseTeleopServer();
+			StopCommandQueue();
+			return -3;
+		}
+		ReadLossyLinkStats(linkStats);
+		port = linkStats.Port;
+	}
+	ResolveUdpAddress("127.0.0.1", port, serverAddress);
+#ifdef _WIN32
+	// frame periods and simulated moves of a few milliseconds
+	timeBeginPeriod(1);
+#endif
+
+	int result = 0;
+	running = true;
+	startTime = NowMicros();
+	int started = 0;
+	for (; started < config.Operators; started++)
+	{
+		LoadOperator &op = operators[started];
+		op.Index = started;
+		op.Sequence = 0;
+		op.ProbeTime = 0;
+		op.NextProbe = 0;
+		memset(op.LastExchange, 0, sizeof(op.LastExchange));
+		ResetPoseEncoder(op.Encoder);
+		op.Socket = OpenUdpSocket(0);
+		if (op.Socket == UDP_NO_SOCKET)
+		{
+			result = -3;
+			break;
+		}
+		op.Worker = thread(OperatorLoop, &op);
+	}
+
+	LoadTestReport last;
+	memset(&last, 0, sizeof(last));
+	long long end = startTime + (long long)config.Seconds * 1000000;
+	long long nextReport = startTime + (long long)config.ReportSeconds * 1000000;
+	while (result == 0 && (config.Seconds == 0 || NowMicros() < end) && (stop == NULL || !*stop))
+	{
+		this_thread::sleep_for(chrono::milliseconds(10));
+		long long now = NowMicros();
+		if (config.ReportSeconds > 0 && now >= nextReport)
+		{
+			Snapshot(now, report);
+			WriteProgress(report, last, out);
+			last = report;
+			nextReport += (long long)config.ReportSeconds * 1000000;
+		}
+	}
+	long long stopped = NowMicros();
+	StopOperators(started);
+
+	// what is still on the way gets its chance to arrive
+	this_thread::sleep_for(chrono::microseconds(LOAD_TEST_DRAIN_MICROS + config.Link.DelayMicros +
+		config.Link.JitterMicros + 2 * (config.ArmMicros + config.ArmJitterMicros)));
+	Snapshot(stopped, report);
+	WriteLoadTestReport(report, out);
+
+	if (lossy)
+	{
+		CloseLossyLink();
+	}
+	CloseTeleopServer();
+	StopCommandQueue();
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+	return result;
+}
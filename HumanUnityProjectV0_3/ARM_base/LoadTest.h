@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Latency.h"
+#include "LossyLink.h"
+#include "TeleopServer.h"
+#include <atomic>
+#include <cstdio>
+
+// Soak test of the operator link without anyone in the headset: synthetic
+// operators stream frames (TELEOP_FRAME) of both hands to a teleop server in
+// this process, whose poses go to a simulated arm behind the command queue
+// the way ARM_base.cpp hands them to the real one. Optionally a lossy link
+// (LossyLink.h) sits in between. A run reports how many frames went out and
+// how many moves the arm made of them, where the rest were dropped, and the
+// latency from when an operator sent a pose until the arm was done with it.
+//
+// Each operator runs on a thread of its own and probes the server's clock as
+// TeleopClient does, so the server stamps poses with when they were sent and
+// the latency includes the way over the link. Operators move both hands in a
+// circle or a sweep, each a little out of phase with the others, or replay a
+// recorded trajectory.
+//
+// From a command line (see ParseLoadTestArguments for the options):
+// %windir%\SysWOW64\rundll32.exe ARM_base_32.dll,LoadTestMain --operators 2 --seconds 600 --loss 0.05
+
+// The server serves no more operators than TELEOP_MAX_PEERS, extra ones are
+// refused and show up as such.
+#define LOAD_TEST_MAX_OPERATORS 8
+
+// How often the operators probe the server's clock, and the simulated arm's
+// slowest move.
+#define LOAD_TEST_SYNC_PERIOD_MICROS 250000
+#define LOAD_TEST_MAX_ARM_MICROS 1000000
+
+enum LoadTestMotion
+{
+	LOAD_TEST_CIRCLE = 0,
+	// back and forth along x
+	LOAD_TEST_SWEEP = 1,
+	// ReplayFile
+	LOAD_TEST_REPLAY = 2,
+};
+
+struct LoadTestConfig
+{
+	int Operators;
+	// frames per second of each operator
+	float RateHz;
+	int Motion;
+	// circle radius or half the sweep, meters, and one turn, seconds
+	float Amplitude;
+	float PeriodSeconds;
+	// line: <seconds> <left|right> x y z thetaX thetaY thetaZ, played in a
+	// loop; each arm holds a sample until its next one
+	char ReplayFile[260];
+	// 0 for no lossy link in between
+	LossyLinkConfig Link;
+	// how long the simulated arm takes for a move, plus up to ArmJitterMicros
+	int ArmMicros;
+	int ArmJitterMicros;
+	// 0 runs until the stop flag is set
+	int Seconds;
+	// progress every ReportSeconds, 0 for none
+	int ReportSeconds;
+	// where LoadTestMain writes, empty for its console
+	char OutFile[260];
+};
+
+struct LoadTestReport
+{
+	double Seconds;
+	int Operators;
+	// frames the operators sent, and sends that failed
+	unsigned int FramesSent;
+	unsigned int SendFailures;
+	// poses in them, two per frame
+	unsigned int PosesSent;
+	// moves the arm made, and poses that never became one: the server's stale,
+	// superseded and refused ones, and those lost on the way
+	unsigned int Moves;
+	unsigned int PosesDropped;
+	TeleopServerStats Server;
+	LossyLinkStats Link;
+	// send to arm done, and submit to arm done; percentiles of the last few
+	// thousand moves (LATENCY_DECAY_COUNT), the max of the whole run
+	LatencyStats EndToEnd;
+	LatencyStats Queue;
+};
+
+void DefaultLoadTestConfig(LoadTestConfig &config);
+
+// --operators n --rate hz --motion circle|sweep|replay --replay file
+// --amplitude m --period s --loss share --burst n --delay us --jitter us
+// --arm us --arm-jitter us --seconds n --report n --out file. Returns false
+// on an unknown option or a value out of range, config holds what was read so
+// far.
+bool ParseLoadTestArguments(const char *arguments, LoadTestConfig &config);
+
+// Runs until config.Seconds are up or *stop is set (stop may be NULL), writing
+// progress lines and the final report to out.
+// returns:
+// 0 - done, report filled in
+// -1 - the teleop server or command queue is in use
+// -2 - the config is out of range, or the replay file holds no samples
+// -3 - the server, link or an operator's socket could not be opened
+int RunLoadTest(const LoadTestConfig &config, const std::atomic<bool> *stop, FILE *out, LoadTestReport &report);
+
+// The report as text, the last lines RunLoadTest writes.
+void WriteLoadTestReport(const LoadTestReport &report, FILE *out);
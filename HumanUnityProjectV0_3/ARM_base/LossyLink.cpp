@@ -0,0 +1,251 @@
+#include "LossyLink.h"
+#include "Timing.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+using namespace std;
+
+// Largest UDP payload in an Ethernet frame.
+#define MAX_DATAGRAM 1472
+
+// How long the relay waits for a datagram before it sends the due ones.
+#define RELAY_POLL_MS 1
+
+struct DelayedDatagram
+{
+	bool Valid;
+	bool ToServer;
+	int Client;
+	long long Due;
+	int Size;
+	unsigned char Data[MAX_DATAGRAM];
+};
+
+static mutex statsLock;
+static LossyLinkStats stats;
+static thread relay;
+static atomic<bool> running(false);
+static UdpHandle nearSocket = UDP_NO_SOCKET;
+// one far socket per client, so the server tells the clients apart
+static UdpHandle farSockets[LOSSY_LINK_MAX_CLIENTS];
+static UdpAddress serverAddress;
+static LossyLinkConfig linkConfig;
+// owned by the relay thread
+static DelayedDatagram queue[LOSSY_LINK_QUEUE];
+static int clients;
+static UdpAddress clientAddresses[LOSSY_LINK_MAX_CLIENTS];
+// in the bad state, per direction (0 to the server)
+static bool losing[2];
+static mt19937 generator;
+
+static void Count(unsigned int LossyLinkStats::*counter)
+{
+	lock_guard<mutex> lock(statsLock);
+	stats.*counter += 1;
+}
+
+static bool Lose(bool toServer)
+{
+	if (linkConfig.Loss <= 0.0f)
+	{
+		return false;
+	}
+	uniform_real_distribution<float> chance(0.0f, 1.0f);
+	bool &bad = losing[toServer ? 0 : 1];
+	// the bad state lasts MeanBurst datagrams on average and takes Loss of them
+	float leave = 1.0f / linkConfig.MeanBurst;
+	float enter = linkConfig.Loss / (linkConfig.MeanBurst * (1.0f - linkConfig.Loss));
+	bad = bad ? chance(generator) >= leave : chance(generator) < enter;
+	return bad;
+}
+
+static void Forward(bool toServer, int client, const unsigned char *data, int size)
+{
+	if (toServer)
+	{
+		SendUdp(farSockets[client], serverAddress, data, size);
+	}
+	else
+	{
+		SendUdp(nearSocket, clientAddresses[client], data, size);
+	}
+	Count(&LossyLinkStats::Forwarded);
+}
+
+static void Relay(bool toServer, int client, const unsigned char *data, int size, long long now)
+{
+	Count(&LossyLinkStats::Datagrams);
+	if (Lose(toServer))
+	{
+		Count(&LossyLinkStats::Dropped);
+		return;
+	}
+	if (linkConfig.DelayMicros == 0 && linkConfig.JitterMicros == 0)
+	{
+		Forward(toServer, client, data, size);
+		return;
+	}
+	for (int i = 0; i < LOSSY_LINK_QUEUE; i++)
+	{
+		DelayedDatagram &slot = queue[i];
+		if (!slot.Valid)
+		{
+			uniform_int_distribution<int> jitter(0, linkConfig.JitterMicros);
+			slot.Valid = true;
+			slot.ToServer = toServer;
+			slot.Client = client;
+			slot.Due = now + linkConfig.DelayMicros + jitter(generator);
+			slot.Size = size;
+			memcpy(slot.Data, data, size);
+			return;
+		}
+	}
+	Count(&LossyLinkStats::Overflowed);
+}
+
+static void SendDue(long long now)
+{
+	for (int i = 0; i < LOSSY_LINK_QUEUE; i++)
+	{
+		DelayedDatagram &slot = queue[i];
+		if (slot.Valid && slot.Due <= now)
+		{
+			Forward(slot.ToServer, slot.Client, slot.Data, slot.Size);
+			slot.Valid = false;
+		}
+	}
+}
+
+// The client's index, a new one gets a far socket of its own. -1 when there
+// are too many or the socket could not be opened.
+static int FindClient(const UdpAddress &address)
+{
+	for (int i = 0; i < clients; i++)
+	{
+		if (SameUdpAddress(clientAddresses[i], address))
+		{
+			return i;
+		}
+	}
+	if (clients == LOSSY_LINK_MAX_CLIENTS || (farSockets[clients] = OpenUdpSocket(0)) == UDP_NO_SOCKET)
+	{
+		return -1;
+	}
+	clientAddresses[clients] = address;
+	return clients++;
+}
+
+static void RelayLoop()
+{
+	static unsigned char buffer[MAX_DATAGRAM];
+	while (running)
+	{
+		UdpAddress from;
+		int size = ReceiveUdp(nearSocket, buffer, sizeof(buffer), from, RELAY_POLL_MS);
+		while (size > 0)
+		{
+			int client = FindClient(from);
+			if (client < 0)
+			{
+				Count(&LossyLinkStats::Datagrams);
+				Count(&LossyLinkStats::Dropped);
+			}
+			else
+			{
+				Relay(true, client, buffer, size, NowMicros());
+			}
+			size = ReceiveUdp(nearSocket, buffer, sizeof(buffer), from, 0);
+		}
+		for (int client = 0; client < clients; client++)
+		{
+			while ((size = ReceiveUdp(farSockets[client], buffer, sizeof(buffer), from, 0)) > 0)
+			{
+				if (SameUdpAddress(from, serverAddress))
+				{
+					Relay(false, client, buffer, size, NowMicros());
+				}
+			}
+		}
+		SendDue(NowMicros());
+	}
+}
+
+static void CloseSockets()
+{
+	CloseUdpSocket(nearSocket);
+	nearSocket = UDP_NO_SOCKET;
+	for (int i = 0; i < clients; i++)
+	{
+		CloseUdpSocket(farSockets[i]);
+	}
+	clients = 0;
+}
+
+int OpenLossyLink(int port, const char *host, int serverPort, const LossyLinkConfig &config)
+{
+	if (running)
+	{
+		return -1;
+	}
+	if (!(config.Loss >= 0.0f && config.Loss < 1.0f) || !(config.MeanBurst >= 1.0f) ||
+		config.DelayMicros < 0 || config.JitterMicros < 0)
+	{
+		return -4;
+	}
+	if (!ResolveUdpAddress(host, serverPort, serverAddress))
+	{
+		return -2;
+	}
+	nearSocket = OpenUdpSocket(port);
+	if (nearSocket == UDP_NO_SOCKET)
+	{
+		return -3;
+	}
+	linkConfig = config;
+	memset(queue, 0, sizeof(queue));
+	clients = 0;
+	losing[0] = false;
+	losing[1] = false;
+	generator.seed((unsigned int)NowMicros());
+	{
+		lock_guard<mutex> lock(statsLock);
+		stats = LossyLinkStats();
+		stats.Running = 1;
+		stats.Port = UdpLocalPort(nearSocket);
+	}
+#ifdef _WIN32
+	// the delays are far below the default 15.6 ms timer resolution
+	timeBeginPeriod(1);
+#endif
+	running = true;
+	relay = thread(RelayLoop);
+	return 0;
+}
+
+void CloseLossyLink()
+{
+	if (!running)
+	{
+		return;
+	}
+	running = false;
+	relay.join();
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+	CloseSockets();
+	lock_guard<mutex> lock(statsLock);
+	stats.Running = 0;
+}
+
+void ReadLossyLinkStats(LossyLinkStats &result)
+{
+	lock_guard<mutex> lock(statsLock);
+	result = stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "UdpSocket.h"
+
+// A bad network on the local machine, to try the operator link against: a
+// relay between a local port and the teleop server that drops, delays and
+// jitters datagrams both ways. The client connects to the relay's port
+// instead of the server. Several clients may share the relay, which talks to
+// the server from a socket per client so it tells them apart. Losses come in
+// bursts as on Wi-Fi (two states, good and bad, with every datagram in the
+// bad one lost).
+
+// Datagrams delayed at once; more are dropped and counted.
+#define LOSSY_LINK_QUEUE 256
+
+// Clients relayed while the link is open; datagrams of more are dropped.
+#define LOSSY_LINK_MAX_CLIENTS 8
+
+struct LossyLinkConfig
+{
+	// share of datagrams lost, 0 to 1
+	float Loss;
+	// mean datagrams lost in a row, 1 for independent losses
+	float MeanBurst;
+	// one way delay, plus up to JitterMicros more (which reorders datagrams)
+	int DelayMicros;
+	int JitterMicros;
+};
+
+// Mirrored by KinovaAPI.LossyLinkStats, keep them in sync.
+struct LossyLinkStats
+{
+	int Running;
+	int Port;
+	unsigned int Datagrams;
+	unsigned int Dropped;
+	unsigned int Forwarded;
+	// the delay queue was full
+	unsigned int Overflowed;
+};
+
+// port 0 takes any free port, see the stats for which.
+// returns:
+// 0 - relaying
+// -1 - already running
+// -2 - the server does not resolve
+// -3 - the socket could not be opened
+// -4 - the config is out of range
+int OpenLossyLink(int port, const char *host, int serverPort, const LossyLinkConfig &config);
+void CloseLossyLink();
+
+void ReadLossyLinkStats(LossyLinkStats &stats);
@@ -0,0 +1,256 @@
+#include "NatNetClient.h"
+#include "Timing.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+// Ping response: u16 message ID, u16 size, then the sender's name (256
+// bytes), its version and its NatNet version (4 bytes each).
+#define PING_RESPONSE_VERSION 264
+
+static mutex statsLock;
+static NatNetClientStats stats;
+static thread receiver;
+static atomic<bool> running(false);
+static UdpHandle dataSocket = UDP_NO_SOCKET;
+static UdpHandle commandSocket = UDP_NO_SOCKET;
+static bool pinging;
+static UdpAddress serverAddress;
+static int pinCpu;
+
+// Packets head - tail to head - 1 (mod NATNET_QUEUE_SIZE) are waiting. Only
+// the receive thread moves head, only the consumer moves tail.
+static vector<NatNetPacket> queue;
+static atomic<unsigned int> head(0);
+static atomic<unsigned int> tail(0);
+
+// Where datagrams go that have no room in the queue.
+static unsigned char discard[NATNET_MAX_PACKET];
+
+static bool PinThread(int cpu)
+{
+#ifdef _WIN32
+	return cpu < (int)(8 * sizeof(DWORD_PTR)) && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+static unsigned int MessageId(const unsigned char *data, int size)
+{
+	return size >= 4 ? data[0] | (data[1] << 8) : 0xFFFF;
+}
+
+static void Ping(long long now, long long &nextPing)
+{
+	if (!pinging || now < nextPing)
+	{
+		return;
+	}
+	nextPing = now + NATNET_PING_PERIOD_MICROS;
+	unsigned char ping[4] = { NATNET_PING, 0, 0, 0 };
+	SendUdp(commandSocket, serverAddress, ping, sizeof(ping));
+}
+
+static void TakeCommands()
+{
+	unsigned char buffer[512];
+	UdpAddress from;
+	int size;
+	while (pinging && (size = ReceiveUdp(commandSocket, buffer, sizeof(buffer), from, 0)) > 0)
+	{
+		if (MessageId(buffer, size) != NATNET_PING_RESPONSE || size < PING_RESPONSE_VERSION + 4)
+		{
+			continue;
+		}
+		lock_guard<mutex> lock(statsLock);
+		for (int i = 0; i < 4; i++)
+		{
+			stats.Version[i] = buffer[PING_RESPONSE_VERSION + i];
+		}
+		pinging = false;
+	}
+}
+
+// Frames go into the queue in the order they came, anything else is left out.
+static void TakeBatch(unsigned int first, int room, int received, const int *sizes, long long arrival)
+{
+	int kept = 0;
+	unsigned int frames = 0;
+	unsigned int dropped = 0;
+	unsigned int ignored = 0;
+	for (int i = 0; i < received; i++)
+	{
+		if (i >= room)
+		{
+			dropped++;
+			continue;
+		}
+		NatNetPacket &packet = queue[(first + i) % NATNET_QUEUE_SIZE];
+		if (MessageId(packet.Data, sizes[i]) != NATNET_FRAME_OF_DATA)
+		{
+			ignored++;
+			continue;
+		}
+		NatNetPacket &slot = queue[(first + kept) % NATNET_QUEUE_SIZE];
+		if (&slot != &packet)
+		{
+			memcpy(slot.Data, packet.Data, sizes[i]);
+		}
+		slot.Arrival = arrival;
+		slot.Size = sizes[i];
+		kept++;
+		frames++;
+	}
+	head.store(first + kept, memory_order_release);
+
+	lock_guard<mutex> lock(statsLock);
+	stats.Datagrams += received;
+	stats.Batches++;
+	stats.MaxBatch = received > stats.MaxBatch ? received : stats.MaxBatch;
+	stats.Frames += frames;
+	stats.Dropped += dropped;
+	stats.Ignored += ignored;
+}
+
+static void ReceiveLoop()
+{
+	if (pinCpu >= 0)
+	{
+		bool pinned = PinThread(pinCpu);
+		lock_guard<mutex> lock(statsLock);
+		stats.Pinned = pinned ? 1 : 0;
+	}
+	unsigned char *buffers[NATNET_RECEIVE_BATCH];
+	int sizes[NATNET_RECEIVE_BATCH];
+	long long nextPing = 0;
+	while (running)
+	{
+		Ping(NowMicros(), nextPing);
+		TakeCommands();
+		if (WaitUdpReadable(dataSocket, NATNET_POLL_MS) <= 0)
+		{
+			continue;
+		}
+		// the slots free once data is in; the consumer only ever frees more
+		unsigned int first = head.load(memory_order_relaxed);
+		int room = NATNET_QUEUE_SIZE - (int)(first - tail.load(memory_order_acquire));
+		room = room < NATNET_RECEIVE_BATCH ? room : NATNET_RECEIVE_BATCH;
+		for (int i = 0; i < NATNET_RECEIVE_BATCH; i++)
+		{
+			buffers[i] = i < room ? queue[(first + i) % NATNET_QUEUE_SIZE].Data : discard;
+		}
+		int received = ReceiveUdpBatch(dataSocket, buffers, NATNET_MAX_PACKET, sizes, NATNET_RECEIVE_BATCH, 0);
+		if (received > 0)
+		{
+			TakeBatch(first, room, received, sizes, NowMicros());
+		}
+	}
+}
+
+int OpenNatNetClient(const char *server, const char *localIp, int receiveCpu)
+{
+	if (running)
+	{
+		return -1;
+	}
+	pinging = server != NULL && server[0] != 0;
+	UdpAddress local;
+	if ((pinging && !ResolveUdpAddress(server, NATNET_COMMAND_PORT, serverAddress)) ||
+		(localIp != NULL && localIp[0] != 0 && !ResolveUdpAddress(localIp, 0, local)))
+	{
+		return -2;
+	}
+	dataSocket = OpenUdpMulticast(NATNET_MULTICAST_GROUP, NATNET_DATA_PORT, localIp, NATNET_RECEIVE_BUFFER);
+	commandSocket = pinging ? OpenUdpSocket(0) : UDP_NO_SOCKET;
+	if (dataSocket == UDP_NO_SOCKET || (pinging && commandSocket == UDP_NO_SOCKET))
+	{
+		CloseUdpSocket(dataSocket);
+		CloseUdpSocket(commandSocket);
+		dataSocket = UDP_NO_SOCKET;
+		commandSocket = UDP_NO_SOCKET;
+		return -3;
+	}
+	// allocated once, a consumer may still be reading a packet after a close
+	if (queue.empty())
+	{
+		queue.resize(NATNET_QUEUE_SIZE);
+	}
+	head = 0;
+	tail = 0;
+	pinCpu = receiveCpu;
+	{
+		lock_guard<mutex> lock(statsLock);
+		stats = NatNetClientStats();
+		stats.Running = 1;
+	}
+	running = true;
+	receiver = thread(ReceiveLoop);
+	return 0;
+}
+
+void CloseNatNetClient()
+{
+	if (!running)
+	{
+		return;
+	}
+	running = false;
+	receiver.join();
+	CloseUdpSocket(dataSocket);
+	CloseUdpSocket(commandSocket);
+	dataSocket = UDP_NO_SOCKET;
+	commandSocket = UDP_NO_SOCKET;
+	lock_guard<mutex> lock(statsLock);
+	stats.Running = 0;
+}
+
+bool NatNetClientRunning()
+{
+	return running;
+}
+
+const NatNetPacket *PeekNatNetPacket()
+{
+	unsigned int next = tail.load(memory_order_relaxed);
+	if (queue.empty() || next == head.load(memory_order_acquire))
+	{
+		return NULL;
+	}
+	return &queue[next % NATNET_QUEUE_SIZE];
+}
+
+void PopNatNetPacket()
+{
+	unsigned int next = tail.load(memory_order_relaxed);
+	if (next != head.load(memory_order_acquire))
+	{
+		tail.store(next + 1, memory_order_release);
+	}
+}
+
+int NatNetPacketsWaiting()
+{
+	return (int)(head.load(memory_order_acquire) - tail.load(memory_order_relaxed));
+}
+
+void ReadNatNetClientStats(NatNetClientStats &result)
+{
+	lock_guard<mutex> lock(statsLock);
+	result = stats;
+}
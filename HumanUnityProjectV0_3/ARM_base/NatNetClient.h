@@ -0,0 +1,89 @@
+#pragma once
+
+#include "UdpSocket.h"
+
+// Mocap ingest straight from Motive's NatNet stream, without NatNetLib.dll, on
+// Windows and Linux alike (UdpSocket.h). Motive multicasts every frame of
+// data to NATNET_MULTICAST_GROUP on NATNET_DATA_PORT and answers commands on
+// NATNET_COMMAND_PORT.
+//
+// The client joins the group and pings the server until it learns its NatNet
+// version, which tells how the frames are laid out. A receive thread of its
+// own, pinned to a core when asked, takes the datagrams in batches (one
+// system call per batch on Linux) straight into the slots of a queue with
+// one producer and one consumer and no locks: the receive thread never waits
+// for the consumer, and the consumer reads each packet where it landed. When
+// the consumer falls behind and the queue is full, arriving frames are
+// dropped and counted; the queued ones stay as they are, in order.
+//
+// Packets are kept as they came, NatNetFrame.h decodes them in place.
+
+#define NATNET_MULTICAST_GROUP "239.255.42.99"
+#define NATNET_COMMAND_PORT 1510
+#define NATNET_DATA_PORT 1511
+
+// NatNet message IDs, the first u16 of every packet
+#define NATNET_PING 0
+#define NATNET_PING_RESPONSE 1
+#define NATNET_FRAME_OF_DATA 7
+
+// Largest packet, a whole UDP datagram.
+#define NATNET_MAX_PACKET 65507
+
+// Packets queued at most, and taken per system call at most.
+#define NATNET_QUEUE_SIZE 64
+#define NATNET_RECEIVE_BATCH 16
+
+#define NATNET_RECEIVE_BUFFER (4 * 1024 * 1024)
+
+// How long the receive thread waits for data before it looks at the command
+// socket, and how often it pings a server that has not answered.
+#define NATNET_POLL_MS 10
+#define NATNET_PING_PERIOD_MICROS 1000000
+
+struct NatNetPacket
+{
+	// NowMicros() when the batch it came in was received
+	long long Arrival;
+	int Size;
+	unsigned char Data[NATNET_MAX_PACKET];
+};
+
+// Mirrored by KinovaAPI.NatNetClientStats, keep them in sync.
+struct NatNetClientStats
+{
+	int Running;
+	// NatNet version of the server (major, minor, build, revision), all 0
+	// until it answers a ping
+	int Version[4];
+	// the receive thread runs on the core asked for
+	int Pinned;
+	unsigned int Datagrams;
+	// system calls that brought datagrams, and the most in one
+	unsigned int Batches;
+	int MaxBatch;
+	unsigned int Frames;
+	// datagrams the full queue had no room for, and datagrams that were no frame
+	unsigned int Dropped;
+	unsigned int Ignored;
+};
+
+// server is where to ping, NULL or "" for none (the version then stays
+// unknown). localIp picks the interface to join the group on, NULL or "" for
+// the system's choice. receiveCpu pins the receive thread, -1 leaves it free.
+// returns:
+// 0 - receiving
+// -1 - already running
+// -2 - an address does not resolve
+// -3 - a socket could not be opened or the group not joined
+int OpenNatNetClient(const char *server, const char *localIp, int receiveCpu);
+void CloseNatNetClient();
+bool NatNetClientRunning();
+
+// The consumer's side, for one thread. The oldest packet waiting, NULL for
+// none; it stays valid and in place until popped.
+const NatNetPacket *PeekNatNetPacket();
+void PopNatNetPacket();
+int NatNetPacketsWaiting();
+
+void ReadNatNetClientStats(NatNetClientStats &stats);
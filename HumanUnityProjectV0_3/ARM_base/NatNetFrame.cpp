@@ -0,0 +1,672 @@
+#include "NatNetFrame.h"
+#include "NatNetClient.h"
+
+// Every layout the decoders are built for, oldest first.
+#define LAYOUT_1_0 0
+#define LAYOUT_2_0 (LAYOUT_1_0 | NATNET_HAS_MARKER_DETAILS)
+#define LAYOUT_2_1 (LAYOUT_2_0 | NATNET_HAS_SKELETONS)
+#define LAYOUT_2_3 (LAYOUT_2_1 | NATNET_HAS_LABELED_MARKERS)
+#define LAYOUT_2_6 (LAYOUT_2_3 | NATNET_HAS_TRACKING_FLAGS)
+#define LAYOUT_2_7 (LAYOUT_2_6 | NATNET_HAS_DOUBLE_TIMESTAMP)
+#define LAYOUT_2_9 (LAYOUT_2_7 | NATNET_HAS_FORCE_PLATES)
+
+static unsigned int ReadU16(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8);
+}
+
+static double ReadF64(const unsigned char *in)
+{
+	unsigned long long bits = NatNetReadU32(in) | ((unsigned long long)NatNetReadU32(in + 4) << 32);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// A count, false when fewer than count items of at least itemSize bytes are
+// left after it.
+static bool ReadCount(const unsigned char *&in, const unsigned char *end, int itemSize, int &count)
+{
+	if (end - in < 4)
+	{
+		return false;
+	}
+	count = (int)NatNetReadU32(in);
+	in += 4;
+	return count >= 0 && count <= (end - in) / itemSize;
+}
+
+// Bytes of a rigid body without its markers, and per marker.
+template <int Layout>
+struct RigidBodyLayout
+{
+	static const int Fixed = 36 + ((Layout & NATNET_HAS_MARKER_DETAILS) ? 4 : 0) +
+		((Layout & NATNET_HAS_TRACKING_FLAGS) ? 2 : 0);
+	static const int Marker = (Layout & NATNET_HAS_MARKER_DETAILS) ? 20 : 12;
+};
+
+// ID, position, orientation, the markers, then the mean error and the flags.
+template <int Layout>
+static bool DecodeRigidBody(const unsigned char *&in, const unsigned char *end, NatNetRigidBodies &bodies)
+{
+	typedef RigidBodyLayout<Layout> Sizes;
+	if (end - in < Sizes::Fixed)
+	{
+		return false;
+	}
+	int i = bodies.Count;
+	bodies.Id[i] = (int)NatNetReadU32(in);
+	bodies.X[i] = NatNetReadF32(in + 4);
+	bodies.Y[i] = NatNetReadF32(in + 8);
+	bodies.Z[i] = NatNetReadF32(in + 12);
+	bodies.QX[i] = NatNetReadF32(in + 16);
+	bodies.QY[i] = NatNetReadF32(in + 20);
+	bodies.QZ[i] = NatNetReadF32(in + 24);
+	bodies.QW[i] = NatNetReadF32(in + 28);
+	in += 32;
+	int markers;
+	if (!ReadCount(in, end, Sizes::Marker, markers))
+	{
+		return false;
+	}
+	bodies.MarkerCount[i] = markers;
+	bodies.Markers[i] = in;
+	in += markers * Sizes::Marker;
+	if (end - in < Sizes::Fixed - 36)
+	{
+		return false;
+	}
+	bodies.Error[i] = 0.0f;
+	bodies.Flags[i] = NATNET_TRACKING_VALID;
+	if (Layout & NATNET_HAS_MARKER_DETAILS)
+	{
+		bodies.Error[i] = NatNetReadF32(in);
+		in += 4;
+	}
+	if (Layout & NATNET_HAS_TRACKING_FLAGS)
+	{
+		bodies.Flags[i] = ReadU16(in);
+		in += 2;
+	}
+	bodies.Count++;
+	return true;
+}
+
+template <int Layout>
+static int DecodeFrame(const unsigned char *packet, int size, NatNetFrameView &view)
+{
+	typedef RigidBodyLayout<Layout> Sizes;
+	if (size < 4 || ReadU16(packet) != NATNET_FRAME_OF_DATA)
+	{
+		return -1;
+	}
+	if ((int)ReadU16(packet + 2) > size - 4)
+	{
+		return -2;
+	}
+	const unsigned char *in = packet + 4;
+	const unsigned char *end = in + ReadU16(packet + 2);
+	int count;
+
+	if (end - in < 4)
+	{
+		return -2;
+	}
+	view.FrameNumber = (int)NatNetReadU32(in);
+	in += 4;
+
+	// name, then the count of its markers
+	if (!ReadCount(in, end, 5, count))
+	{
+		return -2;
+	}
+	if (count > NATNET_MAX_MARKER_SETS)
+	{
+		return -3;
+	}
+	view.MarkerSetCount = count;
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned char *name = in;
+		const unsigned char *nul = (const unsigned char *)memchr(in, 0, end - in);
+		if (nul == NULL)
+		{
+			return -2;
+		}
+		in = nul + 1;
+		int markers;
+		if (!ReadCount(in, end, 12, markers))
+		{
+			return -2;
+		}
+		view.MarkerSetName[i] = (const char *)name;
+		view.MarkerSetSize[i] = markers;
+		view.MarkerSetMarkers[i] = in;
+		in += markers * 12;
+	}
+
+	if (!ReadCount(in, end, 12, count))
+	{
+		return -2;
+	}
+	view.UnlabeledCount = count;
+	view.Unlabeled = in;
+	in += count * 12;
+
+	if (!ReadCount(in, end, Sizes::Fixed, count))
+	{
+		return -2;
+	}
+	if (count > NATNET_MAX_RIGID_BODIES)
+	{
+		return -3;
+	}
+	view.RigidBodies.Count = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (!DecodeRigidBody<Layout>(in, end, view.RigidBodies))
+		{
+			return -2;
+		}
+	}
+
+	view.SkeletonCount = 0;
+	view.Bones.Count = 0;
+	if (Layout & NATNET_HAS_SKELETONS)
+	{
+		// ID, then the count of its bones
+		if (!ReadCount(in, end, 8, count))
+		{
+			return -2;
+		}
+		if (count > NATNET_MAX_SKELETONS)
+		{
+			return -3;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			if (end - in < 4)
+			{
+				return -2;
+			}
+			int id = (int)NatNetReadU32(in);
+			in += 4;
+			int bones;
+			if (!ReadCount(in, end, Sizes::Fixed, bones))
+			{
+				return -2;
+			}
+			if (bones > NATNET_MAX_BONES - view.Bones.Count)
+			{
+				return -3;
+			}
+			view.SkeletonId[i] = id;
+			view.SkeletonFirstBone[i] = view.Bones.Count;
+			view.SkeletonBoneCount[i] = bones;
+			for (int j = 0; j < bones; j++)
+			{
+				if (!DecodeRigidBody<Layout>(in, end, view.Bones))
+				{
+					return -2;
+				}
+			}
+			view.SkeletonCount++;
+		}
+	}
+
+	view.LabeledCount = 0;
+	view.LabeledStride = NATNET_LABELED_MARKER_SIZE + ((Layout & NATNET_HAS_TRACKING_FLAGS) ? 2 : 0);
+	view.Labeled = in;
+	if (Layout & NATNET_HAS_LABELED_MARKERS)
+	{
+		if (!ReadCount(in, end, view.LabeledStride, count))
+		{
+			return -2;
+		}
+		view.LabeledCount = count;
+		view.Labeled = in;
+		in += count * view.LabeledStride;
+	}
+
+	view.ForcePlateCount = 0;
+	if (Layout & NATNET_HAS_FORCE_PLATES)
+	{
+		// ID, then the count of its channels
+		if (!ReadCount(in, end, 8, count))
+		{
+			return -2;
+		}
+		if (count > NATNET_MAX_FORCE_PLATES)
+		{
+			return -3;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			if (end - in < 4)
+			{
+				return -2;
+			}
+			view.ForcePlateId[i] = (int)NatNetReadU32(in);
+			in += 4;
+			int channels;
+			if (!ReadCount(in, end, 4, channels))
+			{
+				return -2;
+			}
+			view.ForcePlateChannels[i] = channels;
+			view.ForcePlateData[i] = in;
+			for (int j = 0; j < channels; j++)
+			{
+				int samples;
+				if (!ReadCount(in, end, 4, samples))
+				{
+					return -2;
+				}
+				in += samples * 4;
+			}
+			view.ForcePlateCount++;
+		}
+	}
+
+	// latency, timecode, subframe, timestamp, flags; the end tag after them
+	// is not needed
+	const int timestampSize = (Layout & NATNET_HAS_DOUBLE_TIMESTAMP) ? 8 : 4;
+	if (end - in < 12 + timestampSize + 2)
+	{
+		return -2;
+	}
+	view.Latency = NatNetReadF32(in);
+	view.Timecode = NatNetReadU32(in + 4);
+	view.TimecodeSubframe = NatNetReadU32(in + 8);
+	in += 12;
+	view.Timestamp = (Layout & NATNET_HAS_DOUBLE_TIMESTAMP) ? ReadF64(in) : NatNetReadF32(in);
+	in += timestampSize;
+	view.Flags = ReadU16(in);
+	return 0;
+}
+
+// Steps over a rigid body, false when it runs past end.
+template <int Layout>
+static bool SkipRigidBody(const unsigned char *&in, const unsigned char *end)
+{
+	typedef RigidBodyLayout<Layout> Sizes;
+	if (end - in < Sizes::Fixed)
+	{
+		return false;
+	}
+	in += 32;
+	int markers;
+	if (!ReadCount(in, end, Sizes::Marker, markers))
+	{
+		return false;
+	}
+	in += markers * Sizes::Marker;
+	if (end - in < Sizes::Fixed - 36)
+	{
+		return false;
+	}
+	in += Sizes::Fixed - 36;
+	return true;
+}
+
+template <int Layout>
+static bool ReadPose(const unsigned char *&in, const unsigned char *end, NatNetPose &pose)
+{
+	const unsigned char *body = in;
+	if (!SkipRigidBody<Layout>(in, end))
+	{
+		return false;
+	}
+	const unsigned char *tail = in - (RigidBodyLayout<Layout>::Fixed - 36);
+	pose.Id = (int)NatNetReadU32(body);
+	pose.Found = 1;
+	pose.Flags = NATNET_TRACKING_VALID;
+	pose.Error = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		pose.Position[i] = NatNetReadF32(body + 4 + 4 * i);
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		pose.Orientation[i] = NatNetReadF32(body + 16 + 4 * i);
+	}
+	if (Layout & NATNET_HAS_MARKER_DETAILS)
+	{
+		pose.Error = NatNetReadF32(tail);
+		tail += 4;
+	}
+	if (Layout & NATNET_HAS_TRACKING_FLAGS)
+	{
+		pose.Flags = ReadU16(tail);
+	}
+	return true;
+}
+
+// One bit per ID modulo 64, so most IDs nobody subscribed to are turned away
+// without looking through the subscription.
+static unsigned long long IdFilter(const int *ids, int count)
+{
+	unsigned long long filter = 0;
+	for (int i = 0; i < count; i++)
+	{
+		filter |= 1ULL << (ids[i] & 63);
+	}
+	return filter;
+}
+
+static int Subscribed(const int *ids, int count, unsigned long long filter, int id)
+{
+	if ((filter >> (id & 63) & 1) == 0)
+	{
+		return -1;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (ids[i] == id)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Only IDs and lengths are read, to step from one entity to the next.
+template <int Layout>
+static int IndexFrame(const unsigned char *packet, int size, const NatNetSubscription &subscription,
+	NatNetFrameIndex &index)
+{
+	typedef RigidBodyLayout<Layout> Sizes;
+	if (size < 4 || ReadU16(packet) != NATNET_FRAME_OF_DATA)
+	{
+		return -1;
+	}
+	if ((int)ReadU16(packet + 2) > size - 4)
+	{
+		return -2;
+	}
+	const unsigned char *in = packet + 4;
+	const unsigned char *end = in + ReadU16(packet + 2);
+	int count;
+
+	if (end - in < 4)
+	{
+		return -2;
+	}
+	index.FrameNumber = (int)NatNetReadU32(in);
+	in += 4;
+
+	index.MarkerSets = (int)(in - packet);
+	if (!ReadCount(in, end, 5, count))
+	{
+		return -2;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned char *nul = (const unsigned char *)memchr(in, 0, end - in);
+		int markers;
+		if (nul == NULL)
+		{
+			return -2;
+		}
+		in = nul + 1;
+		if (!ReadCount(in, end, 12, markers))
+		{
+			return -2;
+		}
+		in += markers * 12;
+	}
+
+	index.Unlabeled = (int)(in - packet);
+	if (!ReadCount(in, end, 12, count))
+	{
+		return -2;
+	}
+	in += count * 12;
+
+	for (int i = 0; i < subscription.RigidBodyCount; i++)
+	{
+		index.RigidBody[i] = -1;
+	}
+	for (int i = 0; i < subscription.SkeletonCount; i++)
+	{
+		index.Skeleton[i] = -1;
+	}
+
+	index.RigidBodies = (int)(in - packet);
+	if (!ReadCount(in, end, Sizes::Fixed, count))
+	{
+		return -2;
+	}
+	unsigned long long filter = IdFilter(subscription.RigidBodyId, subscription.RigidBodyCount);
+	for (int i = 0; i < count; i++)
+	{
+		// the ID only once the whole body is known to be there
+		const unsigned char *body = in;
+		if (!SkipRigidBody<Layout>(in, end))
+		{
+			return -2;
+		}
+		int slot = Subscribed(subscription.RigidBodyId, subscription.RigidBodyCount, filter, (int)NatNetReadU32(body));
+		if (slot >= 0)
+		{
+			index.RigidBody[slot] = (int)(body - packet);
+		}
+	}
+
+	index.Skeletons = -1;
+	if (Layout & NATNET_HAS_SKELETONS)
+	{
+		index.Skeletons = (int)(in - packet);
+		if (!ReadCount(in, end, 8, count))
+		{
+			return -2;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			int bones;
+			if (end - in < 4)
+			{
+				return -2;
+			}
+			int slot = Subscribed(subscription.SkeletonId, subscription.SkeletonCount, ~0ULL, (int)NatNetReadU32(in));
+			if (slot >= 0)
+			{
+				index.Skeleton[slot] = (int)(in - packet);
+			}
+			in += 4;
+			if (!ReadCount(in, end, Sizes::Fixed, bones))
+			{
+				return -2;
+			}
+			for (int j = 0; j < bones; j++)
+			{
+				if (!SkipRigidBody<Layout>(in, end))
+				{
+					return -2;
+				}
+			}
+		}
+	}
+
+	index.Labeled = -1;
+	if (Layout & NATNET_HAS_LABELED_MARKERS)
+	{
+		const int stride = NATNET_LABELED_MARKER_SIZE + ((Layout & NATNET_HAS_TRACKING_FLAGS) ? 2 : 0);
+		index.Labeled = (int)(in - packet);
+		if (!ReadCount(in, end, stride, count))
+		{
+			return -2;
+		}
+		in += count * stride;
+	}
+
+	index.ForcePlates = -1;
+	if (Layout & NATNET_HAS_FORCE_PLATES)
+	{
+		index.ForcePlates = (int)(in - packet);
+		if (!ReadCount(in, end, 8, count))
+		{
+			return -2;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			int channels;
+			if (end - in < 4)
+			{
+				return -2;
+			}
+			in += 4;
+			if (!ReadCount(in, end, 4, channels))
+			{
+				return -2;
+			}
+			for (int j = 0; j < channels; j++)
+			{
+				int samples;
+				if (!ReadCount(in, end, 4, samples))
+				{
+					return -2;
+				}
+				in += samples * 4;
+			}
+		}
+	}
+
+	const int timestampSize = (Layout & NATNET_HAS_DOUBLE_TIMESTAMP) ? 8 : 4;
+	if (end - in < 12 + timestampSize + 2)
+	{
+		return -2;
+	}
+	index.Tail = (int)(in - packet);
+	index.End = (int)(end - packet);
+	return 0;
+}
+
+// Reads what the index points at; the rest of the frame is not touched.
+template <int Layout>
+static int SelectFrame(const unsigned char *packet, const NatNetFrameIndex &index,
+	const NatNetSubscription &subscription, NatNetSelection &selection)
+{
+	typedef RigidBodyLayout<Layout> Sizes;
+	const unsigned char *end = packet + index.End;
+	const unsigned char *in;
+
+	selection.FrameNumber = index.FrameNumber;
+	for (int i = 0; i < subscription.RigidBodyCount; i++)
+	{
+		NatNetPose &pose = selection.RigidBodies[i];
+		pose.Id = subscription.RigidBodyId[i];
+		pose.Found = 0;
+		in = index.RigidBody[i] >= 0 ? packet + index.RigidBody[i] : NULL;
+		if (in != NULL && !ReadPose<Layout>(in, end, pose))
+		{
+			return -2;
+		}
+	}
+
+	selection.BoneCount = 0;
+	for (int i = 0; i < subscription.SkeletonCount; i++)
+	{
+		int bones = 0;
+		in = index.Skeleton[i] >= 0 ? packet + index.Skeleton[i] + 4 : NULL;
+		if (in != NULL && !ReadCount(in, end, Sizes::Fixed, bones))
+		{
+			return -2;
+		}
+		if (bones > NATNET_MAX_SELECTED_BONES - selection.BoneCount)
+		{
+			return -3;
+		}
+		selection.SkeletonFirstBone[i] = selection.BoneCount;
+		selection.SkeletonBoneCount[i] = bones;
+		for (int j = 0; j < bones; j++)
+		{
+			if (!ReadPose<Layout>(in, end, selection.Bones[selection.BoneCount++]))
+			{
+				return -2;
+			}
+		}
+	}
+
+	const int timestampSize = (Layout & NATNET_HAS_DOUBLE_TIMESTAMP) ? 8 : 4;
+	in = packet + index.Tail;
+	if (end - in < 12 + timestampSize + 2)
+	{
+		return -2;
+	}
+	selection.Timestamp = (Layout & NATNET_HAS_DOUBLE_TIMESTAMP) ? ReadF64(in + 12) : NatNetReadF32(in + 12);
+	selection.Flags = ReadU16(in + 12 + timestampSize);
+	return 0;
+}
+
+int NatNetFrameLayout(const int version[4])
+{
+	int major = version[0];
+	int minor = version[1];
+	if (major == 0 && minor == 0 && version[2] == 0 && version[3] == 0)
+	{
+		return LAYOUT_2_9;
+	}
+	if (major < 1 || major > 2)
+	{
+		return -1;
+	}
+	if (major == 1)
+	{
+		return LAYOUT_1_0;
+	}
+	return minor >= 9 ? LAYOUT_2_9 : minor >= 7 ? LAYOUT_2_7 : minor >= 6 ? LAYOUT_2_6 :
+		minor >= 3 ? LAYOUT_2_3 : minor >= 1 ? LAYOUT_2_1 : LAYOUT_2_0;
+}
+
+struct LayoutCodec
+{
+	int Layout;
+	NatNetDecoder Decode;
+	NatNetIndexer Index;
+	NatNetSelector Select;
+};
+
+#define LAYOUT_CODEC(layout) { layout, DecodeFrame<layout>, IndexFrame<layout>, SelectFrame<layout> }
+
+static const LayoutCodec codecs[] =
+{
+	LAYOUT_CODEC(LAYOUT_1_0),
+	LAYOUT_CODEC(LAYOUT_2_0),
+	LAYOUT_CODEC(LAYOUT_2_1),
+	LAYOUT_CODEC(LAYOUT_2_3),
+	LAYOUT_CODEC(LAYOUT_2_6),
+	LAYOUT_CODEC(LAYOUT_2_7),
+	LAYOUT_CODEC(LAYOUT_2_9),
+};
+
+static const LayoutCodec *FindCodec(const int version[4])
+{
+	int layout = NatNetFrameLayout(version);
+	for (unsigned int i = 0; i < sizeof(codecs) / sizeof(codecs[0]); i++)
+	{
+		if (codecs[i].Layout == layout)
+		{
+			return &codecs[i];
+		}
+	}
+	return NULL;
+}
+
+NatNetDecoder SelectNatNetDecoder(const int version[4])
+{
+	const LayoutCodec *codec = FindCodec(version);
+	return codec != NULL ? codec->Decode : NULL;
+}
+
+NatNetIndexer SelectNatNetIndexer(const int version[4])
+{
+	const LayoutCodec *codec = FindCodec(version);
+	return codec != NULL ? codec->Index : NULL;
+}
+
+NatNetSelector SelectNatNetSelector(const int version[4])
+{
+	const LayoutCodec *codec = FindCodec(version);
+	return codec != NULL ? codec->Select : NULL;
+}
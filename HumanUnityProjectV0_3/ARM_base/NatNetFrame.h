@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstring>
+
+// Decoding NatNet frames of data (NATNET_FRAME_OF_DATA, see NatNetClient.h)
+// where they were received, for NatNet 1.x to 2.10, the versions the SDK in
+// FutureWork documents (PacketClient.cpp).
+//
+// Which fields a frame carries depends on the server's NatNet version, so
+// there is one decoder per layout, each compiled for that layout alone:
+// SelectNatNetDecoder picks it once per connection and decoding then never
+// asks for the version again. A decoder walks the packet once, checking every
+// count and string against the end of the packet before it reads past them,
+// and fills in a NatNetFrameView: the rigid bodies and skeleton bones split
+// into one array per field, everything else (names, markers, force plate
+// samples) pointers into the packet. Nothing is copied but the scalars, and
+// the view is only good as long as the packet is.
+//
+// Data in the packet is little endian and not aligned, read it through
+// NatNetReadU32 / NatNetReadF32.
+
+// Most of each the view holds; the SDK's own limits.
+#define NATNET_MAX_MARKER_SETS 200
+#define NATNET_MAX_RIGID_BODIES 1000
+#define NATNET_MAX_SKELETONS 100
+#define NATNET_MAX_BONES 1000
+#define NATNET_MAX_FORCE_PLATES 8
+
+// What a frame has beyond the 1.x layout, and the version it came with.
+// rigid body marker IDs and sizes, and mean marker error (2.0)
+#define NATNET_HAS_MARKER_DETAILS 0x01
+// skeletons (2.1)
+#define NATNET_HAS_SKELETONS 0x02
+// labeled markers (2.3)
+#define NATNET_HAS_LABELED_MARKERS 0x04
+// tracking flags on rigid bodies and labeled markers (2.6)
+#define NATNET_HAS_TRACKING_FLAGS 0x08
+// double precision timestamp (2.7)
+#define NATNET_HAS_DOUBLE_TIMESTAMP 0x10
+// force plates (2.9)
+#define NATNET_HAS_FORCE_PLATES 0x20
+
+// Rigid body tracking flags; before 2.6 every rigid body counts as tracked.
+#define NATNET_TRACKING_VALID 0x01
+
+// A labeled marker: ID, x, y, z, size, then tracking flags (u16) from 2.6.
+#define NATNET_LABELED_MARKER_SIZE 20
+
+// One array per field, index i is one rigid body. Markers points at its
+// MarkerCount positions (3 floats each), followed from 2.0 on by as many IDs
+// (u32) and sizes (floats).
+struct NatNetRigidBodies
+{
+	int Count;
+	int Id[NATNET_MAX_RIGID_BODIES];
+	float X[NATNET_MAX_RIGID_BODIES];
+	float Y[NATNET_MAX_RIGID_BODIES];
+	float Z[NATNET_MAX_RIGID_BODIES];
+	float QX[NATNET_MAX_RIGID_BODIES];
+	float QY[NATNET_MAX_RIGID_BODIES];
+	float QZ[NATNET_MAX_RIGID_BODIES];
+	float QW[NATNET_MAX_RIGID_BODIES];
+	// mean marker error, 0 before 2.0
+	float Error[NATNET_MAX_RIGID_BODIES];
+	int Flags[NATNET_MAX_RIGID_BODIES];
+	int MarkerCount[NATNET_MAX_RIGID_BODIES];
+	const unsigned char *Markers[NATNET_MAX_RIGID_BODIES];
+};
+
+struct NatNetFrameView
+{
+	int FrameNumber;
+
+	// names are NUL terminated in the packet, markers 3 floats each
+	int MarkerSetCount;
+	const char *MarkerSetName[NATNET_MAX_MARKER_SETS];
+	int MarkerSetSize[NATNET_MAX_MARKER_SETS];
+	const unsigned char *MarkerSetMarkers[NATNET_MAX_MARKER_SETS];
+
+	int UnlabeledCount;
+	const unsigned char *Unlabeled;
+
+	NatNetRigidBodies RigidBodies;
+
+	// skeleton i is bones SkeletonFirstBone[i] on, SkeletonBoneCount[i] of them
+	int SkeletonCount;
+	int SkeletonId[NATNET_MAX_SKELETONS];
+	int SkeletonFirstBone[NATNET_MAX_SKELETONS];
+	int SkeletonBoneCount[NATNET_MAX_SKELETONS];
+	NatNetRigidBodies Bones;
+
+	// LabeledStride bytes apart, see NATNET_LABELED_MARKER_SIZE
+	int LabeledCount;
+	int LabeledStride;
+	const unsigned char *Labeled;
+
+	// Channels points at the first channel: a sample count (u32) and that
+	// many floats, then the next channel
+	int ForcePlateCount;
+	int ForcePlateId[NATNET_MAX_FORCE_PLATES];
+	int ForcePlateChannels[NATNET_MAX_FORCE_PLATES];
+	const unsigned char *ForcePlateData[NATNET_MAX_FORCE_PLATES];
+
+	float Latency;
+	unsigned int Timecode;
+	unsigned int TimecodeSubframe;
+	double Timestamp;
+	// 0x01 Motive is recording, 0x02 the tracked models changed
+	int Flags;
+};
+
+// Decodes the size bytes of packet, a whole datagram, into view.
+// returns:
+// 0 - decoded
+// -1 - no frame of data
+// -2 - cut short: a count, string or the byte count runs past the end
+// -3 - more marker sets, rigid bodies, skeletons, bones or force plates than
+// the view holds
+typedef int (*NatNetDecoder)(const unsigned char *packet, int size, NatNetFrameView &view);
+
+// The NATNET_HAS_* a server of this NatNet version (major, minor, build,
+// revision) sends, -1 when its frames are not understood (3.0 on). A version
+// of all 0, the server not known yet, is taken for the newest layout.
+int NatNetFrameLayout(const int version[4]);
+// The decoder for a server of this version, NULL when there is none.
+NatNetDecoder SelectNatNetDecoder(const int version[4]);
+
+// Selective decoding, for consumers that want a few rigid bodies and
+// skeletons out of a big scene. Indexing steps over every entity by its
+// length, reading only IDs and counts, and notes where each section of the
+// frame starts and where the subscribed rigid bodies and skeletons are;
+// selecting then reads those and nothing else.
+
+#define NATNET_MAX_SUBSCRIBED 16
+#define NATNET_MAX_SUBSCRIBED_SKELETONS 4
+#define NATNET_MAX_SELECTED_BONES 128
+
+struct NatNetSubscription
+{
+	int RigidBodyCount;
+	int RigidBodyId[NATNET_MAX_SUBSCRIBED];
+	int SkeletonCount;
+	int SkeletonId[NATNET_MAX_SUBSCRIBED_SKELETONS];
+};
+
+// Offsets into the packet, -1 for sections the layout does not have and for
+// subscribed rigid bodies and skeletons the frame does not have. Tail is where
+// latency, timecode, timestamp and flags are, End the end of the frame.
+struct NatNetFrameIndex
+{
+	int FrameNumber;
+	int MarkerSets;
+	int Unlabeled;
+	int RigidBodies;
+	int Skeletons;
+	int Labeled;
+	int ForcePlates;
+	int Tail;
+	int End;
+	// in the order subscribed
+	int RigidBody[NATNET_MAX_SUBSCRIBED];
+	int Skeleton[NATNET_MAX_SUBSCRIBED_SKELETONS];
+};
+
+// Mirrored by KinovaAPI.NatNetPose, keep them in sync. Motive's frame (right
+// handed, meters), orientation x, y, z, w.
+struct NatNetPose
+{
+	int Id;
+	// 0 when the frame did not have it
+	int Found;
+	int Flags;
+	float Error;
+	float Position[3];
+	float Orientation[4];
+};
+
+// Mirrored by KinovaAPI.NatNetSelection, keep them in sync.
+struct NatNetSelection
+{
+	double Timestamp;
+	int FrameNumber;
+	int Flags;
+	// in the order subscribed
+	NatNetPose RigidBodies[NATNET_MAX_SUBSCRIBED];
+	// subscribed skeleton i is bones SkeletonFirstBone[i] on,
+	// SkeletonBoneCount[i] of them, none when the frame did not have it
+	int SkeletonFirstBone[NATNET_MAX_SUBSCRIBED_SKELETONS];
+	int SkeletonBoneCount[NATNET_MAX_SUBSCRIBED_SKELETONS];
+	int BoneCount;
+	NatNetPose Bones[NATNET_MAX_SELECTED_BONES];
+};
+
+// Indexes the size bytes of packet, a whole datagram, for subscription.
+// Returns like a NatNetDecoder, never -3.
+typedef int (*NatNetIndexer)(const unsigned char *packet, int size, const NatNetSubscription &subscription,
+	NatNetFrameIndex &index);
+
+// Reads the subscribed rigid bodies and skeletons out of a packet indexed
+// before for the same subscription.
+// returns:
+// 0 - selected
+// -2 - the packet is not the one indexed
+// -3 - the subscribed skeletons have more than NATNET_MAX_SELECTED_BONES bones
+typedef int (*NatNetSelector)(const unsigned char *packet, const NatNetFrameIndex &index,
+	const NatNetSubscription &subscription, NatNetSelection &selection);
+
+NatNetIndexer SelectNatNetIndexer(const int version[4]);
+NatNetSelector SelectNatNetSelector(const int version[4]);
+
+inline unsigned int NatNetReadU32(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+inline float NatNetReadF32(const unsigned char *in)
+{
+	unsigned int bits = NatNetReadU32(in);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
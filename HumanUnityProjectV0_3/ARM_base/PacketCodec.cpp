@@ -0,0 +1,191 @@
+#include "PacketCodec.h"
+#include <cstring>
+
+static void WriteShort(unsigned char *out, short value)
+{
+	unsigned short bits = (unsigned short)value;
+	out[0] = (unsigned char)(bits & 0xFF);
+	out[1] = (unsigned char)(bits >> 8);
+}
+
+static short ReadShort(const unsigned char *in)
+{
+	return (short)(unsigned short)(in[0] | (in[1] << 8));
+}
+
+static int HeaderSize(int transport)
+{
+	switch (transport)
+	{
+	case PACKET_USB:
+		return PACKET_CODEC_USB_HEADER_SIZE;
+	case PACKET_ETHERNET:
+		return PACKET_CODEC_ETH_HEADER_SIZE;
+	}
+	return 0;
+}
+
+int PacketSize(int transport)
+{
+	switch (transport)
+	{
+	case PACKET_USB:
+		return PACKET_CODEC_USB_SIZE;
+	case PACKET_ETHERNET:
+		return PACKET_CODEC_ETH_SIZE;
+	}
+	return 0;
+}
+
+int PacketPayloadSize(int transport)
+{
+	return PacketSize(transport) - HeaderSize(transport);
+}
+
+int PacketCount(int transport, int dataSize)
+{
+	int payload = PacketPayloadSize(transport);
+	if (payload <= 0 || dataSize < 0 || dataSize > PACKET_CODEC_MAX_DATA_SIZE)
+	{
+		return PACKET_ERROR_SIZE;
+	}
+	return dataSize == 0 ? 1 : (dataSize + payload - 1) / payload;
+}
+
+int EncodePacket(int transport, short idCommand, const unsigned char *data, int dataSize, int index, unsigned char *out)
+{
+	int count = PacketCount(transport, dataSize);
+	if (count < 0)
+	{
+		return count;
+	}
+	if (index < 1 || index > count)
+	{
+		return PACKET_ERROR_HEADER;
+	}
+
+	int header = HeaderSize(transport);
+	int payload = PacketPayloadSize(transport);
+	WriteShort(out, (short)index);
+	WriteShort(out + 2, (short)count);
+	WriteShort(out + 4, idCommand);
+	WriteShort(out + 6, (short)dataSize);
+	memset(out + 8, 0, header - 8);
+
+	int offset = (index - 1) * payload;
+	int length = dataSize - offset < payload ? dataSize - offset : payload;
+	if (length > 0)
+	{
+		memcpy(out + header, data + offset, length);
+	}
+	else
+	{
+		length = 0;
+	}
+	memset(out + header + length, 0, payload - length);
+	return 0;
+}
+
+int EncodeCommand(int transport, short idCommand, const unsigned char *data, int dataSize, unsigned char *arena, int capacity)
+{
+	int count = PacketCount(transport, dataSize);
+	if (count < 0)
+	{
+		return count;
+	}
+	int size = PacketSize(transport);
+	if (capacity < count * size)
+	{
+		return PACKET_ERROR_CAPACITY;
+	}
+	for (int index = 1; index <= count; index++)
+	{
+		EncodePacket(transport, idCommand, data, dataSize, index, arena + (index - 1) * size);
+	}
+	return count;
+}
+
+int DecodePacket(int transport, const unsigned char *packet, int size, PacketView &view)
+{
+	if (PacketSize(transport) == 0 || size != PacketSize(transport))
+	{
+		return PACKET_ERROR_SIZE;
+	}
+
+	PacketHeader &header = view.Header;
+	header.IdPacket = ReadShort(packet);
+	header.TotalPacketCount = ReadShort(packet + 2);
+	header.IdCommand = ReadShort(packet + 4);
+	header.TotalDataSize = ReadShort(packet + 6);
+	if (header.TotalDataSize < 0 || header.TotalPacketCount != PacketCount(transport, header.TotalDataSize) ||
+		header.IdPacket < 1 || header.IdPacket > header.TotalPacketCount)
+	{
+		return PACKET_ERROR_HEADER;
+	}
+
+	int payload = PacketPayloadSize(transport);
+	int offset = (header.IdPacket - 1) * payload;
+	view.Payload = packet + HeaderSize(transport);
+	view.PayloadSize = header.TotalDataSize - offset < payload ? header.TotalDataSize - offset : payload;
+	if (view.PayloadSize < 0)
+	{
+		view.PayloadSize = 0;
+	}
+	return 0;
+}
+
+void InitReassembler(PacketReassembler &reassembler, int transport, unsigned char *buffer, int capacity)
+{
+	memset(&reassembler, 0, sizeof(reassembler));
+	reassembler.Transport = transport;
+	reassembler.Buffer = buffer;
+	reassembler.Capacity = capacity;
+}
+
+void ResetReassembler(PacketReassembler &reassembler)
+{
+	if (reassembler.Current.TotalPacketCount != 0 && reassembler.Received > 0 &&
+		reassembler.Received < reassembler.Current.TotalPacketCount)
+	{
+		reassembler.Abandoned++;
+	}
+	memset(&reassembler.Current, 0, sizeof(reassembler.Current));
+	memset(reassembler.ReceivedMask, 0, sizeof(reassembler.ReceivedMask));
+	reassembler.Received = 0;
+}
+
+int AddPacket(PacketReassembler &reassembler, const unsigned char *packet, int size)
+{
+	PacketView view;
+	int result = DecodePacket(reassembler.Transport, packet, size, view);
+	if (result != 0)
+	{
+		return result;
+	}
+	if (view.Header.TotalDataSize > reassembler.Capacity)
+	{
+		return PACKET_ERROR_CAPACITY;
+	}
+
+	PacketHeader &current = reassembler.Current;
+	bool sameCommand = current.TotalPacketCount != 0 && reassembler.Received < current.TotalPacketCount &&
+		current.IdCommand == view.Header.IdCommand && current.TotalDataSize == view.Header.TotalDataSize;
+	if (!sameCommand)
+	{
+		ResetReassembler(reassembler);
+		current = view.Header;
+	}
+
+	int index = view.Header.IdPacket - 1;
+	unsigned int bit = 1u << (index % 32);
+	if (reassembler.ReceivedMask[index / 32] & bit)
+	{
+		reassembler.Duplicates++;
+		return PACKET_INCOMPLETE;
+	}
+	reassembler.ReceivedMask[index / 32] |= bit;
+	reassembler.Received++;
+	memcpy(reassembler.Buffer + index * PacketPayloadSize(reassembler.Transport), view.Payload, view.PayloadSize);
+
+	return reassembler.Received == current.TotalPacketCount ? PACKET_COMPLETE : PACKET_INCOMPLETE;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// Framing of Kinova commands into the packets of the communication layer
+// (Packet in Lib_Examples\CommunicationLayerWindows.h), and reassembly of
+// received packets, without the heap. Every packet starts with four little
+// endian 16 bit fields, IdPacket (from 1), TotalPacketCount, IdCommand and
+// TotalDataSize, followed by its share of the command data:
+//
+//   USB       64 bytes, 8 byte header, 56 data bytes
+//   Ethernet  1464 bytes, 10 byte header, 1456 data bytes
+//
+// The two bytes the Ethernet header has on top are not documented; they are
+// written as zero and ignored when decoding.
+//
+// Plain C++ with no Windows or Kinova headers, so a transport or simulator
+// can be built on it anywhere.
+
+enum PacketTransport
+{
+	PACKET_USB = 0,
+	PACKET_ETHERNET = 1,
+};
+
+#define PACKET_CODEC_USB_SIZE 64
+#define PACKET_CODEC_USB_HEADER_SIZE 8
+#define PACKET_CODEC_ETH_SIZE 1464
+#define PACKET_CODEC_ETH_HEADER_SIZE 10
+
+// TotalDataSize is a signed 16 bit field.
+#define PACKET_CODEC_MAX_DATA_SIZE 32767
+#define PACKET_CODEC_MAX_PACKETS ((PACKET_CODEC_MAX_DATA_SIZE + PACKET_CODEC_USB_SIZE - PACKET_CODEC_USB_HEADER_SIZE - 1) / (PACKET_CODEC_USB_SIZE - PACKET_CODEC_USB_HEADER_SIZE))
+
+// Results. Errors are negative.
+#define PACKET_INCOMPLETE 0
+#define PACKET_COMPLETE 1
+// buffer of the wrong size, or unknown transport
+#define PACKET_ERROR_SIZE -1
+// header fields that contradict each other
+#define PACKET_ERROR_HEADER -2
+// the command does not fit the caller's buffer
+#define PACKET_ERROR_CAPACITY -3
+
+struct PacketHeader
+{
+	short IdPacket;
+	short TotalPacketCount;
+	short IdCommand;
+	short TotalDataSize;
+};
+
+// A decoded packet. Payload points into the packet buffer it came from.
+struct PacketView
+{
+	PacketHeader Header;
+	const unsigned char *Payload;
+	int PayloadSize;
+};
+
+// Whole packet and data bytes per packet, 0 for an unknown transport.
+int PacketSize(int transport);
+int PacketPayloadSize(int transport);
+
+// Packets a command of dataSize bytes takes (at least one), or
+// PACKET_ERROR_SIZE when it is too big for the header.
+int PacketCount(int transport, int dataSize);
+
+// Writes packet index (from 1) of a command into out, PacketSize(transport)
+// bytes, reading its share of data in place. Returns 0 or an error.
+int EncodePacket(int transport, short idCommand, const unsigned char *data, int dataSize, int index, unsigned char *out);
+
+// Writes every packet of a command back to back into arena. Returns the
+// packet count, or an error (PACKET_ERROR_CAPACITY when arena is too small).
+int EncodeCommand(int transport, short idCommand, const unsigned char *data, int dataSize, unsigned char *arena, int capacity);
+
+// Checks and splits one received packet of size bytes. Returns 0 or an error.
+int DecodePacket(int transport, const unsigned char *packet, int size, PacketView &view);
+
+// Collects the packets of one command, in any order, into the caller's buffer.
+struct PacketReassembler
+{
+	int Transport;
+	unsigned char *Buffer;
+	int Capacity;
+	// command being collected, TotalPacketCount 0 when none
+	PacketHeader Current;
+	int Received;
+	unsigned int ReceivedMask[(PACKET_CODEC_MAX_PACKETS + 31) / 32];
+	// packets seen twice, and commands dropped half way for a newer one
+	unsigned int Duplicates;
+	unsigned int Abandoned;
+};
+
+void InitReassembler(PacketReassembler &reassembler, int transport, unsigned char *buffer, int capacity);
+
+// Adds one received packet. Returns PACKET_COMPLETE once the command's
+// TotalDataSize bytes are in the buffer (the next packet starts a new command),
+// PACKET_INCOMPLETE while waiting for more, or an error for a bad packet,
+// which leaves the command being collected alone. A packet of another command
+// drops the one being collected and starts over with it.
+int AddPacket(PacketReassembler &reassembler, const unsigned char *packet, int size);
+
+// Forgets the command being collected.
+void ResetReassembler(PacketReassembler &reassembler);
+
+// Reassembler with its own buffer, for commands of up to MaxDataSize bytes.
+template <int MaxDataSize>
+struct FixedReassembler
+{
+	unsigned char Data[MaxDataSize];
+	PacketReassembler Reassembler;
+
+	explicit FixedReassembler(int transport)
+	{
+		InitReassembler(Reassembler, transport, Data, MaxDataSize);
+	}
+
+	int Add(const unsigned char *packet, int size)
+	{
+		return AddPacket(Reassembler, packet, size);
+	}
+
+	int Size() const
+	{
+		return Reassembler.Current.TotalDataSize;
+	}
+};
@@ -0,0 +1,448 @@
+#include "PoseCodec.h"
+#include <cstring>
+
+#define FRAME_ID_MASK 0xFFFF
+#define HEADER_SIZE 4
+#define FINGER_BITS 5
+
+// Largest quaternion component other than the largest, 1 / sqrt(2).
+#define COMPONENT_RANGE 0.70710678f
+
+struct BitWriter
+{
+	unsigned char *Data;
+	int Bits;
+};
+
+struct BitReader
+{
+	const unsigned char *Data;
+	int Size;
+	int Bits;
+	bool Overrun;
+};
+
+static void WriteBits(BitWriter &writer, unsigned int value, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if ((writer.Bits & 7) == 0)
+		{
+			writer.Data[writer.Bits >> 3] = 0;
+		}
+		if ((value >> i) & 1)
+		{
+			writer.Data[writer.Bits >> 3] |= (unsigned char)(1 << (writer.Bits & 7));
+		}
+		writer.Bits++;
+	}
+}
+
+static unsigned int ReadBits(BitReader &reader, int count)
+{
+	unsigned int value = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (reader.Bits >= reader.Size * 8)
+		{
+			reader.Overrun = true;
+			return 0;
+		}
+		value |= (unsigned int)((reader.Data[reader.Bits >> 3] >> (reader.Bits & 7)) & 1) << i;
+		reader.Bits++;
+	}
+	return value;
+}
+
+static unsigned int ZigZag(int value)
+{
+	return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int UnZigZag(unsigned int value)
+{
+	return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+// Two's complement of the low bits, sign extended back.
+static int SignExtend(unsigned int value, int bits)
+{
+	unsigned int sign = 1u << (bits - 1);
+	value &= (1u << bits) - 1;
+	return (int)(value ^ sign) - (int)sign;
+}
+
+static int DifferenceBits(int from, int to, int fullBits)
+{
+	unsigned int z = ZigZag(to - from);
+	return z == 0 ? 1 : z < 16 ? 2 + 4 : z < 256 ? 3 + 8 : 3 + fullBits;
+}
+
+static void WriteDifference(BitWriter &writer, int from, int to, int fullBits)
+{
+	unsigned int z = ZigZag(to - from);
+	if (z == 0)
+	{
+		WriteBits(writer, 0, 1);
+	}
+	else if (z < 16)
+	{
+		WriteBits(writer, 1, 2);
+		WriteBits(writer, z, 4);
+	}
+	else if (z < 256)
+	{
+		WriteBits(writer, 3, 3);
+		WriteBits(writer, z, 8);
+	}
+	else
+	{
+		WriteBits(writer, 7, 3);
+		WriteBits(writer, (unsigned int)to, fullBits);
+	}
+}
+
+// The full value comes back as read, the caller sign extends positions.
+static int ReadDifference(BitReader &reader, int from, int fullBits, bool &full)
+{
+	full = false;
+	if (ReadBits(reader, 1) == 0)
+	{
+		return from;
+	}
+	if (ReadBits(reader, 1) == 0)
+	{
+		return from + UnZigZag(ReadBits(reader, 4));
+	}
+	if (ReadBits(reader, 1) == 0)
+	{
+		return from + UnZigZag(ReadBits(reader, 8));
+	}
+	full = true;
+	return (int)ReadBits(reader, fullBits);
+}
+
+static int HandBits(const QuantizedHand &hand, const QuantizedHand *baseline)
+{
+	if (baseline == NULL)
+	{
+		return 1 + 3 * POSE_CODEC_POSITION_BITS + 2 + 3 * POSE_CODEC_COMPONENT_BITS;
+	}
+	int bits = 2;
+	for (int i = 0; i < 3; i++)
+	{
+		bits += DifferenceBits(baseline->Position[i], hand.Position[i], POSE_CODEC_POSITION_BITS);
+	}
+	if (hand.Largest != baseline->Largest)
+	{
+		return bits + 2 + 3 * POSE_CODEC_COMPONENT_BITS;
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		bits += DifferenceBits(baseline->Components[i], hand.Components[i], POSE_CODEC_COMPONENT_BITS);
+	}
+	return bits;
+}
+
+static void WriteHand(BitWriter &writer, const QuantizedHand &hand, const QuantizedHand *baseline)
+{
+	unsigned int positionMask = (1u << POSE_CODEC_POSITION_BITS) - 1;
+	WriteBits(writer, baseline != NULL ? 1 : 0, 1);
+	for (int i = 0; i < 3; i++)
+	{
+		if (baseline != NULL)
+		{
+			WriteDifference(writer, baseline->Position[i], hand.Position[i], POSE_CODEC_POSITION_BITS);
+		}
+		else
+		{
+			WriteBits(writer, (unsigned int)hand.Position[i] & positionMask, POSE_CODEC_POSITION_BITS);
+		}
+	}
+	bool sameLargest = baseline != NULL && hand.Largest == baseline->Largest;
+	if (baseline != NULL)
+	{
+		WriteBits(writer, sameLargest ? 1 : 0, 1);
+	}
+	if (!sameLargest)
+	{
+		WriteBits(writer, (unsigned int)hand.Largest, 2);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		if (sameLargest)
+		{
+			WriteDifference(writer, baseline->Components[i], hand.Components[i], POSE_CODEC_COMPONENT_BITS);
+		}
+		else
+		{
+			WriteBits(writer, (unsigned int)hand.Components[i], POSE_CODEC_COMPONENT_BITS);
+		}
+	}
+}
+
+// False when the stream wants a baseline hand that is not there.
+static bool ReadHand(BitReader &reader, QuantizedHand &hand, const QuantizedHand *baseline)
+{
+	bool delta = ReadBits(reader, 1) != 0;
+	if (delta && baseline == NULL)
+	{
+		return false;
+	}
+	bool full;
+	for (int i = 0; i < 3; i++)
+	{
+		int value = delta ? ReadDifference(reader, baseline->Position[i], POSE_CODEC_POSITION_BITS, full) :
+			(full = true, (int)ReadBits(reader, POSE_CODEC_POSITION_BITS));
+		hand.Position[i] = full ? SignExtend((unsigned int)value, POSE_CODEC_POSITION_BITS) : value;
+	}
+	bool sameLargest = delta && ReadBits(reader, 1) != 0;
+	hand.Largest = sameLargest ? baseline->Largest : (int)ReadBits(reader, 2);
+	int componentMax = (1 << POSE_CODEC_COMPONENT_BITS) - 1;
+	for (int i = 0; i < 3; i++)
+	{
+		int value = sameLargest ? ReadDifference(reader, baseline->Components[i], POSE_CODEC_COMPONENT_BITS, full) :
+			(int)ReadBits(reader, POSE_CODEC_COMPONENT_BITS);
+		// a corrupt difference must not leave the range DequantizeHand expects
+		hand.Components[i] = value < 0 ? 0 : value > componentMax ? componentMax : value;
+	}
+	return true;
+}
+
+static void Remember(PoseFrameHistory &history, unsigned int id, const QuantizedFrame &frame)
+{
+	int slot = id % POSE_CODEC_HISTORY;
+	history.Valid[slot] = true;
+	history.Id[slot] = id;
+	history.Frames[slot] = frame;
+}
+
+static const QuantizedFrame *Recall(const PoseFrameHistory &history, unsigned int id)
+{
+	int slot = id % POSE_CODEC_HISTORY;
+	return history.Valid[slot] && history.Id[slot] == id ? &history.Frames[slot] : NULL;
+}
+
+static void Quantize(const PoseFrame &frame, QuantizedFrame &result)
+{
+	memset(&result, 0, sizeof(result));
+	result.Contents = frame.Contents & 15;
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if (result.Contents & (POSE_FRAME_LEFT << arm))
+		{
+			result.Flags[arm] = frame.Flags[arm] & 1;
+			QuantizeHand(frame.Hands[arm], result.Hands[arm]);
+		}
+		if (result.Contents & (POSE_FRAME_LEFT_FINGERS << arm))
+		{
+			result.Fingers[arm] = frame.Fingers[arm] & ((1 << FINGER_BITS) - 1);
+		}
+	}
+}
+
+void ResetPoseEncoder(PoseEncoder &encoder)
+{
+	memset(&encoder, 0, sizeof(encoder));
+}
+
+void ResetPoseDecoder(PoseDecoder &decoder)
+{
+	memset(&decoder, 0, sizeof(decoder));
+}
+
+void QuantizeHand(const Pose &hand, QuantizedHand &result)
+{
+	int limit = (1 << (POSE_CODEC_POSITION_BITS - 1)) - 1;
+	float position[3] = { hand.Position.X, hand.Position.Y, hand.Position.Z };
+	for (int i = 0; i < 3; i++)
+	{
+		float scaled = position[i] * POSE_CODEC_POSITION_SCALE;
+		// also catches NaN, which fails both comparisons
+		int value = scaled >= (float)-limit && scaled <= (float)limit ? (int)floorf(scaled + 0.5f) :
+			scaled > 0.0f ? limit : -limit;
+		result.Position[i] = value;
+	}
+
+	Quat q = Normalize(hand.Orientation);
+	float components[4] = { q.X, q.Y, q.Z, q.W };
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+	{
+		largest = fabsf(components[i]) > fabsf(components[largest]) ? i : largest;
+	}
+	// q and -q are the same rotation, make the dropped component positive
+	float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+	int componentMax = (1 << POSE_CODEC_COMPONENT_BITS) - 1;
+	result.Largest = largest;
+	for (int i = 0, j = 0; i < 4; i++)
+	{
+		if (i == largest)
+		{
+			continue;
+		}
+		float unit = (sign * components[i] / COMPONENT_RANGE + 1.0f) * 0.5f;
+		// NaN goes to 0 as well
+		unit = unit >= 0.0f ? (unit <= 1.0f ? unit : 1.0f) : 0.0f;
+		result.Components[j++] = (int)floorf(unit * componentMax + 0.5f);
+	}
+}
+
+void DequantizeHand(const QuantizedHand &hand, Pose &result)
+{
+	result.Position = MakeVec3(hand.Position[0] / POSE_CODEC_POSITION_SCALE, hand.Position[1] / POSE_CODEC_POSITION_SCALE,
+		hand.Position[2] / POSE_CODEC_POSITION_SCALE);
+
+	float componentMax = (float)((1 << POSE_CODEC_COMPONENT_BITS) - 1);
+	float components[4];
+	float sum = 0.0f;
+	for (int i = 0, j = 0; i < 4; i++)
+	{
+		if (i == hand.Largest)
+		{
+			continue;
+		}
+		components[i] = (hand.Components[j++] / componentMax * 2.0f - 1.0f) * COMPONENT_RANGE;
+		sum += components[i] * components[i];
+	}
+	components[hand.Largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+	result.Orientation = Normalize(MakeQuat(components[0], components[1], components[2], components[3]));
+}
+
+int EncodePoseFrame(PoseEncoder &encoder, const PoseFrame &frame, unsigned char *buffer, int capacity,
+	bool &keyframe)
+{
+	if (capacity < POSE_CODEC_MAX_SIZE)
+	{
+		return POSE_CODEC_ERROR_SIZE;
+	}
+	QuantizedFrame quantized;
+	Quantize(frame, quantized);
+
+	unsigned int id = encoder.NextId & FRAME_ID_MASK;
+	encoder.NextId = (id + 1) & FRAME_ID_MASK;
+	// a baseline about to be overwritten in the receiver's history is no good
+	const QuantizedFrame *baseline = NULL;
+	if (encoder.HasAcked && ((id - encoder.Acked) & FRAME_ID_MASK) < POSE_CODEC_HISTORY)
+	{
+		baseline = Recall(encoder.History, encoder.Acked);
+	}
+	keyframe = baseline == NULL;
+
+	buffer[0] = (unsigned char)(id & 0xFF);
+	buffer[1] = (unsigned char)(id >> 8);
+	unsigned int baselineId = keyframe ? id : encoder.Acked;
+	buffer[2] = (unsigned char)(baselineId & 0xFF);
+	buffer[3] = (unsigned char)(baselineId >> 8);
+
+	BitWriter writer = { buffer + HEADER_SIZE, 0 };
+	WriteBits(writer, keyframe ? 1 : 0, 1);
+	WriteBits(writer, (unsigned int)quantized.Contents, 4);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if ((quantized.Contents & (POSE_FRAME_LEFT << arm)) == 0)
+		{
+			continue;
+		}
+		const QuantizedHand *hand = NULL;
+		if (baseline != NULL && (baseline->Contents & (POSE_FRAME_LEFT << arm)) != 0)
+		{
+			hand = &baseline->Hands[arm];
+			// a big jump costs more as differences than in full
+			if (HandBits(quantized.Hands[arm], hand) > HandBits(quantized.Hands[arm], NULL))
+			{
+				hand = NULL;
+			}
+		}
+		WriteBits(writer, (unsigned int)quantized.Flags[arm], 1);
+		WriteHand(writer, quantized.Hands[arm], hand);
+	}
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if (quantized.Contents & (POSE_FRAME_LEFT_FINGERS << arm))
+		{
+			WriteBits(writer, (unsigned int)quantized.Fingers[arm], FINGER_BITS);
+		}
+	}
+	Remember(encoder.History, id, quantized);
+	return HEADER_SIZE + (writer.Bits + 7) / 8;
+}
+
+void AcknowledgePoseFrame(PoseEncoder &encoder, unsigned int frameId)
+{
+	frameId &= FRAME_ID_MASK;
+	// acknowledgements may come out of order, keep the newest of the frames sent
+	if (Recall(encoder.History, frameId) != NULL &&
+		(!encoder.HasAcked || (short)(frameId - encoder.Acked) > 0))
+	{
+		encoder.Acked = frameId;
+		encoder.HasAcked = true;
+	}
+}
+
+int DecodePoseFrame(PoseDecoder &decoder, const unsigned char *data, int size, PoseFrame &frame,
+	unsigned int &frameId)
+{
+	if (data == NULL || size < HEADER_SIZE || size > POSE_CODEC_MAX_SIZE)
+	{
+		return POSE_CODEC_ERROR_SIZE;
+	}
+	frameId = data[0] | (data[1] << 8);
+	unsigned int baselineId = data[2] | (data[3] << 8);
+
+	BitReader reader = { data + HEADER_SIZE, size - HEADER_SIZE, 0, false };
+	bool keyframe = ReadBits(reader, 1) != 0;
+	const QuantizedFrame *baseline = keyframe ? NULL : Recall(decoder.History, baselineId);
+	if (!keyframe && baseline == NULL)
+	{
+		return POSE_CODEC_ERROR_BASELINE;
+	}
+
+	QuantizedFrame quantized;
+	memset(&quantized, 0, sizeof(quantized));
+	quantized.Contents = (int)ReadBits(reader, 4);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if ((quantized.Contents & (POSE_FRAME_LEFT << arm)) == 0)
+		{
+			continue;
+		}
+		quantized.Flags[arm] = (int)ReadBits(reader, 1);
+		const QuantizedHand *hand = baseline != NULL && (baseline->Contents & (POSE_FRAME_LEFT << arm)) != 0 ?
+			&baseline->Hands[arm] : NULL;
+		if (!ReadHand(reader, quantized.Hands[arm], hand))
+		{
+			return POSE_CODEC_ERROR_BASELINE;
+		}
+	}
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if (quantized.Contents & (POSE_FRAME_LEFT_FINGERS << arm))
+		{
+			quantized.Fingers[arm] = (int)ReadBits(reader, FINGER_BITS);
+		}
+	}
+	if (reader.Overrun)
+	{
+		return POSE_CODEC_ERROR_SIZE;
+	}
+
+	Remember(decoder.History, frameId, quantized);
+	memset(&frame, 0, sizeof(frame));
+	frame.Contents = quantized.Contents;
+	for (int arm = 0; arm < 2; arm++)
+	{
+		frame.Flags[arm] = quantized.Flags[arm];
+		frame.Fingers[arm] = quantized.Fingers[arm];
+		if (quantized.Contents & (POSE_FRAME_LEFT << arm))
+		{
+			DequantizeHand(quantized.Hands[arm], frame.Hands[arm]);
+		}
+	}
+	return 0;
+}
+
+bool PoseFrameDecoded(const PoseDecoder &decoder, const unsigned char *data, int size)
+{
+	return data != NULL && size >= HEADER_SIZE && Recall(decoder.History, data[0] | (data[1] << 8)) != NULL;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Compact encoding of both hands and their fingers for the operator link
+// (TELEOP_FRAME in TeleopProtocol.h). Positions are fixed point in steps of
+// 1 / POSE_CODEC_POSITION_SCALE meters, orientations are "smallest three"
+// quaternions: the index of the largest component and the other three in
+// POSE_CODEC_COMPONENT_BITS each, the largest one follows from |q| = 1.
+//
+// A frame is coded against a baseline, an earlier frame the receiver has
+// acknowledged, as variable length differences of the quantized values, so a
+// hand that moves a few millimeters between frames costs a few bits per axis.
+// A frame without a usable baseline is a keyframe with everything in full.
+// Only acknowledged frames are used as baselines, so a lost frame never
+// breaks the ones after it; acknowledgements that stop coming make the
+// baseline age out of POSE_CODEC_HISTORY and the encoder falls back to
+// keyframes until they come again.
+//
+// Body layout: u16 frame ID, u16 baseline ID, then a bit stream (least
+// significant bit first):
+//
+//   1 bit keyframe, 4 bits contents (POSE_FRAME_*)
+//   per hand present: 1 bit TELEOP_POSE_NO_THETA_Y, 1 bit delta,
+//     x, y, z: delta ? 3 differences : 3 x POSE_CODEC_POSITION_BITS
+//     orientation: delta ? (1 bit same largest, then 3 differences,
+//     otherwise in full) : 2 bits largest, 3 x POSE_CODEC_COMPONENT_BITS
+//   per fingers present: 5 bits (TELEOP_FINGER_*)
+//
+// A difference is zigzag coded: "0" for none, "10" + 4 bits, "110" + 8 bits,
+// or "111" and the value in full.
+
+#define POSE_CODEC_POSITION_SCALE 20000.0f
+#define POSE_CODEC_POSITION_BITS 18
+#define POSE_CODEC_COMPONENT_BITS 11
+
+// Frames remembered by both ends to serve as baselines.
+#define POSE_CODEC_HISTORY 64
+
+// Largest encoded frame body, both hands in full and fingers.
+#define POSE_CODEC_MAX_SIZE 32
+
+// What a frame carries
+#define POSE_FRAME_LEFT 1
+#define POSE_FRAME_RIGHT 2
+#define POSE_FRAME_LEFT_FINGERS 4
+#define POSE_FRAME_RIGHT_FINGERS 8
+
+// Decoding errors
+#define POSE_CODEC_ERROR_SIZE -1
+#define POSE_CODEC_ERROR_BASELINE -2
+
+// Index 0 is the left arm, 1 the right one.
+struct PoseFrame
+{
+	int Contents;
+	// TELEOP_POSE_* flags of each hand
+	int Flags[2];
+	Pose Hands[2];
+	// TELEOP_FINGER_* bits
+	int Fingers[2];
+};
+
+struct QuantizedHand
+{
+	int Position[3];
+	int Largest;
+	int Components[3];
+};
+
+struct QuantizedFrame
+{
+	int Contents;
+	int Flags[2];
+	QuantizedHand Hands[2];
+	int Fingers[2];
+};
+
+struct PoseFrameHistory
+{
+	bool Valid[POSE_CODEC_HISTORY];
+	unsigned int Id[POSE_CODEC_HISTORY];
+	QuantizedFrame Frames[POSE_CODEC_HISTORY];
+};
+
+struct PoseEncoder
+{
+	unsigned int NextId;
+	bool HasAcked;
+	unsigned int Acked;
+	PoseFrameHistory History;
+};
+
+struct PoseDecoder
+{
+	PoseFrameHistory History;
+};
+
+void ResetPoseEncoder(PoseEncoder &encoder);
+void ResetPoseDecoder(PoseDecoder &decoder);
+
+// Quantization on its own, the encoder and decoder use these.
+void QuantizeHand(const Pose &hand, QuantizedHand &result);
+void DequantizeHand(const QuantizedHand &hand, Pose &result);
+
+// Returns the body size, or -1 when capacity is below POSE_CODEC_MAX_SIZE.
+// keyframe tells whether it went without a baseline.
+int EncodePoseFrame(PoseEncoder &encoder, const PoseFrame &frame, unsigned char *buffer, int capacity,
+	bool &keyframe);
+
+// The receiver decoded frameId, it may be a baseline from now on.
+void AcknowledgePoseFrame(PoseEncoder &encoder, unsigned int frameId);
+
+// Returns 0, POSE_CODEC_ERROR_SIZE for a short or overlong body, or
+// POSE_CODEC_ERROR_BASELINE when the baseline is not in the history (the
+// sender will send a keyframe once the baseline ages out). frameId is set
+// whenever the IDs could be read.
+int DecodePoseFrame(PoseDecoder &decoder, const unsigned char *data, int size, PoseFrame &frame,
+	unsigned int &frameId);
+
+// The frame in the body was decoded already (it is still in the history), so
+// a repeat of it can be skipped.
+bool PoseFrameDecoded(const PoseDecoder &decoder, const unsigned char *data, int size);
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cmath>
+
+// Small vector/quaternion helpers shared by the native motion code.
+// Positions are meters, angles radians, quaternions are (x, y, z, w).
+
+struct Vec3
+{
+	float X;
+	float Y;
+	float Z;
+};
+
+struct Quat
+{
+	float X;
+	float Y;
+	float Z;
+	float W;
+};
+
+// A Cartesian end effector pose as the Kinova API sees it, plus its quaternion.
+struct Pose
+{
+	Vec3 Position;
+	Quat Orientation;
+};
+
+inline Vec3 MakeVec3(float x, float y, float z)
+{
+	Vec3 v = { x, y, z };
+	return v;
+}
+
+inline Vec3 Add(const Vec3 &a, const Vec3 &b) { return MakeVec3(a.X + b.X, a.Y + b.Y, a.Z + b.Z); }
+inline Vec3 Sub(const Vec3 &a, const Vec3 &b) { return MakeVec3(a.X - b.X, a.Y - b.Y, a.Z - b.Z); }
+inline Vec3 Scale(const Vec3 &a, float s) { return MakeVec3(a.X * s, a.Y * s, a.Z * s); }
+inline float Dot(const Vec3 &a, const Vec3 &b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+inline float Length(const Vec3 &a) { return sqrtf(Dot(a, a)); }
+
+inline Vec3 Cross(const Vec3 &a, const Vec3 &b)
+{
+	return MakeVec3(a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X);
+}
+
+inline Vec3 Lerp(const Vec3 &a, const Vec3 &b, float t)
+{
+	return Add(a, Scale(Sub(b, a), t));
+}
+
+inline Quat MakeQuat(float x, float y, float z, float w)
+{
+	Quat q = { x, y, z, w };
+	return q;
+}
+
+inline float Dot(const Quat &a, const Quat &b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z + a.W * b.W; }
+
+inline Quat Normalize(const Quat &q)
+{
+	float n = sqrtf(Dot(q, q));
+	if (n < 1e-9f)
+	{
+		return MakeQuat(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	return MakeQuat(q.X / n, q.Y / n, q.Z / n, q.W / n);
+}
+
+inline Quat Conjugate(const Quat &q) { return MakeQuat(-q.X, -q.Y, -q.Z, q.W); }
+
+inline Quat Multiply(const Quat &a, const Quat &b)
+{
+	return MakeQuat(
+		a.W * b.X + a.X * b.W + a.Y * b.Z - a.Z * b.Y,
+		a.W * b.Y - a.X * b.Z + a.Y * b.W + a.Z * b.X,
+		a.W * b.Z + a.X * b.Y - a.Y * b.X + a.Z * b.W,
+		a.W * b.W - a.X * b.X - a.Y * b.Y - a.Z * b.Z);
+}
+
+inline Vec3 Rotate(const Quat &q, const Vec3 &v)
+{
+	Vec3 u = MakeVec3(q.X, q.Y, q.Z);
+	Vec3 t = Scale(Cross(u, v), 2.0f);
+	return Add(Add(v, Scale(t, q.W)), Cross(u, t));
+}
+
+// Spherical interpolation along the shortest arc. Falls back to a normalized
+// lerp when the two orientations are nearly the same.
+inline Quat Slerp(const Quat &a, const Quat &b, float t)
+{
+	Quat end = b;
+	float cosAngle = Dot(a, b);
+	if (cosAngle < 0.0f)
+	{
+		end = MakeQuat(-b.X, -b.Y, -b.Z, -b.W);
+		cosAngle = -cosAngle;
+	}
+
+	float wa = 1.0f - t;
+	float wb = t;
+	if (cosAngle < 0.9995f)
+	{
+		float angle = acosf(cosAngle);
+		float sinAngle = sinf(angle);
+		wa = sinf((1.0f - t) * angle) / sinAngle;
+		wb = sinf(t * angle) / sinAngle;
+	}
+	return Normalize(MakeQuat(
+		wa * a.X + wb * end.X,
+		wa * a.Y + wb * end.Y,
+		wa * a.Z + wb * end.Z,
+		wa * a.W + wb * end.W));
+}
+
+// Rotation vector (axis * angle) taking a to b, shortest way round.
+inline Vec3 RotationBetween(const Quat &a, const Quat &b)
+{
+	Quat d = Multiply(b, Conjugate(a));
+	if (d.W < 0.0f)
+	{
+		d = MakeQuat(-d.X, -d.Y, -d.Z, -d.W);
+	}
+	Vec3 axis = MakeVec3(d.X, d.Y, d.Z);
+	float s = Length(axis);
+	if (s < 1e-9f)
+	{
+		return Scale(axis, 2.0f);
+	}
+	float angle = 2.0f * atan2f(s, d.W);
+	return Scale(axis, angle / s);
+}
+
+// Inverse of RotationBetween: orientation q turned by rotation vector r.
+inline Quat ApplyRotation(const Quat &q, const Vec3 &r)
+{
+	float angle = Length(r);
+	if (angle < 1e-9f)
+	{
+		return q;
+	}
+	float s = sinf(angle * 0.5f) / angle;
+	Quat d = MakeQuat(r.X * s, r.Y * s, r.Z * s, cosf(angle * 0.5f));
+	return Normalize(Multiply(d, q));
+}
+
+// The Kinova API describes orientation as Euler XYZ: R = Rx(ThetaX) * Ry(ThetaY) * Rz(ThetaZ).
+inline Quat FromKinovaEuler(float thetaX, float thetaY, float thetaZ)
+{
+	float cx = cosf(thetaX * 0.5f), sx = sinf(thetaX * 0.5f);
+	float cy = cosf(thetaY * 0.5f), sy = sinf(thetaY * 0.5f);
+	float cz = cosf(thetaZ * 0.5f), sz = sinf(thetaZ * 0.5f);
+	Quat qx = MakeQuat(sx, 0.0f, 0.0f, cx);
+	Quat qy = MakeQuat(0.0f, sy, 0.0f, cy);
+	Quat qz = MakeQuat(0.0f, 0.0f, sz, cz);
+	return Multiply(Multiply(qx, qy), qz);
+}
+
+inline void ToKinovaEuler(const Quat &orientation, float &thetaX, float &thetaY, float &thetaZ)
+{
+	Quat q = Normalize(orientation);
+	// rotation matrix terms needed for XYZ
+	float r02 = 2.0f * (q.X * q.Z + q.W * q.Y);
+	float r12 = 2.0f * (q.Y * q.Z - q.W * q.X);
+	float r22 = 1.0f - 2.0f * (q.X * q.X + q.Y * q.Y);
+	float r01 = 2.0f * (q.X * q.Y - q.W * q.Z);
+	float r00 = 1.0f - 2.0f * (q.Y * q.Y + q.Z * q.Z);
+
+	if (r02 > 1.0f) r02 = 1.0f;
+	if (r02 < -1.0f) r02 = -1.0f;
+
+	thetaY = asinf(r02);
+	if (fabsf(r02) < 0.9999f)
+	{
+		thetaX = atan2f(-r12, r22);
+		thetaZ = atan2f(-r01, r00);
+	}
+	else
+	{
+		// gimbal lock, put all of the remaining rotation on X; r21 has its sign
+		// at both poles, r10 only at +pi / 2
+		float r21 = 2.0f * (q.Y * q.Z + q.W * q.X);
+		float r11 = 1.0f - 2.0f * (q.X * q.X + q.Z * q.Z);
+		thetaX = atan2f(r21, r11);
+		thetaZ = 0.0f;
+	}
+}
+
+// Picks the equivalent of angle (mod 2 pi) closest to reference, so a stream of
+// Euler angles does not jump by 2 pi when it wraps.
+inline float UnwrapAngle(float angle, float reference)
+{
+	const float twoPi = 6.28318530718f;
+	while (angle - reference > twoPi * 0.5f) angle -= twoPi;
+	while (angle - reference < -twoPi * 0.5f) angle += twoPi;
+	return angle;
+}
+
+// ToKinovaEuler, picking whichever of the two equivalent angle sets
+// (x, y, z) and (x + pi, pi - y, z + pi) is closest to the reference angles,
+// unwrapped. Keeps a stream of orientations continuous in Euler angles
+// everywhere except right at ThetaY = +-pi / 2.
+inline void ToKinovaEulerNear(const Quat &orientation, float refX, float refY, float refZ,
+	float &thetaX, float &thetaY, float &thetaZ)
+{
+	const float pi = 3.14159265359f;
+	float x, y, z;
+	ToKinovaEuler(orientation, x, y, z);
+
+	float x1 = UnwrapAngle(x, refX), y1 = UnwrapAngle(y, refY), z1 = UnwrapAngle(z, refZ);
+	float x2 = UnwrapAngle(x + pi, refX), y2 = UnwrapAngle(pi - y, refY), z2 = UnwrapAngle(z + pi, refZ);
+	float d1 = fabsf(x1 - refX) + fabsf(y1 - refY) + fabsf(z1 - refZ);
+	float d2 = fabsf(x2 - refX) + fabsf(y2 - refY) + fabsf(z2 - refZ);
+	thetaX = d1 <= d2 ? x1 : x2;
+	thetaY = d1 <= d2 ? y1 : y2;
+	thetaZ = d1 <= d2 ? z1 : z2;
+}
+
+// Mirror images of an orientation across the plane normal to X, and from
+// Unity's left handed axes (z flipped) into right handed ones.
+inline Quat MirrorX(const Quat &q) { return MakeQuat(q.X, -q.Y, -q.Z, q.W); }
+inline Quat MirrorZ(const Quat &q) { return MakeQuat(-q.X, -q.Y, q.Z, q.W); }
@@ -0,0 +1,331 @@
+#include "Predictor.h"
+#include "Latency.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using namespace std;
+
+// predictions waiting for the stream to reach their time, per arm
+#define PREDICTOR_PENDING_SIZE 64
+
+struct PredictorSample
+{
+	long long Time;
+	Pose Target;
+};
+
+struct PendingPrediction
+{
+	long long Time;
+	Pose Predicted;
+	Pose Baseline;
+	// inputs of the learned model, velocity times horizon
+	Vec3 Features[PREDICTOR_LEARNED_TAPS];
+	bool Learned;
+};
+
+struct ArmPredictor
+{
+	PredictorSample Samples[PREDICTOR_HISTORY_SIZE];
+	int SampleHead;
+	int SampleCount;
+	PendingPrediction Pending[PREDICTOR_PENDING_SIZE];
+	int PendingHead;
+	int PendingCount;
+	float Weights[PREDICTOR_LEARNED_TAPS];
+};
+
+static mutex predictorLock;
+static ArmPredictor predictors[2];
+static PredictorStats stats;
+static bool initialized = false;
+
+// Lock must be held.
+static void Initialize()
+{
+	if (initialized)
+	{
+		return;
+	}
+	for (int arm = 0; arm < 2; arm++)
+	{
+		for (int k = 0; k < PREDICTOR_LEARNED_TAPS; k++)
+		{
+			predictors[arm].Weights[k] = k == 0 ? 1.0f : 0.0f;
+		}
+	}
+	stats.Model = PREDICT_NONE;
+	stats.Lead = 1.0f;
+	initialized = true;
+}
+
+static const PredictorSample &SampleAt(const ArmPredictor &arm, int i)
+{
+	return arm.Samples[(arm.SampleHead + i) % PREDICTOR_HISTORY_SIZE];
+}
+
+bool SetPrediction(int model, float lead)
+{
+	if (model < 0 || model >= PREDICTION_MODEL_COUNT || !(lead >= 0.0f && lead <= PREDICTOR_MAX_LEAD))
+	{
+		return false;
+	}
+	lock_guard<mutex> lock(predictorLock);
+	Initialize();
+	stats.Model = model;
+	stats.Lead = lead;
+	return true;
+}
+
+void ResetPredictor(bool rightArm)
+{
+	lock_guard<mutex> lock(predictorLock);
+	Initialize();
+	ArmPredictor &arm = predictors[rightArm ? 1 : 0];
+	arm.SampleCount = 0;
+	arm.PendingCount = 0;
+}
+
+void ReadPredictorStats(PredictorStats &result)
+{
+	lock_guard<mutex> lock(predictorLock);
+	Initialize();
+	result = stats;
+	result.PositionError = sqrtf(stats.PositionError);
+	result.AngleError = sqrtf(stats.AngleError);
+	result.BaselinePositionError = sqrtf(stats.BaselinePositionError);
+	result.BaselineAngleError = sqrtf(stats.BaselineAngleError);
+}
+
+// Pose of the pushed stream at time t, false when t is older than the history.
+static bool ActualAt(const ArmPredictor &arm, long long t, Pose &pose)
+{
+	for (int i = arm.SampleCount - 1; i > 0; i--)
+	{
+		const PredictorSample &a = SampleAt(arm, i - 1);
+		const PredictorSample &b = SampleAt(arm, i);
+		if (a.Time <= t && t <= b.Time)
+		{
+			float u = (float)(t - a.Time) / (float)(b.Time - a.Time);
+			pose.Position = Lerp(a.Target.Position, b.Target.Position, u);
+			pose.Orientation = Slerp(a.Target.Orientation, b.Target.Orientation, u);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void Smooth(float &average, float value, bool first)
+{
+	average = first ? value : average + PREDICTOR_ERROR_SMOOTHING * (value - average);
+}
+
+// Scores the predictions the newest sample has caught up with.
+static void ScorePending(ArmPredictor &arm)
+{
+	long long newest = SampleAt(arm, arm.SampleCount - 1).Time;
+	while (arm.PendingCount > 0)
+	{
+		PendingPrediction &p = arm.Pending[arm.PendingHead];
+		if (p.Time > newest)
+		{
+			break;
+		}
+		Pose actual;
+		if (ActualAt(arm, p.Time, actual))
+		{
+			float positionError = Length(Sub(p.Predicted.Position, actual.Position));
+			float angleError = Length(RotationBetween(p.Predicted.Orientation, actual.Orientation));
+			float baselinePosition = Length(Sub(p.Baseline.Position, actual.Position));
+			float baselineAngle = Length(RotationBetween(p.Baseline.Orientation, actual.Orientation));
+			bool first = stats.Scored == 0;
+			Smooth(stats.PositionError, positionError * positionError, first);
+			Smooth(stats.AngleError, angleError * angleError, first);
+			Smooth(stats.BaselinePositionError, baselinePosition * baselinePosition, first);
+			Smooth(stats.BaselineAngleError, baselineAngle * baselineAngle, first);
+			stats.Scored++;
+
+			if (p.Learned)
+			{
+				// normalized LMS step towards the displacement that really happened
+				Vec3 predicted = MakeVec3(0.0f, 0.0f, 0.0f);
+				float norm = 1e-6f;
+				for (int k = 0; k < PREDICTOR_LEARNED_TAPS; k++)
+				{
+					predicted = Add(predicted, Scale(p.Features[k], arm.Weights[k]));
+					norm += Dot(p.Features[k], p.Features[k]);
+				}
+				Vec3 error = Sub(Sub(actual.Position, p.Baseline.Position), predicted);
+				for (int k = 0; k < PREDICTOR_LEARNED_TAPS; k++)
+				{
+					arm.Weights[k] += PREDICTOR_LEARNING_RATE * Dot(error, p.Features[k]) / norm;
+				}
+			}
+		}
+		arm.PendingHead = (arm.PendingHead + 1) % PREDICTOR_PENDING_SIZE;
+		arm.PendingCount--;
+	}
+}
+
+// Velocity between samples i - 1 and i, m/s.
+static Vec3 VelocityAt(const ArmPredictor &arm, int i)
+{
+	const PredictorSample &a = SampleAt(arm, i - 1);
+	const PredictorSample &b = SampleAt(arm, i);
+	return Scale(Sub(b.Target.Position, a.Target.Position), 1e6f / (float)(b.Time - a.Time));
+}
+
+// Displacement after seconds from a quadratic fit of the history, relative to
+// the newest sample.
+static Vec3 QuadraticDisplacement(const ArmPredictor &arm, float seconds)
+{
+	const PredictorSample &newest = SampleAt(arm, arm.SampleCount - 1);
+	// normal equations of p(tau) = a + b tau + c tau^2
+	double m[3][3] = { { 0 } };
+	double rhs[3][3] = { { 0 } };
+	for (int i = 0; i < arm.SampleCount; i++)
+	{
+		const PredictorSample &s = SampleAt(arm, i);
+		double tau = (s.Time - newest.Time) * 1e-6;
+		double basis[3] = { 1.0, tau, tau * tau };
+		double p[3] = { s.Target.Position.X, s.Target.Position.Y, s.Target.Position.Z };
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				m[r][c] += basis[r] * basis[c];
+				rhs[r][c] += basis[r] * p[c];
+			}
+		}
+	}
+
+	// Gaussian elimination with partial pivoting, all three axes at once
+	for (int col = 0; col < 3; col++)
+	{
+		int pivot = col;
+		for (int r = col + 1; r < 3; r++)
+		{
+			if (fabs(m[r][col]) > fabs(m[pivot][col]))
+			{
+				pivot = r;
+			}
+		}
+		if (fabs(m[pivot][col]) < 1e-15)
+		{
+			return Scale(VelocityAt(arm, arm.SampleCount - 1), seconds);
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			swap(m[col][c], m[pivot][c]);
+			swap(rhs[col][c], rhs[pivot][c]);
+		}
+		for (int r = 0; r < 3; r++)
+		{
+			if (r == col)
+			{
+				continue;
+			}
+			double factor = m[r][col] / m[col][col];
+			for (int c = 0; c < 3; c++)
+			{
+				m[r][c] -= factor * m[col][c];
+				rhs[r][c] -= factor * rhs[col][c];
+			}
+		}
+	}
+
+	double h = seconds;
+	double d[3];
+	for (int c = 0; c < 3; c++)
+	{
+		double velocity = rhs[1][c] / m[1][1];
+		double halfAcceleration = rhs[2][c] / m[2][2];
+		d[c] = velocity * h + halfAcceleration * h * h;
+	}
+	return MakeVec3((float)d[0], (float)d[1], (float)d[2]);
+}
+
+Pose PredictTarget(bool rightArm, long long timestamp, const Pose &sample, long long renderDelayMicros)
+{
+	long long motion = LatencyPercentile(LATENCY_MOTION, 0.5f);
+
+	lock_guard<mutex> lock(predictorLock);
+	Initialize();
+	ArmPredictor &arm = predictors[rightArm ? 1 : 0];
+	if (arm.SampleCount > 0 && timestamp <= SampleAt(arm, arm.SampleCount - 1).Time)
+	{
+		return sample;
+	}
+	if (arm.SampleCount == PREDICTOR_HISTORY_SIZE)
+	{
+		arm.SampleHead = (arm.SampleHead + 1) % PREDICTOR_HISTORY_SIZE;
+		arm.SampleCount--;
+	}
+	PredictorSample &slot = arm.Samples[(arm.SampleHead + arm.SampleCount) % PREDICTOR_HISTORY_SIZE];
+	slot.Time = timestamp;
+	slot.Target.Position = sample.Position;
+	slot.Target.Orientation = Normalize(sample.Orientation);
+	arm.SampleCount++;
+	ScorePending(arm);
+
+	long long horizon = (long long)(stats.Lead * (renderDelayMicros + max(0LL, motion)));
+	horizon = min(horizon, (long long)PREDICTOR_MAX_HORIZON_MICROS);
+	stats.HorizonMicros = horizon;
+	if (stats.Model == PREDICT_NONE || horizon <= 0 || arm.SampleCount < 2)
+	{
+		return slot.Target;
+	}
+
+	float seconds = horizon * 1e-6f;
+	PendingPrediction prediction;
+	prediction.Time = timestamp + horizon;
+	prediction.Baseline = slot.Target;
+	prediction.Learned = stats.Model == PREDICT_LEARNED;
+
+	Vec3 displacement;
+	if (prediction.Learned)
+	{
+		displacement = MakeVec3(0.0f, 0.0f, 0.0f);
+		for (int k = 0; k < PREDICTOR_LEARNED_TAPS; k++)
+		{
+			int i = arm.SampleCount - 1 - k;
+			prediction.Features[k] = i > 0 ? Scale(VelocityAt(arm, i), seconds) : MakeVec3(0.0f, 0.0f, 0.0f);
+			displacement = Add(displacement, Scale(prediction.Features[k], arm.Weights[k]));
+		}
+	}
+	else if (arm.SampleCount >= 3)
+	{
+		displacement = QuadraticDisplacement(arm, seconds);
+	}
+	else
+	{
+		displacement = Scale(VelocityAt(arm, arm.SampleCount - 1), seconds);
+	}
+	float distance = Length(displacement);
+	if (distance > PREDICTOR_MAX_LEAD_DISTANCE)
+	{
+		displacement = Scale(displacement, PREDICTOR_MAX_LEAD_DISTANCE / distance);
+	}
+
+	const PredictorSample &previous = SampleAt(arm, arm.SampleCount - 2);
+	float interval = (timestamp - previous.Time) * 1e-6f;
+	prediction.Predicted.Position = Add(slot.Target.Position, displacement);
+	Vec3 rotation = Scale(RotationBetween(previous.Target.Orientation, slot.Target.Orientation), seconds / interval);
+	float angle = Length(rotation);
+	if (angle > PREDICTOR_MAX_LEAD_ANGLE)
+	{
+		rotation = Scale(rotation, PREDICTOR_MAX_LEAD_ANGLE / angle);
+	}
+	prediction.Predicted.Orientation = ApplyRotation(slot.Target.Orientation, rotation);
+
+	if (arm.PendingCount == PREDICTOR_PENDING_SIZE)
+	{
+		arm.PendingHead = (arm.PendingHead + 1) % PREDICTOR_PENDING_SIZE;
+		arm.PendingCount--;
+	}
+	arm.Pending[(arm.PendingHead + arm.PendingCount) % PREDICTOR_PENDING_SIZE] = prediction;
+	arm.PendingCount++;
+	stats.Predictions++;
+	return prediction.Predicted;
+}
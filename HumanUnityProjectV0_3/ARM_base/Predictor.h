@@ -0,0 +1,61 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Latency compensation for the target stream. Every pushed target is replaced
+// by where the operator's hand is expected to be one horizon later, so the arm
+// (and the 360 video of it) trails the operator by less.
+//
+//   horizon = Lead * (render delay + median LATENCY_MOTION, see Latency.h)
+//
+// Each prediction is scored once the stream reaches its time, against the pose
+// actually pushed then and against not predicting at all.
+
+enum PredictionModel
+{
+	PREDICT_NONE = 0,
+	// quadratic least squares fit of the last samples' positions, constant
+	// angular velocity for the orientation
+	PREDICT_CONSTANT_ACCELERATION = 1,
+	// linear model over the last velocities, its weights learned online (NLMS)
+	// from the scored predictions; starts out as constant velocity
+	PREDICT_LEARNED = 2,
+	PREDICTION_MODEL_COUNT
+};
+
+#define PREDICTOR_HISTORY_SIZE 8
+#define PREDICTOR_LEARNED_TAPS 4
+#define PREDICTOR_LEARNING_RATE 0.05f
+#define PREDICTOR_MAX_LEAD 2.0f
+#define PREDICTOR_MAX_HORIZON_MICROS 200000
+// Predictions never move a target further than this from the sample, meters
+// and radians.
+#define PREDICTOR_MAX_LEAD_DISTANCE 0.15f
+#define PREDICTOR_MAX_LEAD_ANGLE 0.5f
+// Weight of the newest scored prediction in the running errors.
+#define PREDICTOR_ERROR_SMOOTHING 0.02f
+
+// Mirrored by KinovaAPI.PredictorStats. Errors are exponentially weighted RMS
+// over the recently scored predictions of both arms, meters and radians.
+struct PredictorStats
+{
+	int Model;
+	float Lead;
+	long long HorizonMicros;
+	unsigned int Predictions;
+	unsigned int Scored;
+	float PositionError;
+	float AngleError;
+	// error of the raw samples against the same future poses
+	float BaselinePositionError;
+	float BaselineAngleError;
+};
+
+// lead in [0, PREDICTOR_MAX_LEAD]. Returns false for a bad model or lead.
+bool SetPrediction(int model, float lead);
+
+// Records the sample and returns the pose to stream in its place.
+Pose PredictTarget(bool rightArm, long long timestamp, const Pose &sample, long long renderDelayMicros);
+
+void ResetPredictor(bool rightArm);
+void ReadPredictorStats(PredictorStats &stats);
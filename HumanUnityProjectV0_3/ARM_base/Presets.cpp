@@ -0,0 +1,60 @@
+#include "Presets.h"
+#include <cstring>
+
+static const PresetPose presets[] =
+{
+	// HOME (Cartesian Position for Joystick Home)
+	{ "HomePosition", 0.29f, -0.26f, 0.29f, 1.5924f, -1.1792f, 0.0f },
+	// Arm raised up
+	{ "RaiseTheRoof", 0.0f, -0.60f, 0.33f, 1.5665f, -0.4711f, 0.0f },
+	// Arm ready to scoop ice cream
+	{ "Scooping", -0.15f, 0.41f, 0.57f, -1.6554f, -0.6633f, 0.0f },
+	// Arm stretched out from the shoulder
+	{ "StretchOut", -0.11f, -0.25f, 0.75f, 1.5956f, 0.0318f, 0.0f },
+	// Arm hanging to the side
+	{ "RestingPosition", 0.04f, 0.67f, 0.29f, -1.57f, -0.32f, 0.0f },
+	// Arm flexing biceps
+	{ "FlexBiceps", -0.08f, -0.46f, 0.22f, 1.37f, -0.26f, 0.0f },
+};
+
+int PresetCount()
+{
+	return sizeof(presets) / sizeof(presets[0]);
+}
+
+const PresetPose &PresetAt(int index)
+{
+	return presets[index];
+}
+
+const PresetPose *FindPreset(const char *name)
+{
+	int index = PresetIndex(name);
+	return index >= 0 ? &presets[index] : NULL;
+}
+
+int PresetIndex(const char *name)
+{
+	if (name == NULL)
+	{
+		return -1;
+	}
+	for (int i = 0; i < PresetCount(); i++)
+	{
+		if (strcmp(presets[i].Name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+PresetPose MirrorForArm(const PresetPose &pose, bool rightArm)
+{
+	PresetPose mirrored = pose;
+	if (rightArm)
+	{
+		mirrored.X = -pose.X;
+	}
+	return mirrored;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Named Cartesian poses, same values as the presets in KinovaAPI.cs.
+// They are written for the left arm; MirrorForArm gives the right arm version.
+
+struct PresetPose
+{
+	const char *Name;
+	// meters
+	float X;
+	float Y;
+	float Z;
+	// radians
+	float ThetaX;
+	float ThetaY;
+	float ThetaZ;
+};
+
+int PresetCount();
+const PresetPose &PresetAt(int index);
+
+// Case sensitive lookup by name ("HomePosition", "RaiseTheRoof", ...). NULL
+// (or -1 for the index) if unknown.
+const PresetPose *FindPreset(const char *name);
+int PresetIndex(const char *name);
+
+// Right arm presets negate x, like HandController.MoveArm does.
+PresetPose MirrorForArm(const PresetPose &pose, bool rightArm);
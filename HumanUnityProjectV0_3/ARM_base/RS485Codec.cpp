@@ -0,0 +1,152 @@
+#include "RS485Codec.h"
+#include <cstring>
+
+static void WriteWord(unsigned char *out, unsigned int value)
+{
+	out[0] = (unsigned char)(value & 0xFF);
+	out[1] = (unsigned char)((value >> 8) & 0xFF);
+	out[2] = (unsigned char)((value >> 16) & 0xFF);
+	out[3] = (unsigned char)(value >> 24);
+}
+
+static unsigned int ReadWord(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+static short LowHalf(unsigned int word)
+{
+	return (short)(word & 0xFFFF);
+}
+
+static short HighHalf(unsigned int word)
+{
+	return (short)(word >> 16);
+}
+
+static unsigned int Fixed16(float value, float scale)
+{
+	float scaled = value * scale;
+	scaled = scaled < -32768.0f ? -32768.0f : (scaled > 32767.0f ? 32767.0f : scaled);
+	return (unsigned short)(short)scaled;
+}
+
+void EncodeRS485(const RS485Frame &frame, unsigned char *out)
+{
+	out[0] = (unsigned char)(frame.Command & 0xFF);
+	out[1] = (unsigned char)((unsigned short)frame.Command >> 8);
+	out[2] = frame.SourceAddress;
+	out[3] = frame.DestinationAddress;
+	for (int i = 0; i < 4; i++)
+	{
+		WriteWord(out + 4 + 4 * i, frame.DataLong[i]);
+	}
+}
+
+void DecodeRS485(const unsigned char *in, RS485Frame &frame)
+{
+	frame.Command = (short)(unsigned short)(in[0] | (in[1] << 8));
+	frame.SourceAddress = in[2];
+	frame.DestinationAddress = in[3];
+	for (int i = 0; i < 4; i++)
+	{
+		frame.DataLong[i] = ReadWord(in + 4 + 4 * i);
+	}
+}
+
+int EncodeRS485Batch(const RS485Frame *frames, int count, unsigned char *out, int capacity)
+{
+	if (count < 0 || count > RS485_CODEC_MAX_BATCH || capacity < count * RS485_CODEC_MESSAGE_SIZE)
+	{
+		return -1;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		EncodeRS485(frames[i], out + i * RS485_CODEC_MESSAGE_SIZE);
+	}
+	return count * RS485_CODEC_MESSAGE_SIZE;
+}
+
+int DecodeRS485Batch(const unsigned char *in, int size, RS485Frame *frames, int maxCount)
+{
+	int count = size / RS485_CODEC_MESSAGE_SIZE;
+	if (size < 0 || size % RS485_CODEC_MESSAGE_SIZE != 0 || count > RS485_CODEC_MAX_BATCH || count > maxCount)
+	{
+		return -1;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		DecodeRS485(in + i * RS485_CODEC_MESSAGE_SIZE, frames[i]);
+	}
+	return size;
+}
+
+void MakeRS485Message(RS485Frame &frame, short command, unsigned char address)
+{
+	memset(&frame, 0, sizeof(frame));
+	frame.Command = command;
+	frame.SourceAddress = RS485_HOST_ADDRESS;
+	frame.DestinationAddress = address;
+}
+
+void MakeRS485PositionCommand(RS485Frame &frame, unsigned char address, float degrees, bool allValues)
+{
+	MakeRS485Message(frame, allValues ? RS485_CMD_GET_POSITION_COMMAND_ALL_VALUES : RS485_CMD_GET_POSITION_COMMAND, address);
+	frame.DataFloat[0] = degrees;
+	frame.DataFloat[1] = degrees;
+	frame.DataLong[2] = allValues ? 1 : 0;
+}
+
+void MakeRS485Feedthrough(RS485Frame &frame, unsigned char address, float value)
+{
+	MakeRS485Message(frame, RS485_CMD_FEEDTHROUGH, address);
+	value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	frame.DataFloat[0] = value;
+	frame.DataFloat[1] = value;
+}
+
+bool ReadRS485Feedback(const RS485Frame &frame, long long now, ActuatorFeedback &feedback)
+{
+	switch (frame.Command)
+	{
+	case RS485_CMD_SEND_ACTUALPOSITION:
+	case RS485_CMD_SEND_ALL_VALUES_1:
+		feedback.Current = frame.DataFloat[0];
+		feedback.Position = frame.DataFloat[1];
+		feedback.Speed = frame.DataFloat[2];
+		feedback.Torque = frame.DataFloat[3];
+		break;
+	case RS485_CMD_SEND_POSITION_CURRENT:
+		feedback.Current = frame.DataFloat[0];
+		feedback.Position = frame.DataFloat[1];
+		break;
+	case RS485_CMD_SEND_ALL_VALUES_2:
+		feedback.Pwm = frame.DataFloat[0];
+		feedback.EncoderPosition = frame.DataFloat[1];
+		feedback.Acceleration[0] = LowHalf(frame.DataLong[2]) * 0.001f;
+		feedback.Acceleration[1] = HighHalf(frame.DataLong[2]) * 0.001f;
+		feedback.Acceleration[2] = LowHalf(frame.DataLong[3]) * 0.001f;
+		feedback.Temperature = HighHalf(frame.DataLong[3]) * 0.01f;
+		break;
+	case RS485_CMD_SEND_ALL_VALUES_3:
+		memcpy(feedback.ExtraValues, frame.DataLong, sizeof(feedback.ExtraValues));
+		break;
+	case RS485_CMD_REPORT_ERROR:
+		feedback.Fault = frame.DataLong[0];
+		break;
+	default:
+		return false;
+	}
+	feedback.Address = frame.SourceAddress;
+	feedback.Timestamp = now;
+	feedback.Replies++;
+	return true;
+}
+
+void PackRS485AllValues2(RS485Frame &frame, float pwm, float encoderPosition, const float acceleration[3], float temperature)
+{
+	frame.DataFloat[0] = pwm;
+	frame.DataFloat[1] = encoderPosition;
+	frame.DataLong[2] = Fixed16(acceleration[0], 1000.0f) | (Fixed16(acceleration[1], 1000.0f) << 16);
+	frame.DataLong[3] = Fixed16(acceleration[2], 1000.0f) | (Fixed16(temperature, 100.0f) << 16);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Messages of the actuators' RS-485 bus (RS485_Message and the command IDs in
+// Lib_Examples\CommunicationLayerWindows.h), without Windows or Kinova headers.
+// On the wire a message is 20 bytes: the command as a little endian short, the
+// source and destination addresses, then four little endian 32 bit words.
+
+#define RS485_CODEC_MESSAGE_SIZE 20
+
+// Messages per bus transaction (RS485_MESSAGE_MAX_COUNT).
+#define RS485_CODEC_MAX_BATCH 3
+
+// Address the host uses as source, and the first actuator of a Jaco arm.
+#define RS485_HOST_ADDRESS 0x00
+#define RS485_FIRST_ACTUATOR_ADDRESS 0x10
+
+// Command IDs, as in CommunicationLayerWindows.h.
+#define RS485_CMD_SET_ADDRESS 0x00
+#define RS485_CMD_GET_ACTUALPOSITION 0x01
+#define RS485_CMD_SEND_ACTUALPOSITION 0x02
+#define RS485_CMD_START_ASSERV 0x03
+#define RS485_CMD_STOP_ASSERV 0x04
+#define RS485_CMD_FEEDTHROUGH 0x09
+#define RS485_CMD_GET_POSITION_COMMAND 0x10
+#define RS485_CMD_SEND_POSITION_CURRENT 0x11
+#define RS485_CMD_GET_POSITION_COMMAND_ALL_VALUES 0x14
+#define RS485_CMD_SEND_ALL_VALUES_1 0x15
+#define RS485_CMD_SEND_ALL_VALUES_2 0x16
+#define RS485_CMD_SEND_ALL_VALUES_3 0x17
+#define RS485_CMD_REPORT_ERROR 0x30
+#define RS485_CMD_CLEAR_FAULT_FLAG 0x33
+#define RS485_CMD_NACK 0x3E
+#define RS485_CMD_ACK 0x3F
+
+// Same layout as RS485_Message (whose unsigned long is 32 bits on Windows), so
+// arrays of either can be copied into each other.
+struct RS485Frame
+{
+	short Command;
+	unsigned char SourceAddress;
+	unsigned char DestinationAddress;
+	union
+	{
+		unsigned char DataByte[16];
+		float DataFloat[4];
+		unsigned int DataLong[4];
+	};
+};
+
+// What an actuator last reported about itself.
+struct ActuatorFeedback
+{
+	// caller's time of the newest reply, 0 before the first
+	long long Timestamp;
+	unsigned char Address;
+	// SEND_ACTUALPOSITION, SEND_POSITION_CURRENT (first two) and SEND_ALL_VALUES_1:
+	// amperes, degrees, degrees per second, newton meters
+	float Current;
+	float Position;
+	float Speed;
+	float Torque;
+	// SEND_ALL_VALUES_2: PWM duty, encoder position in degrees, g, celsius
+	float Pwm;
+	float EncoderPosition;
+	float Acceleration[3];
+	float Temperature;
+	// SEND_ALL_VALUES_3, kept as is
+	unsigned int ExtraValues[4];
+	// last REPORT_ERROR code, 0 when none
+	unsigned int Fault;
+	unsigned int Replies;
+};
+
+// Writes frame into out, RS485_CODEC_MESSAGE_SIZE bytes.
+void EncodeRS485(const RS485Frame &frame, unsigned char *out);
+void DecodeRS485(const unsigned char *in, RS485Frame &frame);
+
+// count frames back to back, at most RS485_CODEC_MAX_BATCH. Return the number
+// of bytes written or read, or -1 for a bad count or size.
+int EncodeRS485Batch(const RS485Frame *frames, int count, unsigned char *out, int capacity);
+int DecodeRS485Batch(const unsigned char *in, int size, RS485Frame *frames, int maxCount);
+
+// Builders. The actuators only take a position or feedthrough value when it
+// is sent twice, in DataFloat[0] and DataFloat[1]; these do that.
+void MakeRS485Message(RS485Frame &frame, short command, unsigned char address);
+void MakeRS485PositionCommand(RS485Frame &frame, unsigned char address, float degrees, bool allValues);
+// value from -1 to 1, bypassing the actuator's PID (its gains must be zero).
+void MakeRS485Feedthrough(RS485Frame &frame, unsigned char address, float value);
+
+// Takes what a reply says about its source actuator into feedback. Returns
+// true if the frame was a report this understands.
+bool ReadRS485Feedback(const RS485Frame &frame, long long now, ActuatorFeedback &feedback);
+
+// SEND_ALL_VALUES_2 packs acceleration and temperature into DataLong[2..3] as
+// 16 bit fixed point; the simulator writes them with this.
+void PackRS485AllValues2(RS485Frame &frame, float pwm, float encoderPosition, const float acceleration[3], float temperature);
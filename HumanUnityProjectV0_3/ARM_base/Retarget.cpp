@@ -0,0 +1,150 @@
+#include "Retarget.h"
+#include <mutex>
+
+using namespace std;
+
+struct ArmRetarget
+{
+	bool HasFrame;
+	RetargetFrame Frame;
+	bool HasPrevious;
+	KinovaPose Previous;
+};
+
+static mutex retargetLock;
+static ArmRetarget arms[2];
+static bool initialized = false;
+
+// Lock must be held.
+static void Initialize()
+{
+	if (initialized)
+	{
+		return;
+	}
+	arms[0].HasFrame = true;
+	arms[0].Frame = DefaultRetargetFrame();
+	arms[0].HasPrevious = false;
+	arms[1].HasFrame = false;
+	arms[1].HasPrevious = false;
+	initialized = true;
+}
+
+RetargetFrame DefaultRetargetFrame()
+{
+	const float half = 0.70710678f;
+	RetargetFrame frame;
+	// 180 degrees about (1, 0, 1): (x, y, z) -> (z, -y, x)
+	frame.Rotation = MakeQuat(half, 0.0f, half, 0.0f);
+	frame.Translation = MakeVec3(0.0f, 0.0f, 0.0f);
+	frame.Scale = 1.0f;
+	// level controller -> ThetaX -1.64 (the old -pi + 1.5), ThetaY 1.4
+	frame.HandOffset = Multiply(Conjugate(frame.Rotation), FromKinovaEuler(-1.6416f, 1.4f, 0.0f));
+	return frame;
+}
+
+void SetRetargetFrame(bool rightArm, const RetargetFrame &frame)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	ArmRetarget &arm = arms[rightArm ? 1 : 0];
+	arm.HasFrame = true;
+	arm.Frame = frame;
+	arm.Frame.Rotation = Normalize(frame.Rotation);
+	arm.Frame.HandOffset = Normalize(frame.HandOffset);
+}
+
+void ClearRetargetFrame(bool rightArm)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	ArmRetarget &arm = arms[rightArm ? 1 : 0];
+	arm.HasFrame = !rightArm;
+	arm.Frame = DefaultRetargetFrame();
+}
+
+RetargetFrame GetRetargetFrame(bool rightArm)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	return arms[rightArm && arms[1].HasFrame ? 1 : 0].Frame;
+}
+
+bool HasRetargetFrame(bool rightArm)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	return arms[rightArm ? 1 : 0].HasFrame;
+}
+
+static Pose Apply(const RetargetFrame &frame, const Vec3 &position, const Quat &orientation)
+{
+	Pose pose;
+	pose.Position = Add(Scale(Rotate(frame.Rotation, position), frame.Scale), frame.Translation);
+	pose.Orientation = Normalize(Multiply(Multiply(frame.Rotation, orientation), frame.HandOffset));
+	return pose;
+}
+
+// Lock must be held.
+static Pose Retarget(bool rightArm, const ControllerPose &controller)
+{
+	// Unity is left handed
+	Vec3 position = MakeVec3(controller.Position.X, controller.Position.Y, -controller.Position.Z);
+	Quat orientation = MirrorZ(Normalize(controller.Orientation));
+
+	if (!rightArm || arms[1].HasFrame)
+	{
+		return Apply(arms[rightArm ? 1 : 0].Frame, position, orientation);
+	}
+
+	// mirror image of what the left arm would do with the mirrored controller
+	Pose pose = Apply(arms[0].Frame, MakeVec3(-position.X, position.Y, position.Z), MirrorX(orientation));
+	pose.Position.X = -pose.Position.X;
+	pose.Orientation = MirrorX(pose.Orientation);
+	return pose;
+}
+
+Pose RetargetPose(bool rightArm, const ControllerPose &controller)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	return Retarget(rightArm, controller);
+}
+
+void RetargetControllers(const ControllerPose controllers[2], int armMask, KinovaPose poses[2])
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	for (int i = 0; i < 2; i++)
+	{
+		if ((armMask & (i == 0 ? RETARGET_LEFT_ARM : RETARGET_RIGHT_ARM)) == 0)
+		{
+			continue;
+		}
+		ArmRetarget &arm = arms[i];
+		Pose pose = Retarget(i == 1, controllers[i]);
+
+		KinovaPose &out = poses[i];
+		out.X = pose.Position.X;
+		out.Y = pose.Position.Y;
+		out.Z = pose.Position.Z;
+		if (arm.HasPrevious)
+		{
+			ToKinovaEulerNear(pose.Orientation, arm.Previous.ThetaX, arm.Previous.ThetaY, arm.Previous.ThetaZ,
+				out.ThetaX, out.ThetaY, out.ThetaZ);
+		}
+		else
+		{
+			ToKinovaEuler(pose.Orientation, out.ThetaX, out.ThetaY, out.ThetaZ);
+		}
+		arm.Previous = out;
+		arm.HasPrevious = true;
+	}
+}
+
+void ResetRetargetContinuity(bool rightArm)
+{
+	lock_guard<mutex> lock(retargetLock);
+	Initialize();
+	arms[rightArm ? 1 : 0].HasPrevious = false;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "PoseMath.h"
+
+// Operator to robot retargeting: turns a Vive controller pose, as Unity reports
+// it, into a Kinova end effector pose for one arm.
+//
+//   tracked  = controller pose with Unity's z flipped (right handed)
+//   position = Scale * Rotation * tracked position + Translation
+//   rotation = Rotation * tracked rotation * HandOffset
+//
+// The right arm uses its own frame once one is set. Until then it uses the left
+// arm's frame mirrored: the controller across the operator's x and the result
+// across the robot's x, the same way presets are mirrored.
+
+// Mirrored by KinovaAPI.RetargetFrame on the C# side, keep them in sync.
+struct RetargetFrame
+{
+	Quat Rotation;
+	Vec3 Translation;
+	float Scale;
+	// controller orientation to gripper orientation
+	Quat HandOffset;
+};
+
+// Mirrored by KinovaAPI.ControllerPose. Unity world coordinates.
+struct ControllerPose
+{
+	Vec3 Position;
+	Quat Orientation;
+};
+
+// Mirrored by KinovaAPI.KinovaPose. Meters and radians, like MoveHand.
+struct KinovaPose
+{
+	float X;
+	float Y;
+	float Z;
+	float ThetaX;
+	float ThetaY;
+	float ThetaZ;
+};
+
+#define RETARGET_LEFT_ARM 1
+#define RETARGET_RIGHT_ARM 2
+
+// The mapping HandController used to do in C#: x = -z, y = -y, z = x, with a
+// level controller giving the old ThetaX and ThetaY.
+RetargetFrame DefaultRetargetFrame();
+
+void SetRetargetFrame(bool rightArm, const RetargetFrame &frame);
+// The right arm goes back to mirroring the left one; the left to the default.
+void ClearRetargetFrame(bool rightArm);
+// The right arm's is the left one's while it mirrors it.
+RetargetFrame GetRetargetFrame(bool rightArm);
+// False while the right arm mirrors the left one; the left arm always has one.
+bool HasRetargetFrame(bool rightArm);
+
+// Pose of the end effector as a position and quaternion, no Euler angles.
+Pose RetargetPose(bool rightArm, const ControllerPose &controller);
+
+// Retargets the arms in armMask (RETARGET_LEFT_ARM | RETARGET_RIGHT_ARM),
+// index 0 left and 1 right, in one go. The Euler angles of each arm stay
+// continuous with the ones it returned last time.
+void RetargetControllers(const ControllerPose controllers[2], int armMask, KinovaPose poses[2]);
+
+// Forgets the last angles, so the next call starts from the plain Euler angles.
+void ResetRetargetContinuity(bool rightArm);
@@ -0,0 +1,585 @@
+#include "Roadmap.h"
+#include "Presets.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// bump when the planner or kinematic model changes so old caches are replanned
+#define ROADMAP_FORMAT_VERSION 1
+#define ROADMAP_MAGIC 0x504d5248 // "HRMP"
+
+#define ROADMAP_IK_SEEDS 64
+#define ROADMAP_STEP 10.0f
+#define ROADMAP_MAX_SAMPLES 5000
+#define ROADMAP_SHORTCUT_ATTEMPTS 150
+
+struct RoadmapTable
+{
+	unsigned int Hash;
+	int Presets;
+	// [arm][preset]
+	vector<char> Solved;
+	vector<JointConfig> Goals;
+	// [arm][pair], pair of presets i < j, path from i to j
+	vector<unsigned int> Offsets;
+	vector<unsigned int> Counts;
+	vector<JointConfig> Points;
+	vector<Capsule> Obstacles[2];
+};
+
+static mutex roadmapLock;
+static condition_variable roadmapChanged;
+static thread planner;
+static bool running = false;
+static bool dirty = false;
+static atomic<bool> abortPlanning(false);
+static atomic<bool> planning(false);
+static string cachePath;
+static vector<Capsule> environment;
+static shared_ptr<const RoadmapTable> current;
+
+static int PairIndex(int presets, int i, int j)
+{
+	// i < j, row by row of the upper triangle
+	return i * presets - i * (i + 1) / 2 + (j - i - 1);
+}
+
+static int PairCount(int presets)
+{
+	return presets * (presets - 1) / 2;
+}
+
+static void HashBytes(unsigned int &hash, const void *data, size_t size)
+{
+	// FNV-1a
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+}
+
+static unsigned int ModelHash(const vector<Capsule> &obstacles)
+{
+	unsigned int hash = 2166136261u;
+	int version = ROADMAP_FORMAT_VERSION;
+	HashBytes(hash, &version, sizeof(version));
+	for (int i = 0; i < PresetCount(); i++)
+	{
+		const PresetPose &preset = PresetAt(i);
+		HashBytes(hash, preset.Name, strlen(preset.Name));
+		HashBytes(hash, &preset.X, sizeof(float) * 6);
+	}
+	if (!obstacles.empty())
+	{
+		HashBytes(hash, &obstacles[0], obstacles.size() * sizeof(Capsule));
+	}
+	return hash;
+}
+
+static bool ShouldAbort()
+{
+	return abortPlanning.load();
+}
+
+// Collision free IK solution closest to Kinova's home position.
+static bool SolvePreset(bool rightArm, int index, const vector<Capsule> &obstacles, JointConfig &best)
+{
+	PresetPose preset = MirrorForArm(PresetAt(index), rightArm);
+	Pose target;
+	target.Position = MakeVec3(preset.X, preset.Y, preset.Z);
+	target.Orientation = FromKinovaEuler(preset.ThetaX, preset.ThetaY, preset.ThetaZ);
+
+	JointConfig home = HomeJoints();
+	mt19937 random(index * 2 + (rightArm ? 1 : 0));
+	uniform_real_distribution<float> limited(50.0f, 310.0f);
+	uniform_real_distribution<float> anyAngle(0.0f, 360.0f);
+
+	bool found = false;
+	float bestDistance = 0.0f;
+	for (int attempt = 0; attempt < ROADMAP_IK_SEEDS; attempt++)
+	{
+		JointConfig seed = home;
+		if (attempt > 0)
+		{
+			for (int i = 0; i < ARM_DOF; i++)
+			{
+				seed.Angles[i] = IsContinuousJoint(i) ? anyAngle(random) : limited(random);
+			}
+		}
+
+		JointConfig solution;
+		if (!InverseKinematics(target, seed, solution))
+		{
+			continue;
+		}
+		solution = UnwrapJoints(solution, home);
+		if (InCollision(solution, obstacles))
+		{
+			continue;
+		}
+		float distance = JointDistance(solution, home);
+		if (!found || distance < bestDistance)
+		{
+			found = true;
+			bestDistance = distance;
+			best = solution;
+		}
+	}
+	return found;
+}
+
+struct TreeNode
+{
+	JointConfig Joints;
+	int Parent;
+};
+
+enum ExtendResult
+{
+	EXTEND_TRAPPED,
+	EXTEND_ADVANCED,
+	EXTEND_REACHED
+};
+
+static int Nearest(const vector<TreeNode> &tree, const JointConfig &target)
+{
+	int nearest = 0;
+	float nearestDistance = JointDistance(tree[0].Joints, target);
+	for (size_t i = 1; i < tree.size(); i++)
+	{
+		float distance = JointDistance(tree[i].Joints, target);
+		if (distance < nearestDistance)
+		{
+			nearest = (int)i;
+			nearestDistance = distance;
+		}
+	}
+	return nearest;
+}
+
+static ExtendResult Extend(vector<TreeNode> &tree, const JointConfig &target, const vector<Capsule> &obstacles)
+{
+	int nearest = Nearest(tree, target);
+	const JointConfig &from = tree[nearest].Joints;
+	float distance = JointDistance(from, target);
+	bool reached = distance <= ROADMAP_STEP;
+	JointConfig next = reached ? target : LerpJoints(from, target, ROADMAP_STEP / distance);
+
+	if (!WithinJointLimits(next) || MotionInCollision(from, next, obstacles, ROADMAP_CHECK_RESOLUTION))
+	{
+		return EXTEND_TRAPPED;
+	}
+	TreeNode node = { next, nearest };
+	tree.push_back(node);
+	return reached ? EXTEND_REACHED : EXTEND_ADVANCED;
+}
+
+static ExtendResult Connect(vector<TreeNode> &tree, const JointConfig &target, const vector<Capsule> &obstacles)
+{
+	ExtendResult result;
+	do
+	{
+		result = Extend(tree, target, obstacles);
+	} while (result == EXTEND_ADVANCED);
+	return result;
+}
+
+static void Shortcut(vector<JointConfig> &path, const vector<Capsule> &obstacles, mt19937 &random)
+{
+	for (int attempt = 0; attempt < ROADMAP_SHORTCUT_ATTEMPTS && path.size() > 2; attempt++)
+	{
+		uniform_int_distribution<int> pick(0, (int)path.size() - 1);
+		int i = pick(random);
+		int j = pick(random);
+		if (i > j)
+		{
+			swap(i, j);
+		}
+		if (j - i < 2)
+		{
+			continue;
+		}
+		if (!MotionInCollision(path[i], path[j], obstacles, ROADMAP_CHECK_RESOLUTION))
+		{
+			path.erase(path.begin() + i + 1, path.begin() + j);
+		}
+	}
+}
+
+// RRT-Connect from start to goal, shortcut afterwards. Returns false when no
+// path was found within ROADMAP_MAX_SAMPLES or planning was aborted.
+static bool PlanPath(const JointConfig &start, const JointConfig &goal, const vector<Capsule> &obstacles,
+	mt19937 &random, vector<JointConfig> &path)
+{
+	path.clear();
+	if (!MotionInCollision(start, goal, obstacles, ROADMAP_CHECK_RESOLUTION))
+	{
+		path.push_back(start);
+		path.push_back(goal);
+		return true;
+	}
+
+	// continuous joints may go half a turn past either end
+	float low[ARM_DOF];
+	float high[ARM_DOF];
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		low[i] = IsContinuousJoint(i) ? min(start.Angles[i], goal.Angles[i]) - 180.0f : JointMinimum(i);
+		high[i] = IsContinuousJoint(i) ? max(start.Angles[i], goal.Angles[i]) + 180.0f : JointMaximum(i);
+	}
+
+	vector<TreeNode> fromStart(1);
+	fromStart[0].Joints = start;
+	fromStart[0].Parent = -1;
+	vector<TreeNode> fromGoal(1);
+	fromGoal[0].Joints = goal;
+	fromGoal[0].Parent = -1;
+
+	vector<TreeNode> *a = &fromStart;
+	vector<TreeNode> *b = &fromGoal;
+	for (int sample = 0; sample < ROADMAP_MAX_SAMPLES; sample++)
+	{
+		if (ShouldAbort())
+		{
+			return false;
+		}
+
+		JointConfig target;
+		for (int i = 0; i < ARM_DOF; i++)
+		{
+			target.Angles[i] = uniform_real_distribution<float>(low[i], high[i])(random);
+		}
+
+		if (Extend(*a, target, obstacles) != EXTEND_TRAPPED &&
+			Connect(*b, a->back().Joints, obstacles) == EXTEND_REACHED)
+		{
+			// walk both trees back from where they met
+			for (int node = (int)fromStart.size() - 1; node >= 0; node = fromStart[node].Parent)
+			{
+				path.push_back(fromStart[node].Joints);
+			}
+			reverse(path.begin(), path.end());
+			for (int node = fromGoal[fromGoal.size() - 1].Parent; node >= 0; node = fromGoal[node].Parent)
+			{
+				path.push_back(fromGoal[node].Joints);
+			}
+			Shortcut(path, obstacles, random);
+			return true;
+		}
+		swap(a, b);
+	}
+	return false;
+}
+
+// NULL when aborted.
+static shared_ptr<RoadmapTable> BuildTable(const vector<Capsule> &obstacles)
+{
+	shared_ptr<RoadmapTable> table(new RoadmapTable());
+	int presets = PresetCount();
+	table->Hash = ModelHash(obstacles);
+	table->Presets = presets;
+	table->Solved.assign(2 * presets, 0);
+	table->Goals.resize(2 * presets);
+	table->Offsets.assign(2 * PairCount(presets), 0);
+	table->Counts.assign(2 * PairCount(presets), 0);
+
+	for (int arm = 0; arm < 2; arm++)
+	{
+		for (size_t o = 0; o < obstacles.size(); o++)
+		{
+			table->Obstacles[arm].push_back(MirrorCapsule(obstacles[o], arm == 1));
+		}
+		for (int p = 0; p < presets; p++)
+		{
+			table->Solved[arm * presets + p] = SolvePreset(arm == 1, p, table->Obstacles[arm], table->Goals[arm * presets + p]);
+		}
+
+		for (int i = 0; i < presets; i++)
+		{
+			for (int j = i + 1; j < presets; j++)
+			{
+				if (!table->Solved[arm * presets + i] || !table->Solved[arm * presets + j])
+				{
+					continue;
+				}
+				mt19937 random(table->Hash + arm * 1000 + i * presets + j);
+				vector<JointConfig> path;
+				bool found = PlanPath(table->Goals[arm * presets + i], table->Goals[arm * presets + j],
+					table->Obstacles[arm], random, path);
+				if (ShouldAbort())
+				{
+					return shared_ptr<RoadmapTable>();
+				}
+				if (found)
+				{
+					int pair = arm * PairCount(presets) + PairIndex(presets, i, j);
+					table->Offsets[pair] = (unsigned int)table->Points.size();
+					table->Counts[pair] = (unsigned int)path.size();
+					table->Points.insert(table->Points.end(), path.begin(), path.end());
+				}
+			}
+		}
+	}
+	return table;
+}
+
+// File layout: magic, version, hash, preset count, then per arm and preset a
+// solved flag and goal joints, then per arm and pair a point count and the
+// points. Paths are stored shortcut, so most are only a few points.
+static bool SaveTable(const string &path, const RoadmapTable &table)
+{
+	ofstream file(path.c_str(), ios::binary | ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+	unsigned int header[4] = { ROADMAP_MAGIC, ROADMAP_FORMAT_VERSION, table.Hash, (unsigned int)table.Presets };
+	file.write((const char *)header, sizeof(header));
+	for (size_t i = 0; i < table.Solved.size(); i++)
+	{
+		file.write(&table.Solved[i], 1);
+		file.write((const char *)&table.Goals[i], sizeof(JointConfig));
+	}
+	for (size_t pair = 0; pair < table.Counts.size(); pair++)
+	{
+		unsigned short count = (unsigned short)table.Counts[pair];
+		file.write((const char *)&count, sizeof(count));
+		if (count > 0)
+		{
+			file.write((const char *)&table.Points[table.Offsets[pair]], count * sizeof(JointConfig));
+		}
+	}
+	return file.good();
+}
+
+// NULL when missing, unreadable or planned for a different model.
+static shared_ptr<RoadmapTable> LoadTable(const string &path, unsigned int hash, const vector<Capsule> &obstacles)
+{
+	ifstream file(path.c_str(), ios::binary);
+	unsigned int header[4];
+	if (!file || !file.read((char *)header, sizeof(header)) || header[0] != ROADMAP_MAGIC ||
+		header[1] != ROADMAP_FORMAT_VERSION || header[2] != hash || header[3] != (unsigned int)PresetCount())
+	{
+		return shared_ptr<RoadmapTable>();
+	}
+
+	shared_ptr<RoadmapTable> table(new RoadmapTable());
+	int presets = PresetCount();
+	table->Hash = hash;
+	table->Presets = presets;
+	table->Solved.resize(2 * presets);
+	table->Goals.resize(2 * presets);
+	for (int i = 0; i < 2 * presets; i++)
+	{
+		file.read(&table->Solved[i], 1);
+		file.read((char *)&table->Goals[i], sizeof(JointConfig));
+	}
+	table->Offsets.resize(2 * PairCount(presets));
+	table->Counts.resize(2 * PairCount(presets));
+	for (size_t pair = 0; pair < table->Counts.size(); pair++)
+	{
+		unsigned short count = 0;
+		file.read((char *)&count, sizeof(count));
+		table->Offsets[pair] = (unsigned int)table->Points.size();
+		table->Counts[pair] = count;
+		table->Points.resize(table->Points.size() + count);
+		if (count > 0)
+		{
+			file.read((char *)&table->Points[table->Offsets[pair]], count * sizeof(JointConfig));
+		}
+	}
+	if (!file)
+	{
+		return shared_ptr<RoadmapTable>();
+	}
+
+	for (int arm = 0; arm < 2; arm++)
+	{
+		for (size_t o = 0; o < obstacles.size(); o++)
+		{
+			table->Obstacles[arm].push_back(MirrorCapsule(obstacles[o], arm == 1));
+		}
+	}
+	return table;
+}
+
+static void PlannerLoop()
+{
+	unique_lock<mutex> lock(roadmapLock);
+	while (running)
+	{
+		if (!dirty)
+		{
+			roadmapChanged.wait(lock);
+			continue;
+		}
+		dirty = false;
+		abortPlanning = false;
+		vector<Capsule> obstacles = environment;
+		string file = cachePath;
+		planning = true;
+		lock.unlock();
+
+		shared_ptr<RoadmapTable> table = LoadTable(file, ModelHash(obstacles), obstacles);
+		bool loaded = table != NULL;
+		if (!loaded)
+		{
+			table = BuildTable(obstacles);
+		}
+
+		lock.lock();
+		planning = false;
+		if (table != NULL && !dirty && running)
+		{
+			current = table;
+			if (!loaded)
+			{
+				lock.unlock();
+				SaveTable(file, *table);
+				lock.lock();
+			}
+		}
+	}
+}
+
+void StartRoadmap(const char *cacheFile)
+{
+	lock_guard<mutex> lock(roadmapLock);
+	if (running)
+	{
+		return;
+	}
+	cachePath = cacheFile;
+	running = true;
+	dirty = true;
+	abortPlanning = false;
+	planner = thread(PlannerLoop);
+}
+
+void StopRoadmap()
+{
+	{
+		lock_guard<mutex> lock(roadmapLock);
+		if (!running)
+		{
+			return;
+		}
+		running = false;
+		abortPlanning = true;
+	}
+	roadmapChanged.notify_all();
+	planner.join();
+
+	lock_guard<mutex> lock(roadmapLock);
+	current.reset();
+}
+
+int GetRoadmapState()
+{
+	lock_guard<mutex> lock(roadmapLock);
+	if (!running)
+	{
+		return ROADMAP_STOPPED;
+	}
+	return current != NULL ? ROADMAP_READY : ROADMAP_PLANNING;
+}
+
+void SetRoadmapObstacles(const vector<Capsule> &obstacles)
+{
+	{
+		lock_guard<mutex> lock(roadmapLock);
+		environment = obstacles;
+		current.reset();
+		dirty = true;
+		abortPlanning = true;
+	}
+	roadmapChanged.notify_all();
+}
+
+vector<Capsule> GetRoadmapObstacles()
+{
+	lock_guard<mutex> lock(roadmapLock);
+	return environment;
+}
+
+// Moves the whole path by whole turns on the continuous joints so it starts next to reference.
+static void ShiftPath(vector<JointConfig> &path, const JointConfig &reference)
+{
+	JointConfig shifted = UnwrapJoints(path.front(), reference);
+	float offset[ARM_DOF];
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		offset[i] = shifted.Angles[i] - path.front().Angles[i];
+	}
+	for (size_t p = 0; p < path.size(); p++)
+	{
+		for (int i = 0; i < ARM_DOF; i++)
+		{
+			path[p].Angles[i] += offset[i];
+		}
+	}
+}
+
+bool FindRoadmapPath(bool rightArm, const JointConfig &joints, int goalPreset, vector<JointConfig> &path)
+{
+	shared_ptr<const RoadmapTable> table;
+	{
+		lock_guard<mutex> lock(roadmapLock);
+		table = current;
+	}
+	path.clear();
+	int arm = rightArm ? 1 : 0;
+	if (table == NULL || goalPreset < 0 || goalPreset >= table->Presets || !table->Solved[arm * table->Presets + goalPreset])
+	{
+		return false;
+	}
+
+	int from = -1;
+	for (int p = 0; p < table->Presets && from < 0; p++)
+	{
+		const JointConfig &goal = table->Goals[arm * table->Presets + p];
+		if (table->Solved[arm * table->Presets + p] && JointDistance(UnwrapJoints(goal, joints), joints) <= ROADMAP_PRESET_TOLERANCE)
+		{
+			from = p;
+		}
+	}
+
+	if (from >= 0 && from != goalPreset)
+	{
+		int i = min(from, goalPreset);
+		int j = max(from, goalPreset);
+		int pair = arm * PairCount(table->Presets) + PairIndex(table->Presets, i, j);
+		if (table->Counts[pair] > 0)
+		{
+			const JointConfig *points = &table->Points[table->Offsets[pair]];
+			path.assign(points, points + table->Counts[pair]);
+			if (from > goalPreset)
+			{
+				reverse(path.begin(), path.end());
+			}
+			ShiftPath(path, joints);
+			path.front() = joints;
+			return true;
+		}
+	}
+
+	// not on the roadmap, try to join it with a straight move
+	JointConfig goal = UnwrapJoints(table->Goals[arm * table->Presets + goalPreset], joints);
+	if (MotionInCollision(joints, goal, table->Obstacles[arm], ROADMAP_CHECK_RESOLUTION))
+	{
+		return false;
+	}
+	path.push_back(joints);
+	path.push_back(goal);
+	return true;
+}
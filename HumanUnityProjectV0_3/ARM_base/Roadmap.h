@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CollisionModel.h"
+#include <vector>
+
+// Collision free joint space paths between every pair of presets (see
+// Presets.h), planned with RRT-Connect on a background thread and kept in a
+// small cache file. Looking a path up is a table index; planning only happens
+// when the cache does not match the preset library and obstacles.
+
+#define ROADMAP_CACHE_FILE "ARM_base_roadmap.bin"
+
+// The arm counts as being at a preset when every joint is this close, degrees.
+#define ROADMAP_PRESET_TOLERANCE 5.0f
+
+// Collision checks along a motion every this many degrees.
+#define ROADMAP_CHECK_RESOLUTION 2.0f
+
+enum RoadmapState
+{
+	ROADMAP_STOPPED = 0,
+	ROADMAP_PLANNING = 1,
+	ROADMAP_READY = 2
+};
+
+// Loads cacheFile if it matches, otherwise plans and writes it.
+void StartRoadmap(const char *cacheFile);
+void StopRoadmap();
+int GetRoadmapState();
+
+// Replaces the obstacles (left arm frame, mirrored for the right arm) and
+// replans. Paths are unavailable until the new roadmap is ready.
+void SetRoadmapObstacles(const std::vector<Capsule> &obstacles);
+std::vector<Capsule> GetRoadmapObstacles();
+
+// Joint space path from current to the goal preset, current included. Uses the
+// cached path when the arm is at a preset, otherwise a straight joint move to
+// the goal if that is collision free. False when neither works or the roadmap
+// is not ready.
+bool FindRoadmapPath(bool rightArm, const JointConfig &current, int goalPreset, std::vector<JointConfig> &path);
@@ -0,0 +1,369 @@
+#include "SimulatedBus.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+
+// Joint model steps at most this long.
+#define SIMULATED_BUS_STEP_MICROS 1000
+
+// Rough Jaco actuator numbers: newton meters per degree/s^2 of acceleration and
+// at full speed, amperes idle and per newton meter, and winding heating.
+#define SIMULATED_INERTIA 0.002f
+#define SIMULATED_FRICTION 1.5f
+#define SIMULATED_IDLE_CURRENT 0.3f
+#define SIMULATED_CURRENT_PER_TORQUE 0.25f
+#define SIMULATED_AMBIENT 25.0f
+#define SIMULATED_HEATING 0.5f
+#define SIMULATED_COOLING 0.01f
+
+struct SimulatedActuator
+{
+	bool Started;
+	bool Feedthrough;
+	float Command;
+	float FeedthroughValue;
+	float Position;
+	float Speed;
+	float Acceleration;
+	float Torque;
+	float Current;
+	float Temperature;
+	unsigned int Fault;
+};
+
+struct PendingReply
+{
+	long long Ready;
+	RS485Frame Frame;
+};
+
+static mutex busLock;
+static bool busReady = false;
+static SimulatedBusConfig busConfig;
+static SimulatedActuator actuators[SIMULATED_BUS_MAX_ACTUATORS];
+static PendingReply pending[SIMULATED_BUS_MAX_PENDING];
+static int pendingFirst = 0;
+static int pendingCount = 0;
+static long long lastStep = 0;
+static unsigned int randomState = 1;
+static SimulatedBusStats busStats;
+
+static long long BusNow()
+{
+	return busConfig.Clock ? busConfig.Clock() : NowMicros();
+}
+
+// xorshift, so runs with the same seed match
+static float Random01()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (randomState & 0xFFFFFF) / 16777216.0f;
+}
+
+static long long WireMicros()
+{
+	if (busConfig.BitsPerSecond <= 0)
+	{
+		return 0;
+	}
+	// 10 bits per byte with start and stop bits
+	return RS485_CODEC_MESSAGE_SIZE * 10 * 1000000LL / busConfig.BitsPerSecond;
+}
+
+static void StepActuator(SimulatedActuator &actuator, float dt)
+{
+	float target = 0.0f;
+	if (actuator.Started && actuator.Fault == 0)
+	{
+		if (actuator.Feedthrough)
+		{
+			target = actuator.FeedthroughValue * busConfig.MaxSpeed;
+		}
+		else
+		{
+			target = (actuator.Command - actuator.Position) / max(busConfig.TimeConstant, 0.001f);
+			target = max(-busConfig.MaxSpeed, min(busConfig.MaxSpeed, target));
+		}
+	}
+	// the motor reaches a new speed in a quarter of the time constant
+	float blend = min(1.0f, dt / max(busConfig.TimeConstant * 0.25f, 0.0001f));
+	float speed = actuator.Speed + (target - actuator.Speed) * blend;
+	actuator.Acceleration = (speed - actuator.Speed) / dt;
+	actuator.Speed = speed;
+	actuator.Position += speed * dt;
+
+	float friction = busConfig.MaxSpeed > 0.0f ? SIMULATED_FRICTION * speed / busConfig.MaxSpeed : 0.0f;
+	actuator.Torque = SIMULATED_INERTIA * actuator.Acceleration + friction;
+	actuator.Current = SIMULATED_IDLE_CURRENT + SIMULATED_CURRENT_PER_TORQUE * fabs(actuator.Torque);
+	actuator.Temperature += (SIMULATED_HEATING * actuator.Current * actuator.Current -
+		SIMULATED_COOLING * (actuator.Temperature - SIMULATED_AMBIENT)) * dt;
+}
+
+static void Advance(long long now)
+{
+	while (lastStep < now)
+	{
+		long long step = min(now - lastStep, (long long)SIMULATED_BUS_STEP_MICROS);
+		for (int i = 0; i < busConfig.ActuatorCount; i++)
+		{
+			StepActuator(actuators[i], step / 1e6f);
+		}
+		lastStep += step;
+	}
+}
+
+static void PushReply(long long ready, const RS485Frame &frame)
+{
+	if (pendingCount == SIMULATED_BUS_MAX_PENDING)
+	{
+		pendingFirst = (pendingFirst + 1) % SIMULATED_BUS_MAX_PENDING;
+		pendingCount--;
+		busStats.Overflows++;
+	}
+	PendingReply &reply = pending[(pendingFirst + pendingCount) % SIMULATED_BUS_MAX_PENDING];
+	reply.Ready = ready;
+	reply.Frame = frame;
+	pendingCount++;
+	busStats.Replies++;
+}
+
+static void FillState(const SimulatedActuator &actuator, unsigned char address, ActuatorFeedback &state)
+{
+	memset(&state, 0, sizeof(state));
+	state.Address = address;
+	state.Current = actuator.Current;
+	state.Position = actuator.Position;
+	state.Speed = actuator.Speed;
+	state.Torque = actuator.Torque;
+	state.Pwm = busConfig.MaxSpeed > 0.0f ? actuator.Speed / busConfig.MaxSpeed : 0.0f;
+	state.EncoderPosition = actuator.Position;
+	state.Temperature = actuator.Temperature;
+	state.Fault = actuator.Fault;
+}
+
+// Builds the replies to one request into replies, returns how many.
+static int Answer(const RS485Frame &request, SimulatedActuator &actuator, RS485Frame *replies)
+{
+	unsigned char address = request.DestinationAddress;
+	for (int i = 0; i < 3; i++)
+	{
+		MakeRS485Message(replies[i], RS485_CMD_ACK, RS485_HOST_ADDRESS);
+		replies[i].SourceAddress = address;
+	}
+	replies[0].DataLong[0] = (unsigned short)request.Command;
+
+	bool setsValue = request.Command == RS485_CMD_FEEDTHROUGH || request.Command == RS485_CMD_GET_POSITION_COMMAND ||
+		request.Command == RS485_CMD_GET_POSITION_COMMAND_ALL_VALUES;
+	if (setsValue)
+	{
+		if (request.DataFloat[0] != request.DataFloat[1] || !actuator.Started || actuator.Fault != 0)
+		{
+			replies[0].Command = RS485_CMD_NACK;
+			busStats.Nacks++;
+			return 1;
+		}
+		if (request.Command == RS485_CMD_FEEDTHROUGH)
+		{
+			actuator.Feedthrough = true;
+			actuator.FeedthroughValue = max(-1.0f, min(1.0f, request.DataFloat[0]));
+		}
+		else if (busConfig.MaxStep > 0.0f && fabs(request.DataFloat[0] - actuator.Position) > busConfig.MaxStep)
+		{
+			actuator.Fault = 1;
+			busStats.Faults++;
+			replies[0].Command = RS485_CMD_REPORT_ERROR;
+			replies[0].DataLong[0] = actuator.Fault;
+			return 1;
+		}
+		else
+		{
+			actuator.Feedthrough = false;
+			actuator.Command = request.DataFloat[0];
+		}
+	}
+
+	ActuatorFeedback state;
+	FillState(actuator, address, state);
+	switch (request.Command)
+	{
+	case RS485_CMD_GET_ACTUALPOSITION:
+	case RS485_CMD_FEEDTHROUGH:
+		replies[0].Command = RS485_CMD_SEND_ACTUALPOSITION;
+		replies[0].DataFloat[0] = state.Current;
+		replies[0].DataFloat[1] = state.Position;
+		replies[0].DataFloat[2] = state.Speed;
+		replies[0].DataFloat[3] = state.Torque;
+		return 1;
+	case RS485_CMD_GET_POSITION_COMMAND:
+		replies[0].Command = RS485_CMD_SEND_POSITION_CURRENT;
+		replies[0].DataFloat[0] = state.Current;
+		replies[0].DataFloat[1] = state.Position;
+		return 1;
+	case RS485_CMD_GET_POSITION_COMMAND_ALL_VALUES:
+	{
+		replies[0].Command = RS485_CMD_SEND_ALL_VALUES_1;
+		replies[0].DataFloat[0] = state.Current;
+		replies[0].DataFloat[1] = state.Position;
+		replies[0].DataFloat[2] = state.Speed;
+		replies[0].DataFloat[3] = state.Torque;
+		float acceleration[3] = { 0.0f, 0.0f, 1.0f };
+		replies[1].Command = RS485_CMD_SEND_ALL_VALUES_2;
+		PackRS485AllValues2(replies[1], state.Pwm, state.EncoderPosition, acceleration, state.Temperature);
+		replies[2].Command = RS485_CMD_SEND_ALL_VALUES_3;
+		replies[2].DataLong[0] = actuator.Fault;
+		return 3;
+	}
+	case RS485_CMD_SET_ADDRESS:
+		return 1;
+	case RS485_CMD_START_ASSERV:
+		if (!actuator.Started)
+		{
+			actuator.Started = true;
+			actuator.Feedthrough = false;
+			actuator.Command = actuator.Position;
+		}
+		return 1;
+	case RS485_CMD_STOP_ASSERV:
+		actuator.Started = false;
+		return 1;
+	case RS485_CMD_CLEAR_FAULT_FLAG:
+		actuator.Fault = 0;
+		actuator.Started = false;
+		return 1;
+	}
+	replies[0].Command = RS485_CMD_NACK;
+	busStats.Nacks++;
+	return 1;
+}
+
+void DefaultSimulatedBusConfig(SimulatedBusConfig &config)
+{
+	memset(&config, 0, sizeof(config));
+	config.ActuatorCount = 6;
+	config.LatencyMicros = 100;
+	config.TransactionMicros = 125;
+	config.BitsPerSecond = 2000000;
+	config.Seed = 1;
+	config.MaxSpeed = 36.0f;
+	config.TimeConstant = 0.05f;
+	config.MaxStep = 10.0f;
+}
+
+void ResetSimulatedBus(const SimulatedBusConfig &config)
+{
+	lock_guard<mutex> lock(busLock);
+	busConfig = config;
+	busConfig.ActuatorCount = max(0, min(SIMULATED_BUS_MAX_ACTUATORS, config.ActuatorCount));
+	memset(actuators, 0, sizeof(actuators));
+	for (int i = 0; i < SIMULATED_BUS_MAX_ACTUATORS; i++)
+	{
+		actuators[i].Position = SIMULATED_BUS_START_POSITION;
+		actuators[i].Command = SIMULATED_BUS_START_POSITION;
+		actuators[i].Temperature = SIMULATED_AMBIENT;
+		actuators[i].Current = SIMULATED_IDLE_CURRENT;
+	}
+	pendingFirst = 0;
+	pendingCount = 0;
+	memset(&busStats, 0, sizeof(busStats));
+	randomState = config.Seed != 0 ? config.Seed : 1;
+	lastStep = BusNow();
+	busStats.BusyUntil = lastStep;
+	busReady = true;
+}
+
+int SimulatedBusWrite(const RS485Frame *frames, int count, int &sent)
+{
+	lock_guard<mutex> lock(busLock);
+	sent = 0;
+	if (!busReady)
+	{
+		return 1;
+	}
+	long long now = BusNow();
+	Advance(now);
+
+	long long wire = WireMicros();
+	long long time = max(now, busStats.BusyUntil);
+	for (int i = 0; i < count; i++)
+	{
+		if (i % RS485_CODEC_MAX_BATCH == 0)
+		{
+			time += busConfig.TransactionMicros;
+			busStats.Transactions++;
+		}
+		time += wire;
+		busStats.Requests++;
+		sent++;
+
+		int index = frames[i].DestinationAddress - RS485_FIRST_ACTUATOR_ADDRESS;
+		if (index < 0 || index >= busConfig.ActuatorCount)
+		{
+			continue;
+		}
+		if (busConfig.LossRate > 0.0f && Random01() < busConfig.LossRate)
+		{
+			busStats.Lost++;
+			continue;
+		}
+
+		RS485Frame replies[3];
+		int replyCount = Answer(frames[i], actuators[index], replies);
+		time += busConfig.LatencyMicros;
+		if (busConfig.JitterMicros > 0)
+		{
+			time += (long long)(Random01() * busConfig.JitterMicros);
+		}
+		for (int r = 0; r < replyCount; r++)
+		{
+			time += wire;
+			PushReply(time, replies[r]);
+		}
+	}
+	busStats.BusyUntil = time;
+	return 0;
+}
+
+int SimulatedBusRead(RS485Frame *frames, int wanted, int &received)
+{
+	lock_guard<mutex> lock(busLock);
+	received = 0;
+	if (!busReady)
+	{
+		return 1;
+	}
+	long long now = BusNow();
+	Advance(now);
+	while (received < wanted && pendingCount > 0 && pending[pendingFirst].Ready <= now)
+	{
+		frames[received++] = pending[pendingFirst].Frame;
+		pendingFirst = (pendingFirst + 1) % SIMULATED_BUS_MAX_PENDING;
+		pendingCount--;
+	}
+	return 0;
+}
+
+void GetSimulatedBusStats(SimulatedBusStats &stats)
+{
+	lock_guard<mutex> lock(busLock);
+	stats = busStats;
+	stats.Pending = pendingCount;
+}
+
+bool ReadSimulatedActuator(int index, ActuatorFeedback &state)
+{
+	lock_guard<mutex> lock(busLock);
+	if (!busReady || index < 0 || index >= busConfig.ActuatorCount)
+	{
+		return false;
+	}
+	Advance(BusNow());
+	FillState(actuators[index], (unsigned char)(RS485_FIRST_ACTUATOR_ADDRESS + index), state);
+	state.Timestamp = lastStep;
+	return true;
+}
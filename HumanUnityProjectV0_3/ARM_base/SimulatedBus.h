@@ -0,0 +1,80 @@
+#pragma once
+
+#include "RS485Codec.h"
+
+// A stand-in for the arm's RS-485 actuator bus, for trying joint control paths
+// offline. Actuators at RS485_FIRST_ACTUATOR_ADDRESS on answer the messages of
+// RS485Codec.h after a configurable latency, with a simple joint model behind
+// them. SimulatedBusWrite and SimulatedBusRead have the shape of
+// OpenRS485_Write and OpenRS485_Read, so they plug into RS485Ops.
+//
+// Every request goes over the bus in turn and its replies follow it, so
+// nothing overlaps: a request is answered LatencyMicros (plus up to
+// JitterMicros) after it has been sent, and the bus is busy until the last
+// reply is through. Each Write also pays TransactionMicros per batch of
+// RS485_CODEC_MAX_BATCH messages, like one USB packet to the arm.
+//
+// Replies to GET_POSITION_COMMAND_ALL_VALUES are SEND_ALL_VALUES_1 to 3, to
+// GET_POSITION_COMMAND SEND_POSITION_CURRENT, and to GET_ACTUALPOSITION and
+// FEEDTHROUGH SEND_ACTUALPOSITION. Other known commands get an ACK, unknown ones
+// a NACK. Position and feedthrough values are refused (NACK) unless both copies
+// match and the actuator's control is started. A position step bigger than
+// MaxStep faults the actuator (REPORT_ERROR, code 1) and stops it until
+// CLEAR_FAULT_FLAG.
+
+#define SIMULATED_BUS_MAX_ACTUATORS 8
+#define SIMULATED_BUS_MAX_PENDING 64
+
+// Joints start here, in degrees, like a Jaco actuator in the middle of its range.
+#define SIMULATED_BUS_START_POSITION 180.0f
+
+struct SimulatedBusConfig
+{
+	int ActuatorCount;
+	long long LatencyMicros;
+	long long JitterMicros;
+	long long TransactionMicros;
+	// bus speed for the time a message takes on the wire, 0 for none
+	int BitsPerSecond;
+	// share of requests that are never answered
+	float LossRate;
+	unsigned int Seed;
+	// degrees per second, and seconds to close a position error by 63 %
+	float MaxSpeed;
+	float TimeConstant;
+	// degrees, 0 for no limit
+	float MaxStep;
+	// time source, NowMicros when null
+	long long(*Clock)();
+};
+
+struct SimulatedBusStats
+{
+	unsigned long long Transactions;
+	unsigned long long Requests;
+	unsigned long long Replies;
+	unsigned long long Lost;
+	unsigned long long Nacks;
+	unsigned long long Faults;
+	// replies dropped because nobody read them in time
+	unsigned long long Overflows;
+	// replies waiting to be read
+	int Pending;
+	// when the last request's replies are through
+	long long BusyUntil;
+};
+
+void DefaultSimulatedBusConfig(SimulatedBusConfig &config);
+
+// Starts over with config: all actuators at SIMULATED_BUS_START_POSITION,
+// stopped, no pending replies.
+void ResetSimulatedBus(const SimulatedBusConfig &config);
+
+// Return 0, or 1 if the bus was never reset.
+int SimulatedBusWrite(const RS485Frame *frames, int count, int &sent);
+int SimulatedBusRead(RS485Frame *frames, int wanted, int &received);
+
+void GetSimulatedBusStats(SimulatedBusStats &stats);
+
+// True state of actuator index (from 0), as of now.
+bool ReadSimulatedActuator(int index, ActuatorFeedback &state);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+// Latest-value slot for one writer and any number of readers, without locks.
+// The writer bumps the sequence to odd, copies, then bumps it to even again;
+// a reader retries whenever the sequence was odd or changed under it.
+// T must be plain data (copied with memcpy).
+template <typename T>
+class Snapshot
+{
+public:
+	Snapshot() : sequence(0)
+	{
+		memset(&data, 0, sizeof(T));
+	}
+
+	void Publish(const T &value)
+	{
+		unsigned int start = sequence.load(std::memory_order_relaxed);
+		sequence.store(start + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy(&data, &value, sizeof(T));
+		sequence.store(start + 2, std::memory_order_release);
+	}
+
+	// Returns false when nothing was published yet.
+	bool Read(T &value) const
+	{
+		while (true)
+		{
+			unsigned int before = sequence.load(std::memory_order_acquire);
+			if (before == 0)
+			{
+				return false;
+			}
+			if (before & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			memcpy(&value, &data, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) == before)
+			{
+				return true;
+			}
+		}
+	}
+
+	// Number of times Publish was called.
+	unsigned int Version() const
+	{
+		return sequence.load(std::memory_order_acquire) / 2;
+	}
+
+private:
+	std::atomic<unsigned int> sequence;
+	T data;
+};
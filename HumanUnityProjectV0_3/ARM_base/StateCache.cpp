@@ -0,0 +1,41 @@
+#include "StateCache.h"
+#include "Snapshot.h"
+
+static Snapshot<ArmState> armStates[2];
+static Snapshot<ArmEffort> armEfforts[2];
+static Snapshot<ArmSensors> armSensors[2];
+
+void PublishArmState(bool rightArm, const ArmState &state)
+{
+	armStates[rightArm ? 1 : 0].Publish(state);
+}
+
+bool ReadArmState(bool rightArm, ArmState &state)
+{
+	return armStates[rightArm ? 1 : 0].Read(state);
+}
+
+void PublishArmEffort(bool rightArm, const ArmEffort &effort)
+{
+	armEfforts[rightArm ? 1 : 0].Publish(effort);
+}
+
+bool ReadArmEffort(bool rightArm, ArmEffort &effort)
+{
+	return armEfforts[rightArm ? 1 : 0].Read(effort);
+}
+
+unsigned int ArmEffortVersion(bool rightArm)
+{
+	return armEfforts[rightArm ? 1 : 0].Version();
+}
+
+void PublishArmSensors(bool rightArm, const ArmSensors &sensors)
+{
+	armSensors[rightArm ? 1 : 0].Publish(sensors);
+}
+
+bool ReadArmSensors(bool rightArm, ArmSensors &sensors)
+{
+	return armSensors[rightArm ? 1 : 0].Read(sensors);
+}
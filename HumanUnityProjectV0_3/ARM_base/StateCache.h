@@ -0,0 +1,67 @@
+#pragma once
+
+// Latest state read back from each arm. The command worker refreshes it
+// between commands (see RefreshArmStates and RefreshArmEfforts in
+// ARM_base.cpp); anybody may read it at any time without touching the Kinova
+// API.
+
+#define ARM_JOINT_COUNT 7
+#define ARM_FINGER_COUNT 3
+
+// Mirrored by KinovaAPI.ArmState on the C# side, keep them in sync.
+struct ArmState
+{
+	// NowMicros() when the values were read
+	long long Timestamp;
+	// actual end effector pose, meters and radians
+	float X;
+	float Y;
+	float Z;
+	float ThetaX;
+	float ThetaY;
+	float ThetaZ;
+	// actual actuator positions in degrees
+	float Joints[ARM_JOINT_COUNT];
+	float Fingers[ARM_FINGER_COUNT];
+};
+
+// Forces and currents, refreshed faster than ArmState so the operator side can
+// render force cues. Mirrored by KinovaAPI.ArmEffort, keep them in sync.
+struct ArmEffort
+{
+	// NowMicros() when the values were read
+	long long Timestamp;
+	// end effector force in N and torque in Nm, { X, Y, Z, ThetaX, ThetaY, ThetaZ }
+	float Force[6];
+	// actuator torques with gravity removed, Nm
+	float Torques[ARM_JOINT_COUNT];
+	// actuator and finger motor currents, A
+	float Currents[ARM_JOINT_COUNT];
+	float FingerCurrents[ARM_FINGER_COUNT];
+};
+
+// Slow changing sensors, read a few times a second. Mirrored by
+// KinovaAPI.ArmSensors.
+struct ArmSensors
+{
+	long long Timestamp;
+	// supply voltage (V) and total current (A) of the arm
+	float Voltage;
+	float Current;
+	// actuator temperatures in degrees C, 0 for actuators the arm does not have
+	float Temperatures[ARM_JOINT_COUNT];
+};
+
+void PublishArmState(bool rightArm, const ArmState &state);
+
+// Returns false when the arm was never read.
+bool ReadArmState(bool rightArm, ArmState &state);
+
+void PublishArmEffort(bool rightArm, const ArmEffort &effort);
+bool ReadArmEffort(bool rightArm, ArmEffort &effort);
+
+// Number of efforts published for the arm, to tell when a new one is in.
+unsigned int ArmEffortVersion(bool rightArm);
+
+void PublishArmSensors(bool rightArm, const ArmSensors &sensors);
+bool ReadArmSensors(bool rightArm, ArmSensors &sensors);
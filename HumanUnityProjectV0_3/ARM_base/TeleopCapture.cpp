@@ -0,0 +1,106 @@
+#include "TeleopCapture.h"
+#include <cstring>
+
+static int Padding(int size)
+{
+	return (TELEOP_CAPTURE_ALIGN - size % TELEOP_CAPTURE_ALIGN) % TELEOP_CAPTURE_ALIGN;
+}
+
+bool OpenCaptureWriter(TeleopCaptureWriter &writer, const char *file, int port, long long now)
+{
+	memset(&writer, 0, sizeof(writer));
+	writer.File = file != NULL ? fopen(file, "wb") : NULL;
+	if (writer.File == NULL)
+	{
+		return false;
+	}
+	setvbuf(writer.File, NULL, _IOFBF, TELEOP_CAPTURE_BUFFER);
+	TeleopCaptureHeader header;
+	memset(&header, 0, sizeof(header));
+	header.Magic = TELEOP_CAPTURE_MAGIC;
+	header.Version = TELEOP_CAPTURE_VERSION;
+	header.StartTime = now;
+	header.Port = port;
+	writer.Failed = fwrite(&header, sizeof(header), 1, writer.File) != 1;
+	writer.LastFlush = now;
+	return true;
+}
+
+void WriteCaptureRecord(TeleopCaptureWriter &writer, long long arrival, const UdpAddress &from,
+	const unsigned char *data, int size)
+{
+	if (writer.File == NULL || writer.Failed || size < 0 || size > TELEOP_CAPTURE_MAX_DATAGRAM)
+	{
+		return;
+	}
+	static const unsigned char zeros[TELEOP_CAPTURE_ALIGN] = { 0 };
+	TeleopCaptureRecord record;
+	record.Arrival = arrival;
+	record.FromIp = from.Ip;
+	record.FromPort = from.Port;
+	record.Size = (unsigned short)size;
+	int padding = Padding(size);
+	writer.Failed = fwrite(&record, sizeof(record), 1, writer.File) != 1 ||
+		(size > 0 && fwrite(data, size, 1, writer.File) != 1) ||
+		(padding > 0 && fwrite(zeros, padding, 1, writer.File) != 1);
+	writer.Records += writer.Failed ? 0 : 1;
+}
+
+void FlushCaptureWriter(TeleopCaptureWriter &writer, long long now)
+{
+	if (writer.File == NULL || now - writer.LastFlush < TELEOP_CAPTURE_FLUSH_MICROS)
+	{
+		return;
+	}
+	writer.LastFlush = now;
+	writer.Failed = writer.Failed || fflush(writer.File) != 0;
+}
+
+void CloseCaptureWriter(TeleopCaptureWriter &writer)
+{
+	if (writer.File != NULL)
+	{
+		fclose(writer.File);
+		writer.File = NULL;
+	}
+}
+
+bool OpenCaptureReader(TeleopCaptureReader &reader, const char *file)
+{
+	memset(&reader, 0, sizeof(reader));
+	reader.File = file != NULL ? fopen(file, "rb") : NULL;
+	if (reader.File == NULL)
+	{
+		return false;
+	}
+	setvbuf(reader.File, NULL, _IOFBF, TELEOP_CAPTURE_BUFFER);
+	if (fread(&reader.Header, sizeof(reader.Header), 1, reader.File) != 1 ||
+		reader.Header.Magic != TELEOP_CAPTURE_MAGIC || reader.Header.Version != TELEOP_CAPTURE_VERSION)
+	{
+		CloseCaptureReader(reader);
+		return false;
+	}
+	return true;
+}
+
+bool ReadCaptureRecord(TeleopCaptureReader &reader, TeleopCaptureRecord &record, unsigned char *data)
+{
+	if (reader.File == NULL || fread(&record, sizeof(record), 1, reader.File) != 1 ||
+		record.Size > TELEOP_CAPTURE_MAX_DATAGRAM)
+	{
+		return false;
+	}
+	unsigned char padding[TELEOP_CAPTURE_ALIGN];
+	int size = record.Size;
+	return (size == 0 || fread(data, size, 1, reader.File) == 1) &&
+		(Padding(size) == 0 || fread(padding, Padding(size), 1, reader.File) == 1);
+}
+
+void CloseCaptureReader(TeleopCaptureReader &reader)
+{
+	if (reader.File != NULL)
+	{
+		fclose(reader.File);
+		reader.File = NULL;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "UdpSocket.h"
+#include <cstdio>
+
+// Capture file of what reached the teleop server: every datagram as it
+// arrived, with when (NowMicros()) and from where, so a session can be played
+// back into the server later exactly as it came in.
+//
+// A header, then records back to back, each a fixed record header and the
+// datagram padded to TELEOP_CAPTURE_ALIGN bytes. Everything is little endian
+// and aligned, so a mapped capture can be walked in place as well as read
+// front to back. The file is only ever appended to and written through a
+// buffer that is flushed every TELEOP_CAPTURE_FLUSH_MICROS, so capturing costs
+// the server's thread a copy per datagram, and a crash loses at most the last
+// flush period; a record cut short at the end is ignored by the reader.
+
+#define TELEOP_CAPTURE_MAGIC 0x50414354
+#define TELEOP_CAPTURE_VERSION 1
+#define TELEOP_CAPTURE_ALIGN 8
+
+// Longest datagram a record holds, the server's receive buffer.
+#define TELEOP_CAPTURE_MAX_DATAGRAM 512
+
+#define TELEOP_CAPTURE_BUFFER 65536
+#define TELEOP_CAPTURE_FLUSH_MICROS 1000000
+
+// 32 bytes
+struct TeleopCaptureHeader
+{
+	unsigned int Magic;
+	unsigned int Version;
+	// NowMicros() when the capture started, and the port the server was on
+	long long StartTime;
+	int Port;
+	unsigned int Reserved[3];
+};
+
+// 16 bytes, the datagram follows
+struct TeleopCaptureRecord
+{
+	long long Arrival;
+	unsigned int FromIp;
+	unsigned short FromPort;
+	unsigned short Size;
+};
+
+struct TeleopCaptureWriter
+{
+	FILE *File;
+	long long LastFlush;
+	unsigned int Records;
+	// a write failed, nothing more is written
+	bool Failed;
+};
+
+struct TeleopCaptureReader
+{
+	FILE *File;
+	TeleopCaptureHeader Header;
+};
+
+// A capture file holds the records of one session, an existing one is
+// replaced. False when it cannot be created.
+bool OpenCaptureWriter(TeleopCaptureWriter &writer, const char *file, int port, long long now);
+void WriteCaptureRecord(TeleopCaptureWriter &writer, long long arrival, const UdpAddress &from,
+	const unsigned char *data, int size);
+// Writes the buffer out once TELEOP_CAPTURE_FLUSH_MICROS have passed.
+void FlushCaptureWriter(TeleopCaptureWriter &writer, long long now);
+void CloseCaptureWriter(TeleopCaptureWriter &writer);
+
+// False when the file is missing or no capture of this version.
+bool OpenCaptureReader(TeleopCaptureReader &reader, const char *file);
+// The next record and its datagram (data holds TELEOP_CAPTURE_MAX_DATAGRAM
+// bytes). False at the end.
+bool ReadCaptureRecord(TeleopCaptureReader &reader, TeleopCaptureRecord &record, unsigned char *data);
+void CloseCaptureReader(TeleopCaptureReader &reader);
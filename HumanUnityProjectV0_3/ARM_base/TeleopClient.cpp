@@ -0,0 +1,467 @@
+#include "TeleopClient.h"
+#include "Timing.h"
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+
+// Weight of the newest acknowledgement time in the moving average.
+#define ACK_TIME_SMOOTHING 0.05
+// and of the newest frame's size
+#define FRAME_SIZE_SMOOTHING 0.05
+
+struct PendingMessage
+{
+	bool Valid;
+	TeleopMessage Message;
+	long long FirstSent;
+	long long LastSent;
+	int Attempts;
+};
+
+static mutex clientLock;
+static UdpHandle clientSocket = UDP_NO_SOCKET;
+static UdpAddress serverAddress;
+static unsigned int sequence = 0;
+static unsigned int reliableId = 0;
+static PendingMessage pending[TELEOP_MAX_PENDING];
+static PoseEncoder encoder;
+// redundancy settings, and the frames and reliable payloads they repeat
+static int redundancy = 0;
+static int parityGroup = 0;
+static int sentFrames = 0;
+static long long sentFrameTimes[TELEOP_MAX_REDUNDANCY];
+static int sentFrameSizes[TELEOP_MAX_REDUNDANCY];
+static unsigned char sentFrameBodies[TELEOP_MAX_REDUNDANCY][POSE_CODEC_MAX_SIZE];
+static unsigned char reliablePayloads[TELEOP_MAX_PARITY_GROUP][TELEOP_PARITY_SIZE];
+// the server's clock: t1 of the probe waiting for an answer (0 for none), the
+// last answered exchange and when to probe next
+static ClockSync robotClock;
+static long long probeTime = 0;
+static long long lastExchange[4];
+static long long nextProbe = 0;
+// the leases asked for, and when to ask next (0 for never)
+static int leaseArms = 0;
+static int leasePriority = 0;
+static int leaseMicros = 0;
+static long long nextLease = 0;
+static TeleopClientStats stats;
+
+// Lock must be held.
+static bool Send(TeleopMessage &message, long long now)
+{
+	message.Sequence = ++sequence;
+	message.Timestamp = now;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(message, buffer, sizeof(buffer));
+	if (size < 0 || SendUdp(clientSocket, serverAddress, buffer, size) != size)
+	{
+		return false;
+	}
+	stats.Datagrams++;
+	return true;
+}
+
+// Lock must be held.
+static void TakeAck(unsigned int id, long long now)
+{
+	for (int i = 0; i < TELEOP_MAX_PENDING; i++)
+	{
+		PendingMessage &message = pending[i];
+		if (message.Valid && message.Message.ReliableId == id)
+		{
+			long long ackTime = now - message.FirstSent;
+			stats.Acked++;
+			stats.LastAckTime = ackTime;
+			stats.MeanAckTime = stats.MeanAckTime == 0.0 ? (double)ackTime :
+				stats.MeanAckTime + ACK_TIME_SMOOTHING * (ackTime - stats.MeanAckTime);
+			if (ackTime > stats.MaxAckTime)
+			{
+				stats.MaxAckTime = ackTime;
+			}
+			message.Valid = false;
+			return;
+		}
+	}
+}
+
+// Lock must be held.
+static void TakeSyncReply(const TeleopMessage &message, long long arrival)
+{
+	// an answer to a probe given up on already
+	if (probeTime == 0 || message.SyncTimes[0] != probeTime)
+	{
+		return;
+	}
+	long long exchange[4] = { probeTime, message.SyncTimes[1], message.Timestamp, arrival };
+	AddClockSample(robotClock, arrival, ExchangeOffset(exchange[0], exchange[1], exchange[2], exchange[3]),
+		ExchangeDelay(exchange[0], exchange[1], exchange[2], exchange[3]));
+	memcpy(lastExchange, exchange, sizeof(lastExchange));
+	probeTime = 0;
+	stats.SyncReplies++;
+	stats.ClockSynced = robotClock.Valid ? 1 : 0;
+	stats.ClockOffset = robotClock.Offset;
+	stats.ClockDriftPpm = robotClock.Drift * 1e6;
+	stats.ClockDelay = robotClock.Delay;
+}
+
+// Lock must be held.
+static void Take(const unsigned char *data, int size, const UdpAddress &from, long long arrival)
+{
+	TeleopMessage message;
+	if (!SameUdpAddress(from, serverAddress) || DecodeTeleopMessage(data, size, message) != 0)
+	{
+		return;
+	}
+	if (message.Type == TELEOP_ACK)
+	{
+		TakeAck(message.ReliableId, arrival);
+	}
+	else if (message.Type == TELEOP_FRAME_ACK)
+	{
+		AcknowledgePoseFrame(encoder, message.FrameId);
+	}
+	else if (message.Type == TELEOP_SYNC_REPLY)
+	{
+		TakeSyncReply(message, arrival);
+	}
+	else if (message.Type == TELEOP_LEASE_REPLY)
+	{
+		stats.LeaseHeld = message.LeaseArms;
+		stats.LeaseOthers = message.LeaseOthers;
+		// a release is repeated until the server has it
+		if (leaseArms == 0 && message.LeaseArms == 0)
+		{
+			nextLease = 0;
+		}
+	}
+}
+
+// Asks for the leases again when it is time to. Lock must be held.
+static void RenewLease(long long now)
+{
+	if (nextLease == 0 || now < nextLease)
+	{
+		return;
+	}
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_LEASE;
+	message.LeaseArms = leaseArms;
+	message.LeasePriority = leasePriority;
+	message.LeaseMicros = (unsigned int)leaseMicros;
+	Send(message, now);
+	nextLease = now + (leaseArms != 0 ? leaseMicros / TELEOP_LEASE_RENEWALS : TELEOP_RETRANSMIT_MICROS);
+}
+
+// Probes the server's clock when it is time to. An answer is only as exact as
+// it is read soon after it arrives, and there is no thread reading them, so
+// this waits a moment for it. Lock must be held.
+static void Probe()
+{
+	long long now = NowMicros();
+	if (now < nextProbe)
+	{
+		return;
+	}
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_SYNC;
+	memcpy(message.SyncTimes, lastExchange, sizeof(lastExchange));
+	nextProbe = now + (stats.SyncReplies < TELEOP_SYNC_FAST_PROBES ? TELEOP_SYNC_FAST_PERIOD_MICROS :
+		TELEOP_SYNC_PERIOD_MICROS);
+	if (!Send(message, now))
+	{
+		return;
+	}
+	probeTime = now;
+	// the server learns from each exchange once
+	memset(lastExchange, 0, sizeof(lastExchange));
+	stats.SyncProbes++;
+
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	UdpAddress from;
+	long long left;
+	while (probeTime != 0 && (left = now + TELEOP_SYNC_WAIT_MICROS - NowMicros()) > 0)
+	{
+		int size = ReceiveUdp(clientSocket, buffer, sizeof(buffer), from, (int)((left + 999) / 1000));
+		if (size <= 0)
+		{
+			break;
+		}
+		Take(buffer, size, from, NowMicros());
+	}
+}
+
+// Lock must be held.
+static int Poll()
+{
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	UdpAddress from;
+	int size;
+	while ((size = ReceiveUdp(clientSocket, buffer, sizeof(buffer), from, 0)) > 0)
+	{
+		Take(buffer, size, from, NowMicros());
+	}
+	Probe();
+
+	long long now = NowMicros();
+	RenewLease(now);
+	int count = 0;
+	for (int i = 0; i < TELEOP_MAX_PENDING; i++)
+	{
+		PendingMessage &message = pending[i];
+		if (!message.Valid || now - message.LastSent < TELEOP_RETRANSMIT_MICROS)
+		{
+			count += message.Valid ? 1 : 0;
+			continue;
+		}
+		if (message.Attempts >= TELEOP_MAX_ATTEMPTS)
+		{
+			message.Valid = false;
+			stats.GaveUp++;
+			continue;
+		}
+		Send(message.Message, now);
+		message.LastSent = now;
+		message.Attempts++;
+		stats.Retransmits++;
+		count++;
+	}
+	stats.Pending = count;
+	return count;
+}
+
+int OpenTeleopClient(const char *host, int port)
+{
+	lock_guard<mutex> lock(clientLock);
+	UdpAddress address;
+	if (!ResolveUdpAddress(host, port, address))
+	{
+		return -1;
+	}
+	CloseUdpSocket(clientSocket);
+	clientSocket = OpenUdpSocket(0);
+	if (clientSocket == UDP_NO_SOCKET)
+	{
+		return -2;
+	}
+	serverAddress = address;
+	memset(pending, 0, sizeof(pending));
+	ResetPoseEncoder(encoder);
+	sentFrames = 0;
+	ResetClockSync(robotClock);
+	probeTime = 0;
+	memset(lastExchange, 0, sizeof(lastExchange));
+	nextProbe = 0;
+	nextLease = leaseArms != 0 ? 1 : 0;
+	stats = TeleopClientStats();
+	stats.Connected = 1;
+	stats.Redundancy = redundancy;
+	stats.ParityGroup = parityGroup;
+	stats.LeaseWanted = leaseArms;
+	return 0;
+}
+
+void CloseTeleopClient()
+{
+	lock_guard<mutex> lock(clientLock);
+	CloseUdpSocket(clientSocket);
+	clientSocket = UDP_NO_SOCKET;
+	stats.Connected = 0;
+}
+
+int SendTeleopPose(bool rightArm, int flags, const float *pose)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (clientSocket == UDP_NO_SOCKET || pose == NULL)
+	{
+		return -1;
+	}
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_POSE;
+	message.RightArm = rightArm;
+	message.Flags = flags;
+	memcpy(message.Pose, pose, sizeof(message.Pose));
+	bool sent = Send(message, NowMicros());
+	stats.Poses += sent ? 1 : 0;
+	Poll();
+	return sent ? 0 : -1;
+}
+
+int SendTeleopFrame(const PoseFrame &frame)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (clientSocket == UDP_NO_SOCKET)
+	{
+		return -1;
+	}
+	// acknowledgements first, for the newest baseline
+	Poll();
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = redundancy > 0 ? TELEOP_FRAMES : TELEOP_FRAME;
+	bool keyframe;
+	message.FrameSize = EncodePoseFrame(encoder, frame, message.Frame, sizeof(message.Frame), keyframe);
+	long long now = NowMicros();
+	message.Redundant = redundancy < sentFrames ? redundancy : sentFrames;
+	int overhead = redundancy > 0 ? 2 : 0;
+	for (int i = 0; i < message.Redundant; i++)
+	{
+		message.RedundantAges[i] = now - sentFrameTimes[i];
+		message.RedundantSizes[i] = sentFrameSizes[i];
+		memcpy(message.RedundantFrames[i], sentFrameBodies[i], sentFrameSizes[i]);
+		overhead += 3 + sentFrameSizes[i];
+	}
+
+	// remembered newest first whether or not it goes out, a failed send is lost
+	memmove(sentFrameTimes + 1, sentFrameTimes, (TELEOP_MAX_REDUNDANCY - 1) * sizeof(sentFrameTimes[0]));
+	memmove(sentFrameSizes + 1, sentFrameSizes, (TELEOP_MAX_REDUNDANCY - 1) * sizeof(sentFrameSizes[0]));
+	memmove(sentFrameBodies + 1, sentFrameBodies, (TELEOP_MAX_REDUNDANCY - 1) * sizeof(sentFrameBodies[0]));
+	sentFrameTimes[0] = now;
+	sentFrameSizes[0] = message.FrameSize;
+	memcpy(sentFrameBodies[0], message.Frame, message.FrameSize);
+	sentFrames += sentFrames < TELEOP_MAX_REDUNDANCY ? 1 : 0;
+
+	if (!Send(message, now))
+	{
+		return -1;
+	}
+	stats.Frames++;
+	stats.Keyframes += keyframe ? 1 : 0;
+	stats.RedundantFrames += message.Redundant;
+	stats.OverheadBytes += overhead;
+	int size = TELEOP_HEADER_SIZE + message.FrameSize + overhead;
+	stats.MeanFrameSize = stats.MeanFrameSize == 0.0 ? (double)size :
+		stats.MeanFrameSize + FRAME_SIZE_SMOOTHING * (size - stats.MeanFrameSize);
+	return 0;
+}
+
+// Parity of the newest parityGroup reliable messages. Lock must be held.
+static void SendParity(long long now)
+{
+	// IDs start over at 1, a group never reaches across
+	int count = (unsigned int)parityGroup < reliableId ? parityGroup : (int)reliableId;
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_PARITY;
+	message.ReliableId = reliableId - count + 1;
+	message.ParityCount = count;
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned char *payload = reliablePayloads[(message.ReliableId + i) % TELEOP_MAX_PARITY_GROUP];
+		for (int j = 0; j < TELEOP_PARITY_SIZE; j++)
+		{
+			message.Parity[j] ^= payload[j];
+		}
+	}
+	if (Send(message, now))
+	{
+		stats.ParitySent++;
+		stats.OverheadBytes += TELEOP_HEADER_SIZE + 5 + TELEOP_PARITY_SIZE;
+	}
+}
+
+int SendTeleopReliable(int type, bool rightArm, int fingers)
+{
+	lock_guard<mutex> lock(clientLock);
+	if (clientSocket == UDP_NO_SOCKET)
+	{
+		return -1;
+	}
+	if (!TeleopReliable(type))
+	{
+		return -3;
+	}
+	Poll();
+	PendingMessage *slot = NULL;
+	for (int i = 0; i < TELEOP_MAX_PENDING && slot == NULL; i++)
+	{
+		slot = pending[i].Valid ? NULL : &pending[i];
+	}
+	if (slot == NULL)
+	{
+		return -2;
+	}
+
+	memset(slot, 0, sizeof(*slot));
+	slot->Message.Type = type;
+	slot->Message.RightArm = rightArm;
+	slot->Message.Fingers = fingers;
+	// IDs stay positive for the C# side
+	reliableId = reliableId == 0x7fffffff ? 1 : reliableId + 1;
+	slot->Message.ReliableId = reliableId;
+	long long now = NowMicros();
+	// a failed send is repeated like a lost one
+	Send(slot->Message, now);
+	slot->Valid = true;
+	slot->FirstSent = now;
+	slot->LastSent = now;
+	slot->Attempts = 1;
+	stats.Reliable++;
+	stats.Pending++;
+	PackTeleopParity(slot->Message, reliablePayloads[reliableId % TELEOP_MAX_PARITY_GROUP]);
+	if (parityGroup > 0)
+	{
+		SendParity(now);
+	}
+	return (int)reliableId;
+}
+
+int SetTeleopRedundancy(int frames, int group)
+{
+	if (frames < 0 || frames > TELEOP_MAX_REDUNDANCY || group < 0 || group > TELEOP_MAX_PARITY_GROUP)
+	{
+		return -1;
+	}
+	lock_guard<mutex> lock(clientLock);
+	redundancy = frames;
+	parityGroup = group;
+	stats.Redundancy = frames;
+	stats.ParityGroup = group;
+	return 0;
+}
+
+int SetTeleopLease(int arms, int priority, int durationMicros)
+{
+	if ((arms & ~(TELEOP_ARM_LEFT | TELEOP_ARM_RIGHT)) != 0 || priority < 0 || priority > ARM_LEASE_MAX_PRIORITY ||
+		(arms != 0 && (durationMicros <= 0 || durationMicros > ARM_LEASE_MAX_MICROS)))
+	{
+		return -1;
+	}
+	lock_guard<mutex> lock(clientLock);
+	leaseArms = arms;
+	leasePriority = priority;
+	leaseMicros = durationMicros;
+	stats.LeaseWanted = arms;
+	// right away, the next send or poll takes it
+	nextLease = 1;
+	if (clientSocket != UDP_NO_SOCKET)
+	{
+		RenewLease(NowMicros());
+	}
+	return 0;
+}
+
+int PollTeleopClient()
+{
+	lock_guard<mutex> lock(clientLock);
+	if (clientSocket == UDP_NO_SOCKET)
+	{
+		return -1;
+	}
+	return Poll();
+}
+
+long long TeleopRobotTime()
+{
+	lock_guard<mutex> lock(clientLock);
+	return robotClock.Valid ? ToPeerTime(robotClock, NowMicros()) : 0;
+}
+
+void ReadTeleopClientStats(TeleopClientStats &result)
+{
+	lock_guard<mutex> lock(clientLock);
+	result = stats;
+}
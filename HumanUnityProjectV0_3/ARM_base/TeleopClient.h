@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ArmLease.h"
+#include "ClockSync.h"
+#include "TeleopProtocol.h"
+#include "UdpSocket.h"
+
+// Operator side of the link (see TeleopProtocol.h). Poses go out once. Stop,
+// home and fingers are kept until the server acknowledges them and sent again
+// every TELEOP_RETRANSMIT_MICROS, up to TELEOP_MAX_ATTEMPTS times. There is no
+// thread: acknowledgements are taken and messages repeated by PollTeleopClient
+// and by every send, so call it once a frame at least. Frames are coded against
+// the newest one the server acknowledged (PoseCodec.h). For lossy links each
+// frame can carry repeats of the ones before, and each reliable message can
+// be followed by a parity message the server rebuilds a lost one from (see
+// TeleopProtocol.h); both are off until SetTeleopRedundancy. The server's
+// clock is probed every TELEOP_SYNC_PERIOD_MICROS, faster at first. Arms
+// leased with SetTeleopLease are renewed four times a lease, and kept across
+// reconnects.
+
+#define TELEOP_MAX_PENDING 32
+#define TELEOP_RETRANSMIT_MICROS 20000
+#define TELEOP_MAX_ATTEMPTS 25
+
+#define TELEOP_SYNC_PERIOD_MICROS 250000
+#define TELEOP_SYNC_FAST_PERIOD_MICROS 20000
+#define TELEOP_SYNC_FAST_PROBES 8
+// How long a poll waits for the answer to a probe; it returns as soon as the
+// answer is in. Round trips longer than this are read a poll later and come
+// out less exact.
+#define TELEOP_SYNC_WAIT_MICROS 5000
+
+// Leases are renewed this many times before they would run out.
+#define TELEOP_LEASE_RENEWALS 4
+
+// Mirrored by KinovaAPI.TeleopClientStats, keep them in sync.
+struct TeleopClientStats
+{
+	int Connected;
+	// SetTeleopRedundancy
+	int Redundancy;
+	int ParityGroup;
+	unsigned int Datagrams;
+	unsigned int Poses;
+	unsigned int Frames;
+	// frames sent without a baseline
+	unsigned int Keyframes;
+	// datagram bytes, header included
+	double MeanFrameSize;
+	// frame repeats and parity messages sent, and the bytes they cost
+	unsigned int RedundantFrames;
+	unsigned int ParitySent;
+	long long OverheadBytes;
+	unsigned int Reliable;
+	unsigned int Retransmits;
+	unsigned int Acked;
+	// reliable messages given up on after TELEOP_MAX_ATTEMPTS
+	unsigned int GaveUp;
+	int Pending;
+	// first send to acknowledgement of reliable messages, microseconds
+	long long LastAckTime;
+	double MeanAckTime;
+	long long MaxAckTime;
+	// the server's clock (see ClockSync.h): offset is server minus operator,
+	// delay the best round trip, twice the worst error of the offset
+	unsigned int SyncProbes;
+	unsigned int SyncReplies;
+	int ClockSynced;
+	long long ClockOffset;
+	double ClockDriftPpm;
+	long long ClockDelay;
+	// TELEOP_ARM_* bits: leases asked for, and from the server's last answer
+	// those held and those someone else holds
+	int LeaseWanted;
+	int LeaseHeld;
+	int LeaseOthers;
+};
+
+// returns:
+// 0 - ready to send
+// -1 - the host does not resolve
+// -2 - the socket could not be opened
+int OpenTeleopClient(const char *host, int port);
+void CloseTeleopClient();
+
+// Returns 0, or -1 when not open or the send failed.
+int SendTeleopPose(bool rightArm, int flags, const float *pose);
+
+// Both hands and fingers at once, whichever frame.Contents names. Returns 0,
+// or -1 when not open or the send failed.
+int SendTeleopFrame(const PoseFrame &frame);
+
+// TELEOP_STOP, TELEOP_HOME or TELEOP_FINGERS (with TELEOP_FINGER_* bits).
+// Returns the reliable ID, -1 when not open, -2 when TELEOP_MAX_PENDING are
+// waiting for acknowledgement already, -3 for another type.
+int SendTeleopReliable(int type, bool rightArm, int fingers);
+
+// frames: older frames repeated in each frame datagram, up to
+// TELEOP_MAX_REDUNDANCY. group: reliable messages covered by the parity sent
+// after each one, up to TELEOP_MAX_PARITY_GROUP. 0 turns either off. May be
+// changed at any time. Returns 0, or -1 when out of range.
+int SetTeleopRedundancy(int frames, int group);
+
+// Leases the arms (TELEOP_ARM_* bits) for durationMicros at priority (see
+// ArmLease.h) and keeps renewing them; arms 0 releases them. Whether the
+// server granted them shows in the stats a round trip later. Returns 0, or -1
+// when out of range.
+int SetTeleopLease(int arms, int priority, int durationMicros);
+
+// Returns how many reliable messages still wait for acknowledgement, -1 when
+// not open.
+int PollTeleopClient();
+
+// NowMicros() of the server's machine, the shared timebase of both ends; 0
+// until the clocks are synchronized.
+long long TeleopRobotTime();
+
+void ReadTeleopClientStats(TeleopClientStats &stats);
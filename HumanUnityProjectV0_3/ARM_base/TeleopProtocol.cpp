@@ -0,0 +1,349 @@
+#include "TeleopProtocol.h"
+#include <cstring>
+
+static void WriteU16(unsigned char *out, unsigned int value)
+{
+	out[0] = (unsigned char)(value & 0xFF);
+	out[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static void WriteU32(unsigned char *out, unsigned int value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		out[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+	}
+}
+
+static void WriteI64(unsigned char *out, long long value)
+{
+	unsigned long long bits = (unsigned long long)value;
+	for (int i = 0; i < 8; i++)
+	{
+		out[i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+	}
+}
+
+static void WriteF32(unsigned char *out, float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	WriteU32(out, bits);
+}
+
+static unsigned int ReadU16(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8);
+}
+
+static unsigned int ReadU32(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+static long long ReadI64(const unsigned char *in)
+{
+	unsigned long long bits = 0;
+	for (int i = 7; i >= 0; i--)
+	{
+		bits = (bits << 8) | in[i];
+	}
+	return (long long)bits;
+}
+
+static float ReadF32(const unsigned char *in)
+{
+	unsigned int bits = ReadU32(in);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Size of the body after the header, -1 for an unknown type. Frames are
+// only known from the message, see FramesSize.
+static int BodySize(int type)
+{
+	switch (type)
+	{
+	case TELEOP_POSE:
+		return 2 + 6 * 4;
+	case TELEOP_STOP:
+	case TELEOP_HOME:
+		return 5;
+	case TELEOP_FINGERS:
+		return 6;
+	case TELEOP_ACK:
+		return 4;
+	case TELEOP_FRAME_ACK:
+		return 2;
+	case TELEOP_PARITY:
+		return 5 + TELEOP_PARITY_SIZE;
+	case TELEOP_SYNC:
+		return 4 * 8;
+	case TELEOP_SYNC_REPLY:
+		return 2 * 8;
+	case TELEOP_LEASE:
+		return 6;
+	case TELEOP_LEASE_REPLY:
+		return 2;
+	}
+	return -1;
+}
+
+static bool FrameSizeValid(int size)
+{
+	return size >= 0 && size <= POSE_CODEC_MAX_SIZE;
+}
+
+// Body size of TELEOP_FRAME(S), -1 when a frame or the count is out of range.
+static int FramesSize(const TeleopMessage &message)
+{
+	if (!FrameSizeValid(message.FrameSize))
+	{
+		return -1;
+	}
+	if (message.Type == TELEOP_FRAME)
+	{
+		return message.FrameSize;
+	}
+	if (message.Redundant < 0 || message.Redundant > TELEOP_MAX_REDUNDANCY)
+	{
+		return -1;
+	}
+	int size = 2 + message.FrameSize;
+	for (int i = 0; i < message.Redundant; i++)
+	{
+		if (!FrameSizeValid(message.RedundantSizes[i]))
+		{
+			return -1;
+		}
+		size += 3 + message.RedundantSizes[i];
+	}
+	return size;
+}
+
+bool TeleopReliable(int type)
+{
+	return type == TELEOP_STOP || type == TELEOP_HOME || type == TELEOP_FINGERS;
+}
+
+int EncodeTeleopMessage(const TeleopMessage &message, unsigned char *buffer, int capacity)
+{
+	bool frames = message.Type == TELEOP_FRAME || message.Type == TELEOP_FRAMES;
+	int body = frames ? FramesSize(message) : BodySize(message.Type);
+	if (body < 0 && !frames)
+	{
+		return TELEOP_ERROR_TYPE;
+	}
+	if (body < 0 || capacity < TELEOP_HEADER_SIZE + body)
+	{
+		return TELEOP_ERROR_SIZE;
+	}
+	WriteU16(buffer, TELEOP_MAGIC);
+	buffer[2] = TELEOP_VERSION;
+	buffer[3] = (unsigned char)message.Type;
+	WriteU32(buffer + 4, message.Sequence);
+	WriteI64(buffer + 8, message.Timestamp);
+
+	unsigned char *out = buffer + TELEOP_HEADER_SIZE;
+	switch (message.Type)
+	{
+	case TELEOP_POSE:
+		out[0] = message.RightArm ? 1 : 0;
+		out[1] = (unsigned char)message.Flags;
+		for (int i = 0; i < 6; i++)
+		{
+			WriteF32(out + 2 + 4 * i, message.Pose[i]);
+		}
+		break;
+	case TELEOP_STOP:
+	case TELEOP_HOME:
+	case TELEOP_FINGERS:
+		WriteU32(out, message.ReliableId);
+		out[4] = message.RightArm ? 1 : 0;
+		if (message.Type == TELEOP_FINGERS)
+		{
+			out[5] = (unsigned char)(message.Fingers & TELEOP_FINGERS_ALL);
+		}
+		break;
+	case TELEOP_ACK:
+		WriteU32(out, message.ReliableId);
+		break;
+	case TELEOP_FRAME:
+		memcpy(out, message.Frame, body);
+		break;
+	case TELEOP_FRAME_ACK:
+		WriteU16(out, message.FrameId);
+		break;
+	case TELEOP_FRAMES:
+		out[0] = (unsigned char)message.Redundant;
+		out[1] = (unsigned char)message.FrameSize;
+		memcpy(out + 2, message.Frame, message.FrameSize);
+		out += 2 + message.FrameSize;
+		for (int i = 0; i < message.Redundant; i++)
+		{
+			// ages past the u16 are all just old
+			long long age = message.RedundantAges[i] / 10;
+			WriteU16(out, age < 0 ? 0 : age > 0xFFFF ? 0xFFFF : (unsigned int)age);
+			out[2] = (unsigned char)message.RedundantSizes[i];
+			memcpy(out + 3, message.RedundantFrames[i], message.RedundantSizes[i]);
+			out += 3 + message.RedundantSizes[i];
+		}
+		break;
+	case TELEOP_PARITY:
+		WriteU32(out, message.ReliableId);
+		out[4] = (unsigned char)message.ParityCount;
+		memcpy(out + 5, message.Parity, TELEOP_PARITY_SIZE);
+		break;
+	case TELEOP_SYNC:
+	case TELEOP_SYNC_REPLY:
+		for (int i = 0; i < body / 8; i++)
+		{
+			WriteI64(out + 8 * i, message.SyncTimes[i]);
+		}
+		break;
+	case TELEOP_LEASE:
+		out[0] = (unsigned char)message.LeaseArms;
+		out[1] = (unsigned char)message.LeasePriority;
+		WriteU32(out + 2, message.LeaseMicros);
+		break;
+	case TELEOP_LEASE_REPLY:
+		out[0] = (unsigned char)message.LeaseArms;
+		out[1] = (unsigned char)message.LeaseOthers;
+		break;
+	}
+	return TELEOP_HEADER_SIZE + body;
+}
+
+// Reads the TELEOP_FRAMES body, false when it does not fit in size.
+static bool DecodeFrames(const unsigned char *in, int size, TeleopMessage &message)
+{
+	if (size < 2 || in[0] > TELEOP_MAX_REDUNDANCY || !FrameSizeValid(in[1]) || size < 2 + in[1])
+	{
+		return false;
+	}
+	message.Redundant = in[0];
+	message.FrameSize = in[1];
+	memcpy(message.Frame, in + 2, message.FrameSize);
+	int offset = 2 + message.FrameSize;
+	for (int i = 0; i < message.Redundant; i++)
+	{
+		if (size < offset + 3 || !FrameSizeValid(in[offset + 2]) || size < offset + 3 + in[offset + 2])
+		{
+			return false;
+		}
+		message.RedundantAges[i] = 10LL * ReadU16(in + offset);
+		message.RedundantSizes[i] = in[offset + 2];
+		memcpy(message.RedundantFrames[i], in + offset + 3, message.RedundantSizes[i]);
+		offset += 3 + message.RedundantSizes[i];
+	}
+	return true;
+}
+
+int DecodeTeleopMessage(const unsigned char *data, int size, TeleopMessage &message)
+{
+	if (data == NULL || size < TELEOP_HEADER_SIZE)
+	{
+		return TELEOP_ERROR_SIZE;
+	}
+	if (ReadU16(data) != TELEOP_MAGIC || data[2] != TELEOP_VERSION)
+	{
+		return TELEOP_ERROR_HEADER;
+	}
+	// frames are the rest of the datagram
+	bool frames = data[3] == TELEOP_FRAME || data[3] == TELEOP_FRAMES;
+	int body = frames ? size - TELEOP_HEADER_SIZE : BodySize(data[3]);
+	if (body < 0)
+	{
+		return TELEOP_ERROR_TYPE;
+	}
+	if (size < TELEOP_HEADER_SIZE + body || (data[3] == TELEOP_FRAME && !FrameSizeValid(body)))
+	{
+		return TELEOP_ERROR_SIZE;
+	}
+
+	memset(&message, 0, sizeof(message));
+	message.Type = data[3];
+	message.Sequence = ReadU32(data + 4);
+	message.Timestamp = ReadI64(data + 8);
+	const unsigned char *in = data + TELEOP_HEADER_SIZE;
+	switch (message.Type)
+	{
+	case TELEOP_POSE:
+		message.RightArm = in[0] != 0;
+		message.Flags = in[1];
+		for (int i = 0; i < 6; i++)
+		{
+			message.Pose[i] = ReadF32(in + 2 + 4 * i);
+		}
+		break;
+	case TELEOP_STOP:
+	case TELEOP_HOME:
+	case TELEOP_FINGERS:
+		message.ReliableId = ReadU32(in);
+		message.RightArm = in[4] != 0;
+		if (message.Type == TELEOP_FINGERS)
+		{
+			message.Fingers = in[5] & TELEOP_FINGERS_ALL;
+		}
+		break;
+	case TELEOP_ACK:
+		message.ReliableId = ReadU32(in);
+		break;
+	case TELEOP_FRAME:
+		memcpy(message.Frame, in, body);
+		message.FrameSize = body;
+		break;
+	case TELEOP_FRAME_ACK:
+		message.FrameId = ReadU16(in);
+		break;
+	case TELEOP_FRAMES:
+		if (!DecodeFrames(in, body, message))
+		{
+			return TELEOP_ERROR_SIZE;
+		}
+		break;
+	case TELEOP_PARITY:
+		message.ReliableId = ReadU32(in);
+		message.ParityCount = in[4];
+		if (message.ParityCount < 1 || message.ParityCount > TELEOP_MAX_PARITY_GROUP)
+		{
+			return TELEOP_ERROR_SIZE;
+		}
+		memcpy(message.Parity, in + 5, TELEOP_PARITY_SIZE);
+		break;
+	case TELEOP_SYNC:
+	case TELEOP_SYNC_REPLY:
+		for (int i = 0; i < body / 8; i++)
+		{
+			message.SyncTimes[i] = ReadI64(in + 8 * i);
+		}
+		break;
+	case TELEOP_LEASE:
+		message.LeaseArms = in[0] & (TELEOP_ARM_LEFT | TELEOP_ARM_RIGHT);
+		message.LeasePriority = in[1];
+		message.LeaseMicros = ReadU32(in + 2);
+		break;
+	case TELEOP_LEASE_REPLY:
+		message.LeaseArms = in[0] & (TELEOP_ARM_LEFT | TELEOP_ARM_RIGHT);
+		message.LeaseOthers = in[1] & (TELEOP_ARM_LEFT | TELEOP_ARM_RIGHT);
+		break;
+	}
+	return 0;
+}
+
+void PackTeleopParity(const TeleopMessage &message, unsigned char *payload)
+{
+	payload[0] = (unsigned char)message.Type;
+	payload[1] = message.RightArm ? 1 : 0;
+	payload[2] = (unsigned char)(message.Fingers & TELEOP_FINGERS_ALL);
+}
+
+void UnpackTeleopParity(const unsigned char *payload, unsigned int reliableId, TeleopMessage &message)
+{
+	memset(&message, 0, sizeof(message));
+	message.Type = payload[0];
+	message.RightArm = payload[1] != 0;
+	message.Fingers = payload[2] & TELEOP_FINGERS_ALL;
+	message.ReliableId = reliableId;
+}
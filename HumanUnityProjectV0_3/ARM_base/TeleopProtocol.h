@@ -0,0 +1,162 @@
+#pragma once
+
+// Binary protocol of the operator link, one message per UDP datagram. Every
+// datagram starts with a 16 byte little endian header:
+//
+//   Magic      u16  0x5054 ("TP")
+//   Version    u8
+//   Type       u8   TeleopMessageType
+//   Sequence   u32  per sender, +1 for every datagram sent
+//   Timestamp  i64  sender's NowMicros() when it was sent
+//
+// Poses are unreliable and the newest one wins: a pose that arrives after a
+// newer one of the same arm is dropped, and a lost one is never sent again.
+// Stop, home and fingers are reliable: they carry an ID of their own, the
+// receiver acknowledges every copy it gets and acts on each ID once, and the
+// sender repeats them until acknowledged. Frames carry both hands and their
+// fingers at once, compactly coded against a frame the receiver acknowledged
+// before (PoseCodec.h); they are unreliable like poses, and the receiver
+// acknowledges each one it could decode so the sender has a newer baseline.
+//
+// On a lossy link the sender may repeat its last few frames in every
+// datagram (TELEOP_FRAMES), so a burst of lost datagrams costs no frames, and
+// follow every reliable message with a parity message, the XOR of the last few
+// reliable messages, from which the receiver rebuilds one it missed without
+// waiting for the repeat.
+//
+// The client also probes the server's clock now and then (TELEOP_SYNC, see
+// ClockSync.h). Both ends estimate the other's clock from the exchanges, so
+// the server can tell when an operator's message was sent on its own clock.
+//
+// Several operators may share the robot through leases on the arms
+// (ArmLease.h). An operator asks for the arms it wants to command with
+// TELEOP_LEASE and repeats the request to renew the lease; the server answers
+// every request with the arms the operator holds now and those others hold.
+//
+// Plain C++ without sockets, see TeleopServer.h and TeleopClient.h for the
+// two ends.
+
+#include "PoseCodec.h"
+
+#define TELEOP_MAGIC 0x5054
+#define TELEOP_VERSION 1
+#define TELEOP_HEADER_SIZE 16
+#define TELEOP_MAX_DATAGRAM 512
+
+#define TELEOP_DEFAULT_PORT 11112
+
+// Older frames a TELEOP_FRAMES datagram carries at most, and reliable messages
+// a parity message covers at most.
+#define TELEOP_MAX_REDUNDANCY 8
+#define TELEOP_MAX_PARITY_GROUP 8
+
+// Part of a reliable message a parity message covers: u8 type, u8 arm, u8
+// fingers. The IDs follow from the first ID.
+#define TELEOP_PARITY_SIZE 3
+
+enum TeleopMessageType
+{
+	// u8 arm, u8 flags, f32 x, y, z (meters), thetaX, thetaY, thetaZ (radians)
+	TELEOP_POSE = 1,
+	// u32 reliable ID, u8 arm
+	TELEOP_STOP = 2,
+	TELEOP_HOME = 3,
+	// u32 reliable ID, u8 arm, u8 fingers (TELEOP_FINGER_* bits)
+	TELEOP_FINGERS = 4,
+	// u32 reliable ID being acknowledged
+	TELEOP_ACK = 5,
+	// PoseCodec.h frame body, up to POSE_CODEC_MAX_SIZE bytes
+	TELEOP_FRAME = 6,
+	// u16 frame ID being acknowledged
+	TELEOP_FRAME_ACK = 7,
+	// u8 older frames, u8 size, newest frame body, then per older frame (newest
+	// first) u16 age before the header's timestamp (10 microsecond units), u8
+	// size, body
+	TELEOP_FRAMES = 8,
+	// u32 first reliable ID, u8 count, XOR of the TELEOP_PARITY_SIZE payloads
+	// of the count reliable messages from the first ID on
+	TELEOP_PARITY = 9,
+	// i64 t1, t2, t3, t4 of the sender's previous completed exchange (all 0
+	// before the first); the header's timestamp is this probe's t1
+	TELEOP_SYNC = 10,
+	// i64 t1 of the probe answered, i64 t2 when it arrived; the header's
+	// timestamp is t3
+	TELEOP_SYNC_REPLY = 11,
+	// u8 arms wanted (TELEOP_ARM_* bits, none releases them), u8 priority, u32
+	// lease duration in microseconds
+	TELEOP_LEASE = 12,
+	// u8 arms the receiver holds, u8 arms held by someone else
+	TELEOP_LEASE_REPLY = 13,
+};
+
+// Arms in a lease
+#define TELEOP_ARM_LEFT 1
+#define TELEOP_ARM_RIGHT 2
+
+// Pose flags
+#define TELEOP_POSE_NO_THETA_Y 1
+
+// Fingers, as in MoveFingers
+#define TELEOP_FINGER_PINKY 1
+#define TELEOP_FINGER_RING 2
+#define TELEOP_FINGER_MIDDLE 4
+#define TELEOP_FINGER_INDEX 8
+#define TELEOP_FINGER_THUMB 16
+#define TELEOP_FINGERS_ALL 31
+
+// Decoding errors, negative like the encoders' sizes are positive.
+#define TELEOP_ERROR_SIZE -1
+#define TELEOP_ERROR_HEADER -2
+#define TELEOP_ERROR_TYPE -3
+
+struct TeleopMessage
+{
+	int Type;
+	unsigned int Sequence;
+	long long Timestamp;
+	bool RightArm;
+	int Flags;
+	// x, y, z, thetaX, thetaY, thetaZ
+	float Pose[6];
+	int Fingers;
+	// reliable messages and their ACK
+	unsigned int ReliableId;
+	// TELEOP_FRAME(S) newest body, FrameId only for TELEOP_FRAME_ACK
+	unsigned char Frame[POSE_CODEC_MAX_SIZE];
+	int FrameSize;
+	unsigned int FrameId;
+	// TELEOP_FRAMES older bodies, newest first, ages in microseconds
+	int Redundant;
+	unsigned char RedundantFrames[TELEOP_MAX_REDUNDANCY][POSE_CODEC_MAX_SIZE];
+	int RedundantSizes[TELEOP_MAX_REDUNDANCY];
+	long long RedundantAges[TELEOP_MAX_REDUNDANCY];
+	// TELEOP_PARITY, from ReliableId on
+	int ParityCount;
+	unsigned char Parity[TELEOP_PARITY_SIZE];
+	// TELEOP_SYNC(_REPLY), NowMicros() of either end
+	long long SyncTimes[4];
+	// TELEOP_LEASE(_REPLY): TELEOP_ARM_* bits
+	int LeaseArms;
+	int LeaseOthers;
+	int LeasePriority;
+	unsigned int LeaseMicros;
+};
+
+bool TeleopReliable(int type);
+
+// Returns the datagram size, or TELEOP_ERROR_SIZE when capacity is too small
+// (or FrameSize out of range), TELEOP_ERROR_TYPE for an unknown type.
+int EncodeTeleopMessage(const TeleopMessage &message, unsigned char *buffer, int capacity);
+
+// Returns 0 or a TELEOP_ERROR_*. Bytes after the message are ignored.
+int DecodeTeleopMessage(const unsigned char *data, int size, TeleopMessage &message);
+
+// A reliable message's part of the parity, and the message back from it.
+void PackTeleopParity(const TeleopMessage &message, unsigned char *payload);
+void UnpackTeleopParity(const unsigned char *payload, unsigned int reliableId, TeleopMessage &message);
+
+// Sequence a is newer than b, across wrap-around.
+inline bool TeleopNewer(unsigned int a, unsigned int b)
+{
+	return (int)(a - b) > 0;
+}
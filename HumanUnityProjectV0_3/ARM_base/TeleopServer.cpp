@@ -0,0 +1,785 @@
+#include "TeleopServer.h"
+#include "TeleopCapture.h"
+#include "Timing.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+struct TeleopPeer
+{
+	bool Active;
+	UdpAddress Address;
+	long long LastHeard;
+	unsigned int Sequence;
+	// sequence of the newest pose taken from this peer, per arm
+	bool HasPose[2];
+	unsigned int PoseSequence[2];
+	// newest reliable ID seen, and bit i set when ID - 1 - i was seen too
+	bool HasReliable;
+	unsigned int Reliable;
+	unsigned long long ReliableSeen;
+	// baselines of the frames from this peer
+	PoseDecoder Frames;
+	// parity payloads of the reliable messages taken, by ID
+	unsigned int PayloadIds[TELEOP_RELIABLE_WINDOW];
+	unsigned char Payloads[TELEOP_RELIABLE_WINDOW][TELEOP_PARITY_SIZE];
+	// the peer's clock, from its probes
+	ClockSync Clock;
+};
+
+struct WaitingPose
+{
+	bool Valid;
+	// lease holder of the peer it came from
+	int Holder;
+	long long Timestamp;
+	int Flags;
+	float Pose[6];
+};
+
+static mutex statsLock;
+static TeleopServerStats stats;
+static thread server;
+static atomic<bool> running(false);
+static UdpHandle serverSocket = UDP_NO_SOCKET;
+static TeleopSink serverSink;
+// owned by the server thread
+static TeleopPeer peers[TELEOP_MAX_PEERS];
+static WaitingPose waiting[2];
+// fingers last passed on from frames, -1 for none yet, and the Euler angles of
+// the last frame pose to keep the next ones continuous
+static int frameFingers[2];
+static float frameAngles[2][3];
+// a replay runs on the server's thread instead of the socket; the server's
+// clock then runs clockShift ahead of NowMicros() and nothing is sent
+static bool replaying = false;
+static bool replayTiming;
+static TeleopCaptureReader replayReader;
+static long long clockShift = 0;
+// how far the replay's clock runs ahead of the one the capture was taken on,
+// 0 while serving the socket
+static long long replayOffset = 0;
+// written by the server's thread, opened and closed by anyone
+static mutex captureLock;
+static TeleopCaptureWriter capture;
+
+static void Count(unsigned int TeleopServerStats::*counter)
+{
+	lock_guard<mutex> lock(statsLock);
+	stats.*counter += 1;
+}
+
+static void CountRedundantBytes(int bytes)
+{
+	lock_guard<mutex> lock(statsLock);
+	stats.RedundantBytes += bytes;
+}
+
+// NowMicros() while serving the socket, the capture's time while replaying.
+static long long ServerNow()
+{
+	return NowMicros() + clockShift;
+}
+
+static bool SendToPeer(const TeleopPeer &peer, const unsigned char *data, int size)
+{
+	return replaying || SendUdp(serverSocket, peer.Address, data, size) == size;
+}
+
+static int PeerHolder(const TeleopPeer &peer)
+{
+	return TELEOP_LEASE_HOLDER_BASE + (int)(&peer - peers);
+}
+
+static TeleopPeer *FindPeer(const UdpAddress &address, long long now)
+{
+	TeleopPeer *free = NULL;
+	for (int i = 0; i < TELEOP_MAX_PEERS; i++)
+	{
+		TeleopPeer &peer = peers[i];
+		if (peer.Active && now - peer.LastHeard > TELEOP_PEER_TIMEOUT_MICROS)
+		{
+			// the next peer in the slot must not inherit the arms
+			peer.Active = false;
+			ReleaseArmLeases(PeerHolder(peer));
+		}
+		if (peer.Active && SameUdpAddress(peer.Address, address))
+		{
+			return &peer;
+		}
+		if (!peer.Active && free == NULL)
+		{
+			free = &peer;
+		}
+	}
+	if (free != NULL)
+	{
+		memset(free, 0, sizeof(*free));
+		free->Active = true;
+		free->Address = address;
+	}
+	return free;
+}
+
+static int ActivePeers()
+{
+	int count = 0;
+	for (int i = 0; i < TELEOP_MAX_PEERS; i++)
+	{
+		count += peers[i].Active ? 1 : 0;
+	}
+	return count;
+}
+
+// True the first time an ID is seen.
+static bool FirstReliable(TeleopPeer &peer, unsigned int id)
+{
+	if (!peer.HasReliable || TeleopNewer(id, peer.Reliable))
+	{
+		unsigned int shift = peer.HasReliable ? id - peer.Reliable : TELEOP_RELIABLE_WINDOW;
+		peer.ReliableSeen = shift >= TELEOP_RELIABLE_WINDOW ? 0 : (peer.ReliableSeen << shift);
+		if (peer.HasReliable && shift <= TELEOP_RELIABLE_WINDOW)
+		{
+			peer.ReliableSeen |= 1ULL << (shift - 1);
+		}
+		peer.Reliable = id;
+		peer.HasReliable = true;
+		return true;
+	}
+	unsigned int age = peer.Reliable - id;
+	if (age == 0 || age > TELEOP_RELIABLE_WINDOW)
+	{
+		// too old to tell, a retransmit from long ago is safer ignored
+		return false;
+	}
+	unsigned long long bit = 1ULL << (age - 1);
+	bool first = (peer.ReliableSeen & bit) == 0;
+	peer.ReliableSeen |= bit;
+	return first;
+}
+
+// FirstReliable without taking the ID; IDs too old to tell count as seen.
+static bool ReliableSeen(const TeleopPeer &peer, unsigned int id)
+{
+	if (!peer.HasReliable || TeleopNewer(id, peer.Reliable))
+	{
+		return false;
+	}
+	unsigned int age = peer.Reliable - id;
+	return age == 0 || age > TELEOP_RELIABLE_WINDOW || (peer.ReliableSeen & (1ULL << (age - 1))) != 0;
+}
+
+static void Acknowledge(const TeleopPeer &peer, unsigned int id, unsigned int &sequence)
+{
+	TeleopMessage ack;
+	memset(&ack, 0, sizeof(ack));
+	ack.Type = TELEOP_ACK;
+	ack.Sequence = ++sequence;
+	ack.Timestamp = ServerNow();
+	ack.ReliableId = id;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(ack, buffer, sizeof(buffer));
+	if (SendToPeer(peer, buffer, size))
+	{
+		Count(&TeleopServerStats::AcksSent);
+	}
+}
+
+static bool FinitePose(const float *pose)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (!std::isfinite(pose[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The peer may command the arm, counted when it may not.
+static bool Commands(const TeleopPeer &peer, int arm)
+{
+	if (ArmLeaseAllows(arm == 1, PeerHolder(peer), ServerNow()))
+	{
+		return true;
+	}
+	Count(&TeleopServerStats::CommandsRefused);
+	return false;
+}
+
+static void TakePose(TeleopPeer &peer, int arm, unsigned int sequence, long long timestamp, int flags,
+	const float *pose)
+{
+	Count(&TeleopServerStats::Poses);
+	if (!Commands(peer, arm))
+	{
+		return;
+	}
+	if (peer.HasPose[arm] && !TeleopNewer(sequence, peer.PoseSequence[arm]))
+	{
+		Count(&TeleopServerStats::PosesStale);
+		return;
+	}
+	peer.HasPose[arm] = true;
+	peer.PoseSequence[arm] = sequence;
+	if (waiting[arm].Valid)
+	{
+		Count(&TeleopServerStats::PosesSuperseded);
+	}
+	waiting[arm].Valid = true;
+	waiting[arm].Holder = PeerHolder(peer);
+	waiting[arm].Timestamp = timestamp;
+	waiting[arm].Flags = flags;
+	memcpy(waiting[arm].Pose, pose, sizeof(waiting[arm].Pose));
+}
+
+static void AcknowledgeFrame(const TeleopPeer &peer, unsigned int frameId, unsigned int &sequence)
+{
+	TeleopMessage ack;
+	memset(&ack, 0, sizeof(ack));
+	ack.Type = TELEOP_FRAME_ACK;
+	ack.Sequence = ++sequence;
+	ack.Timestamp = ServerNow();
+	ack.FrameId = frameId;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(ack, buffer, sizeof(buffer));
+	SendToPeer(peer, buffer, size);
+}
+
+// When the operator sent a message, on this machine's clock once the clocks
+// are synchronized, until then when it arrived.
+static long long SentTime(const TeleopPeer &peer, long long sent, long long arrival)
+{
+	if (!peer.Clock.Valid)
+	{
+		return arrival;
+	}
+	long long local = FromPeerTime(peer.Clock, sent);
+	return local < arrival ? local : arrival;
+}
+
+// Decodes and acknowledges one frame body, false when it cannot be decoded.
+static bool DecodeFrame(TeleopPeer &peer, const unsigned char *data, int size, PoseFrame &frame,
+	unsigned int &sequence)
+{
+	unsigned int frameId;
+	int result = DecodePoseFrame(peer.Frames, data, size, frame, frameId);
+	if (result != 0)
+	{
+		Count(result == POSE_CODEC_ERROR_BASELINE ? &TeleopServerStats::FramesUndecodable :
+			&TeleopServerStats::Malformed);
+		return false;
+	}
+	// even a stale frame is a baseline the sender may use
+	AcknowledgeFrame(peer, frameId, sequence);
+	return true;
+}
+
+// Kinova pose of a frame's hand, continuous with the previous one.
+static void FramePose(int arm, const Pose &hand, float *pose)
+{
+	float *angles = frameAngles[arm];
+	ToKinovaEulerNear(hand.Orientation, angles[0], angles[1], angles[2], angles[0], angles[1], angles[2]);
+	pose[0] = hand.Position.X;
+	pose[1] = hand.Position.Y;
+	pose[2] = hand.Position.Z;
+	memcpy(pose + 3, angles, 3 * sizeof(float));
+}
+
+// Repeats of older frames in a TELEOP_FRAMES, oldest first. Those lost
+// before go to the sink as recovered samples, stamped with when they were
+// sent as far as the arrival time and their age tell.
+static void TakeRedundantFrames(TeleopPeer &peer, const TeleopMessage &message, long long now,
+	unsigned int &sequence)
+{
+	for (int i = message.Redundant - 1; i >= 0; i--)
+	{
+		CountRedundantBytes(3 + message.RedundantSizes[i]);
+		PoseFrame frame;
+		if (PoseFrameDecoded(peer.Frames, message.RedundantFrames[i], message.RedundantSizes[i]) ||
+			!DecodeFrame(peer, message.RedundantFrames[i], message.RedundantSizes[i], frame, sequence))
+		{
+			continue;
+		}
+		Count(&TeleopServerStats::FramesRecovered);
+		for (int arm = 0; arm < 2; arm++)
+		{
+			if ((frame.Contents & (POSE_FRAME_LEFT << arm)) && serverSink.Recovered != NULL)
+			{
+				float pose[6];
+				FramePose(arm, frame.Hands[arm], pose);
+				long long age = message.RedundantAges[i];
+				serverSink.Recovered(arm == 1, SentTime(peer, message.Timestamp - age, now - age), frame.Flags[arm], pose);
+			}
+		}
+	}
+}
+
+static void TakeFrame(TeleopPeer &peer, const TeleopMessage &message, long long now, unsigned int &sequence)
+{
+	Count(&TeleopServerStats::Frames);
+	// repeats in a late datagram are older than what came already
+	if (message.Type == TELEOP_FRAMES && message.Sequence == peer.Sequence)
+	{
+		TakeRedundantFrames(peer, message, now, sequence);
+	}
+	PoseFrame frame;
+	if (!DecodeFrame(peer, message.Frame, message.FrameSize, frame, sequence))
+	{
+		return;
+	}
+
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if (frame.Contents & (POSE_FRAME_LEFT << arm))
+		{
+			float pose[6];
+			FramePose(arm, frame.Hands[arm], pose);
+			TakePose(peer, arm, message.Sequence, SentTime(peer, message.Timestamp, now), frame.Flags[arm], pose);
+		}
+	}
+	// fingers are the state of the hand in every frame, passed on when they
+	// change; an older frame than the newest datagram has nothing to say
+	if (message.Sequence != peer.Sequence)
+	{
+		return;
+	}
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if ((frame.Contents & (POSE_FRAME_LEFT_FINGERS << arm)) && frame.Fingers[arm] != frameFingers[arm] &&
+			Commands(peer, arm))
+		{
+			frameFingers[arm] = frame.Fingers[arm];
+			serverSink.Fingers(arm == 1, frame.Fingers[arm]);
+		}
+	}
+}
+
+static void TakeReliable(TeleopPeer &peer, const TeleopMessage &message, unsigned int &sequence)
+{
+	Acknowledge(peer, message.ReliableId, sequence);
+	if (!FirstReliable(peer, message.ReliableId))
+	{
+		Count(&TeleopServerStats::Duplicates);
+		return;
+	}
+	Count(&TeleopServerStats::Reliable);
+	int slot = message.ReliableId % TELEOP_RELIABLE_WINDOW;
+	peer.PayloadIds[slot] = message.ReliableId;
+	PackTeleopParity(message, peer.Payloads[slot]);
+	if (message.Type != TELEOP_STOP && !Commands(peer, message.RightArm ? 1 : 0))
+	{
+		return;
+	}
+	switch (message.Type)
+	{
+	case TELEOP_STOP:
+		// a pose still waiting would start the arm again
+		waiting[message.RightArm ? 1 : 0].Valid = false;
+		serverSink.Stop(message.RightArm);
+		break;
+	case TELEOP_HOME:
+		waiting[message.RightArm ? 1 : 0].Valid = false;
+		serverSink.Home(message.RightArm);
+		break;
+	case TELEOP_FINGERS:
+		serverSink.Fingers(message.RightArm, message.Fingers);
+		break;
+	}
+}
+
+// Rebuilds the one reliable message of the group that never came, when the
+// others did and are still remembered.
+static void TakeParity(TeleopPeer &peer, const TeleopMessage &message, unsigned int &sequence)
+{
+	CountRedundantBytes(TELEOP_HEADER_SIZE + 5 + TELEOP_PARITY_SIZE);
+	unsigned char payload[TELEOP_PARITY_SIZE];
+	memcpy(payload, message.Parity, sizeof(payload));
+	unsigned int missing = 0;
+	int missingCount = 0;
+	for (int i = 0; i < message.ParityCount; i++)
+	{
+		unsigned int id = message.ReliableId + i;
+		if (!ReliableSeen(peer, id))
+		{
+			missing = id;
+			missingCount++;
+			continue;
+		}
+		int slot = id % TELEOP_RELIABLE_WINDOW;
+		if (peer.PayloadIds[slot] != id)
+		{
+			return;
+		}
+		for (int j = 0; j < TELEOP_PARITY_SIZE; j++)
+		{
+			payload[j] ^= peer.Payloads[slot][j];
+		}
+	}
+	if (missingCount != 1)
+	{
+		return;
+	}
+	TeleopMessage recovered;
+	UnpackTeleopParity(payload, missing, recovered);
+	if (!TeleopReliable(recovered.Type))
+	{
+		Count(&TeleopServerStats::Malformed);
+		return;
+	}
+	Count(&TeleopServerStats::ReliableRecovered);
+	TakeReliable(peer, recovered, sequence);
+}
+
+// Answers a clock probe, and learns the peer's clock from the exchange before
+// it, which the probe reports.
+static void TakeSync(TeleopPeer &peer, const TeleopMessage &message, long long arrival, unsigned int &sequence)
+{
+	TeleopMessage reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.Type = TELEOP_SYNC_REPLY;
+	reply.Sequence = ++sequence;
+	reply.SyncTimes[0] = message.Timestamp;
+	reply.SyncTimes[1] = arrival;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	reply.Timestamp = ServerNow();
+	int size = EncodeTeleopMessage(reply, buffer, sizeof(buffer));
+	SendToPeer(peer, buffer, size);
+
+	const long long *t = message.SyncTimes;
+	if (t[0] == 0 || t[3] == 0)
+	{
+		return;
+	}
+	// a replayed exchange was stamped by the server the capture was taken on
+	long long received = t[1] + replayOffset;
+	long long answered = t[2] + replayOffset;
+	// the peer started it, so its offset is the other way around
+	AddClockSample(peer.Clock, answered, -ExchangeOffset(t[0], received, answered, t[3]),
+		ExchangeDelay(t[0], received, answered, t[3]));
+	lock_guard<mutex> lock(statsLock);
+	stats.SyncProbes++;
+	stats.ClockSynced = peer.Clock.Valid ? 1 : 0;
+	stats.ClockOffset = peer.Clock.Offset;
+	stats.ClockDriftPpm = peer.Clock.Drift * 1e6;
+	stats.ClockDelay = peer.Clock.Delay;
+}
+
+// Takes, renews or releases the peer's leases and tells it where it stands.
+static void TakeLease(TeleopPeer &peer, const TeleopMessage &message, long long now, unsigned int &sequence)
+{
+	Count(&TeleopServerStats::LeaseRequests);
+	int holder = PeerHolder(peer);
+	long long duration = message.LeaseMicros < ARM_LEASE_MAX_MICROS ? message.LeaseMicros : ARM_LEASE_MAX_MICROS;
+	TeleopMessage reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.Type = TELEOP_LEASE_REPLY;
+	for (int arm = 0; arm < 2; arm++)
+	{
+		int bit = arm == 0 ? TELEOP_ARM_LEFT : TELEOP_ARM_RIGHT;
+		if (message.LeaseArms & bit)
+		{
+			AcquireArmLease(arm == 1, holder, message.LeasePriority, duration, now);
+		}
+		else
+		{
+			ReleaseArmLease(arm == 1, holder);
+		}
+		ArmLeaseInfo lease;
+		ReadArmLease(arm == 1, now, lease);
+		reply.LeaseArms |= lease.Holder == holder ? bit : 0;
+		reply.LeaseOthers |= lease.Holder != holder && lease.Holder != 0 ? bit : 0;
+	}
+	reply.Sequence = ++sequence;
+	reply.Timestamp = ServerNow();
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(reply, buffer, sizeof(buffer));
+	SendToPeer(peer, buffer, size);
+}
+
+static void TakeDatagram(const unsigned char *data, int size, const UdpAddress &from, long long now,
+	unsigned int &sequence)
+{
+	Count(&TeleopServerStats::Datagrams);
+	TeleopMessage message;
+	if (DecodeTeleopMessage(data, size, message) != 0 ||
+		(message.Type == TELEOP_POSE && !FinitePose(message.Pose)))
+	{
+		Count(&TeleopServerStats::Malformed);
+		return;
+	}
+	TeleopPeer *peer = FindPeer(from, now);
+	if (peer == NULL)
+	{
+		Count(&TeleopServerStats::PeersRefused);
+		return;
+	}
+	if (peer->LastHeard != 0 && TeleopNewer(message.Sequence, peer->Sequence + 1))
+	{
+		lock_guard<mutex> lock(statsLock);
+		stats.Lost += message.Sequence - peer->Sequence - 1;
+	}
+	if (peer->LastHeard == 0 || TeleopNewer(message.Sequence, peer->Sequence))
+	{
+		peer->Sequence = message.Sequence;
+	}
+	peer->LastHeard = now;
+
+	if (message.Type == TELEOP_POSE)
+	{
+		TakePose(*peer, message.RightArm ? 1 : 0, message.Sequence, SentTime(*peer, message.Timestamp, now),
+			message.Flags, message.Pose);
+	}
+	else if (message.Type == TELEOP_FRAME || message.Type == TELEOP_FRAMES)
+	{
+		TakeFrame(*peer, message, now, sequence);
+	}
+	else if (message.Type == TELEOP_PARITY)
+	{
+		TakeParity(*peer, message, sequence);
+	}
+	else if (message.Type == TELEOP_SYNC)
+	{
+		TakeSync(*peer, message, now, sequence);
+	}
+	else if (message.Type == TELEOP_LEASE)
+	{
+		TakeLease(*peer, message, now, sequence);
+	}
+	else if (TeleopReliable(message.Type))
+	{
+		TakeReliable(*peer, message, sequence);
+	}
+}
+
+static void CaptureDatagram(const unsigned char *data, int size, const UdpAddress &from, long long arrival)
+{
+	lock_guard<mutex> lock(captureLock);
+	if (capture.File != NULL)
+	{
+		WriteCaptureRecord(capture, arrival, from, data, size);
+	}
+}
+
+static void FlushCapture()
+{
+	lock_guard<mutex> lock(captureLock);
+	FlushCaptureWriter(capture, ServerNow());
+	lock_guard<mutex> statsGuard(statsLock);
+	stats.Captured = capture.Records;
+}
+
+static void OfferWaitingPoses()
+{
+	long long now = ServerNow();
+	for (int arm = 0; arm < 2; arm++)
+	{
+		// the arm went to another operator while the pose waited
+		if (waiting[arm].Valid && !ArmLeaseAllows(arm == 1, waiting[arm].Holder, now))
+		{
+			waiting[arm].Valid = false;
+			Count(&TeleopServerStats::CommandsRefused);
+		}
+		if (waiting[arm].Valid && serverSink.Pose(arm == 1, waiting[arm].Timestamp, waiting[arm].Flags,
+			waiting[arm].Pose))
+		{
+			waiting[arm].Valid = false;
+			Count(&TeleopServerStats::PosesApplied);
+		}
+	}
+}
+
+static void ServerLoop()
+{
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	unsigned int sequence = 0;
+	while (running)
+	{
+		UdpAddress from;
+		int size = ReceiveUdp(serverSocket, buffer, sizeof(buffer), from, TELEOP_SERVER_POLL_MS);
+		// take everything that is in before the arms get the newest poses
+		while (size > 0)
+		{
+			long long now = ServerNow();
+			CaptureDatagram(buffer, size, from, now);
+			TakeDatagram(buffer, size, from, now, sequence);
+			size = ReceiveUdp(serverSocket, buffer, sizeof(buffer), from, 0);
+		}
+		OfferWaitingPoses();
+		FlushCapture();
+
+		lock_guard<mutex> lock(statsLock);
+		stats.Peers = ActivePeers();
+	}
+}
+
+// The datagrams of a capture as they came in, each at its time on the
+// server's clock, which starts at NowMicros(). With replayTiming they are
+// also taken when they came in, waiting poses being offered in between as
+// the socket loop would; otherwise one after the other at once.
+static void ReplayLoop()
+{
+	unsigned char data[TELEOP_CAPTURE_MAX_DATAGRAM];
+	TeleopCaptureRecord record;
+	unsigned int sequence = 0;
+	long long start = NowMicros();
+	long long first = 0;
+	while (running && ReadCaptureRecord(replayReader, record, data))
+	{
+		first = first == 0 ? record.Arrival : first;
+		long long due = start + (record.Arrival - first);
+		long long left;
+		while (replayTiming && running && (left = due - NowMicros()) > 0)
+		{
+			this_thread::sleep_for(chrono::microseconds(left < TELEOP_SERVER_POLL_MS * 1000 ? left :
+				TELEOP_SERVER_POLL_MS * 1000));
+			OfferWaitingPoses();
+		}
+		clockShift = due - NowMicros();
+		replayOffset = due - record.Arrival;
+		UdpAddress from = { record.FromIp, record.FromPort };
+		TakeDatagram(data, record.Size, from, ServerNow(), sequence);
+		OfferWaitingPoses();
+
+		lock_guard<mutex> lock(statsLock);
+		stats.Peers = ActivePeers();
+		stats.ReplayMicros = NowMicros() - start;
+	}
+	CloseCaptureReader(replayReader);
+	lock_guard<mutex> lock(statsLock);
+	stats.Replaying = 0;
+}
+
+static void ResetServer(const TeleopSink &sink)
+{
+	serverSink = sink;
+	memset(peers, 0, sizeof(peers));
+	memset(waiting, 0, sizeof(waiting));
+	memset(frameAngles, 0, sizeof(frameAngles));
+	frameFingers[0] = -1;
+	frameFingers[1] = -1;
+	clockShift = 0;
+	replayOffset = 0;
+	lock_guard<mutex> lock(statsLock);
+	bool capturing = stats.Capturing != 0;
+	unsigned int captured = stats.Captured;
+	stats = TeleopServerStats();
+	stats.Running = 1;
+	stats.Capturing = capturing ? 1 : 0;
+	stats.Captured = captured;
+}
+
+int OpenTeleopServer(int port, const TeleopSink &sink)
+{
+	if (running)
+	{
+		return -1;
+	}
+	serverSocket = OpenUdpSocket(port);
+	if (serverSocket == UDP_NO_SOCKET)
+	{
+		return -2;
+	}
+	replaying = false;
+	ResetServer(sink);
+	{
+		lock_guard<mutex> lock(statsLock);
+		stats.Port = UdpLocalPort(serverSocket);
+	}
+	running = true;
+	server = thread(ServerLoop);
+	return 0;
+}
+
+int OpenTeleopReplay(const char *file, bool originalTiming, const TeleopSink &sink)
+{
+	if (running)
+	{
+		return -1;
+	}
+	if (!OpenCaptureReader(replayReader, file))
+	{
+		return -2;
+	}
+	replaying = true;
+	replayTiming = originalTiming;
+	ResetServer(sink);
+	{
+		lock_guard<mutex> lock(statsLock);
+		stats.Port = replayReader.Header.Port;
+		stats.Replaying = 1;
+	}
+	running = true;
+	server = thread(ReplayLoop);
+	return 0;
+}
+
+void CloseTeleopServer()
+{
+	if (!running)
+	{
+		return;
+	}
+	running = false;
+	server.join();
+	if (!replaying)
+	{
+		CloseUdpSocket(serverSocket);
+		serverSocket = UDP_NO_SOCKET;
+	}
+	for (int i = 0; i < TELEOP_MAX_PEERS; i++)
+	{
+		ReleaseArmLeases(PeerHolder(peers[i]));
+	}
+	lock_guard<mutex> lock(statsLock);
+	stats.Running = 0;
+	stats.Peers = 0;
+	stats.Replaying = 0;
+}
+
+bool TeleopServerRunning()
+{
+	return running;
+}
+
+void ReadTeleopServerStats(TeleopServerStats &result)
+{
+	lock_guard<mutex> lock(statsLock);
+	result = stats;
+}
+
+int OpenTeleopCapture(const char *file)
+{
+	lock_guard<mutex> lock(captureLock);
+	if (capture.File != NULL)
+	{
+		return -1;
+	}
+	int port;
+	{
+		lock_guard<mutex> statsGuard(statsLock);
+		port = stats.Running != 0 ? stats.Port : 0;
+	}
+	if (!OpenCaptureWriter(capture, file, port, NowMicros()))
+	{
+		return -2;
+	}
+	lock_guard<mutex> statsGuard(statsLock);
+	stats.Capturing = 1;
+	stats.Captured = 0;
+	return 0;
+}
+
+void CloseTeleopCapture()
+{
+	lock_guard<mutex> lock(captureLock);
+	CloseCaptureWriter(capture);
+	lock_guard<mutex> statsGuard(statsLock);
+	stats.Capturing = 0;
+	stats.Captured = capture.Records;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "ArmLease.h"
+#include "ClockSync.h"
+#include "TeleopProtocol.h"
+#include "UdpSocket.h"
+
+// Robot side of the operator link: a thread of its own receives the operators'
+// datagrams (TeleopProtocol.h) and hands them to the bridge through a sink.
+// Only the newest pose of each arm is kept. When the arm is still busy with
+// the previous one, the pose waits and is offered again a couple of
+// milliseconds later, unless an even newer one has replaced it by then, so a
+// slow arm never works through a backlog of stale poses. Reliable messages
+// are acknowledged to their sender and passed on once. Frames are decoded
+// against the sender's baselines and acknowledged, their poses then go the
+// way of single poses and their fingers to the sink when they change. Repeats
+// of frames lost before and reliable messages rebuilt from parity are taken
+// like the originals would have been. Clock probes are answered at once, and
+// once an operator's clock is known its poses are stamped with when they were
+// sent instead of when they arrived.
+//
+// Operators lease the arms they command (ArmLease.h, TELEOP_LEASE). Poses,
+// home and fingers of an operator the leases keep from an arm are dropped,
+// also a pose that was waiting for the arm when the lease went elsewhere. A
+// stop always goes through, any station may stop the arms.
+//
+// Everything the socket receives can be captured to a file (TeleopCapture.h)
+// and later replayed into a server in place of the socket: the same
+// datagrams from the same addresses, each taken at its arrival time as the
+// server's clock sees it, either spaced as they came in or as fast as the
+// server takes them. Nothing is sent while replaying, so the operators of the
+// captured session are left alone. Only the sink's answers, the arm's side,
+// may differ from the original session.
+
+// Operators (addresses) served at once; one silent for the timeout is forgotten.
+#define TELEOP_MAX_PEERS 4
+#define TELEOP_PEER_TIMEOUT_MICROS 5000000
+
+// Peer i holds its leases as holder TELEOP_LEASE_HOLDER_BASE + i; the holders
+// from TELEOP_LEASE_HOLDER_BASE + TELEOP_MAX_PEERS on are free for others.
+#define TELEOP_LEASE_HOLDER_BASE 1
+
+// Reliable IDs of a peer remembered below the newest, to act on each once.
+#define TELEOP_RELIABLE_WINDOW 64
+
+// How long the server waits for a datagram before it offers waiting poses again.
+#define TELEOP_SERVER_POLL_MS 2
+
+// What the server does with the messages, ARM_base.cpp wires it to the bridge.
+// All calls come from the server's thread.
+struct TeleopSink
+{
+	// Returns false while the arm cannot take a new pose yet. timestamp is when
+	// the operator sent the pose, on this machine's NowMicros() clock; when the
+	// pose arrived until the clocks are synchronized.
+	bool(*Pose)(bool rightArm, long long timestamp, int flags, const float *pose);
+	// A pose from a frame repeated after it was lost, older than the next pose
+	// the sink will be offered; timestamp as for Pose. Only a
+	// stream of samples has a use for it. May be NULL.
+	void(*Recovered)(bool rightArm, long long timestamp, int flags, const float *pose);
+	void(*Stop)(bool rightArm);
+	void(*Home)(bool rightArm);
+	void(*Fingers)(bool rightArm, int fingers);
+};
+
+// Mirrored by KinovaAPI.TeleopServerStats, keep them in sync.
+struct TeleopServerStats
+{
+	int Running;
+	int Port;
+	int Peers;
+	unsigned int Datagrams;
+	unsigned int Malformed;
+	// gaps in the senders' sequences, late datagrams count as lost too
+	unsigned int Lost;
+	unsigned int Poses;
+	// arrived after a newer pose of the arm, or replaced by a newer one while
+	// waiting for the arm
+	unsigned int PosesStale;
+	unsigned int PosesSuperseded;
+	unsigned int PosesApplied;
+	// TELEOP_FRAME datagrams, each pose in one counts with the poses above
+	unsigned int Frames;
+	// frames whose baseline was forgotten, e.g. after the server restarted
+	unsigned int FramesUndecodable;
+	// lost frames taken from the repeats in later datagrams
+	unsigned int FramesRecovered;
+	unsigned int Reliable;
+	unsigned int Duplicates;
+	// lost reliable messages rebuilt from parity
+	unsigned int ReliableRecovered;
+	unsigned int AcksSent;
+	// peers refused because TELEOP_MAX_PEERS were talking already
+	unsigned int PeersRefused;
+	// lease requests, and poses, home and fingers the leases kept from the arms
+	unsigned int LeaseRequests;
+	unsigned int CommandsRefused;
+	// repeated frames and parity messages received, the cost of the redundancy
+	long long RedundantBytes;
+	// the clock of the operator that probed last (see ClockSync.h): offset is
+	// operator minus server, delay the best round trip
+	unsigned int SyncProbes;
+	int ClockSynced;
+	long long ClockOffset;
+	double ClockDriftPpm;
+	long long ClockDelay;
+	// datagrams written to the capture file, and while a replay runs how long
+	// it has taken so far
+	int Capturing;
+	unsigned int Captured;
+	int Replaying;
+	long long ReplayMicros;
+};
+
+// port 0 takes any free port, see the stats for which.
+// returns:
+// 0 - running
+// -1 - already running
+// -2 - the socket could not be opened
+int OpenTeleopServer(int port, const TeleopSink &sink);
+void CloseTeleopServer();
+bool TeleopServerRunning();
+
+// A server fed from a capture instead of the socket. Stats tell when the
+// replay is done, the server stays open with them until closed.
+// returns:
+// 0 - replaying
+// -1 - already running
+// -2 - the file is no capture
+int OpenTeleopReplay(const char *file, bool originalTiming, const TeleopSink &sink);
+
+// Captures what the server receives from now on, also across server restarts,
+// until closed. An existing file is replaced.
+// returns:
+// 0 - capturing
+// -1 - already capturing
+// -2 - the file could not be created
+int OpenTeleopCapture(const char *file);
+void CloseTeleopCapture();
+
+void ReadTeleopServerStats(TeleopServerStats &stats);
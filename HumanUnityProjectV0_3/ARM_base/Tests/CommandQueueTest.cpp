@@ -0,0 +1,119 @@
+// Test of the command worker's background tasks (CommandQueue.h).
+//
+// A task added to a running queue that has no commands and no other tasks, as
+// InitRobot adds its state polling, must run without waiting for a command.
+// So must a task added while the worker sleeps until another task is due, and
+// a fast task must keep running. Commands must still go through.
+//
+// Standalone, not part of the bridge project. CommandQueue.cpp takes an error
+// code from the Kinova SDK's Lib_Examples\CommunicationLayerWindows.h, a
+// Windows path; elsewhere give it a copy under that name:
+//   g++ -std=c++14 -O1 -g -fsanitize=address,undefined -I.. CommandQueueTest.cpp ../CommandQueue.cpp
+//     ../Latency.cpp -o CommandQueueTest -lpthread
+// Exits 0 when every check holds.
+
+#include "CommandQueue.h"
+#include "Timing.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace std;
+
+#define FAST_PERIOD_MICROS 10000
+#define SLOW_PERIOD_MICROS 10000000
+// long enough for the worker to be asleep before anything is added
+#define SETTLE_MICROS 50000
+#define WATCH_MICROS 200000
+
+static int failures;
+
+static void Check(bool ok, const char *what, long long value)
+{
+	if (!ok)
+	{
+		printf("FAIL %s: %lld\n", what, value);
+		failures++;
+	}
+}
+
+static atomic<int> executed(0);
+static atomic<int> fastRuns(0);
+static atomic<int> slowRuns(0);
+static atomic<int> lateRuns(0);
+
+static int Execute(const ArmCommand &)
+{
+	executed++;
+	return 0;
+}
+
+static void FastTask()
+{
+	fastRuns++;
+}
+
+static void SlowTask()
+{
+	slowRuns++;
+}
+
+static void LateTask()
+{
+	lateRuns++;
+}
+
+static void Sleep(long long micros)
+{
+	this_thread::sleep_for(chrono::microseconds(micros));
+}
+
+// Adds the task and returns how long it took to run the first time, -1 when
+// it did not run within WATCH_MICROS.
+static long long FirstRun(BackgroundTask task, atomic<int> &runs, const char *what)
+{
+	long long added = NowMicros();
+	Check(AddBackgroundTask(task, SLOW_PERIOD_MICROS), what, 0);
+	while (runs == 0 && NowMicros() - added < WATCH_MICROS)
+	{
+		Sleep(1000);
+	}
+	return runs == 0 ? -1 : NowMicros() - added;
+}
+
+int main()
+{
+	// tasks cannot be taken away again, so from no task over a slow one to a
+	// fast one
+	StartCommandQueue(Execute);
+	Sleep(SETTLE_MICROS);
+	long long idle = FirstRun(SlowTask, slowRuns, "add to an idle queue");
+	printf("idle queue: task ran after %lld us\n", idle);
+	Check(idle >= 0, "task on an idle queue", idle);
+
+	// the worker now sleeps until the slow task is due again, seconds away
+	Sleep(SETTLE_MICROS);
+	long long waiting = FirstRun(LateTask, lateRuns, "add while waiting for a task");
+	printf("waiting for a task: task ran after %lld us\n", waiting);
+	Check(waiting >= 0, "task added while waiting for a task", waiting);
+	Check(slowRuns == 1 && lateRuns == 1, "slow tasks run once", slowRuns + lateRuns);
+
+	Check(AddBackgroundTask(FastTask, FAST_PERIOD_MICROS), "add the fast task", 0);
+	Sleep(WATCH_MICROS);
+	int runs = fastRuns;
+	printf("fast task: %d runs in %d ms\n", runs, WATCH_MICROS / 1000);
+	Check(runs >= WATCH_MICROS / FAST_PERIOD_MICROS / 2, "fast task runs", runs);
+	Check(executed == 0, "commands executed", executed);
+
+	// commands still go through
+	ArmCommand command = {};
+	command.Type = CMD_MOVE_HAND;
+	unsigned int id = SubmitCommand(command);
+	CommandCompletion completion;
+	Check(WaitForCompletion(id, 1000, completion) == 0 && completion.Result == 0, "command", id);
+	StopCommandQueue();
+
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,408 @@
+// Fuzz test and benchmark of the NatNet frame decoders (NatNetFrame.h).
+//
+// A frame of every layout, NatNet 1.x to 2.10, must decode to what was put in
+// it, every shorter cut of it must be turned away as cut short, and counts
+// beyond what the view holds as too many. Then mutated frames of every
+// layout, each in a heap buffer of exactly its size so an address sanitizer
+// sees any read past it, must decode to one of the documented results, and
+// when they decode, everything the view points at must lie in the packet.
+// Last the time a decode takes against the number of rigid bodies.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O1 -g -fsanitize=address,undefined -I.. NatNetFrameTest.cpp ../NatNetFrame.cpp -o NatNetFrameTest
+// Exits 0 when every check holds.
+
+#include "NatNetFrames.h"
+#include "Timing.h"
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+#define FUZZ_FRAMES 300000
+#define BENCHMARK_BYTES (1024 * 1024 * 1024)
+// the largest datagram a server sends
+#define MAX_DATAGRAM 65507
+
+static int failures;
+
+static void Fail(const char *what, int layout, int value)
+{
+	if (failures < 20)
+	{
+		printf("FAIL %s, layout %02x: %d\n", what, layout, value);
+	}
+	failures++;
+}
+
+static const int versions[][4] =
+{
+	{ 1, 2, 0, 0 },
+	{ 2, 0, 0, 0 },
+	{ 2, 2, 0, 0 },
+	{ 2, 5, 0, 0 },
+	{ 2, 6, 0, 0 },
+	{ 2, 8, 0, 0 },
+	{ 2, 10, 0, 0 },
+	{ 0, 0, 0, 0 },
+};
+#define VERSIONS (int)(sizeof(versions) / sizeof(versions[0]))
+
+static const NatNetScene scene = { 2, 3, 5, 10, 2, 21, 20, 2, 3, 2 };
+
+// A copy of the packet in a buffer of exactly its size; the header's byte
+// count is set to what is left after the header when fit is set.
+static unsigned char *Exact(const vector<unsigned char> &packet, size_t size, bool fit)
+{
+	unsigned char *exact = new unsigned char[size > 0 ? size : 1];
+	memcpy(exact, packet.data(), size);
+	if (fit && size >= 4)
+	{
+		exact[2] = (unsigned char)((size - 4) & 0xFF);
+		exact[3] = (unsigned char)((size - 4) >> 8);
+	}
+	return exact;
+}
+
+static void CheckBodies(const NatNetRigidBodies &bodies, int first, int count, int layout, const int *ids)
+{
+	for (int i = 0; i < count; i++)
+	{
+		int k = first + i;
+		int id = ids[i];
+		float values[7] = { bodies.X[k], bodies.Y[k], bodies.Z[k], bodies.QX[k], bodies.QY[k], bodies.QZ[k],
+			bodies.QW[k] };
+		bool same = bodies.Id[k] == id && bodies.MarkerCount[k] == scene.Markers;
+		for (int field = 0; field < 7; field++)
+		{
+			same = same && values[field] == NatNetBodyValue(id, field);
+		}
+		same = same && bodies.Error[k] == ((layout & NATNET_HAS_MARKER_DETAILS) ? NatNetBodyValue(id, 7) : 0.0f);
+		same = same && bodies.Flags[k] == ((layout & NATNET_HAS_TRACKING_FLAGS) ? NatNetBodyFlags(id) :
+			NATNET_TRACKING_VALID);
+		same = same && NatNetReadF32(bodies.Markers[k] + 12 * (scene.Markers - 1) + 8) ==
+			0.5f * (3 * scene.Markers - 1);
+		if (!same)
+		{
+			Fail("rigid body", layout, id);
+		}
+	}
+}
+
+static void CheckView(const NatNetFrameView &view, int layout)
+{
+	bool same = view.FrameNumber == 1234 && view.MarkerSetCount == scene.MarkerSets &&
+		strcmp(view.MarkerSetName[1], "set1") == 0 && view.MarkerSetSize[1] == scene.Markers &&
+		NatNetReadF32(view.MarkerSetMarkers[1] + 4) == 0.5f && view.UnlabeledCount == scene.Unlabeled &&
+		NatNetReadF32(view.Unlabeled + 12 * scene.Unlabeled - 4) == 0.5f * (3 * scene.Unlabeled - 1) &&
+		view.RigidBodies.Count == scene.RigidBodies && view.Latency == 0.004f && view.Timecode == 77 &&
+		view.TimecodeSubframe == 3 && view.Timestamp == NatNetFrameTimestamp(1234) && view.Flags == 1;
+	if (!same)
+	{
+		Fail("frame", layout, 0);
+	}
+	int ids[NATNET_MAX_BONES];
+	for (int i = 0; i < scene.RigidBodies; i++)
+	{
+		ids[i] = i + 1;
+	}
+	CheckBodies(view.RigidBodies, 0, view.RigidBodies.Count, layout, ids);
+
+	int skeletons = (layout & NATNET_HAS_SKELETONS) ? scene.Skeletons : 0;
+	if (view.SkeletonCount != skeletons || view.Bones.Count != skeletons * scene.Bones)
+	{
+		Fail("skeleton count", layout, view.SkeletonCount);
+		skeletons = 0;
+	}
+	for (int i = 0; i < skeletons; i++)
+	{
+		if (view.SkeletonId[i] != NatNetSkeletonId(i) || view.SkeletonFirstBone[i] != i * scene.Bones ||
+			view.SkeletonBoneCount[i] != scene.Bones)
+		{
+			Fail("skeleton", layout, i);
+			continue;
+		}
+		for (int j = 0; j < scene.Bones; j++)
+		{
+			ids[j] = NatNetBoneId(i, j);
+		}
+		CheckBodies(view.Bones, view.SkeletonFirstBone[i], scene.Bones, layout, ids);
+	}
+
+	if (layout & NATNET_HAS_LABELED_MARKERS)
+	{
+		const unsigned char *last = view.Labeled + (scene.Labeled - 1) * view.LabeledStride;
+		if (view.LabeledCount != scene.Labeled || (int)NatNetReadU32(last) != scene.Labeled - 1 ||
+			NatNetReadF32(last + 12) != 3.0f * (scene.Labeled - 1))
+		{
+			Fail("labeled markers", layout, view.LabeledCount);
+		}
+	}
+	else if (view.LabeledCount != 0)
+	{
+		Fail("labeled markers in a layout without", layout, view.LabeledCount);
+	}
+
+	if (layout & NATNET_HAS_FORCE_PLATES)
+	{
+		if (view.ForcePlateCount != scene.ForcePlates || view.ForcePlateId[1] != 2 ||
+			view.ForcePlateChannels[1] != scene.Channels || (int)NatNetReadU32(view.ForcePlateData[1]) != scene.Samples)
+		{
+			Fail("force plates", layout, view.ForcePlateCount);
+		}
+	}
+	else if (view.ForcePlateCount != 0)
+	{
+		Fail("force plates in a layout without", layout, view.ForcePlateCount);
+	}
+}
+
+static void RoundTrips()
+{
+	static NatNetFrameView view;
+	for (int v = 0; v < VERSIONS; v++)
+	{
+		int layout = NatNetFrameLayout(versions[v]);
+		NatNetDecoder decode = SelectNatNetDecoder(versions[v]);
+		if (layout < 0 || decode == NULL)
+		{
+			Fail("no decoder", layout, v);
+			continue;
+		}
+		vector<unsigned char> packet = BuildNatNetFrame(layout, scene, 1234);
+		unsigned char *exact = Exact(packet, packet.size(), false);
+		// the view points into the packet
+		int result = decode(exact, (int)packet.size(), view);
+		if (result == 0)
+		{
+			CheckView(view, layout);
+		}
+		else
+		{
+			Fail("decode", layout, result);
+		}
+		delete[] exact;
+
+		// cut anywhere, the byte count in the header saying so or not; the last
+		// bytes are the end tag, which is not read
+		int cuts = 0;
+		for (size_t size = 0; size < packet.size() - 4; size++)
+		{
+			for (int fit = 0; fit < 2; fit++)
+			{
+				unsigned char *cut = Exact(packet, size, fit != 0);
+				result = decode(cut, (int)size, view);
+				delete[] cut;
+				if (result != (size < 4 ? -1 : -2))
+				{
+					Fail("cut short", layout, (int)size);
+				}
+				cuts++;
+			}
+		}
+		printf("layout %02x: %d bytes, decoded, %d cuts turned away\n", layout, (int)packet.size(), cuts);
+	}
+
+	int unknown[4] = { 3, 0, 0, 0 };
+	if (NatNetFrameLayout(unknown) != -1 || SelectNatNetDecoder(unknown) != NULL)
+	{
+		Fail("decoder for NatNet 3", 0, 0);
+	}
+}
+
+static void TooMany()
+{
+	static NatNetFrameView view;
+	int version[4] = { 2, 10, 0, 0 };
+	int layout = NatNetFrameLayout(version);
+	NatNetDecoder decode = SelectNatNetDecoder(version);
+	NatNetScene scenes[4] =
+	{
+		{ NATNET_MAX_MARKER_SETS + 1, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+		{ 0, 0, 0, NATNET_MAX_RIGID_BODIES + 1, 0, 0, 0, 0, 0, 0 },
+		{ 0, 0, 0, 0, NATNET_MAX_SKELETONS + 1, 0, 0, 0, 0, 0 },
+		{ 0, 0, 0, 0, 2, NATNET_MAX_BONES / 2 + 1, 0, 0, 0, 0 },
+	};
+	for (int i = 0; i < 4; i++)
+	{
+		vector<unsigned char> packet = BuildNatNetFrame(layout, scenes[i], 1);
+		int result = decode(packet.data(), (int)packet.size(), view);
+		if (packet.size() > MAX_DATAGRAM || result != -3)
+		{
+			Fail("too many", layout, result);
+		}
+	}
+	NatNetScene plates = { 0, 0, 0, 0, 0, 0, 0, NATNET_MAX_FORCE_PLATES + 1, 1, 1 };
+	vector<unsigned char> packet = BuildNatNetFrame(layout, plates, 1);
+	if (decode(packet.data(), (int)packet.size(), view) != -3)
+	{
+		Fail("too many force plates", layout, 0);
+	}
+}
+
+static bool Inside(const unsigned char *from, long long bytes, const unsigned char *packet, int size)
+{
+	return bytes >= 0 && from >= packet + 4 && from + bytes <= packet + size;
+}
+
+// Everything a decoded view points at, in the packet.
+static void CheckBounds(const NatNetFrameView &view, const unsigned char *packet, int size, int layout)
+{
+	bool inside = view.MarkerSetCount <= NATNET_MAX_MARKER_SETS && view.RigidBodies.Count <= NATNET_MAX_RIGID_BODIES &&
+		view.SkeletonCount <= NATNET_MAX_SKELETONS && view.Bones.Count <= NATNET_MAX_BONES &&
+		view.ForcePlateCount <= NATNET_MAX_FORCE_PLATES;
+	for (int i = 0; inside && i < view.MarkerSetCount; i++)
+	{
+		const char *name = view.MarkerSetName[i];
+		inside = Inside((const unsigned char *)name, (long long)strnlen(name, packet + size - (const unsigned char *)name) + 1,
+			packet, size) && Inside(view.MarkerSetMarkers[i], 12LL * view.MarkerSetSize[i], packet, size);
+	}
+	inside = inside && Inside(view.Unlabeled, 12LL * view.UnlabeledCount, packet, size);
+	const NatNetRigidBodies *sets[2] = { &view.RigidBodies, &view.Bones };
+	int markerSize = (layout & NATNET_HAS_MARKER_DETAILS) ? 20 : 12;
+	for (int s = 0; s < 2; s++)
+	{
+		for (int i = 0; inside && i < sets[s]->Count; i++)
+		{
+			inside = Inside(sets[s]->Markers[i], (long long)markerSize * sets[s]->MarkerCount[i], packet, size);
+		}
+	}
+	for (int i = 0; inside && i < view.SkeletonCount; i++)
+	{
+		inside = view.SkeletonFirstBone[i] >= 0 && view.SkeletonBoneCount[i] >= 0 &&
+			view.SkeletonFirstBone[i] + view.SkeletonBoneCount[i] <= view.Bones.Count;
+	}
+	inside = inside && Inside(view.Labeled, (long long)view.LabeledStride * view.LabeledCount, packet, size);
+	for (int i = 0; inside && i < view.ForcePlateCount; i++)
+	{
+		const unsigned char *channel = view.ForcePlateData[i];
+		for (int j = 0; inside && j < view.ForcePlateChannels[i]; j++)
+		{
+			inside = Inside(channel, 4, packet, size) &&
+				Inside(channel, 4 + 4LL * NatNetReadU32(channel), packet, size);
+			channel += inside ? 4 + 4 * NatNetReadU32(channel) : 0;
+		}
+	}
+	if (!inside)
+	{
+		Fail("view outside the packet", layout, size);
+	}
+}
+
+static void Mutate(vector<unsigned char> &packet, mt19937 &random)
+{
+	switch (random() % 4)
+	{
+	case 0:
+		// a few bytes to anything
+		for (int i = (int)(random() % 4); i >= 0; i--)
+		{
+			packet[random() % packet.size()] = (unsigned char)random();
+		}
+		break;
+	case 1:
+		// a count or ID to something big, small or negative
+		{
+			size_t at = (random() % (packet.size() / 4)) * 4;
+			unsigned int values[] = { 0, 1, 2, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, (unsigned int)random() };
+			unsigned int value = values[random() % 7];
+			for (int i = 0; i < 4 && at + i < packet.size(); i++)
+			{
+				packet[at + i] = (unsigned char)(value >> (8 * i));
+			}
+		}
+		break;
+	case 2:
+		// cut short, the header's byte count left as it was
+		packet.resize(random() % packet.size());
+		break;
+	default:
+		// a byte anywhere, then cut short and the header made to agree
+		packet[random() % packet.size()] = (unsigned char)random();
+		packet.resize(4 + random() % (packet.size() - 3));
+		packet[2] = (unsigned char)((packet.size() - 4) & 0xFF);
+		packet[3] = (unsigned char)((packet.size() - 4) >> 8);
+		break;
+	}
+}
+
+static void Fuzz()
+{
+	mt19937 random(1);
+	static NatNetFrameView view;
+	vector<unsigned char> packets[VERSIONS];
+	for (int v = 0; v < VERSIONS; v++)
+	{
+		packets[v] = BuildNatNetFrame(NatNetFrameLayout(versions[v]), scene, 1234);
+	}
+	int results[4] = {};
+	for (int i = 0; i < FUZZ_FRAMES; i++)
+	{
+		int v = (int)(random() % VERSIONS);
+		int layout = NatNetFrameLayout(versions[v]);
+		vector<unsigned char> packet = packets[v];
+		Mutate(packet, random);
+		unsigned char *exact = Exact(packet, packet.size(), false);
+		int result = SelectNatNetDecoder(versions[v])(exact, (int)packet.size(), view);
+		if (result > 0 || result < -3)
+		{
+			Fail("decode result", layout, result);
+		}
+		else
+		{
+			results[-result]++;
+		}
+		if (result == 0)
+		{
+			CheckBounds(view, exact, (int)packet.size(), layout);
+		}
+		delete[] exact;
+	}
+	printf("%d mutated frames: %d decoded, %d not a frame, %d cut short, %d too many\n", FUZZ_FRAMES, results[0],
+		results[1], results[2], results[3]);
+}
+
+static void Benchmark()
+{
+	static NatNetFrameView view;
+	int version[4] = { 2, 10, 0, 0 };
+	int layout = NatNetFrameLayout(version);
+	NatNetDecoder decode = SelectNatNetDecoder(version);
+	int bodies[] = { 10, 100, 1000 };
+	int markers[] = { 0, 4 };
+	for (int b = 0; b < 3; b++)
+	{
+		for (int m = 0; m < 2; m++)
+		{
+			NatNetScene big = { 0, markers[m], 0, bodies[b], 0, 0, 0, 0, 0, 0 };
+			vector<unsigned char> packet = BuildNatNetFrame(layout, big, 1);
+			if (packet.size() > MAX_DATAGRAM)
+			{
+				printf("%4d rigid bodies, %d markers each: %d bytes, more than a datagram\n", bodies[b], markers[m],
+					(int)packet.size());
+				continue;
+			}
+			int frames = BENCHMARK_BYTES / (int)packet.size();
+			long long sink = 0;
+			long long start = NowMicros();
+			for (int i = 0; i < frames; i++)
+			{
+				sink += decode(packet.data(), (int)packet.size(), view) + view.RigidBodies.Count;
+			}
+			long long elapsed = NowMicros() - start;
+			printf("%4d rigid bodies, %d markers each: %5d bytes, %7.2f us per frame, %.0f MB/s (%lld)\n", bodies[b],
+				markers[m], (int)packet.size(), (double)elapsed / frames, (double)frames * packet.size() / elapsed,
+				sink / frames);
+		}
+	}
+}
+
+int main()
+{
+	RoundTrips();
+	TooMany();
+	Fuzz();
+	Benchmark();
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
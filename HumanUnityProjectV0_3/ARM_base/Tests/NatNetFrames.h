@@ -0,0 +1,221 @@
+#pragma once
+
+#include "NatNetClient.h"
+#include "NatNetFrame.h"
+#include <cstdio>
+#include <vector>
+
+// Builds NatNet frames of data the way a server of each layout (NATNET_HAS_*
+// in NatNetFrame.h) sends them, for the NatNet tests. Every value is worked
+// out from the entity's ID, so a test can tell what it should read back.
+
+// What a frame has. Markers is the size of each marker set, rigid body and
+// bone; sections the layout does not have are left out.
+struct NatNetScene
+{
+	int MarkerSets;
+	int Markers;
+	int Unlabeled;
+	int RigidBodies;
+	int Skeletons;
+	int Bones;
+	int Labeled;
+	int ForcePlates;
+	int Channels;
+	int Samples;
+};
+
+// Rigid body i has ID i + 1, bone j of skeleton i ID (SkeletonId(i) << 16) | j.
+inline int NatNetSkeletonId(int i)
+{
+	return 100 + i;
+}
+
+inline int NatNetBoneId(int skeleton, int bone)
+{
+	return (NatNetSkeletonId(skeleton) << 16) | bone;
+}
+
+// field 0 to 6 x, y, z, qx, qy, qz, qw, 7 the mean marker error; exact in a
+// float for any ID
+inline float NatNetBodyValue(int id, int field)
+{
+	return (float)(id & 0xFFFF) + 0.125f * field;
+}
+
+inline int NatNetBodyFlags(int id)
+{
+	return NATNET_TRACKING_VALID | (id & 2);
+}
+
+inline double NatNetFrameTimestamp(int frameNumber)
+{
+	return frameNumber / 128.0;
+}
+
+struct NatNetFrameWriter
+{
+	std::vector<unsigned char> Bytes;
+
+	void U16(unsigned int value)
+	{
+		Bytes.push_back((unsigned char)(value & 0xFF));
+		Bytes.push_back((unsigned char)(value >> 8));
+	}
+
+	void U32(unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			Bytes.push_back((unsigned char)(value >> (8 * i)));
+		}
+	}
+
+	void F32(float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		U32(bits);
+	}
+
+	void F64(double value)
+	{
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		U32((unsigned int)bits);
+		U32((unsigned int)(bits >> 32));
+	}
+
+	void String(const char *text)
+	{
+		Bytes.insert(Bytes.end(), text, text + strlen(text) + 1);
+	}
+
+	void Markers(int count)
+	{
+		for (int i = 0; i < count * 3; i++)
+		{
+			F32(0.5f * i);
+		}
+	}
+
+	void RigidBody(int layout, int id, int markers)
+	{
+		U32((unsigned int)id);
+		for (int field = 0; field < 7; field++)
+		{
+			F32(NatNetBodyValue(id, field));
+		}
+		U32((unsigned int)markers);
+		Markers(markers);
+		if (layout & NATNET_HAS_MARKER_DETAILS)
+		{
+			for (int i = 0; i < markers; i++)
+			{
+				U32((unsigned int)i);
+			}
+			for (int i = 0; i < markers; i++)
+			{
+				F32(0.01f);
+			}
+			F32(NatNetBodyValue(id, 7));
+		}
+		if (layout & NATNET_HAS_TRACKING_FLAGS)
+		{
+			U16((unsigned int)NatNetBodyFlags(id));
+		}
+	}
+};
+
+// The whole datagram.
+inline std::vector<unsigned char> BuildNatNetFrame(int layout, const NatNetScene &scene, int frameNumber)
+{
+	NatNetFrameWriter out;
+	out.U16(NATNET_FRAME_OF_DATA);
+	out.U16(0);
+	out.U32((unsigned int)frameNumber);
+
+	out.U32((unsigned int)scene.MarkerSets);
+	for (int i = 0; i < scene.MarkerSets; i++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "set%d", i);
+		out.String(name);
+		out.U32((unsigned int)scene.Markers);
+		out.Markers(scene.Markers);
+	}
+	out.U32((unsigned int)scene.Unlabeled);
+	out.Markers(scene.Unlabeled);
+
+	out.U32((unsigned int)scene.RigidBodies);
+	for (int i = 0; i < scene.RigidBodies; i++)
+	{
+		out.RigidBody(layout, i + 1, scene.Markers);
+	}
+	if (layout & NATNET_HAS_SKELETONS)
+	{
+		out.U32((unsigned int)scene.Skeletons);
+		for (int i = 0; i < scene.Skeletons; i++)
+		{
+			out.U32((unsigned int)NatNetSkeletonId(i));
+			out.U32((unsigned int)scene.Bones);
+			for (int j = 0; j < scene.Bones; j++)
+			{
+				out.RigidBody(layout, NatNetBoneId(i, j), scene.Markers);
+			}
+		}
+	}
+	if (layout & NATNET_HAS_LABELED_MARKERS)
+	{
+		out.U32((unsigned int)scene.Labeled);
+		for (int i = 0; i < scene.Labeled; i++)
+		{
+			out.U32((unsigned int)i);
+			out.F32(1.0f * i);
+			out.F32(2.0f * i);
+			out.F32(3.0f * i);
+			out.F32(0.01f);
+			if (layout & NATNET_HAS_TRACKING_FLAGS)
+			{
+				out.U16(NATNET_TRACKING_VALID);
+			}
+		}
+	}
+	if (layout & NATNET_HAS_FORCE_PLATES)
+	{
+		out.U32((unsigned int)scene.ForcePlates);
+		for (int i = 0; i < scene.ForcePlates; i++)
+		{
+			out.U32((unsigned int)(i + 1));
+			out.U32((unsigned int)scene.Channels);
+			for (int j = 0; j < scene.Channels; j++)
+			{
+				out.U32((unsigned int)scene.Samples);
+				for (int k = 0; k < scene.Samples; k++)
+				{
+					out.F32((float)k);
+				}
+			}
+		}
+	}
+
+	// latency, timecode, subframe, timestamp, flags, end tag
+	out.F32(0.004f);
+	out.U32(77);
+	out.U32(3);
+	if (layout & NATNET_HAS_DOUBLE_TIMESTAMP)
+	{
+		out.F64(NatNetFrameTimestamp(frameNumber));
+	}
+	else
+	{
+		out.F32((float)NatNetFrameTimestamp(frameNumber));
+	}
+	out.U16(1);
+	out.U32(0);
+
+	int size = (int)out.Bytes.size() - 4;
+	out.Bytes[2] = (unsigned char)(size & 0xFF);
+	out.Bytes[3] = (unsigned char)(size >> 8);
+	return out.Bytes;
+}
@@ -0,0 +1,358 @@
+// Fuzz test and benchmark of selective NatNet decoding (the indexers and
+// selectors in NatNetFrame.h).
+//
+// For frames of every layout and random subscriptions, indexing and selecting
+// must come out as the full decoder does for the subscribed rigid bodies and
+// skeletons. Mutated frames, each in a heap buffer of exactly its size so an
+// address sanitizer sees any read past it, must be turned away by the indexer
+// exactly when the full decoder turns them away, and select the same when it
+// does not. Last the time a frame takes against the size of the scene, fully
+// decoded and selectively.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O1 -g -fsanitize=address,undefined -I.. NatNetSelectTest.cpp ../NatNetFrame.cpp -o NatNetSelectTest
+// Exits 0 when every check holds.
+
+#include "NatNetFrames.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+#define ROUND_TRIPS 2000
+#define FUZZ_FRAMES 300000
+#define BENCHMARK_FRAMES 20000
+// the largest datagram a server sends
+#define MAX_DATAGRAM 65507
+
+static int failures;
+
+static void Fail(const char *what, int layout, int value)
+{
+	if (failures < 20)
+	{
+		printf("FAIL %s, layout %02x: %d\n", what, layout, value);
+	}
+	failures++;
+}
+
+static const int versions[][4] =
+{
+	{ 1, 2, 0, 0 },
+	{ 2, 0, 0, 0 },
+	{ 2, 2, 0, 0 },
+	{ 2, 5, 0, 0 },
+	{ 2, 6, 0, 0 },
+	{ 2, 8, 0, 0 },
+	{ 2, 10, 0, 0 },
+};
+#define VERSIONS (int)(sizeof(versions) / sizeof(versions[0]))
+
+static const NatNetScene scene = { 2, 3, 5, 30, 3, 21, 20, 2, 3, 2 };
+
+// Some of the scene's rigid bodies and skeletons and some it does not have,
+// each once.
+static NatNetSubscription RandomSubscription(mt19937 &random)
+{
+	NatNetSubscription subscription;
+	memset(&subscription, 0, sizeof(subscription));
+	vector<int> ids;
+	for (int id = 1; id <= scene.RigidBodies + 8; id++)
+	{
+		ids.push_back(id);
+	}
+	// IDs 64 apart share a bit of the indexer's filter
+	ids.push_back(64 + 1);
+	ids.push_back(-1);
+	shuffle(ids.begin(), ids.end(), random);
+	subscription.RigidBodyCount = (int)(random() % (NATNET_MAX_SUBSCRIBED + 1));
+	copy(ids.begin(), ids.begin() + subscription.RigidBodyCount, subscription.RigidBodyId);
+
+	vector<int> skeletons;
+	for (int i = 0; i < scene.Skeletons + 2; i++)
+	{
+		skeletons.push_back(NatNetSkeletonId(i));
+	}
+	shuffle(skeletons.begin(), skeletons.end(), random);
+	// the bones of two skeletons at most, NATNET_MAX_SELECTED_BONES
+	subscription.SkeletonCount = (int)(random() % 3);
+	copy(skeletons.begin(), skeletons.begin() + subscription.SkeletonCount, subscription.SkeletonId);
+	return subscription;
+}
+
+// The last one with the ID, as the indexer keeps the last one it finds.
+static int Find(const int *ids, int count, int id)
+{
+	int found = -1;
+	for (int i = 0; i < count; i++)
+	{
+		found = ids[i] == id ? i : found;
+	}
+	return found;
+}
+
+// Bit for bit, mutated frames have NaNs.
+static bool Same(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static bool SamePose(const NatNetPose &pose, const NatNetRigidBodies &bodies, int k)
+{
+	return pose.Found == 1 && pose.Id == bodies.Id[k] && pose.Flags == bodies.Flags[k] && Same(pose.Error, bodies.Error[k]) &&
+		Same(pose.Position[0], bodies.X[k]) && Same(pose.Position[1], bodies.Y[k]) && Same(pose.Position[2], bodies.Z[k]) &&
+		Same(pose.Orientation[0], bodies.QX[k]) && Same(pose.Orientation[1], bodies.QY[k]) &&
+		Same(pose.Orientation[2], bodies.QZ[k]) && Same(pose.Orientation[3], bodies.QW[k]);
+}
+
+// The selection against what the full decoder made of the same packet.
+static void Compare(const NatNetSubscription &subscription, const NatNetSelection &selection,
+	const NatNetFrameView &view, int layout)
+{
+	if (selection.FrameNumber != view.FrameNumber || selection.Flags != view.Flags ||
+		memcmp(&selection.Timestamp, &view.Timestamp, sizeof(view.Timestamp)) != 0)
+	{
+		Fail("frame", layout, selection.FrameNumber);
+	}
+	for (int i = 0; i < subscription.RigidBodyCount; i++)
+	{
+		const NatNetPose &pose = selection.RigidBodies[i];
+		int k = Find(view.RigidBodies.Id, view.RigidBodies.Count, subscription.RigidBodyId[i]);
+		if (k < 0 ? pose.Found != 0 || pose.Id != subscription.RigidBodyId[i] : !SamePose(pose, view.RigidBodies, k))
+		{
+			Fail("rigid body", layout, subscription.RigidBodyId[i]);
+		}
+	}
+	int bones = 0;
+	for (int i = 0; i < subscription.SkeletonCount; i++)
+	{
+		int k = Find(view.SkeletonId, view.SkeletonCount, subscription.SkeletonId[i]);
+		int count = k < 0 ? 0 : view.SkeletonBoneCount[k];
+		if (selection.SkeletonFirstBone[i] != bones || selection.SkeletonBoneCount[i] != count)
+		{
+			Fail("skeleton", layout, subscription.SkeletonId[i]);
+			return;
+		}
+		for (int j = 0; j < count; j++)
+		{
+			if (!SamePose(selection.Bones[bones + j], view.Bones, view.SkeletonFirstBone[k] + j))
+			{
+				Fail("bone", layout, view.Bones.Id[view.SkeletonFirstBone[k] + j]);
+			}
+		}
+		bones += count;
+	}
+	if (selection.BoneCount != bones)
+	{
+		Fail("bone count", layout, selection.BoneCount);
+	}
+}
+
+static void RoundTrips()
+{
+	mt19937 random(1);
+	static NatNetFrameView view;
+	static NatNetSelection selection;
+	for (int v = 0; v < VERSIONS; v++)
+	{
+		int layout = NatNetFrameLayout(versions[v]);
+		NatNetDecoder decode = SelectNatNetDecoder(versions[v]);
+		NatNetIndexer indexer = SelectNatNetIndexer(versions[v]);
+		NatNetSelector selector = SelectNatNetSelector(versions[v]);
+		vector<unsigned char> packet = BuildNatNetFrame(layout, scene, 1234);
+		if (decode(packet.data(), (int)packet.size(), view) != 0)
+		{
+			Fail("decode", layout, 0);
+			continue;
+		}
+		int found = 0;
+		for (int trip = 0; trip < ROUND_TRIPS; trip++)
+		{
+			NatNetSubscription subscription = RandomSubscription(random);
+			NatNetFrameIndex index;
+			int result = indexer(packet.data(), (int)packet.size(), subscription, index);
+			if (result == 0)
+			{
+				result = selector(packet.data(), index, subscription, selection);
+			}
+			if (result != 0)
+			{
+				Fail("index and select", layout, result);
+				continue;
+			}
+			Compare(subscription, selection, view, layout);
+			for (int i = 0; i < subscription.RigidBodyCount; i++)
+			{
+				found += selection.RigidBodies[i].Found;
+			}
+		}
+		printf("layout %02x: %d subscriptions, %d rigid bodies found\n", layout, ROUND_TRIPS, found);
+	}
+}
+
+static void Mutate(vector<unsigned char> &packet, mt19937 &random)
+{
+	switch (random() % 4)
+	{
+	case 0:
+		// a few bytes to anything
+		for (int i = (int)(random() % 4); i >= 0; i--)
+		{
+			packet[random() % packet.size()] = (unsigned char)random();
+		}
+		break;
+	case 1:
+		// a count or ID to something big, small or negative
+		{
+			size_t at = (random() % (packet.size() / 4)) * 4;
+			unsigned int values[] = { 0, 1, 2, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, (unsigned int)random() };
+			unsigned int value = values[random() % 7];
+			for (int i = 0; i < 4 && at + i < packet.size(); i++)
+			{
+				packet[at + i] = (unsigned char)(value >> (8 * i));
+			}
+		}
+		break;
+	case 2:
+		// cut short, the header's byte count left as it was
+		packet.resize(random() % packet.size());
+		break;
+	default:
+		// a byte anywhere, then cut short and the header made to agree; a cut
+		// inside the last rigid body's ID is where an early read of it shows
+		packet[random() % packet.size()] = (unsigned char)random();
+		packet.resize(4 + random() % (packet.size() - 3));
+		packet[2] = (unsigned char)((packet.size() - 4) & 0xFF);
+		packet[3] = (unsigned char)((packet.size() - 4) >> 8);
+		break;
+	}
+}
+
+static void Fuzz()
+{
+	mt19937 random(2);
+	static NatNetFrameView view;
+	static NatNetSelection selection;
+	vector<unsigned char> packets[VERSIONS];
+	for (int v = 0; v < VERSIONS; v++)
+	{
+		packets[v] = BuildNatNetFrame(NatNetFrameLayout(versions[v]), scene, 1234);
+	}
+	int indexed = 0;
+	int selected = 0;
+	for (int i = 0; i < FUZZ_FRAMES; i++)
+	{
+		int v = (int)(random() % VERSIONS);
+		int layout = NatNetFrameLayout(versions[v]);
+		NatNetSubscription subscription = RandomSubscription(random);
+		vector<unsigned char> packet = packets[v];
+		Mutate(packet, random);
+		unsigned char *exact = new unsigned char[packet.size() + (packet.empty() ? 1 : 0)];
+		memcpy(exact, packet.data(), packet.size());
+		int size = (int)packet.size();
+
+		int decoded = SelectNatNetDecoder(versions[v])(exact, size, view);
+		NatNetFrameIndex index;
+		int result = SelectNatNetIndexer(versions[v])(exact, size, subscription, index);
+		// the full decoder's -3 is a frame the view cannot hold, given before it
+		// reads the rest, which may be cut short
+		if (decoded == -3 ? result != 0 && result != -2 : result != decoded)
+		{
+			Fail("index result", layout, result);
+		}
+		if (result == 0)
+		{
+			indexed++;
+			if (index.End > size || index.Tail > index.End)
+			{
+				Fail("index outside the packet", layout, index.End);
+			}
+			result = SelectNatNetSelector(versions[v])(exact, index, subscription, selection);
+			if (result == 0 && decoded == 0)
+			{
+				selected++;
+				Compare(subscription, selection, view, layout);
+			}
+			else if (result != 0 && result != -3)
+			{
+				Fail("select result", layout, result);
+			}
+		}
+		delete[] exact;
+	}
+	printf("%d mutated frames: %d indexed, %d selected and compared\n", FUZZ_FRAMES, indexed, selected);
+}
+
+static double MicrosPerFrame(long long start)
+{
+	return (double)(NowMicros() - start) / BENCHMARK_FRAMES;
+}
+
+// Two hands and an operator out of scenes from a few tracked objects to a
+// stage full of them.
+static void Benchmark()
+{
+	static NatNetFrameView view;
+	static NatNetSelection selection;
+	int version[4] = { 2, 10, 0, 0 };
+	int layout = NatNetFrameLayout(version);
+	NatNetDecoder decode = SelectNatNetDecoder(version);
+	NatNetIndexer indexer = SelectNatNetIndexer(version);
+	NatNetSelector selector = SelectNatNetSelector(version);
+	NatNetSubscription subscription;
+	memset(&subscription, 0, sizeof(subscription));
+	subscription.RigidBodyCount = 2;
+	subscription.RigidBodyId[0] = 2;
+	subscription.RigidBodyId[1] = 3;
+	subscription.SkeletonCount = 1;
+	subscription.SkeletonId[0] = NatNetSkeletonId(0);
+
+	// rigid bodies, skeletons, labeled markers, marker sets
+	int scenes[][4] = { { 4, 1, 0, 0 }, { 20, 2, 50, 1 }, { 100, 4, 200, 2 }, { 300, 6, 1000, 4 }, { 1000, 1, 0, 0 } };
+	printf("rigid bodies  skeletons  labeled   bytes | full decode  index  index + select, us per frame\n");
+	for (int s = 0; s < (int)(sizeof(scenes) / sizeof(scenes[0])); s++)
+	{
+		NatNetScene big = { scenes[s][3], 3, scenes[s][2] / 4, scenes[s][0], scenes[s][1], 21, scenes[s][2], 0, 0, 0 };
+		vector<unsigned char> packet = BuildNatNetFrame(layout, big, 1);
+		if (packet.size() > MAX_DATAGRAM)
+		{
+			// markers on every rigid body make a stage full too big for a datagram
+			big.Markers = 0;
+			packet = BuildNatNetFrame(layout, big, 1);
+		}
+		long long sink = 0;
+		NatNetFrameIndex index;
+		long long start = NowMicros();
+		for (int i = 0; i < BENCHMARK_FRAMES; i++)
+		{
+			sink += decode(packet.data(), (int)packet.size(), view) + view.RigidBodies.Count;
+		}
+		double full = MicrosPerFrame(start);
+		start = NowMicros();
+		for (int i = 0; i < BENCHMARK_FRAMES; i++)
+		{
+			sink += indexer(packet.data(), (int)packet.size(), subscription, index) + index.Tail;
+		}
+		double indexing = MicrosPerFrame(start);
+		start = NowMicros();
+		for (int i = 0; i < BENCHMARK_FRAMES; i++)
+		{
+			sink += indexer(packet.data(), (int)packet.size(), subscription, index);
+			sink += selector(packet.data(), index, subscription, selection) + selection.BoneCount;
+		}
+		double selecting = MicrosPerFrame(start);
+		printf("%12d %10d %8d %7d | %11.2f %6.2f %15.2f (%lld)\n", scenes[s][0], scenes[s][1], scenes[s][2],
+			(int)packet.size(), full, indexing, selecting, sink / BENCHMARK_FRAMES);
+	}
+}
+
+int main()
+{
+	RoundTrips();
+	Fuzz();
+	Benchmark();
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+// Fuzz test and throughput benchmark of the Kinova packet codec
+// (PacketCodec.h), for USB and Ethernet packets.
+//
+// Commands of random sizes are split, shuffled, duplicated and put back
+// together, and must come out as they went in. Then random and mutated
+// packets, each in a heap buffer of exactly its size so an address sanitizer
+// sees any read past it, go through DecodePacket and a reassembler, which
+// must answer with one of their documented results and never write past the
+// caller's buffer.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O1 -g -fsanitize=address,undefined -I.. PacketCodecTest.cpp ../PacketCodec.cpp -o PacketCodecTest
+// Exits 0 when every check holds.
+
+#include "PacketCodec.h"
+#include "Timing.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+#define ROUND_TRIPS 2000
+#define FUZZ_PACKETS 500000
+// the reassembler's buffer in the fuzz test, smaller than the largest command
+#define FUZZ_CAPACITY 4000
+#define BENCHMARK_BYTES (256 * 1024 * 1024)
+
+static int failures;
+
+static void Fail(const char *what, int transport, int value)
+{
+	if (failures < 20)
+	{
+		printf("FAIL %s, transport %d: %d\n", what, transport, value);
+	}
+	failures++;
+}
+
+static void RoundTrips(int transport, mt19937 &random)
+{
+	int size = PacketSize(transport);
+	vector<unsigned char> data(PACKET_CODEC_MAX_DATA_SIZE);
+	vector<unsigned char> arena(PACKET_CODEC_MAX_PACKETS * size);
+	vector<unsigned char> buffer(PACKET_CODEC_MAX_DATA_SIZE);
+	PacketReassembler reassembler;
+	InitReassembler(reassembler, transport, buffer.data(), (int)buffer.size());
+	for (int trip = 0; trip < ROUND_TRIPS; trip++)
+	{
+		// mostly small commands, now and then one up to the largest
+		int dataSize = trip % 10 == 0 ? (int)(random() % (PACKET_CODEC_MAX_DATA_SIZE + 1)) : (int)(random() % 3000);
+		for (int i = 0; i < dataSize; i++)
+		{
+			data[i] = (unsigned char)random();
+		}
+		short idCommand = (short)(random() & 0x7FFF);
+		int count = EncodeCommand(transport, idCommand, data.data(), dataSize, arena.data(), (int)arena.size());
+		if (count != PacketCount(transport, dataSize))
+		{
+			Fail("packet count", transport, count);
+			continue;
+		}
+
+		// any order, some packets twice
+		vector<int> order;
+		for (int i = 0; i < count; i++)
+		{
+			order.push_back(i);
+			if (random() % 8 == 0)
+			{
+				order.push_back(i);
+			}
+		}
+		shuffle(order.begin(), order.end(), random);
+		vector<bool> seen(count, false);
+		int distinct = 0;
+		int completions = 0;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			vector<unsigned char> packet(arena.begin() + order[i] * size, arena.begin() + (order[i] + 1) * size);
+			distinct += seen[order[i]] ? 0 : 1;
+			seen[order[i]] = true;
+			int result = AddPacket(reassembler, packet.data(), size);
+			// complete first with the last packet not seen before; copies that
+			// come after may put the command together again
+			if ((completions == 0 && distinct == count) != (result == PACKET_COMPLETE && completions == 0))
+			{
+				Fail("completed at the wrong packet", transport, distinct);
+			}
+			if (result == PACKET_COMPLETE)
+			{
+				completions++;
+				if (reassembler.Current.TotalDataSize != dataSize || memcmp(buffer.data(), data.data(), dataSize) != 0)
+				{
+					Fail("reassembled data", transport, dataSize);
+				}
+				ResetReassembler(reassembler);
+			}
+			else if (result != PACKET_INCOMPLETE)
+			{
+				Fail("packet rejected", transport, result);
+			}
+		}
+		if (completions == 0)
+		{
+			Fail("never completed", transport, count);
+		}
+		ResetReassembler(reassembler);
+	}
+}
+
+static void Mutate(vector<unsigned char> &packet, mt19937 &random)
+{
+	switch (random() % 4)
+	{
+	case 0:
+		// flip a few bits anywhere
+		for (int i = (int)(random() % 4); i >= 0; i--)
+		{
+			packet[random() % packet.size()] ^= (unsigned char)(1 << (random() % 8));
+		}
+		break;
+	case 1:
+		// a header field to anything
+		{
+			int field = (int)(random() % 4) * 2;
+			packet[field] = (unsigned char)random();
+			packet[field + 1] = (unsigned char)random();
+		}
+		break;
+	case 2:
+		// cut short or grown
+		packet.resize(random() % (packet.size() + 16));
+		break;
+	default:
+		// all random
+		for (size_t i = 0; i < packet.size(); i++)
+		{
+			packet[i] = (unsigned char)random();
+		}
+		break;
+	}
+}
+
+static void Fuzz(int transport, mt19937 &random)
+{
+	int size = PacketSize(transport);
+	int payloadSize = PacketPayloadSize(transport);
+	vector<unsigned char> data(PACKET_CODEC_MAX_DATA_SIZE);
+	vector<unsigned char> arena(PACKET_CODEC_MAX_PACKETS * size);
+	// the reassembler's buffer is on the heap at exactly its capacity too
+	unsigned char *buffer = new unsigned char[FUZZ_CAPACITY];
+	PacketReassembler reassembler;
+	InitReassembler(reassembler, transport, buffer, FUZZ_CAPACITY);
+	int decoded = 0;
+	int completed = 0;
+	for (int i = 0; i < FUZZ_PACKETS; i++)
+	{
+		// a valid packet of a random command, then mutated most of the time
+		int dataSize = (int)(random() % 6000);
+		int count = EncodeCommand(transport, (short)(random() & 0x7FFF), data.data(), dataSize, arena.data(), (int)arena.size());
+		int index = (int)(random() % count);
+		vector<unsigned char> packet(arena.begin() + index * size, arena.begin() + (index + 1) * size);
+		if (random() % 8 != 0)
+		{
+			Mutate(packet, random);
+		}
+		unsigned char *exact = new unsigned char[packet.size() + (packet.empty() ? 1 : 0)];
+		memcpy(exact, packet.data(), packet.size());
+
+		PacketView view;
+		int result = DecodePacket(transport, exact, (int)packet.size(), view);
+		if (result == 0)
+		{
+			decoded++;
+			if (view.PayloadSize < 0 || view.PayloadSize > payloadSize || view.Payload != exact + size - payloadSize)
+			{
+				Fail("payload", transport, view.PayloadSize);
+			}
+		}
+		else if (result != PACKET_ERROR_SIZE && result != PACKET_ERROR_HEADER)
+		{
+			Fail("decode result", transport, result);
+		}
+
+		result = AddPacket(reassembler, exact, (int)packet.size());
+		if (result == PACKET_COMPLETE)
+		{
+			completed++;
+			if (reassembler.Current.TotalDataSize > FUZZ_CAPACITY)
+			{
+				Fail("completed past capacity", transport, reassembler.Current.TotalDataSize);
+			}
+		}
+		else if (result != PACKET_INCOMPLETE && result != PACKET_ERROR_SIZE && result != PACKET_ERROR_HEADER &&
+			result != PACKET_ERROR_CAPACITY)
+		{
+			Fail("add result", transport, result);
+		}
+		delete[] exact;
+	}
+	delete[] buffer;
+	printf("transport %d: %d packets fuzzed, %d decoded, %d commands completed\n", transport, FUZZ_PACKETS,
+		decoded, completed);
+}
+
+static void Benchmark(int transport, int dataSize)
+{
+	int size = PacketSize(transport);
+	int count = PacketCount(transport, dataSize);
+	vector<unsigned char> data(dataSize, 0x5A);
+	vector<unsigned char> arena(count * size);
+	vector<unsigned char> buffer(dataSize);
+	PacketReassembler reassembler;
+	InitReassembler(reassembler, transport, buffer.data(), dataSize);
+	int commands = BENCHMARK_BYTES / dataSize;
+	unsigned int sink = 0;
+	long long start = NowMicros();
+	for (int i = 0; i < commands; i++)
+	{
+		EncodeCommand(transport, (short)(i & 0x7FFF), data.data(), dataSize, arena.data(), (int)arena.size());
+		for (int k = 0; k < count; k++)
+		{
+			sink += AddPacket(reassembler, arena.data() + k * size, size);
+		}
+		sink += buffer[i % dataSize];
+	}
+	long long elapsed = NowMicros() - start;
+	printf("transport %d, %5d byte commands: %.0f MB/s encoded and reassembled, %.0f ns per packet (%u)\n",
+		transport, dataSize, (double)commands * dataSize / elapsed, 1000.0 * elapsed / ((double)commands * count), sink);
+}
+
+int main()
+{
+	mt19937 random(1);
+	for (int transport = PACKET_USB; transport <= PACKET_ETHERNET; transport++)
+	{
+		RoundTrips(transport, random);
+		Fuzz(transport, random);
+	}
+	int sizes[] = { 56, 1456, 8192, PACKET_CODEC_MAX_DATA_SIZE };
+	for (int transport = PACKET_USB; transport <= PACKET_ETHERNET; transport++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			Benchmark(transport, sizes[i]);
+		}
+	}
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
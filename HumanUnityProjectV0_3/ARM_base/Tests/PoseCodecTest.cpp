@@ -0,0 +1,221 @@
+// Round trip and benchmark of the operator link's pose codec (PoseCodec.h).
+//
+// Both hands move like an operator's, sampled at 200 Hz, and go through an
+// encoder and decoder over a simulated link that loses frames and their
+// acknowledgements and acknowledges late. Every frame that arrives must
+// decode, to within the quantization steps, however many were lost before
+// it. Then the size per frame and bytes per second the link takes at each
+// loss rate, and the time an encode and a decode take.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O2 -I.. PoseCodecTest.cpp ../PoseCodec.cpp -o PoseCodecTest
+// Exits 0 when every frame comes back.
+
+#include "PoseCodec.h"
+#include "TeleopProtocol.h"
+#include "Timing.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+#define RATE 200
+#define FRAMES (60 * RATE)
+// frames sent before the acknowledgement of one comes back, 50 ms; the
+// older the baseline, the bigger the differences
+#define ACK_DELAY 10
+// half a step of each, and a little for float rounding
+#define MAX_POSITION_ERROR (0.5f / POSE_CODEC_POSITION_SCALE + 1e-6f)
+#define MAX_ANGLE_ERROR 0.002f
+#define BENCHMARK_FRAMES 2000000
+
+static int failures;
+
+static void Fail(const char *what, float loss, int frame, float value)
+{
+	if (failures < 20)
+	{
+		printf("FAIL %s, loss %.2f, frame %d: %f\n", what, loss, frame, value);
+	}
+	failures++;
+}
+
+static float AngleBetween(const Quat &a, const Quat &b)
+{
+	float d = fabsf(Dot(Normalize(a), Normalize(b)));
+	return 2.0f * acosf(d > 1.0f ? 1.0f : d);
+}
+
+// Hands sweeping through the workspace at up to about 1 m/s and 3 rad/s,
+// with some tremor, fingers closing now and then.
+static void Operator(int i, mt19937 &random, PoseFrame &frame)
+{
+	normal_distribution<float> tremor(0.0f, 0.0003f);
+	float t = (float)i / RATE;
+	memset(&frame, 0, sizeof(frame));
+	frame.Contents = POSE_FRAME_LEFT | POSE_FRAME_RIGHT;
+	for (int arm = 0; arm < 2; arm++)
+	{
+		float phase = arm * 1.3f;
+		frame.Hands[arm].Position = MakeVec3((arm == 0 ? -0.3f : 0.3f) + 0.2f * sinf(1.1f * t + phase) + tremor(random),
+			0.4f + 0.15f * sinf(0.7f * t + phase) + tremor(random), 0.3f * cosf(0.9f * t + phase) + tremor(random));
+		frame.Hands[arm].Orientation = FromKinovaEuler(1.5f * sinf(0.8f * t + phase), 0.6f * sinf(1.3f * t),
+			3.0f * sinf(0.5f * t + phase));
+		frame.Flags[arm] = (i / 700) % 2;
+		if ((i / 300) % 4 == arm)
+		{
+			frame.Contents |= POSE_FRAME_LEFT_FINGERS << arm;
+			frame.Fingers[arm] = (i / 50) & TELEOP_FINGERS_ALL;
+		}
+	}
+}
+
+static void Compare(const PoseFrame &sent, const PoseFrame &received, float loss, int i)
+{
+	if (received.Contents != sent.Contents)
+	{
+		Fail("contents", loss, i, (float)received.Contents);
+		return;
+	}
+	for (int arm = 0; arm < 2; arm++)
+	{
+		const Pose &a = sent.Hands[arm];
+		const Pose &b = received.Hands[arm];
+		float position = fmaxf(fmaxf(fabsf(a.Position.X - b.Position.X), fabsf(a.Position.Y - b.Position.Y)),
+			fabsf(a.Position.Z - b.Position.Z));
+		if (!(position <= MAX_POSITION_ERROR))
+		{
+			Fail("position", loss, i, position);
+		}
+		float angle = AngleBetween(a.Orientation, b.Orientation);
+		if (!(angle <= MAX_ANGLE_ERROR))
+		{
+			Fail("orientation", loss, i, angle);
+		}
+		if (received.Flags[arm] != sent.Flags[arm] || received.Fingers[arm] != sent.Fingers[arm])
+		{
+			Fail("flags or fingers", loss, i, (float)arm);
+		}
+	}
+}
+
+static void Link(float loss, int ackDelay)
+{
+	mt19937 random(1);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	ResetPoseEncoder(encoder);
+	ResetPoseDecoder(decoder);
+	// acknowledgements on their way back, by the frame they arrive at
+	unsigned int acks[ACK_DELAY];
+	bool ackValid[ACK_DELAY] = {};
+	long long bytes = 0;
+	int keyframes = 0;
+	int arrived = 0;
+	for (int i = 0; i < FRAMES; i++)
+	{
+		int slot = i % ackDelay;
+		if (ackValid[slot])
+		{
+			AcknowledgePoseFrame(encoder, acks[slot]);
+			ackValid[slot] = false;
+		}
+
+		PoseFrame sent;
+		Operator(i, random, sent);
+		unsigned char buffer[POSE_CODEC_MAX_SIZE];
+		bool keyframe;
+		int size = EncodePoseFrame(encoder, sent, buffer, sizeof(buffer), keyframe);
+		if (size < 0 || size > POSE_CODEC_MAX_SIZE)
+		{
+			Fail("encoded size", loss, i, (float)size);
+			continue;
+		}
+		bytes += size;
+		keyframes += keyframe ? 1 : 0;
+		if (unit(random) < loss)
+		{
+			continue;
+		}
+
+		arrived++;
+		PoseFrame received;
+		unsigned int frameId;
+		int result = DecodePoseFrame(decoder, buffer, size, received, frameId);
+		if (result != 0)
+		{
+			Fail("decode", loss, i, (float)result);
+			continue;
+		}
+		Compare(sent, received, loss, i);
+		if (unit(random) >= loss)
+		{
+			acks[slot] = frameId;
+			ackValid[slot] = true;
+		}
+	}
+	printf("loss %.2f, acknowledged %2d frames late: %d arrived, %.1f bytes per frame, %.1f%% keyframes, "
+		"%.0f bytes/s at %d Hz\n", loss, ackDelay, arrived, (double)bytes / FRAMES, 100.0 * keyframes / FRAMES,
+		(double)bytes * RATE / FRAMES, RATE);
+}
+
+static void Benchmark()
+{
+	mt19937 random(2);
+	static PoseFrame frames[1024];
+	for (int i = 0; i < 1024; i++)
+	{
+		Operator(i, random, frames[i]);
+	}
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	ResetPoseEncoder(encoder);
+	ResetPoseDecoder(decoder);
+	static unsigned char buffers[BENCHMARK_FRAMES / 1000][POSE_CODEC_MAX_SIZE];
+	static int sizes[BENCHMARK_FRAMES / 1000];
+	long long encoding = 0;
+	long long decoding = 0;
+	unsigned int sink = 0;
+	// a thousand frames at a time, acknowledged ACK_DELAY behind
+	for (int batch = 0; batch < 1000; batch++)
+	{
+		int count = BENCHMARK_FRAMES / 1000;
+		long long start = NowMicros();
+		for (int i = 0; i < count; i++)
+		{
+			if (i >= ACK_DELAY)
+			{
+				AcknowledgePoseFrame(encoder, buffers[i - ACK_DELAY][0] | (buffers[i - ACK_DELAY][1] << 8));
+			}
+			bool keyframe;
+			sizes[i] = EncodePoseFrame(encoder, frames[(batch * count + i) % 1024], buffers[i], POSE_CODEC_MAX_SIZE,
+				keyframe);
+		}
+		long long middle = NowMicros();
+		for (int i = 0; i < count; i++)
+		{
+			PoseFrame frame;
+			unsigned int frameId;
+			sink += DecodePoseFrame(decoder, buffers[i], sizes[i], frame, frameId) + frameId;
+		}
+		encoding += middle - start;
+		decoding += NowMicros() - middle;
+	}
+	printf("%.0f ns per encode, %.0f ns per decode (%u)\n", 1000.0 * encoding / BENCHMARK_FRAMES,
+		1000.0 * decoding / BENCHMARK_FRAMES, sink);
+}
+
+int main()
+{
+	Link(0.0f, 1);
+	float losses[] = { 0.0f, 0.05f, 0.2f, 0.5f };
+	for (int i = 0; i < 4; i++)
+	{
+		Link(losses[i], ACK_DELAY);
+	}
+	Benchmark();
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+// Round trip of Kinova Euler angles through quaternions (PoseMath.h), over
+// the whole ThetaY range and right at both poles, where ToKinovaEuler puts all
+// of the rotation on X.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O1 -I.. PoseMathTest.cpp -o PoseMathTest
+// Exits 0 when every orientation comes back.
+
+#include "PoseMath.h"
+#include <cstdio>
+
+// Two orientations are the same when their quaternions are, up to sign. The
+// Euler angles near a pole come back with ThetaZ folded into ThetaX, so the
+// angles themselves are not compared. The gimbal lock branch starts about
+// 0.014 rad short of the poles, and drops up to twice that.
+#define MAX_ANGLE_ERROR 0.03f
+
+static float AngleBetween(const Quat &a, const Quat &b)
+{
+	float d = fabsf(Dot(Normalize(a), Normalize(b)));
+	return 2.0f * acosf(d > 1.0f ? 1.0f : d);
+}
+
+static int failures;
+
+static void Check(float thetaX, float thetaY, float thetaZ)
+{
+	Quat q = FromKinovaEuler(thetaX, thetaY, thetaZ);
+	float x, y, z;
+	ToKinovaEuler(q, x, y, z);
+	float error = AngleBetween(q, FromKinovaEuler(x, y, z));
+	if (!(error <= MAX_ANGLE_ERROR))
+	{
+		if (failures < 20)
+		{
+			printf("FAIL (%f, %f, %f) -> (%f, %f, %f), off by %f\n", thetaX, thetaY, thetaZ, x, y, z, error);
+		}
+		failures++;
+	}
+}
+
+int main()
+{
+	const float pi = 3.14159265359f;
+	const int steps = 24;
+	int checked = 0;
+	for (int i = 0; i <= steps; i++)
+	{
+		float thetaX = -pi + 2.0f * pi * i / steps;
+		for (int k = 0; k <= steps; k++)
+		{
+			float thetaZ = -pi + 2.0f * pi * k / steps;
+			// ThetaY from pole to pole, both included
+			for (int j = 0; j <= 4 * steps; j++)
+			{
+				Check(thetaX, -0.5f * pi + pi * j / (4 * steps), thetaZ);
+				checked++;
+			}
+			// and just inside the poles, where the gimbal lock branch starts
+			for (int s = -1; s <= 1; s += 2)
+			{
+				Check(thetaX, s * (0.5f * pi - 0.01f), thetaZ);
+				Check(thetaX, s * (0.5f * pi - 0.001f), thetaZ);
+				Check(thetaX, s * 0.5f * pi, thetaZ);
+				checked += 3;
+			}
+		}
+	}
+	printf("%d orientations, %d failed\n", checked, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// Property test and benchmark of controller retargeting (Retarget.h).
+//
+// Random walks of the controller, from starts spread evenly over the whole
+// orientation sphere, through both arms at once (the right one mirrored).
+// Every step the Kinova angles must describe the retargeted orientation, and
+// away from gimbal lock they must move no more than the step allows: Euler
+// angles change by up to step / cos(ThetaY) for a rotation of step.
+//
+// Standalone, not part of the bridge project:
+//   g++ -std=c++14 -O2 -I.. RetargetTest.cpp ../Retarget.cpp -o RetargetTest -lpthread
+// Exits 0 when every step holds.
+
+#include "Retarget.h"
+#include "Timing.h"
+#include <cstdio>
+#include <random>
+
+using namespace std;
+
+#define WALKS 2000
+#define STEPS 500
+// rotation per step, radians; a controller turning 4 rad/s sampled at 200 Hz
+#define STEP_ANGLE 0.02f
+// |cos(ThetaY)| below this counts as gimbal lock, where the angles may swing
+#define GIMBAL_COS 0.2f
+#define MAX_ANGLE_ERROR 0.03f
+#define BENCHMARK_CALLS 1000000
+
+static int failures;
+
+static float AngleBetween(const Quat &a, const Quat &b)
+{
+	float d = fabsf(Dot(Normalize(a), Normalize(b)));
+	return 2.0f * acosf(d > 1.0f ? 1.0f : d);
+}
+
+// uniform over the sphere (Shoemake)
+static Quat RandomOrientation(mt19937 &random)
+{
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float twoPi = 6.28318530718f;
+	float u = unit(random), v = unit(random), w = unit(random);
+	float a = sqrtf(1.0f - u), b = sqrtf(u);
+	return MakeQuat(a * sinf(twoPi * v), a * cosf(twoPi * v), b * sinf(twoPi * w), b * cosf(twoPi * w));
+}
+
+static Quat RandomStep(mt19937 &random)
+{
+	normal_distribution<float> normal(0.0f, 1.0f);
+	Vec3 axis = MakeVec3(normal(random), normal(random), normal(random));
+	float length = Length(axis);
+	return ApplyRotation(MakeQuat(0.0f, 0.0f, 0.0f, 1.0f), Scale(axis, STEP_ANGLE / (length > 0.0f ? length : 1.0f)));
+}
+
+static void Fail(const char *what, int arm, const KinovaPose &before, const KinovaPose &after, float value)
+{
+	if (failures < 20)
+	{
+		printf("FAIL %s, arm %d: (%f, %f, %f) -> (%f, %f, %f): %f\n", what, arm, before.ThetaX, before.ThetaY,
+			before.ThetaZ, after.ThetaX, after.ThetaY, after.ThetaZ, value);
+	}
+	failures++;
+}
+
+static void CheckStep(int arm, const ControllerPose &controller, const KinovaPose &before, const KinovaPose &after,
+	bool first, int &locked)
+{
+	Pose target = RetargetPose(arm == 1, controller);
+	float error = AngleBetween(target.Orientation, FromKinovaEuler(after.ThetaX, after.ThetaY, after.ThetaZ));
+	if (!(error <= MAX_ANGLE_ERROR))
+	{
+		Fail("orientation", arm, before, after, error);
+	}
+	if (first)
+	{
+		return;
+	}
+	float cosY = fminf(fabsf(cosf(before.ThetaY)), fabsf(cosf(after.ThetaY)));
+	if (cosY < GIMBAL_COS)
+	{
+		locked++;
+		return;
+	}
+	// twice what the step allows on each angle, for the linearization
+	float allowed = 2.0f * STEP_ANGLE / cosY;
+	float jump = fmaxf(fmaxf(fabsf(after.ThetaX - before.ThetaX), fabsf(after.ThetaY - before.ThetaY)),
+		fabsf(after.ThetaZ - before.ThetaZ));
+	if (!(jump <= allowed))
+	{
+		Fail("jump", arm, before, after, jump);
+	}
+}
+
+static void PropertyTest()
+{
+	mt19937 random(1);
+	uniform_real_distribution<float> position(-1.0f, 1.0f);
+	int locked = 0;
+	for (int walk = 0; walk < WALKS; walk++)
+	{
+		ResetRetargetContinuity(false);
+		ResetRetargetContinuity(true);
+		ControllerPose controllers[2];
+		controllers[0].Position = MakeVec3(position(random), position(random), position(random));
+		controllers[0].Orientation = RandomOrientation(random);
+		controllers[1] = controllers[0];
+		KinovaPose before[2] = {};
+		KinovaPose after[2] = {};
+		for (int step = 0; step < STEPS; step++)
+		{
+			RetargetControllers(controllers, RETARGET_LEFT_ARM | RETARGET_RIGHT_ARM, after);
+			for (int arm = 0; arm < 2; arm++)
+			{
+				CheckStep(arm, controllers[arm], before[arm], after[arm], step == 0, locked);
+				before[arm] = after[arm];
+			}
+			controllers[0].Orientation = Normalize(Multiply(RandomStep(random), controllers[0].Orientation));
+			controllers[1].Orientation = controllers[0].Orientation;
+		}
+	}
+	printf("%d steps of both arms, %d in gimbal lock, %d failed\n", WALKS * STEPS, locked, failures);
+}
+
+static void Benchmark()
+{
+	mt19937 random(2);
+	ControllerPose controllers[2];
+	controllers[0].Position = MakeVec3(0.1f, 0.2f, 0.3f);
+	controllers[0].Orientation = RandomOrientation(random);
+	controllers[1] = controllers[0];
+	// a random walk from the same start over and over, like a hand; turning
+	// one way for ever would wind the continuous angles up without end
+	Quat start = controllers[0].Orientation;
+	static Quat steps[1024];
+	for (int i = 0; i < 1024; i++)
+	{
+		steps[i] = RandomStep(random);
+	}
+	KinovaPose poses[2];
+	float sink = 0.0f;
+	long long began = NowMicros();
+	for (int i = 0; i < BENCHMARK_CALLS; i++)
+	{
+		controllers[0].Orientation = i % 1024 == 0 ? start : Multiply(steps[i % 1024], controllers[0].Orientation);
+		controllers[1].Orientation = controllers[0].Orientation;
+		RetargetControllers(controllers, RETARGET_LEFT_ARM | RETARGET_RIGHT_ARM, poses);
+		sink += poses[0].ThetaX + poses[1].ThetaZ;
+	}
+	long long elapsed = NowMicros() - began;
+	printf("%.1f ns per call for both arms (%f)\n", 1000.0 * elapsed / BENCHMARK_CALLS, sink);
+}
+
+int main()
+{
+	PropertyTest();
+	Benchmark();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+// Loopback test of the operator link: a teleop server (TeleopServer.h) and
+// client (TeleopClient.h) in one process, talking over 127.0.0.1, first
+// directly and then through a lossy relay (LossyLink.h).
+//
+// The sink plays a slow arm that takes a new pose only every ARM_BUSY_MICROS.
+// Poses must reach it in the order they were sent and the newest one of each
+// arm last, however many were dropped on the way. Every stop, home and
+// fingers message must reach it exactly once, also when datagrams are lost,
+// delayed and reordered, and when one is sent twice. Malformed datagrams must
+// be counted and go no further. Every pose must be stamped with when it was
+// sent on the server's clock, also when the direct session is captured and
+// played back into the server with its original timing.
+//
+// Standalone, not part of the bridge project (Linux; on Windows link ws2_32):
+//   g++ -std=c++14 -O1 -g -fsanitize=address,undefined -I.. TeleopLoopbackTest.cpp ../TeleopServer.cpp
+//     ../TeleopClient.cpp ../TeleopProtocol.cpp ../TeleopCapture.cpp ../PoseCodec.cpp ../ClockSync.cpp
+//     ../ArmLease.cpp ../LossyLink.cpp ../UdpSocket.cpp -o TeleopLoopbackTest -lpthread
+// Exits 0 when every check holds.
+
+#include "LossyLink.h"
+#include "TeleopClient.h"
+#include "TeleopServer.h"
+#include "Timing.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+#define ARM_BUSY_MICROS 5000
+#define POSES 400
+#define POSE_PERIOD_MICROS 2000
+#define RELIABLE_ROUNDS 30
+// how long the client may take to get every reliable message through
+#define SETTLE_MICROS 3000000
+// how long before the sink a pose may have been sent: the relay's delay and
+// jitter, and waiting for the arm
+#define MAX_POSE_AGE_MICROS 50000
+#define CAPTURE_FILE "TeleopLoopbackTest.capture"
+
+static int failures;
+
+static void Check(bool ok, const char *what, long long value)
+{
+	if (!ok)
+	{
+		printf("FAIL %s: %lld\n", what, value);
+		failures++;
+	}
+}
+
+// What the sink has seen, written by the server's thread.
+static mutex sinkLock;
+static long long busyUntil[2];
+static int posesTaken[2];
+static float lastPose[2];
+static bool outOfOrder;
+static int stops[2];
+static int homes[2];
+static int fingerMessages[2];
+static int lastFingers[2];
+static long long minPoseAge;
+static long long maxPoseAge;
+
+static bool TakePose(bool rightArm, long long timestamp, int, const float *pose)
+{
+	lock_guard<mutex> lock(sinkLock);
+	int arm = rightArm ? 1 : 0;
+	long long now = NowMicros();
+	// a replay's clock runs with NowMicros(), it only starts later
+	minPoseAge = now - timestamp < minPoseAge ? now - timestamp : minPoseAge;
+	maxPoseAge = now - timestamp > maxPoseAge ? now - timestamp : maxPoseAge;
+	if (now < busyUntil[arm])
+	{
+		return false;
+	}
+	busyUntil[arm] = now + ARM_BUSY_MICROS;
+	// pose[0] counts up per arm on the client
+	if (posesTaken[arm] > 0 && !(pose[0] > lastPose[arm]))
+	{
+		outOfOrder = true;
+	}
+	lastPose[arm] = pose[0];
+	posesTaken[arm]++;
+	return true;
+}
+
+static void TakeStop(bool rightArm)
+{
+	lock_guard<mutex> lock(sinkLock);
+	stops[rightArm ? 1 : 0]++;
+}
+
+static void TakeHome(bool rightArm)
+{
+	lock_guard<mutex> lock(sinkLock);
+	homes[rightArm ? 1 : 0]++;
+}
+
+static void TakeFingers(bool rightArm, int fingers)
+{
+	lock_guard<mutex> lock(sinkLock);
+	fingerMessages[rightArm ? 1 : 0]++;
+	lastFingers[rightArm ? 1 : 0] = fingers;
+}
+
+static void ResetSink()
+{
+	lock_guard<mutex> lock(sinkLock);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		busyUntil[arm] = 0;
+		posesTaken[arm] = 0;
+		lastPose[arm] = 0.0f;
+		stops[arm] = 0;
+		homes[arm] = 0;
+		fingerMessages[arm] = 0;
+		lastFingers[arm] = 0;
+	}
+	outOfOrder = false;
+	minPoseAge = LLONG_MAX;
+	maxPoseAge = LLONG_MIN;
+}
+
+static void Sleep(long long micros)
+{
+	this_thread::sleep_for(chrono::microseconds(micros));
+}
+
+// Streams poses of both arms with stop, home and fingers in between, then
+// polls until nothing waits for acknowledgement.
+static void Session(const char *name)
+{
+	float next[2] = { 1.0f, 1.0f };
+	int reliableSent = 0;
+	for (int i = 0; i < POSES; i++)
+	{
+		bool rightArm = (i & 1) != 0;
+		float pose[6] = { next[rightArm ? 1 : 0], 0.3f, 0.5f, 3.1f, 0.2f, -1.5f };
+		next[rightArm ? 1 : 0] += 1.0f;
+		SendTeleopPose(rightArm, 0, pose);
+		if (i % (POSES / RELIABLE_ROUNDS) == 0 && reliableSent < RELIABLE_ROUNDS)
+		{
+			SendTeleopReliable(TELEOP_STOP, rightArm, 0);
+			SendTeleopReliable(TELEOP_HOME, !rightArm, 0);
+			SendTeleopReliable(TELEOP_FINGERS, rightArm, reliableSent & TELEOP_FINGERS_ALL);
+			reliableSent++;
+		}
+		PollTeleopClient();
+		Sleep(POSE_PERIOD_MICROS);
+	}
+	// until the retransmits are through, then give the arm time for its last move
+	long long settleEnd = NowMicros() + SETTLE_MICROS;
+	while (NowMicros() < settleEnd && PollTeleopClient() > 0)
+	{
+		Sleep(1000);
+	}
+	Sleep(2 * ARM_BUSY_MICROS + 20000);
+
+	TeleopClientStats client;
+	ReadTeleopClientStats(client);
+	TeleopServerStats server;
+	ReadTeleopServerStats(server);
+	lock_guard<mutex> lock(sinkLock);
+	printf("%s: %d poses sent, %d + %d taken; %d reliable sent, %u retransmits, ack mean %.0f us max %lld us; "
+		"server lost %u, stale %u, superseded %u, duplicates %u\n", name, POSES, posesTaken[0], posesTaken[1],
+		reliableSent * 3, client.Retransmits, client.MeanAckTime, client.MaxAckTime, server.Lost, server.PosesStale,
+		server.PosesSuperseded, server.Duplicates);
+
+	Check(!outOfOrder, "poses out of order", 0);
+	Check(minPoseAge >= 0 && maxPoseAge <= MAX_POSE_AGE_MICROS, "pose stamped in the future or past",
+		minPoseAge < 0 ? minPoseAge : maxPoseAge);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		Check(posesTaken[arm] > 0 && posesTaken[arm] <= POSES / 2, "poses taken", posesTaken[arm]);
+		// the last pose sent may be lost on a lossy link, then the one before wins
+		Check(lastPose[arm] >= next[arm] - 3.0f, "newest pose not taken last", (long long)(next[arm] - lastPose[arm]));
+	}
+	Check(client.Pending == 0, "reliable messages still pending", client.Pending);
+	Check(client.GaveUp == 0, "reliable messages given up", client.GaveUp);
+	Check(stops[0] + stops[1] == reliableSent, "stops taken", stops[0] + stops[1]);
+	Check(homes[0] + homes[1] == reliableSent, "homes taken", homes[0] + homes[1]);
+	Check(fingerMessages[0] + fingerMessages[1] == reliableSent, "fingers taken", fingerMessages[0] + fingerMessages[1]);
+}
+
+// A reliable datagram twice and malformed ones, straight from a socket.
+static void Datagrams(int port)
+{
+	UdpHandle socket = OpenUdpSocket(0);
+	UdpAddress server;
+	ResolveUdpAddress("127.0.0.1", port, server);
+	TeleopServerStats before;
+	ReadTeleopServerStats(before);
+
+	TeleopMessage message;
+	memset(&message, 0, sizeof(message));
+	message.Type = TELEOP_HOME;
+	message.Sequence = 1;
+	message.Timestamp = NowMicros();
+	message.RightArm = true;
+	message.ReliableId = 7;
+	unsigned char buffer[TELEOP_MAX_DATAGRAM];
+	int size = EncodeTeleopMessage(message, buffer, sizeof(buffer));
+	SendUdp(socket, server, buffer, size);
+	message.Sequence = 2;
+	size = EncodeTeleopMessage(message, buffer, sizeof(buffer));
+	SendUdp(socket, server, buffer, size);
+
+	// cut short, wrong magic, unknown type
+	SendUdp(socket, server, buffer, 3);
+	buffer[0] ^= 0xFF;
+	SendUdp(socket, server, buffer, size);
+	buffer[0] ^= 0xFF;
+	buffer[3] = 200;
+	SendUdp(socket, server, buffer, size);
+	Sleep(50000);
+	CloseUdpSocket(socket);
+
+	TeleopServerStats after;
+	ReadTeleopServerStats(after);
+	lock_guard<mutex> lock(sinkLock);
+	Check(homes[1] == 1, "home sent twice taken", homes[1]);
+	Check(after.Duplicates == before.Duplicates + 1, "duplicates", after.Duplicates - before.Duplicates);
+	Check(after.Malformed == before.Malformed + 3, "malformed", after.Malformed - before.Malformed);
+}
+
+// The captured direct session played back with its original timing, seconds
+// after it was taken.
+static void Replay(int directPoses)
+{
+	TeleopSink sink = { TakePose, NULL, TakeStop, TakeHome, TakeFingers };
+	Check(OpenTeleopReplay(CAPTURE_FILE, true, sink) == 0, "replay", 0);
+	TeleopServerStats stats;
+	do
+	{
+		Sleep(50000);
+		ReadTeleopServerStats(stats);
+	} while (stats.Replaying);
+	CloseTeleopServer();
+	remove(CAPTURE_FILE);
+
+	lock_guard<mutex> lock(sinkLock);
+	printf("replay: %d + %d poses taken, %d before; clock synced %d, pose age %lld to %lld us\n", posesTaken[0],
+		posesTaken[1], directPoses, stats.ClockSynced, minPoseAge, maxPoseAge);
+	Check(posesTaken[0] > 0 && posesTaken[1] > 0, "poses taken in the replay", posesTaken[0] + posesTaken[1]);
+	Check(stats.ClockSynced == 1, "replay synced no clock", 0);
+	Check(!outOfOrder, "poses out of order in the replay", 0);
+	Check(minPoseAge >= 0 && maxPoseAge <= MAX_POSE_AGE_MICROS, "replayed pose stamped in the future or past",
+		minPoseAge < 0 ? minPoseAge : maxPoseAge);
+}
+
+int main()
+{
+	TeleopSink sink = { TakePose, NULL, TakeStop, TakeHome, TakeFingers };
+	Check(OpenTeleopServer(0, sink) == 0, "server", 0);
+	TeleopServerStats stats;
+	ReadTeleopServerStats(stats);
+	int port = stats.Port;
+
+	ResetSink();
+	Check(OpenTeleopCapture(CAPTURE_FILE) == 0, "capture", 0);
+	Check(OpenTeleopClient("127.0.0.1", port) == 0, "client", 0);
+	Session("direct");
+	CloseTeleopClient();
+	CloseTeleopCapture();
+	int directPoses;
+	{
+		lock_guard<mutex> lock(sinkLock);
+		directPoses = posesTaken[0] + posesTaken[1];
+	}
+
+	// 20% lost in bursts, delayed and, with jitter above the pose period,
+	// reordered both ways; a new client through the relay is a new operator
+	ResetSink();
+	TeleopServerStats direct;
+	ReadTeleopServerStats(direct);
+	LossyLinkConfig config = { 0.2f, 2.0f, 2000, 10000 };
+	Check(OpenLossyLink(0, "127.0.0.1", port, config) == 0, "lossy link", 0);
+	LossyLinkStats link;
+	ReadLossyLinkStats(link);
+	Check(OpenTeleopClient("127.0.0.1", link.Port) == 0, "client through the lossy link", 0);
+	SetTeleopRedundancy(0, 0);
+	Session("lossy");
+	CloseTeleopClient();
+	ReadLossyLinkStats(link);
+	printf("lossy link: %u datagrams, %u dropped\n", link.Datagrams, link.Dropped);
+	Check(link.Dropped > 0, "lossy link dropped nothing", 0);
+	ReadTeleopServerStats(stats);
+	Check(stats.PosesStale > direct.PosesStale, "no pose came in late", 0);
+	CloseLossyLink();
+
+	ResetSink();
+	Datagrams(port);
+
+	CloseTeleopServer();
+
+	ResetSink();
+	Replay(directPoses);
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
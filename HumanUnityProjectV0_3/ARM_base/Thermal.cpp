@@ -0,0 +1,158 @@
+#include "Thermal.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+using namespace std;
+
+struct JointThermal
+{
+	float Measured;
+	float WindingRise;
+	float Trend;
+	float CurrentSquared;
+};
+
+struct ArmThermal
+{
+	bool Initialized;
+	long long Time;
+	JointThermal Joints[ARM_JOINT_COUNT];
+	ThermalStatus Status;
+};
+
+static mutex thermalLock;
+static ArmThermal arms[2];
+static atomic<float> scales[2] = { { 1.0f }, { 1.0f } };
+static atomic<bool> governorEnabled(true);
+
+static float ContinuousCurrent(int joint)
+{
+	return joint < 3 ? THERMAL_CONTINUOUS_CURRENT_LARGE : THERMAL_CONTINUOUS_CURRENT_SMALL;
+}
+
+// 1 at or under soft, 0 at or over hard.
+static float Remaining(float value, float soft, float hard)
+{
+	return max(0.0f, min(1.0f, (hard - value) / (hard - soft)));
+}
+
+void UpdateThermalModel(bool rightArm, const ArmSensors &sensors, const ArmEffort &effort)
+{
+	lock_guard<mutex> lock(thermalLock);
+	ArmThermal &arm = arms[rightArm ? 1 : 0];
+	float seconds = arm.Initialized ? (sensors.Timestamp - arm.Time) * 1e-6f : 0.0f;
+	if (arm.Initialized && seconds <= 0.0f)
+	{
+		return;
+	}
+
+	ThermalStatus &status = arm.Status;
+	status.Timestamp = sensors.Timestamp;
+	status.LimitingJoint = -1;
+	float target = 1.0f;
+	for (int j = 0; j < ARM_JOINT_COUNT; j++)
+	{
+		JointThermal &joint = arm.Joints[j];
+		float measured = sensors.Temperatures[j];
+		float current = effort.Currents[j];
+		if (measured <= 0.0f)
+		{
+			// no actuator there
+			status.Measured[j] = status.Estimated[j] = status.Forecast[j] = 0.0f;
+			status.RmsCurrent[j] = 0.0f;
+			status.Headroom[j] = 1.0f;
+			continue;
+		}
+
+		if (!arm.Initialized)
+		{
+			joint.Measured = measured;
+			joint.WindingRise = 0.0f;
+			joint.Trend = 0.0f;
+			// the RMS window fills up from zero, a single spike must not derate
+			joint.CurrentSquared = 0.0f;
+		}
+		else
+		{
+			// exact first order steps, so any refresh period works
+			float winding = 1.0f - expf(-seconds / THERMAL_WINDING_TIME_CONSTANT);
+			float trend = 1.0f - expf(-seconds / THERMAL_TREND_TIME_CONSTANT);
+			float window = 1.0f - expf(-seconds / THERMAL_CURRENT_TIME_CONSTANT);
+			joint.WindingRise += winding * (THERMAL_WINDING_RISE * current * current - joint.WindingRise);
+			joint.Trend += trend * ((measured - joint.Measured) / seconds - joint.Trend);
+			joint.CurrentSquared += window * (current * current - joint.CurrentSquared);
+			joint.Measured = measured;
+		}
+
+		status.Measured[j] = measured;
+		status.Estimated[j] = measured + joint.WindingRise;
+		status.Forecast[j] = status.Estimated[j] + max(0.0f, joint.Trend) * THERMAL_FORECAST_SECONDS;
+		status.RmsCurrent[j] = sqrtf(joint.CurrentSquared);
+
+		float rated = ContinuousCurrent(j);
+		status.Headroom[j] = min(Remaining(status.Forecast[j], THERMAL_SOFT_LIMIT, THERMAL_HARD_LIMIT),
+			Remaining(status.RmsCurrent[j], THERMAL_SOFT_CURRENT * rated, rated));
+		float scale = THERMAL_MIN_SCALE + (1.0f - THERMAL_MIN_SCALE) * status.Headroom[j];
+		if (scale < target)
+		{
+			target = scale;
+			status.LimitingJoint = j;
+		}
+	}
+
+	// drop at once, recover slowly so the arm does not oscillate around a limit
+	float scale = arm.Initialized ? min(target, status.Scale + THERMAL_RECOVERY_RATE * seconds) : target;
+	status.Scale = scale;
+	arm.Time = sensors.Timestamp;
+	arm.Initialized = true;
+	scales[rightArm ? 1 : 0] = governorEnabled ? scale : 1.0f;
+}
+
+float ThermalScale(bool rightArm)
+{
+	return scales[rightArm ? 1 : 0];
+}
+
+bool ReadThermalStatus(bool rightArm, ThermalStatus &status)
+{
+	lock_guard<mutex> lock(thermalLock);
+	const ArmThermal &arm = arms[rightArm ? 1 : 0];
+	status = arm.Status;
+	return arm.Initialized;
+}
+
+void SetThermalGovernor(bool enabled)
+{
+	lock_guard<mutex> lock(thermalLock);
+	governorEnabled = enabled;
+	for (int i = 0; i < 2; i++)
+	{
+		scales[i] = enabled && arms[i].Initialized ? arms[i].Status.Scale : 1.0f;
+	}
+}
+
+MotionLimits ThermalMotionLimits(bool rightArm, const MotionLimits &limits)
+{
+	float scale = ThermalScale(rightArm);
+	MotionLimits scaled = limits;
+	for (int i = 0; i < CARTESIAN_AXES; i++)
+	{
+		scaled.MaxVelocity[i] *= scale;
+		scaled.MaxAcceleration[i] *= scale;
+	}
+	return scaled;
+}
+
+JointMotionLimits ThermalJointMotionLimits(bool rightArm, const JointMotionLimits &limits)
+{
+	float scale = ThermalScale(rightArm);
+	JointMotionLimits scaled = limits;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		scaled.MaxVelocity[i] *= scale;
+		scaled.MaxAcceleration[i] *= scale;
+	}
+	return scaled;
+}
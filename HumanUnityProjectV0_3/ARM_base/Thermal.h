@@ -0,0 +1,78 @@
+#pragma once
+
+#include "StateCache.h"
+#include "Trajectory.h"
+
+// Thermal and current budget of the actuators. Every sensor refresh feeds the
+// measured actuator temperatures and motor currents into a small model per
+// joint:
+//
+//   winding rise  dW/dt = (THERMAL_WINDING_RISE * I^2 - W) / THERMAL_WINDING_TIME_CONSTANT
+//   estimated     = measured + W
+//   forecast      = estimated + rising trend * THERMAL_FORECAST_SECONDS
+//   RMS current   over about THERMAL_CURRENT_TIME_CONSTANT
+//
+// The arm's speed scale falls from 1 to THERMAL_MIN_SCALE as the hottest
+// forecast goes from THERMAL_SOFT_LIMIT to THERMAL_HARD_LIMIT, or the RMS
+// current of a joint from THERMAL_SOFT_CURRENT to 1 times its continuous
+// rating. Trajectory limits, Cartesian command speeds and the target stream's
+// command rate are all multiplied by it, so the arm slows down well before an
+// actuator faults.
+//
+// The constants are conservative guesses for the Jaco 2 actuators; tune them
+// on the arm with ThermalStatus.
+
+#define THERMAL_SOFT_LIMIT 55.0f
+#define THERMAL_HARD_LIMIT 70.0f
+#define THERMAL_MIN_SCALE 0.25f
+
+// Steady state winding rise over the case sensor, degrees C per A^2.
+#define THERMAL_WINDING_RISE 6.0f
+#define THERMAL_WINDING_TIME_CONSTANT 30.0f
+#define THERMAL_TREND_TIME_CONSTANT 30.0f
+#define THERMAL_FORECAST_SECONDS 60.0f
+#define THERMAL_CURRENT_TIME_CONSTANT 60.0f
+
+// Continuous current of the large (1 to 3) and small (4 to 7) actuators, A.
+#define THERMAL_CONTINUOUS_CURRENT_LARGE 1.5f
+#define THERMAL_CONTINUOUS_CURRENT_SMALL 0.8f
+// Fraction of the continuous current where derating starts.
+#define THERMAL_SOFT_CURRENT 0.8f
+
+// The scale drops right away but only recovers this much per second.
+#define THERMAL_RECOVERY_RATE 0.02f
+
+// Cartesian speeds MoveHand is limited to once the scale is under 1.
+#define THERMAL_NOMINAL_LINEAR_SPEED 0.15f
+#define THERMAL_NOMINAL_ANGULAR_SPEED 0.6f
+
+// Mirrored by KinovaAPI.ThermalStatus. Temperatures in degrees C, joints the
+// arm does not report a temperature for read 0.
+struct ThermalStatus
+{
+	long long Timestamp;
+	// what speeds and command rate are multiplied by, 1 when not derating
+	float Scale;
+	// joint setting the scale, -1 when none is over its soft limit
+	int LimitingJoint;
+	float Measured[ARM_JOINT_COUNT];
+	float Estimated[ARM_JOINT_COUNT];
+	float Forecast[ARM_JOINT_COUNT];
+	float RmsCurrent[ARM_JOINT_COUNT];
+	// 1 with the joint under both soft limits, 0 at a hard limit
+	float Headroom[ARM_JOINT_COUNT];
+};
+
+void UpdateThermalModel(bool rightArm, const ArmSensors &sensors, const ArmEffort &effort);
+
+// Lock free, cheap enough for every command.
+float ThermalScale(bool rightArm);
+
+// Returns false until the arm's sensors were read.
+bool ReadThermalStatus(bool rightArm, ThermalStatus &status);
+
+// Disabled, the model keeps running but the scale stays at 1.
+void SetThermalGovernor(bool enabled);
+
+MotionLimits ThermalMotionLimits(bool rightArm, const MotionLimits &limits);
+JointMotionLimits ThermalJointMotionLimits(bool rightArm, const JointMotionLimits &limits);
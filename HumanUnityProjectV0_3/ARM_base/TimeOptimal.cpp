@@ -0,0 +1,270 @@
+#include "TimeOptimal.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// grid spacing aimed for, degrees of joint space path length
+#define TOPP_GRID_STEP 1.0f
+#define TOPP_EPSILON 1e-6f
+// path speed squared when no joint limits it (the path does not move there)
+#define TOPP_UNBOUNDED 1e12f
+
+// a * u + b * x <= c, u = path acceleration, x = path speed squared
+struct Constraint
+{
+	float A;
+	float B;
+	float C;
+};
+
+struct GridPoint
+{
+	float Along;
+	// dq/ds and d2q/ds2
+	float First[ARM_DOF];
+	float Second[ARM_DOF];
+	float MaxSpeedSquared;
+};
+
+static float Distance(const JointConfig &a, const JointConfig &b)
+{
+	float sum = 0.0f;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		float d = b.Angles[i] - a.Angles[i];
+		sum += d * d;
+	}
+	return sqrtf(sum);
+}
+
+// Resamples the polyline so every vertex is also a grid point.
+static void BuildGrid(const vector<JointConfig> &path, vector<JointConfig> &points, vector<float> &along)
+{
+	float total = 0.0f;
+	for (size_t k = 1; k < path.size(); k++)
+	{
+		total += Distance(path[k - 1], path[k]);
+	}
+	int intervals = (int)ceilf(total / TOPP_GRID_STEP);
+	intervals = max(TOPP_MIN_GRID_POINTS - 1, min(TOPP_MAX_GRID_POINTS - 1, intervals));
+
+	points.assign(1, path.front());
+	along.assign(1, 0.0f);
+	for (size_t k = 1; k < path.size(); k++)
+	{
+		float length = Distance(path[k - 1], path[k]);
+		if (length < TOPP_EPSILON)
+		{
+			continue;
+		}
+		int steps = max(1, (int)floorf(intervals * length / total + 0.5f));
+		for (int n = 1; n <= steps; n++)
+		{
+			points.push_back(LerpJoints(path[k - 1], path[k], (float)n / steps));
+			along.push_back(along.back() + length / steps);
+		}
+	}
+}
+
+static void Derivatives(const vector<JointConfig> &points, const vector<float> &along, const float *maxVelocity,
+	vector<GridPoint> &grid)
+{
+	size_t count = points.size();
+	grid.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t before = i > 0 ? i - 1 : i;
+		size_t after = i + 1 < count ? i + 1 : i;
+		GridPoint &point = grid[i];
+		point.Along = along[i];
+		point.MaxSpeedSquared = TOPP_UNBOUNDED;
+
+		for (int j = 0; j < ARM_DOF; j++)
+		{
+			point.First[j] = (points[after].Angles[j] - points[before].Angles[j]) / (along[after] - along[before]);
+			point.Second[j] = 0.0f;
+			if (before != i && after != i)
+			{
+				float slopeBefore = (points[i].Angles[j] - points[before].Angles[j]) / (along[i] - along[before]);
+				float slopeAfter = (points[after].Angles[j] - points[i].Angles[j]) / (along[after] - along[i]);
+				point.Second[j] = 2.0f * (slopeAfter - slopeBefore) / (along[after] - along[before]);
+			}
+			if (fabsf(point.First[j]) > TOPP_EPSILON)
+			{
+				float limit = maxVelocity[j] / fabsf(point.First[j]);
+				point.MaxSpeedSquared = min(point.MaxSpeedSquared, limit * limit);
+			}
+		}
+	}
+}
+
+// Range of u allowed by the joint accelerations at speed squared x.
+static void ControlRange(const GridPoint &point, const float *maxAcceleration, float x, float &low, float &high)
+{
+	low = -TOPP_UNBOUNDED;
+	high = TOPP_UNBOUNDED;
+	for (int j = 0; j < ARM_DOF; j++)
+	{
+		float a = point.First[j];
+		if (fabsf(a) < TOPP_EPSILON)
+		{
+			continue;
+		}
+		// -max <= a u + b x <= max
+		float u1 = (maxAcceleration[j] - point.Second[j] * x) / a;
+		float u2 = (-maxAcceleration[j] - point.Second[j] * x) / a;
+		low = max(low, min(u1, u2));
+		high = min(high, max(u1, u2));
+	}
+}
+
+// Smallest and largest x at point from which some allowed u lands inside
+// [nextLow, nextHigh] at the next point, delta further along. A two variable
+// linear program, solved by checking every vertex.
+static bool ControllableRange(const GridPoint &point, const float *maxAcceleration, float delta,
+	float nextLow, float nextHigh, float &low, float &high)
+{
+	Constraint constraints[2 * ARM_DOF + 4];
+	int count = 0;
+	for (int j = 0; j < ARM_DOF; j++)
+	{
+		Constraint upper = { point.First[j], point.Second[j], maxAcceleration[j] };
+		Constraint lower = { -point.First[j], -point.Second[j], maxAcceleration[j] };
+		constraints[count++] = upper;
+		constraints[count++] = lower;
+	}
+	Constraint positive = { 0.0f, -1.0f, 0.0f };
+	Constraint fast = { 0.0f, 1.0f, point.MaxSpeedSquared };
+	Constraint reachHigh = { 2.0f * delta, 1.0f, nextHigh };
+	Constraint reachLow = { -2.0f * delta, -1.0f, -nextLow };
+	constraints[count++] = positive;
+	constraints[count++] = fast;
+	constraints[count++] = reachHigh;
+	constraints[count++] = reachLow;
+
+	bool found = false;
+	for (int m = 0; m < count; m++)
+	{
+		for (int n = m + 1; n < count; n++)
+		{
+			const Constraint &p = constraints[m];
+			const Constraint &q = constraints[n];
+			double determinant = (double)p.A * q.B - (double)p.B * q.A;
+			if (fabs(determinant) < 1e-12)
+			{
+				continue;
+			}
+			double u = ((double)p.C * q.B - (double)p.B * q.C) / determinant;
+			double x = ((double)p.A * q.C - (double)p.C * q.A) / determinant;
+
+			bool feasible = true;
+			for (int k = 0; k < count && feasible; k++)
+			{
+				double slack = constraints[k].C - constraints[k].A * u - constraints[k].B * x;
+				feasible = slack >= -1e-4 * (1.0 + fabs(constraints[k].C));
+			}
+			if (!feasible)
+			{
+				continue;
+			}
+			if (!found)
+			{
+				low = high = (float)x;
+				found = true;
+			}
+			low = min(low, (float)x);
+			high = max(high, (float)x);
+		}
+	}
+	low = max(0.0f, low);
+	return found;
+}
+
+bool TimeOptimalTiming(const vector<JointConfig> &path, const float *maxVelocity, const float *maxAcceleration,
+	TimedPath &timed)
+{
+	timed.Points.clear();
+	timed.Times.clear();
+	timed.SpeedSquared.clear();
+	timed.Along.clear();
+	if (path.empty())
+	{
+		return false;
+	}
+
+	BuildGrid(path, timed.Points, timed.Along);
+	size_t count = timed.Points.size();
+	if (count == 1)
+	{
+		timed.Times.push_back(0.0f);
+		timed.SpeedSquared.push_back(0.0f);
+		return true;
+	}
+
+	vector<GridPoint> grid;
+	Derivatives(timed.Points, timed.Along, maxVelocity, grid);
+
+	// backward pass: controllable speeds, ending at rest
+	vector<float> low(count, 0.0f);
+	vector<float> high(count, 0.0f);
+	for (size_t i = count - 1; i-- > 0;)
+	{
+		float delta = grid[i + 1].Along - grid[i].Along;
+		if (!ControllableRange(grid[i], maxAcceleration, delta, low[i + 1], high[i + 1], low[i], high[i]))
+		{
+			return false;
+		}
+	}
+	if (low[0] > TOPP_EPSILON)
+	{
+		return false;
+	}
+
+	// forward pass: greedy, as fast as the next controllable range allows
+	timed.SpeedSquared.assign(count, 0.0f);
+	timed.Times.assign(count, 0.0f);
+	for (size_t i = 0; i + 1 < count; i++)
+	{
+		float x = timed.SpeedSquared[i];
+		float delta = grid[i + 1].Along - grid[i].Along;
+		float uLow;
+		float uHigh;
+		ControlRange(grid[i], maxAcceleration, x, uLow, uHigh);
+		float u = min(uHigh, (high[i + 1] - x) / (2.0f * delta));
+		u = max(u, max(uLow, (low[i + 1] - x) / (2.0f * delta)));
+
+		float next = max(low[i + 1], min(high[i + 1], x + 2.0f * delta * u));
+		timed.SpeedSquared[i + 1] = next;
+
+		float speeds = sqrtf(x) + sqrtf(next);
+		if (speeds < TOPP_EPSILON)
+		{
+			return false;
+		}
+		timed.Times[i + 1] = timed.Times[i] + 2.0f * delta / speeds;
+	}
+	return true;
+}
+
+JointConfig SampleTimedPath(const TimedPath &timed, float time)
+{
+	if (time <= 0.0f || timed.Points.size() == 1)
+	{
+		return timed.Points.front();
+	}
+	if (time >= timed.Times.back())
+	{
+		return timed.Points.back();
+	}
+
+	size_t i = upper_bound(timed.Times.begin(), timed.Times.end(), time) - timed.Times.begin() - 1;
+	float delta = timed.Along[i + 1] - timed.Along[i];
+	float x = timed.SpeedSquared[i];
+	// path acceleration is constant between grid points
+	float u = (timed.SpeedSquared[i + 1] - x) / (2.0f * delta);
+	float tau = time - timed.Times[i];
+	float travelled = sqrtf(x) * tau + 0.5f * u * tau * tau;
+	float t = max(0.0f, min(1.0f, travelled / delta));
+	return LerpJoints(timed.Points[i], timed.Points[i + 1], t);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Kinematics.h"
+#include <vector>
+
+// Time optimal timing along a joint space path under per joint velocity and
+// acceleration limits, after TOPP-RA (Pham and Pham, 2018): a backward pass
+// finds how fast the arm may go at each grid point and still stop in time, a
+// forward pass then accelerates as hard as that allows.
+
+// The path is resampled to between these many grid points.
+#define TOPP_MIN_GRID_POINTS 50
+#define TOPP_MAX_GRID_POINTS 200
+
+// Samples of the timed path: joints at each grid point and the time in seconds
+// the arm should be there. Starts and ends at rest.
+struct TimedPath
+{
+	std::vector<JointConfig> Points;
+	std::vector<float> Times;
+	// path parameter speed squared at each point, for resampling
+	std::vector<float> SpeedSquared;
+	std::vector<float> Along;
+};
+
+// maxVelocity in deg/s and maxAcceleration in deg/s^2, ARM_DOF values each.
+// Returns false when the path is empty or no timing satisfies the limits.
+bool TimeOptimalTiming(const std::vector<JointConfig> &path, const float *maxVelocity, const float *maxAcceleration,
+	TimedPath &timed);
+
+// Joints at time seconds into a timed path.
+JointConfig SampleTimedPath(const TimedPath &timed, float time);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <chrono>
+
+// Monotonic time in microseconds. Every timestamp the bridge hands back to
+// Unity (command submit/start/end, ...) is on this clock so they can be
+// subtracted from each other directly.
+inline long long NowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
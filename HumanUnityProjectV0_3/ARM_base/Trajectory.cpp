@@ -0,0 +1,243 @@
+#include "Trajectory.h"
+#include "PoseMath.h"
+#include "TimeOptimal.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// For s(t) = 10 t^3 - 15 t^4 + 6 t^5 over a move of length D and duration T,
+// peak velocity is 1.875 D / T and peak acceleration 5.7735 D / T^2.
+#define MIN_JERK_PEAK_VELOCITY 1.875f
+#define MIN_JERK_PEAK_ACCELERATION 5.7735f
+
+static float MinimumJerk(float t)
+{
+	return t * t * t * (10.0f + t * (-15.0f + t * 6.0f));
+}
+
+static float AxisDuration(float distance, float maxVelocity, float maxAcceleration)
+{
+	distance = fabsf(distance);
+	if (distance <= 0.0f)
+	{
+		return 0.0f;
+	}
+	float byVelocity = MIN_JERK_PEAK_VELOCITY * distance / maxVelocity;
+	float byAcceleration = sqrtf(MIN_JERK_PEAK_ACCELERATION * distance / maxAcceleration);
+	return max(byVelocity, byAcceleration);
+}
+
+MotionLimits DefaultMotionLimits()
+{
+	// well inside the Jaco 2 Cartesian limits
+	MotionLimits limits;
+	for (int i = 0; i < 3; i++)
+	{
+		limits.MaxVelocity[i] = 0.15f;
+		limits.MaxAcceleration[i] = 0.4f;
+		limits.MaxVelocity[i + 3] = 0.6f;
+		limits.MaxAcceleration[i + 3] = 1.5f;
+	}
+	return limits;
+}
+
+JointMotionLimits DefaultJointMotionLimits()
+{
+	JointMotionLimits limits;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		limits.MaxVelocity[i] = JointMaxVelocity(i);
+		limits.MaxAcceleration[i] = JointMaxAcceleration(i);
+	}
+	return limits;
+}
+
+static Quat Orientation(const float pose[CARTESIAN_AXES])
+{
+	return FromKinovaEuler(pose[3], pose[4], pose[5]);
+}
+
+float MinimumJerkDuration(const float start[CARTESIAN_AXES], const float goal[CARTESIAN_AXES], const MotionLimits &limits)
+{
+	float duration = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		duration = max(duration, AxisDuration(goal[i] - start[i], limits.MaxVelocity[i], limits.MaxAcceleration[i]));
+	}
+
+	float angularVelocity = min(limits.MaxVelocity[3], min(limits.MaxVelocity[4], limits.MaxVelocity[5]));
+	float angularAcceleration = min(limits.MaxAcceleration[3], min(limits.MaxAcceleration[4], limits.MaxAcceleration[5]));
+	float angle = Length(RotationBetween(Orientation(start), Orientation(goal)));
+	return max(duration, AxisDuration(angle, angularVelocity, angularAcceleration));
+}
+
+void GenerateMinimumJerk(const float start[CARTESIAN_AXES], const float goal[CARTESIAN_AXES], const MotionLimits &limits,
+	float spacing, vector<Waypoint> &waypoints)
+{
+	waypoints.clear();
+	float duration = MinimumJerkDuration(start, goal, limits);
+	int count = max(1, (int)ceilf(duration / spacing));
+	waypoints.reserve(count);
+
+	Quat from = Orientation(start);
+	Quat to = Orientation(goal);
+	Vec3 startPosition = MakeVec3(start[0], start[1], start[2]);
+	Vec3 goalPosition = MakeVec3(goal[0], goal[1], goal[2]);
+
+	float previous[CARTESIAN_AXES];
+	copy(start, start + CARTESIAN_AXES, previous);
+	Quat previousOrientation = from;
+	float dt = duration / count;
+
+	for (int k = 1; k <= count; k++)
+	{
+		float s = MinimumJerk((float)k / count);
+		Vec3 position = Lerp(startPosition, goalPosition, s);
+		Quat orientation = Slerp(from, to, s);
+
+		Waypoint point;
+		point.Time = k * dt;
+		point.Angular = false;
+		point.Pose[0] = position.X;
+		point.Pose[1] = position.Y;
+		point.Pose[2] = position.Z;
+		ToKinovaEuler(orientation, point.Pose[3], point.Pose[4], point.Pose[5]);
+		for (int i = 3; i < CARTESIAN_AXES; i++)
+		{
+			point.Pose[i] = UnwrapAngle(point.Pose[i], previous[i]);
+		}
+
+		if (dt > 0.0f)
+		{
+			float travelled = Length(Sub(position, MakeVec3(previous[0], previous[1], previous[2])));
+			float turned = Length(RotationBetween(previousOrientation, orientation));
+			point.LinearSpeed = max(TRAJECTORY_MIN_LINEAR_SPEED, travelled / dt);
+			point.AngularSpeed = max(TRAJECTORY_MIN_ANGULAR_SPEED, turned / dt);
+		}
+		else
+		{
+			point.LinearSpeed = TRAJECTORY_MIN_LINEAR_SPEED;
+			point.AngularSpeed = TRAJECTORY_MIN_ANGULAR_SPEED;
+		}
+
+		waypoints.push_back(point);
+		copy(point.Pose, point.Pose + CARTESIAN_AXES, previous);
+		previousOrientation = orientation;
+	}
+
+	// land exactly on the requested pose, angles included
+	for (int i = 0; i < CARTESIAN_AXES; i++)
+	{
+		waypoints.back().Pose[i] = i < 3 ? goal[i] : UnwrapAngle(goal[i], waypoints.back().Pose[i]);
+	}
+}
+
+// Path length in seconds at full speed (or in seconds squared at full
+// acceleration): each segment counts as long as its slowest joint needs.
+static float ScaledLength(const JointConfig &a, const JointConfig &b, const float *limit)
+{
+	float length = 0.0f;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		length = max(length, fabsf(b.Angles[i] - a.Angles[i]) / limit[i]);
+	}
+	return length;
+}
+
+float JointPathDuration(const vector<JointConfig> &path, const JointMotionLimits &limits)
+{
+	float byVelocity = 0.0f;
+	float byAcceleration = 0.0f;
+	for (size_t i = 1; i < path.size(); i++)
+	{
+		byVelocity += ScaledLength(path[i - 1], path[i], limits.MaxVelocity);
+		byAcceleration += ScaledLength(path[i - 1], path[i], limits.MaxAcceleration);
+	}
+	// same peaks as AxisDuration with every limit normalized to 1
+	return max(MIN_JERK_PEAK_VELOCITY * byVelocity, sqrtf(MIN_JERK_PEAK_ACCELERATION * byAcceleration));
+}
+
+static Waypoint JointWaypoint(const JointConfig &joints, const JointConfig &previous, float time, float dt)
+{
+	Waypoint point;
+	point.Time = time;
+	point.Angular = true;
+	point.LinearSpeed = TRAJECTORY_MIN_JOINT_SPEED;
+	point.AngularSpeed = TRAJECTORY_MIN_JOINT_SPEED;
+	for (int i = 0; i < ARM_DOF; i++)
+	{
+		point.Pose[i] = joints.Angles[i];
+		float speed = dt > 0.0f ? fabsf(joints.Angles[i] - previous.Angles[i]) / dt : 0.0f;
+		float &group = i < 3 ? point.LinearSpeed : point.AngularSpeed;
+		group = max(group, speed);
+	}
+	return point;
+}
+
+static void GenerateMinimumJerkJointPath(const vector<JointConfig> &path, const JointMotionLimits &limits,
+	float spacing, vector<Waypoint> &waypoints)
+{
+	// cumulative path parameter at every vertex
+	vector<float> along(path.size(), 0.0f);
+	for (size_t i = 1; i < path.size(); i++)
+	{
+		along[i] = along[i - 1] + ScaledLength(path[i - 1], path[i], limits.MaxVelocity);
+	}
+	float total = along.back();
+	float duration = JointPathDuration(path, limits);
+	int count = max(1, (int)ceilf(duration / spacing));
+	waypoints.reserve(count);
+	float dt = duration / count;
+
+	JointConfig previous = path.front();
+	size_t segment = 1;
+	for (int k = 1; k <= count; k++)
+	{
+		float target = MinimumJerk((float)k / count) * total;
+		while (segment < path.size() - 1 && along[segment] < target)
+		{
+			segment++;
+		}
+
+		JointConfig joints = path.back();
+		if (k < count && path.size() > 1)
+		{
+			float length = along[segment] - along[segment - 1];
+			float t = length > 0.0f ? (target - along[segment - 1]) / length : 1.0f;
+			joints = LerpJoints(path[segment - 1], path[segment], min(1.0f, max(0.0f, t)));
+		}
+
+		waypoints.push_back(JointWaypoint(joints, previous, k * dt, dt));
+		previous = joints;
+	}
+}
+
+void GenerateJointPath(const vector<JointConfig> &path, const JointMotionLimits &limits,
+	float spacing, vector<Waypoint> &waypoints)
+{
+	waypoints.clear();
+	if (path.empty())
+	{
+		return;
+	}
+
+	TimedPath timed;
+	if (!TimeOptimalTiming(path, limits.MaxVelocity, limits.MaxAcceleration, timed))
+	{
+		GenerateMinimumJerkJointPath(path, limits, spacing, waypoints);
+		return;
+	}
+
+	float duration = timed.Times.back();
+	int count = max(1, (int)ceilf(duration / spacing));
+	waypoints.reserve(count);
+	float dt = duration / count;
+	JointConfig previous = path.front();
+	for (int k = 1; k <= count; k++)
+	{
+		JointConfig joints = k < count ? SampleTimedPath(timed, k * dt) : path.back();
+		waypoints.push_back(JointWaypoint(joints, previous, k * dt, dt));
+		previous = joints;
+	}
+}
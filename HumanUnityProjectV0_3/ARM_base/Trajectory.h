@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Kinematics.h"
+#include <vector>
+
+// Minimum jerk (quintic) moves between two Cartesian poses, or along a joint
+// space path.
+// Poses are { X, Y, Z, ThetaX, ThetaY, ThetaZ } in meters and radians, the
+// same order as Kinova's CartesianInfo.
+
+#define CARTESIAN_AXES 6
+
+// Per axis limits. Translation axes in m/s and m/s^2. The orientation is
+// interpolated as a single rotation, which has to stay under the smallest of
+// the three angular limits (rad/s and rad/s^2).
+struct MotionLimits
+{
+	float MaxVelocity[CARTESIAN_AXES];
+	float MaxAcceleration[CARTESIAN_AXES];
+};
+
+// Per joint limits in deg/s and deg/s^2.
+struct JointMotionLimits
+{
+	float MaxVelocity[ARM_DOF];
+	float MaxAcceleration[ARM_DOF];
+};
+
+struct Waypoint
+{
+	// seconds from the start of the move
+	float Time;
+	// when Angular is set, Pose holds actuator angles 1 to 6 in degrees
+	bool Angular;
+	float Pose[CARTESIAN_AXES];
+	// speed needed to reach this waypoint from the previous one on time,
+	// sent to the arm as the point's Limitations. For angular waypoints these
+	// are the fastest of actuators 1-3 and 4-6, in deg/s, like Kinova's
+	// speedParameter1 and speedParameter2.
+	float LinearSpeed;
+	float AngularSpeed;
+};
+
+// Waypoints are this far apart in time.
+#define TRAJECTORY_WAYPOINT_SPACING 0.02f
+
+// The arm is never asked to go slower than this between waypoints, otherwise
+// the start and end of a move crawl.
+#define TRAJECTORY_MIN_LINEAR_SPEED 0.01f
+#define TRAJECTORY_MIN_ANGULAR_SPEED 0.05f
+
+// Slowest joint speed asked for between angular waypoints, deg/s.
+#define TRAJECTORY_MIN_JOINT_SPEED 2.0f
+
+MotionLimits DefaultMotionLimits();
+JointMotionLimits DefaultJointMotionLimits();
+
+// Shortest duration in seconds of a minimum jerk move from start to goal that
+// stays within limits.
+float MinimumJerkDuration(const float start[CARTESIAN_AXES], const float goal[CARTESIAN_AXES], const MotionLimits &limits);
+
+// Replaces waypoints with the samples of a minimum jerk move, spacing seconds
+// apart, ending exactly on goal. The start pose itself is not included.
+void GenerateMinimumJerk(const float start[CARTESIAN_AXES], const float goal[CARTESIAN_AXES], const MotionLimits &limits,
+	float spacing, std::vector<Waypoint> &waypoints);
+
+// Shortest duration in seconds of a minimum jerk move along the joint space
+// polyline path that stays within limits.
+float JointPathDuration(const std::vector<JointConfig> &path, const JointMotionLimits &limits);
+
+// Replaces waypoints with angular waypoints spacing seconds apart along path,
+// timed as fast as limits allow (see TimeOptimal.h). Falls back to a minimum
+// jerk profile over the whole path length if that fails.
+void GenerateJointPath(const std::vector<JointConfig> &path, const JointMotionLimits &limits,
+	float spacing, std::vector<Waypoint> &waypoints);
@@ -0,0 +1,131 @@
+#include "TrajectoryStreamer.h"
+#include "CommandQueue.h"
+#include "Timing.h"
+#include "Lib_Examples\CommunicationLayerWindows.h"
+#include <mutex>
+
+using namespace std;
+
+struct WaypointStream
+{
+	bool Active;
+	// erase what is left of the previous move before sending the first point
+	bool EraseFirst;
+	unsigned int CommandId;
+	long long SubmitTime;
+	long long StartTime;
+	vector<Waypoint> Points;
+	size_t Next;
+};
+
+static mutex streamLock;
+static WaypointStream streams[2];
+
+static WaypointStream &StreamFor(bool rightArm)
+{
+	return streams[rightArm ? 1 : 0];
+}
+
+// Lock must be held.
+static void Finish(WaypointStream &stream, int result)
+{
+	if (!stream.Active)
+	{
+		return;
+	}
+	CommandCompletion completion;
+	completion.Id = stream.CommandId;
+	completion.Result = result;
+	completion.SubmitTime = stream.SubmitTime;
+	completion.StartTime = stream.StartTime != 0 ? stream.StartTime : NowMicros();
+	completion.EndTime = NowMicros();
+	PostCompletion(completion);
+
+	stream.Active = false;
+	stream.Points.clear();
+	stream.Next = 0;
+}
+
+void StartWaypointStream(bool rightArm, unsigned int commandId, long long submitTime, vector<Waypoint> &waypoints)
+{
+	lock_guard<mutex> lock(streamLock);
+	WaypointStream &stream = StreamFor(rightArm);
+	Finish(stream, ERROR_OPERATION_INCOMPLETED);
+
+	stream.Active = true;
+	stream.EraseFirst = true;
+	stream.CommandId = commandId;
+	stream.SubmitTime = submitTime;
+	stream.StartTime = 0;
+	stream.Points.swap(waypoints);
+	stream.Next = 0;
+}
+
+void CancelWaypointStream(bool rightArm)
+{
+	lock_guard<mutex> lock(streamLock);
+	Finish(StreamFor(rightArm), ERROR_OPERATION_INCOMPLETED);
+}
+
+bool WaypointStreamActive(bool rightArm)
+{
+	lock_guard<mutex> lock(streamLock);
+	return StreamFor(rightArm).Active;
+}
+
+static void Feed(bool rightArm, WaypointStream &stream, const FifoOps &ops)
+{
+	int result = ops.SelectArm(rightArm);
+	if (result == 0 && stream.EraseFirst)
+	{
+		result = ops.EraseFifo();
+		stream.EraseFirst = false;
+		stream.StartTime = NowMicros();
+	}
+
+	unsigned int queued = 0;
+	if (result == 0)
+	{
+		result = ops.GetFifoCount(queued);
+	}
+	if (result != 0)
+	{
+		Finish(stream, result);
+		return;
+	}
+
+	if (stream.Next == stream.Points.size())
+	{
+		// everything was sent, done once the robot has played it all
+		if (queued == 0)
+		{
+			Finish(stream, 0);
+		}
+		return;
+	}
+
+	while (queued < TRAJECTORY_FIFO_LOOKAHEAD && stream.Next < stream.Points.size())
+	{
+		result = ops.SendWaypoint(stream.Points[stream.Next]);
+		if (result != 0)
+		{
+			Finish(stream, result);
+			return;
+		}
+		stream.Next++;
+		queued++;
+	}
+}
+
+void FeedWaypointStreams(const FifoOps &ops)
+{
+	// held across the Kinova calls so a new stream can't slip in half way
+	lock_guard<mutex> lock(streamLock);
+	for (int arm = 0; arm < 2; arm++)
+	{
+		if (streams[arm].Active)
+		{
+			Feed(arm == 1, streams[arm], ops);
+		}
+	}
+}
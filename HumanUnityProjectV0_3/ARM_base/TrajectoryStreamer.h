@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Trajectory.h"
+#include <vector>
+
+// Feeds long waypoint lists into the arm's trajectory FIFO a few points at a
+// time. Keeping only TRAJECTORY_FIFO_LOOKAHEAD points queued on the robot means
+// a new move or a stop takes effect right away instead of after the whole list.
+
+#define TRAJECTORY_FIFO_LOOKAHEAD 8
+
+// How often the worker tops up the FIFO.
+#define TRAJECTORY_FEED_PERIOD_MICROS 10000
+
+// Robot side of the feeding, implemented with the Kinova API by ARM_base.cpp.
+// Every call returns 0 or a Kinova error code.
+struct FifoOps
+{
+	int(*SelectArm)(bool rightArm);
+	int(*GetFifoCount)(unsigned int &count);
+	int(*EraseFifo)();
+	int(*SendWaypoint)(const Waypoint &waypoint);
+};
+
+// Starts streaming waypoints to one arm under command commandId (from
+// ReserveCommandId). Replaces whatever that arm was streaming: the old command
+// completes with ERROR_OPERATION_INCOMPLETED and the FIFO is erased before the
+// first new point goes out. The new command completes once its last point has
+// been executed, or with the first Kinova error.
+void StartWaypointStream(bool rightArm, unsigned int commandId, long long submitTime, std::vector<Waypoint> &waypoints);
+
+// Drops the arm's stream, completing it with ERROR_OPERATION_INCOMPLETED.
+// Does not touch the robot; call from the worker before erasing the FIFO.
+void CancelWaypointStream(bool rightArm);
+
+bool WaypointStreamActive(bool rightArm);
+
+// Background task body: tops up the FIFO of every arm that is streaming.
+void FeedWaypointStreams(const FifoOps &ops);
@@ -0,0 +1,277 @@
+#include "UdpSocket.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mutex>
+#pragma comment(lib, "Ws2_32.lib")
+
+typedef int socklen_t;
+
+// Winsock wants WSAStartup once per process before anything else.
+static bool StartWinsock()
+{
+	static std::once_flag once;
+	static bool started = false;
+	std::call_once(once, [] {
+		WSADATA data;
+		started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	});
+	return started;
+}
+
+static SOCKET Native(UdpHandle socket)
+{
+	return (SOCKET)socket;
+}
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <cerrno>
+#include <vector>
+#endif
+
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+
+static bool StartWinsock()
+{
+	return true;
+}
+
+static SOCKET Native(UdpHandle socket)
+{
+	return (SOCKET)socket;
+}
+#endif
+
+// Room for bursts at a few hundred datagrams a second.
+#define UDP_RECEIVE_BUFFER (256 * 1024)
+
+static sockaddr_in ToNative(const UdpAddress &address)
+{
+	sockaddr_in native;
+	memset(&native, 0, sizeof(native));
+	native.sin_family = AF_INET;
+	native.sin_addr.s_addr = htonl(address.Ip);
+	native.sin_port = htons(address.Port);
+	return native;
+}
+
+bool ResolveUdpAddress(const char *host, int port, UdpAddress &address)
+{
+	if (host == NULL || port < 0 || port > 65535 || !StartWinsock())
+	{
+		return false;
+	}
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo *found = NULL;
+	if (getaddrinfo(host, NULL, &hints, &found) != 0 || found == NULL)
+	{
+		return false;
+	}
+	address.Ip = ntohl(((sockaddr_in *)found->ai_addr)->sin_addr.s_addr);
+	address.Port = (unsigned short)port;
+	freeaddrinfo(found);
+	return true;
+}
+
+bool SameUdpAddress(const UdpAddress &a, const UdpAddress &b)
+{
+	return a.Ip == b.Ip && a.Port == b.Port;
+}
+
+UdpHandle OpenUdpSocket(int port)
+{
+	if (!StartWinsock())
+	{
+		return UDP_NO_SOCKET;
+	}
+	SOCKET native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (native == INVALID_SOCKET)
+	{
+		return UDP_NO_SOCKET;
+	}
+	int size = UDP_RECEIVE_BUFFER;
+	setsockopt(native, SOL_SOCKET, SO_RCVBUF, (const char *)&size, sizeof(size));
+#ifdef _WIN32
+	// otherwise a datagram to a closed port fails the next receive
+	BOOL report = FALSE;
+	DWORD returned = 0;
+	WSAIoctl(native, _WSAIOW(IOC_VENDOR, 12), &report, sizeof(report), NULL, 0, &returned, NULL, NULL);
+#endif
+
+	UdpAddress any = { 0, (unsigned short)port };
+	sockaddr_in address = ToNative(any);
+	if (bind(native, (sockaddr *)&address, sizeof(address)) != 0)
+	{
+		closesocket(native);
+		return UDP_NO_SOCKET;
+	}
+	return (UdpHandle)native;
+}
+
+void CloseUdpSocket(UdpHandle socket)
+{
+	if (socket != UDP_NO_SOCKET)
+	{
+		closesocket(Native(socket));
+	}
+}
+
+int UdpLocalPort(UdpHandle socket)
+{
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	if (socket == UDP_NO_SOCKET || getsockname(Native(socket), (sockaddr *)&address, &length) != 0)
+	{
+		return -1;
+	}
+	return ntohs(address.sin_port);
+}
+
+int SendUdp(UdpHandle socket, const UdpAddress &to, const void *data, int size)
+{
+	sockaddr_in address = ToNative(to);
+	int sent = (int)sendto(Native(socket), (const char *)data, size, 0, (sockaddr *)&address, sizeof(address));
+	return sent < 0 ? -1 : sent;
+}
+
+int WaitUdpReadable(UdpHandle socket, int timeoutMs)
+{
+#ifdef _WIN32
+	WSAPOLLFD entry;
+	entry.fd = Native(socket);
+	entry.events = POLLRDNORM;
+	entry.revents = 0;
+	return WSAPoll(&entry, 1, timeoutMs);
+#else
+	pollfd entry;
+	entry.fd = Native(socket);
+	entry.events = POLLIN;
+	entry.revents = 0;
+	return poll(&entry, 1, timeoutMs);
+#endif
+}
+
+int ReceiveUdp(UdpHandle socket, void *buffer, int capacity, UdpAddress &from, int timeoutMs)
+{
+	int ready = WaitUdpReadable(socket, timeoutMs);
+	if (ready <= 0)
+	{
+		return ready;
+	}
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	int received = (int)recvfrom(Native(socket), (char *)buffer, capacity, 0, (sockaddr *)&address, &length);
+#ifdef _WIN32
+	if (received < 0 && WSAGetLastError() == WSAEMSGSIZE)
+	{
+		received = capacity;
+	}
+#endif
+	if (received < 0)
+	{
+		return -1;
+	}
+	from.Ip = ntohl(address.sin_addr.s_addr);
+	from.Port = ntohs(address.sin_port);
+	return received;
+}
+
+UdpHandle OpenUdpMulticast(const char *group, int port, const char *localIp, int receiveBuffer)
+{
+	UdpAddress groupAddress;
+	UdpAddress local = { 0, 0 };
+	if (!ResolveUdpAddress(group, port, groupAddress) ||
+		(localIp != NULL && localIp[0] != 0 && !ResolveUdpAddress(localIp, 0, local)))
+	{
+		return UDP_NO_SOCKET;
+	}
+	SOCKET native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (native == INVALID_SOCKET)
+	{
+		return UDP_NO_SOCKET;
+	}
+	int reuse = 1;
+	setsockopt(native, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+	setsockopt(native, SOL_SOCKET, SO_RCVBUF, (const char *)&receiveBuffer, sizeof(receiveBuffer));
+
+	UdpAddress any = { 0, (unsigned short)port };
+	sockaddr_in address = ToNative(any);
+	ip_mreq membership;
+	memset(&membership, 0, sizeof(membership));
+	membership.imr_multiaddr.s_addr = htonl(groupAddress.Ip);
+	membership.imr_interface.s_addr = htonl(local.Ip);
+	if (bind(native, (sockaddr *)&address, sizeof(address)) != 0 ||
+		setsockopt(native, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&membership, sizeof(membership)) != 0)
+	{
+		closesocket(native);
+		return UDP_NO_SOCKET;
+	}
+	return (UdpHandle)native;
+}
+
+int ReceiveUdpBatch(UdpHandle socket, unsigned char **buffers, int capacity, int *sizes, int count, int timeoutMs)
+{
+	if (count <= 0)
+	{
+		return 0;
+	}
+	int ready = timeoutMs != 0 ? WaitUdpReadable(socket, timeoutMs) : 1;
+	if (ready <= 0)
+	{
+		return ready;
+	}
+#ifdef __linux__
+	// owned by the one thread that receives on the socket, grown once
+	static thread_local std::vector<mmsghdr> messages;
+	static thread_local std::vector<iovec> vectors;
+	if ((int)messages.size() < count)
+	{
+		messages.resize(count);
+		vectors.resize(count);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		vectors[i].iov_base = buffers[i];
+		vectors[i].iov_len = capacity;
+		memset(&messages[i], 0, sizeof(messages[i]));
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	int received = recvmmsg(Native(socket), &messages[0], count, MSG_DONTWAIT, NULL);
+	if (received < 0)
+	{
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+	}
+	for (int i = 0; i < received; i++)
+	{
+		sizes[i] = (int)messages[i].msg_len;
+	}
+	return received;
+#else
+	int received = 0;
+	UdpAddress from;
+	while (received < count)
+	{
+		int size = ReceiveUdp(socket, buffers[received], capacity, from, 0);
+		if (size <= 0)
+		{
+			break;
+		}
+		sizes[received++] = size;
+	}
+	return received;
+#endif
+}
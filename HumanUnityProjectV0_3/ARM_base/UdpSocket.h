@@ -0,0 +1,51 @@
+#pragma once
+
+// Just enough of UDP for the teleop link: Winsock on Windows, BSD sockets
+// elsewhere, so both ends of the link build on either. IPv4 only.
+
+typedef long long UdpHandle;
+#define UDP_NO_SOCKET (-1LL)
+
+// Addresses and ports in host byte order.
+struct UdpAddress
+{
+	unsigned int Ip;
+	unsigned short Port;
+};
+
+// A dotted address or a host name. False when it does not resolve.
+bool ResolveUdpAddress(const char *host, int port, UdpAddress &address);
+bool SameUdpAddress(const UdpAddress &a, const UdpAddress &b);
+
+// Bound to port on every interface, 0 for any free port. UDP_NO_SOCKET on
+// failure.
+UdpHandle OpenUdpSocket(int port);
+void CloseUdpSocket(UdpHandle socket);
+
+// The port the socket is bound to, -1 on failure.
+int UdpLocalPort(UdpHandle socket);
+
+// Returns the bytes sent or -1.
+int SendUdp(UdpHandle socket, const UdpAddress &to, const void *data, int size);
+
+// Waits up to timeoutMs (0 only polls, -1 forever) for a datagram to come in.
+// Returns 1 when one is in, 0 when none came, -1 on error.
+int WaitUdpReadable(UdpHandle socket, int timeoutMs);
+
+// Waits up to timeoutMs (0 only polls, -1 forever) for one datagram. Returns
+// its size, 0 when none came, -1 on error. A datagram longer than capacity is
+// cut to it.
+int ReceiveUdp(UdpHandle socket, void *buffer, int capacity, UdpAddress &from, int timeoutMs);
+
+// Bound to port on every interface and a member of the multicast group on the
+// interface with address localIp (NULL or "" lets the system pick). Other
+// programs on the machine may join the same group and port.
+// receiveBuffer is the socket's receive buffer in bytes. UDP_NO_SOCKET on
+// failure.
+UdpHandle OpenUdpMulticast(const char *group, int port, const char *localIp, int receiveBuffer);
+
+// Waits like ReceiveUdp for the first datagram, then takes up to count that
+// are in already: buffers[i] gets one, cut to capacity, and sizes[i] its size.
+// One system call for all of them on Linux (recvmmsg), one per datagram
+// elsewhere. Returns how many, 0 when none came, -1 on error.
+int ReceiveUdpBatch(UdpHandle socket, unsigned char **buffers, int capacity, int *sizes, int count, int timeoutMs);
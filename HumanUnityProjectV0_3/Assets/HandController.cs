@@ -64,6 +64,11 @@ public class HandController : MonoBehaviour
   public float zMax = 2.0f;
 
   public float moveFrequency = 0.05f; // seconds
+
+  // The controller buzzes once the gripper pushes harder than the threshold,
+  // at full strength threshold + range newtons.
+  public float hapticForceThreshold = 5.0f;
+  public float hapticForceRange = 20.0f;
   public float unlockFrequency = 0.5f; // seconds
 
   private float xTarget;
@@ -133,7 +138,8 @@ public class HandController : MonoBehaviour
   {
 	trackedHandObj = GetComponent<SteamVR_TrackedObject> ();  //Left or right controller
 
-	// Send commands to arm at most every 5 ms
+	// Send targets every moveFrequency seconds (20 Hz by default). When the
+	// bridge's target stream is running it smooths these into 100-500 Hz commands.
 	InvokeRepeating ("MoveArmToControllerPosition", 0.0f, moveFrequency);
 	InvokeRepeating ("UnlockArm", unlockFrequency, unlockFrequency);
   }
@@ -161,6 +167,21 @@ public class HandController : MonoBehaviour
   	UpdateWithinValidRange();
   
   	redSphere.SetActive(!withinValidRange);
+
+	// calibration: K with the controller held against the gripper, L to solve
+	if (Input.GetKeyDown (KeyCode.K)) {
+	  Vector3 offset = new Vector3 (OffsetX, OffsetY, OffsetZ);
+	  myNetworkManager.SendCalibrationSample (rightArm, GetGlobalPosition () + offset, transform.rotation);
+	}
+	if (Input.GetKeyDown (KeyCode.L)) {
+	  myNetworkManager.SendCalibrate (rightArm, false);
+	}
+
+	ArmFeedbackMessage feedback = myNetworkManager.LatestArmFeedback (rightArm);
+	if (feedback != null && feedback.force.magnitude > hapticForceThreshold) {
+	  float strength = Mathf.Clamp01 ((feedback.force.magnitude - hapticForceThreshold) / hapticForceRange);
+	  controller.TriggerHapticPulse ((ushort)(500 + strength * 3000));
+	}
   }
 
 
@@ -168,39 +189,11 @@ public class HandController : MonoBehaviour
   {
 	if (controller.GetPress (triggerButton)) {
 	  if (withinValidRange) {
-		float pi = (float)Math.PI;
-
-		if (rightArm) {
-		  zTarget *= -1;
-		}
-
-		float eulerY = transform.rotation.eulerAngles.y;
-		float radY = eulerY * pi / 180f;
-		float kinovaRadY = radY < pi ? radY * -1f : radY - pi;
-		float eulerX = transform.rotation.eulerAngles.x;
-		if (kinovaRadY < 0 && eulerX > 90) { // turning left/up
-		  eulerX = 275 - (eulerX - 275);
-		}
-		if (eulerX < 90) { // turning right/down
-		  eulerX -= 180;
-		} 
-		if (kinovaRadY < 0 && eulerX < 0) { // turning left/down
-		  eulerX = -90 - (eulerX + 90);
-		}
-		float radX = eulerX * pi / 180f;
-		float kinovaRadX = radX < pi ? radX * -1f : radX - pi;
-		if (eulerX < 0) { // turning right/down
-		  kinovaRadX = radX;
-		}
-		if (rightArm) { // mirror X rotation
-		  kinovaRadX -= 1.5f; // shift rotation to match hand instead of wrist
-		  kinovaRadX = (kinovaRadX * -1) + 3;
-		} else {
-		  kinovaRadX += 1.5f; // shift rotation to match hand instead of wrist
-		}
-
-		MoveArmNoThetaY (new KinovaAPI.Position (xTarget, yTarget, zTarget,
-		  kinovaRadX, 1.4f, 0f));
+		// axes, mirroring and the hand orientation are worked out by the
+		// bridge's retargeting stage (ARM_base/Retarget.h), on the server or,
+		// with nativeTeleop, here before the pose goes over the native link
+		Vector3 offset = new Vector3 (OffsetX, OffsetY, OffsetZ);
+		myNetworkManager.SendControllerPose (rightArm, GetGlobalPosition () + offset, transform.rotation);
 
 	  } else {
 		Debug.Log ("Trigger pressed outside of valid range:");
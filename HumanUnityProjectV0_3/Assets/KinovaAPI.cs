@@ -29,7 +29,680 @@ public class KinovaAPI : MonoBehaviour
   [DllImport ("ARM_base_32", EntryPoint = "StopArm")]
   private static extern int _StopArm (bool rightArm);
 
+  [DllImport ("ARM_base_32", EntryPoint = "SubmitMoveHand")]
+  private static extern int _SubmitMoveHand (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SubmitMoveHandNoThetaY")]
+  private static extern int _SubmitMoveHandNoThetaY (bool rightArm, float x, float y, float z, float thetaX, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SubmitStopArm")]
+  private static extern int _SubmitStopArm (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PollCommandCompletions")]
+  private static extern int _PollCommandCompletions ([Out] CommandCompletion[] completions, int maxCount);
+
+  [DllImport ("ARM_base_32", EntryPoint = "WaitForCommand")]
+  private static extern int _WaitForCommand (int commandId, int timeoutMs, out CommandCompletion completion);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SubmitClearErrorLog")]
+  private static extern int _SubmitClearErrorLog (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "ReadSystemErrors")]
+  private static extern int _ReadSystemErrors (ref long cursor, [Out] SystemErrorEntry[] entries, int maxCount);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetBridgeTime")]
+  private static extern long _GetBridgeTime ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartTargetStream")]
+  private static extern int _StartTargetStream (int rateHz, int delayMs);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StopTargetStream")]
+  private static extern int _StopTargetStream ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "PushTargetSample")]
+  private static extern int _PushTargetSample (bool rightArm, long timestamp, float x, float y, float z, float qx, float qy, float qz, float qw);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PushTargetPose")]
+  private static extern int _PushTargetPose (bool rightArm, long timestamp, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "MoveHandToController")]
+  private static extern int _MoveHandToController (bool rightArm, ref ControllerPose controller);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PushControllerTargets")]
+  private static extern int _PushControllerTargets (long timestamp, ControllerPose[] controllers, int armMask);
+
+  [DllImport ("ARM_base_32", EntryPoint = "RetargetControllerPoses")]
+  private static extern int _RetargetControllerPoses (ControllerPose[] controllers, int armMask, [Out] KinovaPose[] poses);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetControllerFrame")]
+  private static extern int _SetControllerFrame (bool rightArm, ref RetargetFrame frame);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetControllerFrame")]
+  private static extern int _ResetControllerFrame (bool rightArm, System.IntPtr frame);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetControllerFrame")]
+  private static extern int _GetControllerFrame (bool rightArm, out RetargetFrame frame);
+
+  [DllImport ("ARM_base_32", EntryPoint = "AddCalibrationSample")]
+  private static extern int _AddCalibrationSample (bool rightArm, int source, ref ControllerPose pose);
+
+  [DllImport ("ARM_base_32", EntryPoint = "ClearCalibrationSamples")]
+  private static extern int _ClearCalibrationSamples (bool rightArm, int source);
+
+  [DllImport ("ARM_base_32", EntryPoint = "CalibrateArm")]
+  private static extern int _CalibrateArm (bool rightArm, int source, bool withScale, out CalibrationResult result);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetTargetStreamStats")]
+  private static extern int _GetTargetStreamStats (out TargetStreamStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetTargetPrediction")]
+  private static extern int _SetTargetPrediction (int model, float lead);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetPredictionStats")]
+  private static extern int _GetPredictionStats (out PredictorStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetLatencyStats")]
+  private static extern int _GetLatencyStats (int histogram, out LatencyStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "CoordinateArms")]
+  private static extern int _CoordinateArms (bool enabled, int constraint, float distance);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetRightArmBase")]
+  private static extern int _SetRightArmBase (float x, float y, float z, float qx, float qy, float qz, float qw);
+
+  [DllImport ("ARM_base_32", EntryPoint = "DeriveRightArmBase")]
+  private static extern int _DeriveRightArmBase (int source);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetDualArmStats")]
+  private static extern int _GetDualArmStats (out DualArmStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmState")]
+  private static extern int _GetArmState (bool rightArm, out ArmState state);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmEffort")]
+  private static extern int _GetArmEffort (bool rightArm, out ArmEffort effort);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmSensors")]
+  private static extern int _GetArmSensors (bool rightArm, out ArmSensors sensors);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetThermalStatus")]
+  private static extern int _GetThermalStatus (bool rightArm, out ThermalStatus status);
+
+  [DllImport ("ARM_base_32", EntryPoint = "EnableThermalGovernor")]
+  private static extern int _EnableThermalGovernor (bool enabled);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetTrajectoryLimits")]
+  private static extern int _SetTrajectoryLimits (float[] maxVelocity, float[] maxAcceleration);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetJointTrajectoryLimits")]
+  private static extern int _SetJointTrajectoryLimits (float[] maxVelocity, float[] maxAcceleration);
+
+  [DllImport ("ARM_base_32", EntryPoint = "MoveArmToPreset")]
+  private static extern int _MoveArmToPreset (bool rightArm, string preset);
+
+  [DllImport ("ARM_base_32", EntryPoint = "AddObstacle")]
+  private static extern int _AddObstacle (float x1, float y1, float z1, float x2, float y2, float z2, float radius);
+
+  [DllImport ("ARM_base_32", EntryPoint = "ClearObstacles")]
+  private static extern int _ClearObstacles ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetRoadmapStatus")]
+  private static extern int _GetRoadmapStatus ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "ConnectArmDaemon")]
+  private static extern int _ConnectArmDaemon ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "DisconnectArmDaemon")]
+  private static extern int _DisconnectArmDaemon ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "ShutdownArmDaemon")]
+  private static extern int _ShutdownArmDaemon ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "DaemonMoveHand")]
+  private static extern int _DaemonMoveHand (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "DaemonMoveArmHome")]
+  private static extern int _DaemonMoveArmHome (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "DaemonMoveFingers")]
+  private static extern int _DaemonMoveFingers (bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
+
+  [DllImport ("ARM_base_32", EntryPoint = "DaemonStopArm")]
+  private static extern int _DaemonStopArm (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PollDaemonCompletions")]
+  private static extern int _PollDaemonCompletions ([Out] CommandCompletion[] completions, int maxCount);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetDaemonArmState")]
+  private static extern int _GetDaemonArmState (bool rightArm, out ArmState state);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PingArmDaemon")]
+  private static extern long _PingArmDaemon (int timeoutMs);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmChannelStats")]
+  private static extern int _GetArmChannelStats (out ArmChannelStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartTeleopServer")]
+  private static extern int _StartTeleopServer (int port);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StopTeleopServer")]
+  private static extern int _StopTeleopServer ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetTeleopServerStats")]
+  private static extern int _GetTeleopServerStats (out TeleopServerStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartTeleopReplay")]
+  private static extern int _StartTeleopReplay (string file, bool originalTiming);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartTeleopCapture")]
+  private static extern int _StartTeleopCapture (string file);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StopTeleopCapture")]
+  private static extern int _StopTeleopCapture ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "ConnectTeleop")]
+  private static extern int _ConnectTeleop (string host, int port);
+
+  [DllImport ("ARM_base_32", EntryPoint = "DisconnectTeleop")]
+  private static extern int _DisconnectTeleop ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopMoveArm")]
+  private static extern int _TeleopMoveArm (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopMoveArmNoThetaY")]
+  private static extern int _TeleopMoveArmNoThetaY (bool rightArm, float x, float y, float z, float thetaX, float thetaZ);
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopMoveHands")]
+  private static extern int _TeleopMoveHands (int contents, float[] leftPose, float[] rightPose, int flags, int leftFingers, int rightFingers);
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopStopArm")]
+  private static extern int _TeleopStopArm (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopMoveArmHome")]
+  private static extern int _TeleopMoveArmHome (bool rightArm);
+
+  [DllImport ("ARM_base_32", EntryPoint = "TeleopMoveFingers")]
+  private static extern int _TeleopMoveFingers (bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetTeleopRedundancyMode")]
+  private static extern int _SetTeleopRedundancyMode (int frames, int parityGroup);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartLossyLink")]
+  private static extern int _StartLossyLink (int port, string host, int serverPort, float loss, float meanBurst, int delayMicros, int jitterMicros);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StopLossyLink")]
+  private static extern int _StopLossyLink ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetLossyLinkStats")]
+  private static extern int _GetLossyLinkStats (out LossyLinkStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "LeaseTeleopArms")]
+  private static extern int _LeaseTeleopArms (int arms, int priority, int durationMs);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SetArmLeasePolicy")]
+  private static extern int _SetArmLeasePolicy (bool required);
+
+  [DllImport ("ARM_base_32", EntryPoint = "RequestArmLease")]
+  private static extern int _RequestArmLease (bool rightArm, int holder, int priority, int durationMs);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PassArmLease")]
+  private static extern int _PassArmLease (bool rightArm, int from, int to, int priority, int durationMs);
+
+  [DllImport ("ARM_base_32", EntryPoint = "ReturnArmLease")]
+  private static extern int _ReturnArmLease (bool rightArm, int holder);
+
+  [DllImport ("ARM_base_32", EntryPoint = "CanCommandArm")]
+  private static extern int _CanCommandArm (bool rightArm, int holder);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmLease")]
+  private static extern int _GetArmLease (bool rightArm, out ArmLeaseInfo info);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetArmLeaseStats")]
+  private static extern int _GetArmLeaseStats (out ArmLeaseStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StartNatNet")]
+  private static extern int _StartNatNet (string server, string localIp, int receiveCpu);
+
+  [DllImport ("ARM_base_32", EntryPoint = "StopNatNet")]
+  private static extern int _StopNatNet ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetNatNetStats")]
+  private static extern int _GetNatNetStats (out NatNetClientStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "SubscribeNatNet")]
+  private static extern int _SubscribeNatNet (int[] rigidBodies, int rigidBodyCount, int[] skeletons, int skeletonCount);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PollNatNet")]
+  private static extern int _PollNatNet (out NatNetSelection selection);
+
+  [DllImport ("ARM_base_32", EntryPoint = "PollTeleop")]
+  private static extern int _PollTeleop ();
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetTeleopClientStats")]
+  private static extern int _GetTeleopClientStats (out TeleopClientStats stats);
+
+  [DllImport ("ARM_base_32", EntryPoint = "GetTeleopRobotTime")]
+  private static extern long _GetTeleopRobotTime ();
+
   private static bool initSuccessful = false;
+  private static bool daemonConnected = false;
+
+  // Mirrors CommandCompletion in ARM_base/CommandQueue.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct CommandCompletion
+  {
+	public uint Id;
+	public int Result; // 0 on success, Kinova error code otherwise (1022 = comm timeout, 9999 = NACK)
+	public long SubmitTime; // microseconds
+	public long StartTime;
+	public long EndTime;
+  }
+
+  // Mirrors SystemErrorEntry in ARM_base/ErrorLog.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct SystemErrorEntry
+  {
+	public long Timestamp; // microseconds, same clock as GetBridgeTime()
+	public uint LastCommandId; // newest command ID issued when it was read
+	public int Arm; // 0 left, 1 right
+	public uint LogIndex;
+	public uint ErrorHeader;
+	public int ErrorType;
+	public int FirmwareVersion;
+	public int KeosVersion;
+	public uint SystemTime; // robot clock
+	public int LifeTime;
+	public uint LayerErrors; // bit per layer
+	public int DataCount;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 50)]
+	public uint[] Data;
+  }
+
+  // Mirrors TargetStreamStats in ARM_base/Interpolator.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct TargetStreamStats
+  {
+	public uint Ticks;
+	public uint CommandsSent;
+	public uint TicksSkippedBusy;
+	public uint TicksExtrapolated;
+	public uint TicksHeld;
+	public uint TicksThrottled; // thermal governor
+	public long MaxLatenessMicros;
+  }
+
+  // Models in ARM_base/Predictor.h
+  public const int PREDICT_NONE = 0;
+  public const int PREDICT_CONSTANT_ACCELERATION = 1;
+  public const int PREDICT_LEARNED = 2;
+
+  // Mirrors PredictorStats in ARM_base/Predictor.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct PredictorStats
+  {
+	public int Model;
+	public float Lead;
+	public long HorizonMicros;
+	public uint Predictions;
+	public uint Scored;
+	public float PositionError; // meters, recent RMS
+	public float AngleError; // radians
+	public float BaselinePositionError; // same, without prediction
+	public float BaselineAngleError;
+  }
+
+  // Histograms in ARM_base/Latency.h
+  public const int LATENCY_COMMAND = 0;
+  public const int LATENCY_MOTION = 1;
+  public const int LATENCY_CAPTURE = 2; // operator capture to the arm, needs synchronized clocks
+
+  // Mirrors LatencyStats in ARM_base/Latency.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct LatencyStats
+  {
+	public uint Count;
+	public long MeanMicros;
+	public long P50Micros;
+	public long P90Micros;
+	public long P99Micros;
+	public long MaxMicros;
+  }
+
+  // Constraints in ARM_base/DualArm.h
+  public const int DUAL_ARM_FREE = 0;
+  public const int DUAL_ARM_FIXED_DISTANCE = 1;
+  public const int DUAL_ARM_RIGID = 2;
+
+  // Mirrors DualArmStats in ARM_base/DualArm.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct DualArmStats
+  {
+	public int Constraint;
+	public float Distance; // meters, DUAL_ARM_FIXED_DISTANCE only
+	public uint Pairs;
+	public uint PairsHeld; // one arm ready, waiting for the other
+	public uint Corrections;
+	public float LastCorrection; // meters
+	public float MaxCorrection;
+	public long InputSkewMicros; // right samples minus left samples
+	public long LastDispatchSkewMicros; // right command start minus left
+	public long MeanDispatchSkewMicros;
+	public long MaxDispatchSkewMicros;
+  }
+
+  // RobotStatus while the arm daemon is still initializing, see ARM_base/ArmChannel.h
+  public const int ARM_CHANNEL_ROBOT_STARTING = 1;
+
+  // Mirrors ArmChannelStats in ARM_base/ArmDaemon.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmChannelStats
+  {
+	public int Connected;
+	public int RobotStatus; // InitRobot's result in the daemon
+	public uint ClientGeneration;
+	public long DaemonAge; // microseconds since the daemon's heartbeat
+	public uint Sent;
+	public uint Completed;
+	public uint Refused; // channel full
+	public uint CompletionsDropped;
+	public double MeanCommandLatency; // microseconds, client to daemon
+	public long MaxCommandLatency;
+	public long LastRoundTrip; // PingArmDaemon, microseconds
+	public double MeanRoundTrip;
+	public long MinRoundTrip;
+	public long MaxRoundTrip;
+  }
+
+  // TeleopMoveHands contents, see ARM_base/PoseCodec.h
+  public const int POSE_FRAME_LEFT = 1;
+  public const int POSE_FRAME_RIGHT = 2;
+  public const int POSE_FRAME_LEFT_FINGERS = 4;
+  public const int POSE_FRAME_RIGHT_FINGERS = 8;
+
+  // Flags and finger bits, see ARM_base/TeleopProtocol.h
+  public const int TELEOP_POSE_NO_THETA_Y = 1;
+  public const int TELEOP_FINGER_PINKY = 1;
+  public const int TELEOP_FINGER_RING = 2;
+  public const int TELEOP_FINGER_MIDDLE = 4;
+  public const int TELEOP_FINGER_INDEX = 8;
+  public const int TELEOP_FINGER_THUMB = 16;
+
+  // Arms in a lease
+  public const int TELEOP_ARM_LEFT = 1;
+  public const int TELEOP_ARM_RIGHT = 2;
+
+  // Lease holders 1 to 4 are the native link's operators, see
+  // ARM_base/TeleopServer.h; the rest up to ARM_LEASE_MAX_HOLDER are free.
+  public const int TELEOP_LEASE_HOLDER_BASE = 1;
+  public const int ARM_LEASE_MAX_HOLDER = 4095;
+  public const int ARM_LEASE_MAX_PRIORITY = 15;
+
+  // Mirrors TeleopServerStats in ARM_base/TeleopServer.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct TeleopServerStats
+  {
+	public int Running;
+	public int Port;
+	public int Peers;
+	public uint Datagrams;
+	public uint Malformed;
+	public uint Lost;
+	public uint Poses;
+	public uint PosesStale; // older than one already taken
+	public uint PosesSuperseded; // replaced while the arm was busy
+	public uint PosesApplied;
+	public uint Frames;
+	public uint FramesUndecodable; // baseline forgotten, e.g. after a restart
+	public uint FramesRecovered; // lost, then taken from a later repeat
+	public uint Reliable;
+	public uint Duplicates;
+	public uint ReliableRecovered; // rebuilt from parity
+	public uint AcksSent;
+	public uint PeersRefused;
+	public uint LeaseRequests;
+	public uint CommandsRefused; // kept from the arms by the leases
+	public long RedundantBytes;
+	public uint SyncProbes; // clock of the operator that probed last
+	public int ClockSynced;
+	public long ClockOffset; // microseconds, operator minus robot
+	public double ClockDriftPpm;
+	public long ClockDelay; // best round trip
+	public int Capturing;
+	public uint Captured; // datagrams written to the capture
+	public int Replaying;
+	public long ReplayMicros; // time the replay has taken so far
+  }
+
+  // Mirrors TeleopClientStats in ARM_base/TeleopClient.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct TeleopClientStats
+  {
+	public int Connected;
+	public int Redundancy;
+	public int ParityGroup;
+	public uint Datagrams;
+	public uint Poses;
+	public uint Frames;
+	public uint Keyframes; // sent without a baseline
+	public double MeanFrameSize; // bytes
+	public uint RedundantFrames;
+	public uint ParitySent;
+	public long OverheadBytes;
+	public uint Reliable;
+	public uint Retransmits;
+	public uint Acked;
+	public uint GaveUp;
+	public int Pending;
+	public long LastAckTime; // microseconds
+	public double MeanAckTime;
+	public long MaxAckTime;
+	public uint SyncProbes;
+	public uint SyncReplies;
+	public int ClockSynced;
+	public long ClockOffset; // microseconds, robot minus operator
+	public double ClockDriftPpm;
+	public long ClockDelay; // best round trip
+	public int LeaseWanted; // TELEOP_ARM_* bits
+	public int LeaseHeld;
+	public int LeaseOthers; // held by another operator
+  }
+
+  // Mirrors LossyLinkStats in ARM_base/LossyLink.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct LossyLinkStats
+  {
+	public int Running;
+	public int Port;
+	public uint Datagrams;
+	public uint Dropped;
+	public uint Forwarded;
+	public uint Overflowed; // delay queue full
+  }
+
+  // Mirrors ArmLeaseInfo in ARM_base/ArmLease.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmLeaseInfo
+  {
+	public int Holder; // 0 when the arm is free
+	public int Priority;
+	public long Expiry; // microseconds, same clock as GetBridgeTime()
+  }
+
+  // Mirrors ArmLeaseStats in ARM_base/ArmLease.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmLeaseStats
+  {
+	public int Required;
+	public uint Granted;
+	public uint Preempted;
+	public uint HandedOff;
+	public uint Renewed;
+	public uint Released;
+	public uint Refused; // requests for an arm someone else holds
+	public uint CommandsRefused;
+  }
+
+  // Mirrors NatNetClientStats in ARM_base/NatNetClient.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct NatNetClientStats
+  {
+	public int Running;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 4)]
+	public int[] Version; // all 0 until Motive answers
+	public int Pinned;
+	public uint Datagrams;
+	public uint Batches;
+	public int MaxBatch;
+	public uint Frames;
+	public uint Dropped; // no room left in the queue
+	public uint Ignored;
+  }
+
+  // Mirrors NatNetPose in ARM_base/NatNetFrame.h. Motive's frame: right
+  // handed, meters.
+  [StructLayout (LayoutKind.Sequential)]
+  public struct NatNetPose
+  {
+	public int Id;
+	public int Found; // 0 when the frame did not have it
+	public int Flags;
+	public float Error;
+	public Vector3 Position;
+	public Quaternion Orientation;
+  }
+
+  // Mirrors NatNetSelection in ARM_base/NatNetFrame.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct NatNetSelection
+  {
+	public double Timestamp;
+	public int FrameNumber;
+	public int Flags;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 16)]
+	public NatNetPose[] RigidBodies; // in the order subscribed
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 4)]
+	public int[] SkeletonFirstBone;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 4)]
+	public int[] SkeletonBoneCount;
+	public int BoneCount;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 128)]
+	public NatNetPose[] Bones;
+  }
+
+  // Mirrors ControllerPose in ARM_base/Retarget.h. Unity world coordinates.
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ControllerPose
+  {
+	public Vector3 Position;
+	public Quaternion Rotation;
+
+	public ControllerPose (Vector3 position, Quaternion rotation)
+	{
+	  Position = position;
+	  Rotation = rotation;
+	}
+  }
+
+  // Mirrors KinovaPose in ARM_base/Retarget.h. Meters and radians, like MoveHand.
+  [StructLayout (LayoutKind.Sequential)]
+  public struct KinovaPose
+  {
+	public float X;
+	public float Y;
+	public float Z;
+	public float ThetaX;
+	public float ThetaY;
+	public float ThetaZ;
+  }
+
+  // Mirrors RetargetFrame in ARM_base/Retarget.h: Unity (z flipped) to arm base frame
+  [StructLayout (LayoutKind.Sequential)]
+  public struct RetargetFrame
+  {
+	public Quaternion Rotation;
+	public Vector3 Translation;
+	public float Scale;
+	public Quaternion HandOffset; // controller to gripper
+  }
+
+  // Sources in ARM_base/Calibration.h
+  public const int CALIBRATION_CONTROLLER = 0;
+  public const int CALIBRATION_RIGID_BODY = 1;
+
+  // Mirrors CalibrationResult in ARM_base/Calibration.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct CalibrationResult
+  {
+	public RetargetFrame Frame;
+	public int Samples;
+	public int Inliers;
+	public float RmsPositionError; // meters
+	public float RmsAngleError; // radians
+  }
+
+  // Mirrors ArmState in ARM_base/StateCache.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmState
+  {
+	public long Timestamp; // microseconds, same clock as GetBridgeTime()
+	public float X;
+	public float Y;
+	public float Z;
+	public float ThetaX;
+	public float ThetaY;
+	public float ThetaZ;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Joints; // degrees
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 3)]
+	public float[] Fingers;
+  }
+
+  // Mirrors ArmEffort in ARM_base/StateCache.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmEffort
+  {
+	public long Timestamp; // microseconds, same clock as GetBridgeTime()
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 6)]
+	public float[] Force; // X, Y, Z in N, ThetaX, ThetaY, ThetaZ in Nm
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Torques; // Nm, gravity removed
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Currents; // A
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 3)]
+	public float[] FingerCurrents;
+  }
+
+  // Mirrors ArmSensors in ARM_base/StateCache.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ArmSensors
+  {
+	public long Timestamp; // microseconds, same clock as GetBridgeTime()
+	public float Voltage; // V
+	public float Current; // A, whole arm
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Temperatures; // degrees C, 0 for actuators the arm does not have
+  }
+
+  // Mirrors ThermalStatus in ARM_base/Thermal.h
+  [StructLayout (LayoutKind.Sequential)]
+  public struct ThermalStatus
+  {
+	public long Timestamp;
+	public float Scale; // speeds and command rate are multiplied by this
+	public int LimitingJoint; // -1 when not derating
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Measured; // degrees C
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Estimated; // with the modeled winding rise
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Forecast;
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] RmsCurrent; // A
+	[MarshalAs (UnmanagedType.ByValArray, SizeConst = 7)]
+	public float[] Headroom; // 1 cool, 0 at a limit
+  }
+
+  private static bool streamingTargets = false;
 
   public class Position
   {
@@ -140,6 +813,36 @@ public class KinovaAPI : MonoBehaviour
 	case -18:
 	  Debug.LogError ("Robot APIs troubles: StartForceControl");
 	  break;
+	case -19:
+	  Debug.LogError ("Robot APIs troubles: GetCartesianPosition");
+	  break;
+	case -20:
+	  Debug.LogError ("Robot APIs troubles: GetAngularPosition");
+	  break;
+	case -21:
+	  Debug.LogError ("Robot APIs troubles: GetGlobalTrajectoryInfo");
+	  break;
+	case -22:
+	  Debug.LogError ("Robot APIs troubles: GetCartesianForce");
+	  break;
+	case -23:
+	  Debug.LogError ("Robot APIs troubles: GetAngularForceGravityFree");
+	  break;
+	case -24:
+	  Debug.LogError ("Robot APIs troubles: GetAngularCurrent");
+	  break;
+	case -25:
+	  Debug.LogError ("Robot APIs troubles: GetSensorsInfo");
+	  break;
+	case -26:
+	  Debug.LogError ("Robot APIs troubles: GetSystemErrorCount");
+	  break;
+	case -27:
+	  Debug.LogError ("Robot APIs troubles: GetSystemError");
+	  break;
+	case -28:
+	  Debug.LogError ("Robot APIs troubles: ClearErrorLog");
+	  break;
 	case -123:
 	  Debug.LogError ("Robot APIs troubles: Command Layer Handle");
 	  break;
@@ -185,6 +888,757 @@ public class KinovaAPI : MonoBehaviour
   }
 
 
+  // Queue a move without waiting for the arm; returns the command ID or -1.
+  public static int SubmitMoveHand (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+  {
+	if (!initSuccessful) {
+	  return -1;
+	}
+	return _SubmitMoveHand (rightArm, x, y, z, thetaX, thetaY, thetaZ);
+  }
+
+  public static int SubmitMoveHandNoThetaY (bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+  {
+	if (!initSuccessful) {
+	  return -1;
+	}
+	return _SubmitMoveHandNoThetaY (rightArm, x, y, z, thetaX, thetaZ);
+  }
+
+  public static int SubmitStopArm (bool rightArm)
+  {
+	if (!initSuccessful) {
+	  return -1;
+	}
+	return _SubmitStopArm (rightArm);
+  }
+
+  // Command ID of the clear, or -1 when the robot is not initialized.
+  public static int SubmitClearErrorLog (bool rightArm)
+  {
+	if (!initSuccessful) {
+	  return -1;
+	}
+	return _SubmitClearErrorLog (rightArm);
+  }
+
+  // Fills entries with the arms' error log entries from cursor on and moves
+  // cursor past them. Start with 0 for everything the bridge still holds, -1
+  // for new entries only. Returns how many were written.
+  public static int ReadSystemErrors (ref long cursor, SystemErrorEntry[] entries)
+  {
+	if (!initSuccessful) {
+	  return 0;
+	}
+	return _ReadSystemErrors (ref cursor, entries, entries.Length);
+  }
+
+  // Fills completions with finished commands, returns how many were written.
+  public static int PollCompletions (CommandCompletion[] completions)
+  {
+	if (!initSuccessful) {
+	  return 0;
+	}
+	return _PollCommandCompletions (completions, completions.Length);
+  }
+
+  // 0 when completion is filled in, -1 on timeout, -2 for an unknown ID.
+  public static int WaitForCommand (int commandId, int timeoutMs, out CommandCompletion completion)
+  {
+	completion = new CommandCompletion ();
+	if (!initSuccessful) {
+	  return -2;
+	}
+	return _WaitForCommand (commandId, timeoutMs, out completion);
+  }
+
+
+  // Microseconds on the bridge clock, used to timestamp target samples.
+  public static long GetBridgeTime ()
+  {
+	return initSuccessful ? _GetBridgeTime () : 0;
+  }
+
+  /**
+   * Let the bridge send interpolated targets to the arms at rateHz (100 to 500),
+   * rendered delayMs behind the newest samples.
+   */
+  public static void StartTargetStream (int rateHz, int delayMs)
+  {
+	if (!initSuccessful) {
+	  return;
+	}
+	int errorCode = _StartTargetStream (rateHz, delayMs);
+	if (errorCode == 0) {
+	  streamingTargets = true;
+	} else {
+	  Debug.LogError ("Robot - could not start target stream: " + errorCode);
+	}
+  }
+
+  public static void StopTargetStream ()
+  {
+	if (streamingTargets) {
+	  _StopTargetStream ();
+	  streamingTargets = false;
+	}
+  }
+
+  // timestamp from GetBridgeTime(), or 0 for "now"
+  public static void PushTargetSample (bool rightArm, long timestamp, Vector3 position, Quaternion rotation)
+  {
+	if (streamingTargets) {
+	  _PushTargetSample (rightArm, timestamp, position.x, position.y, position.z,
+		rotation.x, rotation.y, rotation.z, rotation.w);
+	}
+  }
+
+  public static void PushTargetPose (bool rightArm, long timestamp, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+  {
+	if (streamingTargets) {
+	  _PushTargetPose (rightArm, timestamp, x, y, z, thetaX, thetaY, thetaZ);
+	}
+  }
+
+  public static TargetStreamStats GetTargetStreamStats ()
+  {
+	TargetStreamStats stats = new TargetStreamStats ();
+	if (streamingTargets) {
+	  _GetTargetStreamStats (out stats);
+	}
+	return stats;
+  }
+
+  // Leads the target stream by lead times the render delay plus the measured
+  // arm lag. Compare PredictorStats' errors with the baseline ones to tune lead.
+  public static void SetTargetPrediction (int model, float lead)
+  {
+	if (initSuccessful && _SetTargetPrediction (model, lead) != 0) {
+	  Debug.LogError ("Prediction model " + model + " with lead " + lead + " rejected");
+	}
+  }
+
+  public static PredictorStats GetPredictionStats ()
+  {
+	PredictorStats stats = new PredictorStats ();
+	if (initSuccessful) {
+	  _GetPredictionStats (out stats);
+	}
+	return stats;
+  }
+
+  public static LatencyStats GetLatencyStats (int histogram)
+  {
+	LatencyStats stats = new LatencyStats ();
+	if (initSuccessful) {
+	  _GetLatencyStats (histogram, out stats);
+	}
+	return stats;
+  }
+
+  // Sends both arms' stream targets together each tick. A constraint other than
+  // DUAL_ARM_FREE needs SetRightArmBase or DeriveRightArmBase first; distance
+  // 0 keeps the hands as far apart as they are when it starts.
+  public static bool CoordinateArms (bool enabled, int constraint, float distance)
+  {
+	if (!initSuccessful) {
+	  return false;
+	}
+	int errorCode = _CoordinateArms (enabled, constraint, distance);
+	if (errorCode != 0) {
+	  Debug.LogError ("Robot - could not coordinate arms: " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  // Pose of the right arm's base in the left arm's base frame (meters, Kinova axes).
+  public static void SetRightArmBase (Vector3 position, Quaternion rotation)
+  {
+	if (initSuccessful) {
+	  _SetRightArmBase (position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w);
+	}
+  }
+
+  // From both arms' calibration against the same tracker, see CalibrateArm.
+  public static bool DeriveRightArmBase (int source)
+  {
+	return initSuccessful && _DeriveRightArmBase (source) == 0;
+  }
+
+  public static DualArmStats GetDualArmStats ()
+  {
+	DualArmStats stats = new DualArmStats ();
+	if (initSuccessful) {
+	  _GetDualArmStats (out stats);
+	}
+	return stats;
+  }
+
+  // Moves the arm to where the controller is, retargeted by the bridge.
+  public static void MoveHandToController (bool rightArm, Vector3 position, Quaternion rotation)
+  {
+	if (initSuccessful) {
+	  ControllerPose controller = new ControllerPose (position, rotation);
+	  _MoveHandToController (rightArm, ref controller);
+	}
+  }
+
+  // Both controllers in one call; only the arms in armMask (1 left, 2 right) are
+  // pushed. False when the target stream is not running.
+  public static bool PushControllerTargets (long timestamp, ControllerPose left, ControllerPose right, int armMask)
+  {
+	if (!streamingTargets) {
+	  return false;
+	}
+	_PushControllerTargets (timestamp, new ControllerPose[] { left, right }, armMask);
+	return true;
+  }
+
+  // The arm pose for the controller, without moving anything; works without a
+  // robot. Continuous in Euler angles with the arm's last retargeted pose.
+  public static KinovaPose RetargetController (bool rightArm, Vector3 position, Quaternion rotation)
+  {
+	ControllerPose[] controllers = new ControllerPose[2];
+	KinovaPose[] poses = new KinovaPose[2];
+	controllers [rightArm ? 1 : 0] = new ControllerPose (position, rotation);
+	_RetargetControllerPoses (controllers, rightArm ? 2 : 1, poses);
+	return poses [rightArm ? 1 : 0];
+  }
+
+  // The frames are math only, like RetargetController: the client keeps the
+  // server's copies to retarget for the native teleop link.
+  public static void SetControllerFrame (bool rightArm, RetargetFrame frame)
+  {
+	_SetControllerFrame (rightArm, ref frame);
+  }
+
+  // back to the default mapping; the right arm mirrors the left one
+  public static void ResetControllerFrame (bool rightArm)
+  {
+	_ResetControllerFrame (rightArm, System.IntPtr.Zero);
+  }
+
+  public static RetargetFrame GetControllerFrame (bool rightArm)
+  {
+	bool mirrored;
+	return GetControllerFrame (rightArm, out mirrored);
+  }
+
+  // mirrored: the right arm has no frame of its own and mirrors the left one,
+  // whose frame is returned
+  public static RetargetFrame GetControllerFrame (bool rightArm, out bool mirrored)
+  {
+	RetargetFrame frame;
+	mirrored = _GetControllerFrame (rightArm, out frame) == 1;
+	return frame;
+  }
+
+  // Pairs the controller pose with where the arm is now. Hold the controller
+  // against the gripper and take samples spread over the workspace.
+  public static bool AddCalibrationSample (bool rightArm, int source, Vector3 position, Quaternion rotation)
+  {
+	if (!initSuccessful) {
+	  return false;
+	}
+	ControllerPose pose = new ControllerPose (position, rotation);
+	return _AddCalibrationSample (rightArm, source, ref pose) == 0;
+  }
+
+  public static void ClearCalibrationSamples (bool rightArm, int source)
+  {
+	if (initSuccessful) {
+	  _ClearCalibrationSamples (rightArm, source);
+	}
+  }
+
+  // Fits, applies and saves the frame; false when there are too few usable samples.
+  public static bool CalibrateArm (bool rightArm, int source, bool withScale, out CalibrationResult result)
+  {
+	result = new CalibrationResult ();
+	if (!initSuccessful) {
+	  return false;
+	}
+	int returnValue = _CalibrateArm (rightArm, source, withScale, out result);
+	if (returnValue == -2) {
+	  Debug.LogWarning ("Calibration file could not be written");
+	}
+	return returnValue != -1;
+  }
+
+  // false until the bridge has read the arm at least once
+  public static bool GetArmState (bool rightArm, out ArmState state)
+  {
+	state = new ArmState ();
+	if (!initSuccessful) {
+	  return false;
+	}
+	return _GetArmState (rightArm, out state) == 0;
+  }
+
+  // false until the bridge has read the arm's forces at least once
+  public static bool GetArmEffort (bool rightArm, out ArmEffort effort)
+  {
+	effort = new ArmEffort ();
+	if (!initSuccessful) {
+	  return false;
+	}
+	return _GetArmEffort (rightArm, out effort) == 0;
+  }
+
+  // false until the bridge has read the arm's voltage and temperatures
+  public static bool GetArmSensors (bool rightArm, out ArmSensors sensors)
+  {
+	sensors = new ArmSensors ();
+	if (!initSuccessful) {
+	  return false;
+	}
+	return _GetArmSensors (rightArm, out sensors) == 0;
+  }
+
+  // false until the bridge has read the arm's temperatures at least once
+  public static bool GetThermalStatus (bool rightArm, out ThermalStatus status)
+  {
+	status = new ThermalStatus ();
+	if (!initSuccessful) {
+	  return false;
+	}
+	return _GetThermalStatus (rightArm, out status) == 0;
+  }
+
+  // the governor is on by default; off, the arm is never slowed down for heat
+  public static void EnableThermalGovernor (bool enabled)
+  {
+	if (initSuccessful) {
+	  _EnableThermalGovernor (enabled);
+	}
+  }
+
+  // 6 values each: X, Y, Z (m/s, m/s^2), ThetaX, ThetaY, ThetaZ (rad/s, rad/s^2)
+  public static void SetTrajectoryLimits (float[] maxVelocity, float[] maxAcceleration)
+  {
+	if (initSuccessful && _SetTrajectoryLimits (maxVelocity, maxAcceleration) != 0) {
+	  Debug.LogError ("Robot - invalid trajectory limits");
+	}
+  }
+
+  // 6 values each, one per actuator (deg/s, deg/s^2). Moves along the roadmap
+  // run as fast as these allow; the bridge caps them at the actuator limits.
+  public static void SetJointTrajectoryLimits (float[] maxVelocity, float[] maxAcceleration)
+  {
+	if (initSuccessful && _SetJointTrajectoryLimits (maxVelocity, maxAcceleration) != 0) {
+	  Debug.LogError ("Robot - invalid joint trajectory limits");
+	}
+  }
+
+  // Smooth move to one of the named presets (HomePosition, RaiseTheRoof, ...).
+  // Returns the command ID to wait on, or 0 if the move could not start.
+  public static uint MoveArmToPreset (bool rightArm, string preset)
+  {
+	if (!initSuccessful) {
+	  return 0;
+	}
+	int id = _MoveArmToPreset (rightArm, preset);
+	if (id <= 0) {
+	  Debug.LogError ("Robot - could not move to preset " + preset + ": " + id);
+	  return 0;
+	}
+	return (uint)id;
+  }
+
+  // Capsule from a to b in the left arm's base frame (meters), mirrored for the
+  // right arm. Preset moves plan around it once the roadmap is replanned.
+  public static void AddObstacle (Vector3 a, Vector3 b, float radius)
+  {
+	if (initSuccessful) {
+	  _AddObstacle (a.x, a.y, a.z, b.x, b.y, b.z, radius);
+	}
+  }
+
+  public static void ClearObstacles ()
+  {
+	if (initSuccessful) {
+	  _ClearObstacles ();
+	}
+  }
+
+  // true once preset moves follow collision free paths
+  public static bool RoadmapReady ()
+  {
+	return initSuccessful && _GetRoadmapStatus () == 2;
+  }
+
+
+  /**
+   * Use an arm daemon instead of loading the Kinova API into Unity, so a crash
+   * or reload leaves the arms alone. Start the daemon first with
+   * %windir%\SysWOW64\rundll32.exe ARM_base_32.dll,ArmDaemonMain
+   */
+  public static bool ConnectArmDaemon ()
+  {
+	int errorCode = _ConnectArmDaemon ();
+	switch (errorCode) {
+	case 0:
+	  Debug.Log ("Connected to the arm daemon");
+	  daemonConnected = true;
+	  break;
+	case -1:
+	  Debug.LogError ("Robot - no arm daemon running");
+	  break;
+	case -2:
+	  Debug.LogError ("Robot - the arm daemon runs another version of the bridge");
+	  break;
+	case -3:
+	  Debug.LogError ("Robot - another client is connected to the arm daemon");
+	  break;
+	default:
+	  Debug.LogError ("Robot - unknown error connecting to the arm daemon");
+	  break;
+	}
+	return daemonConnected;
+  }
+
+  // The daemon stops the arms and waits for the next client.
+  public static void DisconnectArmDaemon ()
+  {
+	if (daemonConnected) {
+	  _DisconnectArmDaemon ();
+	  daemonConnected = false;
+	}
+  }
+
+  public static void ShutdownArmDaemon ()
+  {
+	if (daemonConnected) {
+	  _ShutdownArmDaemon ();
+	  daemonConnected = false;
+	}
+  }
+
+  // Daemon versions of the Submit calls: the tag that comes back as the
+  // completion's Id, -1 when the daemon is gone, -2 when the channel is full.
+  public static int DaemonMoveHand (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+  {
+	if (!daemonConnected) {
+	  return -1;
+	}
+	return _DaemonMoveHand (rightArm, x, y, z, thetaX, thetaY, thetaZ);
+  }
+
+  public static int DaemonMoveArmHome (bool rightArm)
+  {
+	if (!daemonConnected) {
+	  return -1;
+	}
+	return _DaemonMoveArmHome (rightArm);
+  }
+
+  public static int DaemonMoveFingers (bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb)
+  {
+	if (!daemonConnected) {
+	  return -1;
+	}
+	return _DaemonMoveFingers (rightArm, pinky, ring, middle, index, thumb);
+  }
+
+  public static int DaemonStopArm (bool rightArm)
+  {
+	if (!daemonConnected) {
+	  return -1;
+	}
+	return _DaemonStopArm (rightArm);
+  }
+
+  public static int PollDaemonCompletions (CommandCompletion[] completions)
+  {
+	if (!daemonConnected) {
+	  return 0;
+	}
+	return _PollDaemonCompletions (completions, completions.Length);
+  }
+
+  public static bool GetDaemonArmState (bool rightArm, out ArmState state)
+  {
+	state = new ArmState ();
+	if (!daemonConnected) {
+	  return false;
+	}
+	return _GetDaemonArmState (rightArm, out state) == 0;
+  }
+
+  // Round trip through the channel in microseconds, negative on failure.
+  public static long PingArmDaemon (int timeoutMs)
+  {
+	return daemonConnected ? _PingArmDaemon (timeoutMs) : -1;
+  }
+
+  public static ArmChannelStats GetArmChannelStats ()
+  {
+	ArmChannelStats stats = new ArmChannelStats ();
+	_GetArmChannelStats (out stats);
+	return stats;
+  }
+
+
+  // Robot side of the native operator link. Needs InitRobot first.
+  public static void StartTeleopServer (int port)
+  {
+	if (!initSuccessful) {
+	  return;
+	}
+	int errorCode = _StartTeleopServer (port);
+	if (errorCode == 0) {
+	  Debug.Log ("Teleop server listening on UDP port " + port);
+	} else {
+	  Debug.LogError ("Robot - could not start the teleop server: " + errorCode);
+	}
+  }
+
+  public static void StopTeleopServer ()
+  {
+	_StopTeleopServer ();
+  }
+
+  public static TeleopServerStats GetTeleopServerStats ()
+  {
+	TeleopServerStats stats = new TeleopServerStats ();
+	_GetTeleopServerStats (out stats);
+	return stats;
+  }
+
+  // Plays a capture of the operator link into the robot side instead of the
+  // network, spaced as it came in or as fast as possible. Needs InitRobot
+  // first and no teleop server running; StopTeleopServer ends it.
+  public static bool StartTeleopReplay (string file, bool originalTiming)
+  {
+	if (!initSuccessful) {
+	  return false;
+	}
+	int errorCode = _StartTeleopReplay (file, originalTiming);
+	if (errorCode != 0) {
+	  Debug.LogError ("Robot - could not replay " + file + ": " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  // Records every datagram the teleop server receives to file.
+  public static bool StartTeleopCapture (string file)
+  {
+	int errorCode = _StartTeleopCapture (file);
+	if (errorCode != 0) {
+	  Debug.LogError ("Robot - could not capture to " + file + ": " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  public static void StopTeleopCapture ()
+  {
+	_StopTeleopCapture ();
+  }
+
+  // Operator side, works without a robot.
+  public static bool ConnectTeleop (string host, int port)
+  {
+	int errorCode = _ConnectTeleop (host, port);
+	if (errorCode != 0) {
+	  Debug.LogError ("Could not reach teleop server " + host + ":" + port + ": " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  public static void DisconnectTeleop ()
+  {
+	_DisconnectTeleop ();
+  }
+
+  // Poses are sent once, the newest wins on the robot.
+  public static void TeleopMoveArm (bool rightArm, float x, float y, float z, float thetaX, float thetaY, float thetaZ)
+  {
+	_TeleopMoveArm (rightArm, x, y, z, thetaX, thetaY, thetaZ);
+  }
+
+  public static void TeleopMoveArmNoThetaY (bool rightArm, float x, float y, float z, float thetaX, float thetaZ)
+  {
+	_TeleopMoveArmNoThetaY (rightArm, x, y, z, thetaX, thetaZ);
+  }
+
+  // Both hands and fingers in one compact datagram; poses are { x, y, z, thetaX,
+  // thetaY, thetaZ }, null for a hand not sent, fingers TELEOP_FINGER_* bits.
+  public static void TeleopMoveHands (int contents, float[] leftPose, float[] rightPose, int flags, int leftFingers, int rightFingers)
+  {
+	_TeleopMoveHands (contents, leftPose, rightPose, flags, leftFingers, rightFingers);
+  }
+
+  // Stop, home and fingers are repeated until the robot acknowledges them.
+  public static void TeleopStopArm (bool rightArm)
+  {
+	if (_TeleopStopArm (rightArm) < 0) {
+	  Debug.LogError ("Could not send stop " + (rightArm ? "right" : "left") + " arm");
+	}
+  }
+
+  public static void TeleopMoveArmHome (bool rightArm)
+  {
+	_TeleopMoveArmHome (rightArm);
+  }
+
+  public static void TeleopMoveFingers (bool rightArm, bool pinky, bool ring, bool middle, bool index, bool thumb)
+  {
+	_TeleopMoveFingers (rightArm, pinky, ring, middle, index, thumb);
+  }
+
+  // frames: older frames repeated with each one, parityGroup: reliable messages
+  // covered by a parity message after each; up to 8, 0 turns either off.
+  public static void SetTeleopRedundancy (int frames, int parityGroup)
+  {
+	if (_SetTeleopRedundancyMode (frames, parityGroup) != 0) {
+	  Debug.LogError ("Teleop redundancy out of range: " + frames + " frames, parity over " + parityGroup);
+	}
+  }
+
+  // Relay on port that loses (loss 0 to 1, in bursts of meanBurst), delays and
+  // jitters the link to the server, to try the redundancy against.
+  public static bool StartLossyLink (int port, string host, int serverPort, float loss, float meanBurst, int delayMicros, int jitterMicros)
+  {
+	int errorCode = _StartLossyLink (port, host, serverPort, loss, meanBurst, delayMicros, jitterMicros);
+	if (errorCode != 0) {
+	  Debug.LogError ("Could not start the lossy link: " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  public static void StopLossyLink ()
+  {
+	_StopLossyLink ();
+  }
+
+  public static LossyLinkStats GetLossyLinkStats ()
+  {
+	LossyLinkStats stats = new LossyLinkStats ();
+	_GetLossyLinkStats (out stats);
+	return stats;
+  }
+
+  // Operator side: lease the arms (TELEOP_ARM_* bits, 0 releases them) and keep
+  // renewing while connected; see GetTeleopClientStats for what was granted.
+  public static void LeaseTeleopArms (int arms, int priority, int durationMs)
+  {
+	if (_LeaseTeleopArms (arms, priority, durationMs) != 0) {
+	  Debug.LogError ("Teleop lease out of range: arms " + arms + ", priority " + priority + ", " + durationMs + " ms");
+	}
+  }
+
+  // With leases required an arm nobody leased takes no commands from anyone,
+  // clients that never lease only watch.
+  public static void SetArmLeasePolicy (bool required)
+  {
+	_SetArmLeasePolicy (required);
+  }
+
+  // Lease an arm for holder, or renew its lease. False while someone else
+  // holds it at the same or a higher priority.
+  public static bool RequestArmLease (bool rightArm, int holder, int priority, int durationMs)
+  {
+	return _RequestArmLease (rightArm, holder, priority, durationMs) == 0;
+  }
+
+  // Hand the arm from one holder straight to another.
+  public static bool PassArmLease (bool rightArm, int from, int to, int priority, int durationMs)
+  {
+	return _PassArmLease (rightArm, from, to, priority, durationMs) == 0;
+  }
+
+  public static void ReturnArmLease (bool rightArm, int holder)
+  {
+	_ReturnArmLease (rightArm, holder);
+  }
+
+  // Check before passing a client's command on to the arm.
+  public static bool CanCommandArm (bool rightArm, int holder)
+  {
+	return _CanCommandArm (rightArm, holder) != 0;
+  }
+
+  public static ArmLeaseInfo GetArmLease (bool rightArm)
+  {
+	ArmLeaseInfo info = new ArmLeaseInfo ();
+	_GetArmLease (rightArm, out info);
+	return info;
+  }
+
+  public static ArmLeaseStats GetArmLeaseStats ()
+  {
+	ArmLeaseStats stats = new ArmLeaseStats ();
+	_GetArmLeaseStats (out stats);
+	return stats;
+  }
+
+  // Mocap straight from Motive's multicast stream. server (null to skip) is
+  // asked for its NatNet version, localIp (null for any) is the interface the
+  // stream comes in on, receiveCpu pins the receive thread (-1 for none).
+  public static bool StartNatNet (string server, string localIp, int receiveCpu)
+  {
+	int errorCode = _StartNatNet (server, localIp, receiveCpu);
+	if (errorCode != 0) {
+	  Debug.LogError ("Could not join the NatNet stream: " + errorCode);
+	}
+	return errorCode == 0;
+  }
+
+  public static void StopNatNet ()
+  {
+	_StopNatNet ();
+  }
+
+  public static NatNetClientStats GetNatNetStats ()
+  {
+	NatNetClientStats stats = new NatNetClientStats ();
+	_GetNatNetStats (out stats);
+	return stats;
+  }
+
+  // Only these rigid bodies (up to 16) and skeletons (up to 4) are read out of
+  // each frame, by their IDs in Motive.
+  public static bool SubscribeNatNet (int[] rigidBodies, int[] skeletons)
+  {
+	int errorCode = _SubscribeNatNet (rigidBodies, rigidBodies.Length, skeletons, skeletons.Length);
+	if (errorCode != 0) {
+	  Debug.LogError ("NatNet subscription too large: " + rigidBodies.Length + " rigid bodies, " + skeletons.Length + " skeletons");
+	}
+	return errorCode == 0;
+  }
+
+  // Call once a frame: the subscribed poses of the newest mocap frame, false
+  // when no new frame came in.
+  public static bool PollNatNet (out NatNetSelection selection)
+  {
+	int result = _PollNatNet (out selection);
+	if (result < 0) {
+	  Debug.LogError ("Could not read the NatNet stream: " + result);
+	}
+	return result > 0;
+  }
+
+  // Call once a frame on the operator side.
+  public static void PollTeleop ()
+  {
+	_PollTeleop ();
+  }
+
+  public static TeleopClientStats GetTeleopClientStats ()
+  {
+	TeleopClientStats stats = new TeleopClientStats ();
+	_GetTeleopClientStats (out stats);
+	return stats;
+  }
+
+  // GetBridgeTime() on the robot's machine, for stamping captured poses the
+  // robot side can compare with its own clock; 0 until the link has synced.
+  public static long GetTeleopRobotTime ()
+  {
+	return _GetTeleopRobotTime ();
+  }
+
+
   /**@brief OnApplicationQuit() is called when application closes.
    * 
    * section DESCRIPTION
@@ -197,9 +1651,14 @@ public class KinovaAPI : MonoBehaviour
    */
   private void OnApplicationQuit ()
   {
+	StopTeleopServer ();
+	StopLossyLink ();
 	if (initSuccessful) {
 	  Debug.Log("Closing Robot API...");
+	  StopTargetStream ();
 	  _CloseDevice (false);
 	}
+	DisconnectArmDaemon ();
+	DisconnectTeleop ();
   }
 }
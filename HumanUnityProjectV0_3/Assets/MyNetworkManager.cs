@@ -8,6 +8,12 @@ public class MyMsgTypes
 	public static short MSG_MOVE_ARM_HOME = 1002;
 	public static short MSG_STOP_ARM = 1003;
 	public static short MSG_MOVE_FINGERS = 1004;
+	public static short MSG_CONTROLLER_POSE = 1005;
+	public static short MSG_CALIBRATION_SAMPLE = 1006;
+	public static short MSG_CALIBRATE = 1007;
+	public static short MSG_ARM_FEEDBACK = 1008;
+	public static short MSG_ARM_LEASE = 1009;
+	public static short MSG_CONTROLLER_FRAME = 1010;
 }
 
 public class MoveArmMessage : MessageBase
@@ -52,17 +58,162 @@ public class MoveFingersMessage : MessageBase
 	public bool thumb;
 }
 
+// Raw controller pose, retargeted to the arm on the server
+public class ControllerPoseMessage : MessageBase
+{
+	public bool rightArm;
+	public Vector3 position;
+	public Quaternion rotation;
+}
+
+// Client asks for an arm or renews it (durationMs 0 gives it back), the server
+// answers with the same message and granted set.
+public class ArmLeaseMessage : MessageBase
+{
+	public bool rightArm;
+	public int priority;
+	public int durationMs;
+	public bool granted;
+}
+
+// The server's controller frame of an arm, for clients that retarget
+// themselves (nativeTeleop). mirrored: the right arm mirrors the left one.
+public class ControllerFrameMessage : MessageBase
+{
+	public bool rightArm;
+	public bool mirrored;
+	public Quaternion rotation;
+	public Vector3 translation;
+	public float scale;
+	public Quaternion handOffset;
+}
+
+public class CalibrateMessage : MessageBase
+{
+	public bool rightArm;
+	public bool withScale;
+}
+
+// Forces and currents of one arm, server to client on the unreliable channel.
+// Values go out as 16 bit steps (0.01 N, 0.01 Nm, 1 mA): 51 bytes a message.
+public class ArmFeedbackMessage : MessageBase
+{
+	public bool rightArm;
+	public uint timestamp; // milliseconds on the bridge clock, wraps around
+	public Vector3 force; // N, arm base frame
+	public Vector3 torque; // Nm
+	public float[] jointTorques = new float[7]; // Nm, gravity removed
+	public float[] jointCurrents = new float[7]; // A
+	public float[] fingerCurrents = new float[3];
+
+	private const float FORCE_STEP = 0.01f;
+	private const float CURRENT_STEP = 0.001f;
+
+	public override void Serialize (NetworkWriter writer)
+	{
+		writer.Write (rightArm);
+		writer.Write (timestamp);
+		WriteVector (writer, force, FORCE_STEP);
+		WriteVector (writer, torque, FORCE_STEP);
+		WriteValues (writer, jointTorques, FORCE_STEP);
+		WriteValues (writer, jointCurrents, CURRENT_STEP);
+		WriteValues (writer, fingerCurrents, CURRENT_STEP);
+	}
+
+	public override void Deserialize (NetworkReader reader)
+	{
+		rightArm = reader.ReadBoolean ();
+		timestamp = reader.ReadUInt32 ();
+		force = ReadVector (reader, FORCE_STEP);
+		torque = ReadVector (reader, FORCE_STEP);
+		ReadValues (reader, jointTorques, FORCE_STEP);
+		ReadValues (reader, jointCurrents, CURRENT_STEP);
+		ReadValues (reader, fingerCurrents, CURRENT_STEP);
+	}
+
+	private static void WriteValue (NetworkWriter writer, float value, float step)
+	{
+		writer.Write ((short)Mathf.Clamp (Mathf.Round (value / step), short.MinValue, short.MaxValue));
+	}
+
+	private static void WriteVector (NetworkWriter writer, Vector3 value, float step)
+	{
+		WriteValue (writer, value.x, step);
+		WriteValue (writer, value.y, step);
+		WriteValue (writer, value.z, step);
+	}
+
+	private static void WriteValues (NetworkWriter writer, float[] values, float step)
+	{
+		for (int i = 0; i < values.Length; i++) {
+			WriteValue (writer, values [i], step);
+		}
+	}
+
+	private static Vector3 ReadVector (NetworkReader reader, float step)
+	{
+		float x = reader.ReadInt16 () * step;
+		float y = reader.ReadInt16 () * step;
+		float z = reader.ReadInt16 () * step;
+		return new Vector3 (x, y, z);
+	}
+
+	private static void ReadValues (NetworkReader reader, float[] values, float step)
+	{
+		for (int i = 0; i < values.Length; i++) {
+			values [i] = reader.ReadInt16 () * step;
+		}
+	}
+}
+
 public class MyNetworkManager : MonoBehaviour
 {
 
   public string address = "127.0.0.1";
   public int port = 11111;  
+  // arm commands over the bridge's own UDP link instead of UNET messages,
+  // see ARM_base/TeleopProtocol.h
+  public bool nativeTeleop = false;
+  public int teleopPort = 11112;
+  // older frames repeated per datagram and parity group for reliable
+  // messages, for lossy links; 0 is off
+  public int teleopRedundancy = 0;
+  public int teleopParityGroup = 0;
+  // arm ownership among several clients, see ARM_base/ArmLease.h: leases of
+  // leaseMs are renewed while wanted, a higher leasePriority takes an arm over.
+  // With leasesRequired the server takes commands from lease holders only, the
+  // other clients just watch. Stop always goes through.
+  public bool leasesRequired = false;
+  public int leasePriority = 0;
+  public int leaseMs = 2000;
   public GameObject cameraRig;
   public VideoChatExample videoChat;
 
   private bool isAtStartup = true;
   private bool connectedToServer = false;
   private bool localRun = false;
+  private bool serverRunning = false;
+
+  // feedback older than this is not handed out, seconds
+  public float feedbackTimeout = 0.2f;
+  private long[] lastFeedbackSent = new long[2];
+  private ArmFeedbackMessage[] armFeedback = new ArmFeedbackMessage[2];
+  private float[] armFeedbackReceived = new float[2];
+
+  // UNET connection c holds its leases as this + c, above the native link's
+  private const int UNET_LEASE_HOLDER_BASE = 16;
+  private bool[] leaseWanted = new bool[2];
+  private bool[] leaseHeld = new bool[2];
+  private float[] leaseRenewed = new float[2];
+
+  // Server function: the move each arm is on for controller poses, when the
+  // target stream is not running
+  private int[] controllerMoves = new int[2];
+
+  // Client function: the hands retargeted this frame for the native link, sent
+  // together in LateUpdate as one TeleopMoveHands frame
+  private int handsContents = 0;
+  private float[][] handPoses = { new float[6], new float[6] };
     
   NetworkClient myClient;
 
@@ -83,6 +234,27 @@ public class MyNetworkManager : MonoBehaviour
 		SetupLocalClient ();
 	  }
 	}
+
+	if (serverRunning) {
+	  SendArmFeedback (false);
+	  SendArmFeedback (true);
+	}
+	if (nativeTeleop && connectedToServer) {
+	  KinovaAPI.PollTeleop ();
+	}
+	if (connectedToServer && !nativeTeleop) {
+	  RenewArmLease (false);
+	  RenewArmLease (true);
+	}
+  }
+
+  // after every HandController's Update, so both hands share a frame
+  void LateUpdate ()
+  {
+	if (handsContents != 0) {
+	  KinovaAPI.TeleopMoveHands (handsContents, handPoses [0], handPoses [1], 0, 0, 0);
+	  handsContents = 0;
+	}
   }
 
   void OnGUI ()
@@ -103,11 +275,22 @@ public class MyNetworkManager : MonoBehaviour
 	NetworkServer.RegisterHandler (MyMsgTypes.MSG_MOVE_ARM_NO_THETAY, ReceiveMoveArmNoThetaY);
 	NetworkServer.RegisterHandler (MyMsgTypes.MSG_MOVE_ARM_HOME, ReceiveMoveArmHome);
 	NetworkServer.RegisterHandler (MyMsgTypes.MSG_STOP_ARM, ReceiveStopArm);
+	NetworkServer.RegisterHandler (MyMsgTypes.MSG_CONTROLLER_POSE, ReceiveControllerPose);
+	NetworkServer.RegisterHandler (MyMsgTypes.MSG_CALIBRATION_SAMPLE, ReceiveCalibrationSample);
+	NetworkServer.RegisterHandler (MyMsgTypes.MSG_CALIBRATE, ReceiveCalibrate);
+	NetworkServer.RegisterHandler (MyMsgTypes.MSG_ARM_LEASE, ReceiveArmLease);
+	NetworkServer.RegisterHandler (MsgType.Connect, OnClientConnected);
+	NetworkServer.RegisterHandler (MsgType.Disconnect, OnClientDisconnected);
+	KinovaAPI.SetArmLeasePolicy (leasesRequired);
+	if (nativeTeleop) {
+	  KinovaAPI.StartTeleopServer (teleopPort);
+	}
 	if (!localRun) {
 	  videoChat.gameObject.SetActive (true);
 	  videoChat.StartVideoChat ();
 	}
 	isAtStartup = false;
+	serverRunning = true;
 	Debug.Log ("Server running listening on port " + port);
   }
     
@@ -132,6 +315,9 @@ public class MyNetworkManager : MonoBehaviour
   private void InitClient ()
   {
 	myClient.RegisterHandler (MsgType.Connect, OnConnected);
+	myClient.RegisterHandler (MyMsgTypes.MSG_ARM_FEEDBACK, ReceiveArmFeedback);
+	myClient.RegisterHandler (MyMsgTypes.MSG_ARM_LEASE, ReceiveArmLeaseAnswer);
+	myClient.RegisterHandler (MyMsgTypes.MSG_CONTROLLER_FRAME, ReceiveControllerFrame);
 	cameraRig.SetActive (true); // transitively enables VIVE controllers
 	if (!localRun) {
 	  videoChat.gameObject.SetActive (true);
@@ -143,6 +329,12 @@ public class MyNetworkManager : MonoBehaviour
   public void OnConnected (NetworkMessage netMsg)
   {
 	Debug.Log ("Connected to server on " + address + ":" + port);
+	if (nativeTeleop) {
+	  if (KinovaAPI.ConnectTeleop (localRun ? "127.0.0.1" : address, teleopPort)) {
+		KinovaAPI.SetTeleopRedundancy (teleopRedundancy, teleopParityGroup);
+		LeaseTeleopArms ();
+	  }
+	}
 	if (!localRun) {
 	  Invoke ("JoinVideoChat", 3.0f);
 	}
@@ -161,6 +353,11 @@ public class MyNetworkManager : MonoBehaviour
 	  return;
 	}
 
+	if (nativeTeleop) {
+	  KinovaAPI.TeleopMoveArm (rightArm, x, y, z, thetaX, thetaY, thetaZ);
+	  return;
+	}
+
 	Debug.Log ("Sending move " + ArmSide(rightArm) + " arm...");
     MoveArmMessage m = new MoveArmMessage();
     m.rightArm = rightArm;
@@ -177,6 +374,9 @@ public class MyNetworkManager : MonoBehaviour
   private void ReceiveMoveArm (NetworkMessage message)
   {
 	MoveArmMessage m = message.ReadMessage<MoveArmMessage>();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
 	Debug.Log ("Move " + ArmSide(m.rightArm) + " arm received!");
     KinovaAPI.MoveHand(m.rightArm, m.x, m.y, m.z, m.thetaX, m.thetaY, m.thetaZ);
   }
@@ -188,6 +388,11 @@ public class MyNetworkManager : MonoBehaviour
 	  return;
 	}
 
+	if (nativeTeleop) {
+	  KinovaAPI.TeleopMoveArmNoThetaY (rightArm, x, y, z, thetaX, thetaZ);
+	  return;
+	}
+
 	Debug.Log ("Sending move " + ArmSide(rightArm) + " arm no theta y...");
 	MoveArmNoThetaYMessage m = new MoveArmNoThetaYMessage();
     m.rightArm = rightArm;
@@ -203,6 +408,9 @@ public class MyNetworkManager : MonoBehaviour
   private void ReceiveMoveArmNoThetaY (NetworkMessage message)
   {
 	MoveArmNoThetaYMessage m = message.ReadMessage<MoveArmNoThetaYMessage>();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
 	Debug.Log ("Move " + ArmSide(m.rightArm) + " arm received!");
     KinovaAPI.MoveHandNoThetaY(m.rightArm, m.x, m.y, m.z, m.thetaX, m.thetaZ);
   }
@@ -214,6 +422,11 @@ public class MyNetworkManager : MonoBehaviour
 	  return;
 	}
 
+	if (nativeTeleop) {
+	  KinovaAPI.TeleopMoveArmHome (rightArm);
+	  return;
+	}
+
 	Debug.Log ("Sending move " + ArmSide (rightArm) + " arm home...");
 	MoveArmHomeMessage m = new MoveArmHomeMessage();
     m.rightArm = rightArm;
@@ -224,6 +437,9 @@ public class MyNetworkManager : MonoBehaviour
   private void ReceiveMoveArmHome (NetworkMessage message)
   {
 	MoveArmHomeMessage m = message.ReadMessage<MoveArmHomeMessage> ();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
 	Debug.Log ("Stop " + ArmSide (m.rightArm) + " arm received!");
     KinovaAPI.MoveArmHome(m.rightArm);
   }
@@ -235,6 +451,11 @@ public class MyNetworkManager : MonoBehaviour
 	  return;
 	}
 
+	if (nativeTeleop) {
+	  KinovaAPI.TeleopStopArm (rightArm);
+	  return;
+	}
+
 	if (!suppressLog) {
 	  Debug.Log ("Sending stop " + ArmSide (rightArm) + " arm...");
 	}
@@ -261,6 +482,11 @@ public class MyNetworkManager : MonoBehaviour
 	  return;
 	}
 
+	if (nativeTeleop) {
+	  KinovaAPI.TeleopMoveFingers (rightArm, pinky, ring, middle, index, thumb);
+	  return;
+	}
+
     Debug.Log ("Sending move " + ArmSide (rightArm) + " arm fingers...");
     MoveFingersMessage m = new MoveFingersMessage();
     m.rightArm = rightArm;
@@ -276,10 +502,314 @@ public class MyNetworkManager : MonoBehaviour
   private void ReceiveMoveFingers (NetworkMessage message)
   {
 	MoveFingersMessage m = message.ReadMessage<MoveFingersMessage> ();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
 	Debug.Log ("Move " + ArmSide (m.rightArm) + " arm fingers received!");
     KinovaAPI.MoveFingers(m.rightArm, m.pinky, m.ring, m.middle, m.index, m.thumb);
   }
 
+  // sent every tick while the trigger is held, so not logged. With nativeTeleop
+  // the client retargets with the server's frames and sends the arm poses over
+  // the native link, both hands in one compact frame where the newest wins;
+  // UNET's reliable channel would queue every one of them behind a lost packet.
+  public void SendControllerPose (bool rightArm, Vector3 position, Quaternion rotation)
+  {
+	if (!connectedToServer) {
+	  Debug.LogWarning ("Not connected to server!");
+	  return;
+	}
+
+	if (nativeTeleop) {
+	  KinovaAPI.KinovaPose pose = KinovaAPI.RetargetController (rightArm, position, rotation);
+	  float[] hand = handPoses [rightArm ? 1 : 0];
+	  hand [0] = pose.X;
+	  hand [1] = pose.Y;
+	  hand [2] = pose.Z;
+	  hand [3] = pose.ThetaX;
+	  hand [4] = pose.ThetaY;
+	  hand [5] = pose.ThetaZ;
+	  handsContents |= rightArm ? KinovaAPI.POSE_FRAME_RIGHT : KinovaAPI.POSE_FRAME_LEFT;
+	  return;
+	}
+
+	ControllerPoseMessage m = new ControllerPoseMessage();
+	m.rightArm = rightArm;
+	m.position = position;
+	m.rotation = rotation;
+
+	myClient.Send (MyMsgTypes.MSG_CONTROLLER_POSE, m);
+  }
+
+  // Into the target stream when it runs. Otherwise the pose becomes a move once
+  // the arm is done with the one before, poses in between are dropped; never
+  // waits for the arm.
+  private void ReceiveControllerPose (NetworkMessage message)
+  {
+	ControllerPoseMessage m = message.ReadMessage<ControllerPoseMessage> ();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
+	KinovaAPI.ControllerPose controller = new KinovaAPI.ControllerPose (m.position, m.rotation);
+	if (KinovaAPI.PushControllerTargets (0, controller, controller, m.rightArm ? 2 : 1)) {
+	  return;
+	}
+	int arm = m.rightArm ? 1 : 0;
+	KinovaAPI.CommandCompletion completion;
+	if (controllerMoves [arm] > 0 && KinovaAPI.WaitForCommand (controllerMoves [arm], 0, out completion) == -1) {
+	  return;
+	}
+	KinovaAPI.KinovaPose pose = KinovaAPI.RetargetController (m.rightArm, m.position, m.rotation);
+	controllerMoves [arm] = KinovaAPI.SubmitMoveHand (m.rightArm, pose.X, pose.Y, pose.Z, pose.ThetaX, pose.ThetaY, pose.ThetaZ);
+  }
+
+  // controller held against the gripper, see KinovaAPI.AddCalibrationSample
+  public void SendCalibrationSample (bool rightArm, Vector3 position, Quaternion rotation)
+  {
+	if (!connectedToServer) {
+	  Debug.LogWarning ("Not connected to server!");
+	  return;
+	}
+
+	ControllerPoseMessage m = new ControllerPoseMessage();
+	m.rightArm = rightArm;
+	m.position = position;
+	m.rotation = rotation;
+
+	myClient.Send (MyMsgTypes.MSG_CALIBRATION_SAMPLE, m);
+  }
+
+  private void ReceiveCalibrationSample (NetworkMessage message)
+  {
+	ControllerPoseMessage m = message.ReadMessage<ControllerPoseMessage> ();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
+	if (!KinovaAPI.AddCalibrationSample (m.rightArm, KinovaAPI.CALIBRATION_CONTROLLER, m.position, m.rotation)) {
+	  Debug.LogWarning ("Calibration sample for the " + ArmSide (m.rightArm) + " arm rejected");
+	}
+  }
+
+  public void SendCalibrate (bool rightArm, bool withScale)
+  {
+	if (!connectedToServer) {
+	  Debug.LogWarning ("Not connected to server!");
+	  return;
+	}
+
+	CalibrateMessage m = new CalibrateMessage();
+	m.rightArm = rightArm;
+	m.withScale = withScale;
+
+	Debug.Log ("Calibrating the " + ArmSide (rightArm) + " arm");
+	myClient.Send (MyMsgTypes.MSG_CALIBRATE, m);
+  }
+
+  private void ReceiveCalibrate (NetworkMessage message)
+  {
+	CalibrateMessage m = message.ReadMessage<CalibrateMessage> ();
+	if (!Commands (message, m.rightArm)) {
+	  return;
+	}
+	KinovaAPI.CalibrationResult result;
+	if (KinovaAPI.CalibrateArm (m.rightArm, KinovaAPI.CALIBRATION_CONTROLLER, m.withScale, out result)) {
+	  Debug.Log ("Calibrated the " + ArmSide (m.rightArm) + " arm: " + result.Inliers + "/" + result.Samples +
+		" samples, rms " + result.RmsPositionError + " m, " + result.RmsAngleError + " rad");
+	  // a new left frame moves a mirroring right arm too
+	  NetworkServer.SendToAll (MyMsgTypes.MSG_CONTROLLER_FRAME, ControllerFrame (false));
+	  NetworkServer.SendToAll (MyMsgTypes.MSG_CONTROLLER_FRAME, ControllerFrame (true));
+	} else {
+	  Debug.LogWarning ("Not enough calibration samples for the " + ArmSide (m.rightArm) + " arm");
+	}
+  }
+
+  // Server function
+  private ControllerFrameMessage ControllerFrame (bool rightArm)
+  {
+	bool mirrored;
+	KinovaAPI.RetargetFrame frame = KinovaAPI.GetControllerFrame (rightArm, out mirrored);
+	ControllerFrameMessage m = new ControllerFrameMessage ();
+	m.rightArm = rightArm;
+	m.mirrored = mirrored;
+	m.rotation = frame.Rotation;
+	m.translation = frame.Translation;
+	m.scale = frame.Scale;
+	m.handOffset = frame.HandOffset;
+	return m;
+  }
+
+  // Server function: a new client starts with the frames calibrated so far.
+  private void OnClientConnected (NetworkMessage message)
+  {
+	message.conn.Send (MyMsgTypes.MSG_CONTROLLER_FRAME, ControllerFrame (false));
+	message.conn.Send (MyMsgTypes.MSG_CONTROLLER_FRAME, ControllerFrame (true));
+  }
+
+  // Client function: keeps the frames for SendControllerPose; a local client
+  // shares the server's already.
+  private void ReceiveControllerFrame (NetworkMessage message)
+  {
+	ControllerFrameMessage m = message.ReadMessage<ControllerFrameMessage> ();
+	if (localRun) {
+	  return;
+	}
+	if (m.mirrored) {
+	  KinovaAPI.ResetControllerFrame (m.rightArm);
+	  return;
+	}
+	KinovaAPI.RetargetFrame frame = new KinovaAPI.RetargetFrame ();
+	frame.Rotation = m.rotation;
+	frame.Translation = m.translation;
+	frame.Scale = m.scale;
+	frame.HandOffset = m.handOffset;
+	KinovaAPI.SetControllerFrame (m.rightArm, frame);
+  }
+
+  // Server function: sends the arm's forces once per new reading from the bridge.
+  // Lost messages are not resent, the next reading replaces them anyway.
+  private void SendArmFeedback (bool rightArm)
+  {
+	KinovaAPI.ArmEffort effort;
+	int arm = rightArm ? 1 : 0;
+	if (!KinovaAPI.GetArmEffort (rightArm, out effort) || effort.Timestamp == lastFeedbackSent [arm]) {
+	  return;
+	}
+	lastFeedbackSent [arm] = effort.Timestamp;
+
+	ArmFeedbackMessage m = new ArmFeedbackMessage();
+	m.rightArm = rightArm;
+	m.timestamp = (uint)(effort.Timestamp / 1000);
+	m.force = new Vector3 (effort.Force [0], effort.Force [1], effort.Force [2]);
+	m.torque = new Vector3 (effort.Force [3], effort.Force [4], effort.Force [5]);
+	m.jointTorques = effort.Torques;
+	m.jointCurrents = effort.Currents;
+	m.fingerCurrents = effort.FingerCurrents;
+
+	NetworkServer.SendByChannelToAll (MyMsgTypes.MSG_ARM_FEEDBACK, m, Channels.DefaultUnreliable);
+  }
+
+  private void ReceiveArmFeedback (NetworkMessage message)
+  {
+	ArmFeedbackMessage m = message.ReadMessage<ArmFeedbackMessage> ();
+	int arm = m.rightArm ? 1 : 0;
+	armFeedback [arm] = m;
+	armFeedbackReceived [arm] = Time.time;
+  }
+
+  // Client function: latest forces of the arm, null when none arrived lately.
+  public ArmFeedbackMessage LatestArmFeedback (bool rightArm)
+  {
+	int arm = rightArm ? 1 : 0;
+	if (armFeedback [arm] == null || Time.time - armFeedbackReceived [arm] > feedbackTimeout) {
+	  return null;
+	}
+	return armFeedback [arm];
+  }
+
+  // Client function: ask for the arm and keep it until ReleaseArm.
+  public void RequestArm (bool rightArm)
+  {
+	int arm = rightArm ? 1 : 0;
+	leaseWanted [arm] = true;
+	leaseRenewed [arm] = float.NegativeInfinity;
+	if (nativeTeleop && connectedToServer) {
+	  LeaseTeleopArms ();
+	}
+  }
+
+  public void ReleaseArm (bool rightArm)
+  {
+	int arm = rightArm ? 1 : 0;
+	leaseWanted [arm] = false;
+	leaseHeld [arm] = false;
+	if (!connectedToServer) {
+	  return;
+	}
+	if (nativeTeleop) {
+	  LeaseTeleopArms ();
+	  return;
+	}
+	SendArmLease (rightArm, 0);
+  }
+
+  // Client function: the server granted the arm when last asked.
+  public bool HoldsArm (bool rightArm)
+  {
+	if (nativeTeleop) {
+	  int bit = rightArm ? KinovaAPI.TELEOP_ARM_RIGHT : KinovaAPI.TELEOP_ARM_LEFT;
+	  return (KinovaAPI.GetTeleopClientStats ().LeaseHeld & bit) != 0;
+	}
+	return leaseHeld [rightArm ? 1 : 0];
+  }
+
+  // the native link renews by itself
+  private void LeaseTeleopArms ()
+  {
+	int arms = (leaseWanted [0] ? KinovaAPI.TELEOP_ARM_LEFT : 0) | (leaseWanted [1] ? KinovaAPI.TELEOP_ARM_RIGHT : 0);
+	KinovaAPI.LeaseTeleopArms (arms, leasePriority, leaseMs);
+  }
+
+  // four times a lease, a lost message or two does not cost the arm
+  private void RenewArmLease (bool rightArm)
+  {
+	int arm = rightArm ? 1 : 0;
+	if (leaseWanted [arm] && Time.time - leaseRenewed [arm] > leaseMs / 4000.0f) {
+	  leaseRenewed [arm] = Time.time;
+	  SendArmLease (rightArm, leaseMs);
+	}
+  }
+
+  private void SendArmLease (bool rightArm, int durationMs)
+  {
+	ArmLeaseMessage m = new ArmLeaseMessage ();
+	m.rightArm = rightArm;
+	m.priority = leasePriority;
+	m.durationMs = durationMs;
+	myClient.Send (MyMsgTypes.MSG_ARM_LEASE, m);
+  }
+
+  private void ReceiveArmLeaseAnswer (NetworkMessage message)
+  {
+	ArmLeaseMessage m = message.ReadMessage<ArmLeaseMessage> ();
+	int arm = m.rightArm ? 1 : 0;
+	if (leaseWanted [arm] && leaseHeld [arm] != m.granted) {
+	  Debug.Log ((m.granted ? "Got the " : "Lost the ") + ArmSide (m.rightArm) + " arm");
+	}
+	leaseHeld [arm] = leaseWanted [arm] && m.granted;
+  }
+
+  // Server function
+  private void ReceiveArmLease (NetworkMessage message)
+  {
+	ArmLeaseMessage m = message.ReadMessage<ArmLeaseMessage> ();
+	int holder = LeaseHolder (message.conn);
+	if (m.durationMs > 0) {
+	  m.granted = KinovaAPI.RequestArmLease (m.rightArm, holder, m.priority, m.durationMs);
+	} else {
+	  KinovaAPI.ReturnArmLease (m.rightArm, holder);
+	  m.granted = false;
+	}
+	message.conn.Send (MyMsgTypes.MSG_ARM_LEASE, m);
+  }
+
+  private void OnClientDisconnected (NetworkMessage message)
+  {
+	int holder = LeaseHolder (message.conn);
+	KinovaAPI.ReturnArmLease (false, holder);
+	KinovaAPI.ReturnArmLease (true, holder);
+  }
+
+  private int LeaseHolder (NetworkConnection conn)
+  {
+	return UNET_LEASE_HOLDER_BASE + conn.connectionId;
+  }
+
+  // Server function: whether the sender may move the arm, see leasesRequired.
+  private bool Commands (NetworkMessage message, bool rightArm)
+  {
+	return KinovaAPI.CanCommandArm (rightArm, LeaseHolder (message.conn));
+  }
+
   private string ArmSide (bool rightArm)
   {
 	return rightArm ? "right" : "left";